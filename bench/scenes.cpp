@@ -0,0 +1,326 @@
+// Runs every test scene headless for a fixed number of frames along a scripted camera path and
+// compares the cpu and gpu frame time distributions against a stored baseline.
+//
+// usage (from the repo root):
+//   bench.exe                      run all scenes and compare with bench/baseline.csv
+//   bench.exe --frames 2000        frames per scene (default 1000)
+//   bench.exe --scene lights       only run scenes whose name contains "lights"
+//   bench.exe --update-baseline    store the results as the new baseline
+//   bench.exe --gl-performance     run with a debug context and fail on opengl performance messages
+//
+// results are written to bench/results.csv with one row per scene and timer. the heap allocations
+// per frame are printed with the rest of the metrics of each scene.
+// the process returns 1 if any timer regressed or, with --gl-performance, if the driver raised any
+// performance messages. Ex: to fail a ci job.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <numbers>
+#include <cmath>
+
+#define WRAP_G_OPENGL_VERSION_MAJOR 4
+#define WRAP_G_OPENGL_VERSION_MINOR 6
+// loading in the background would time blank frames until the resources arrive
+#define WRAP_G_BACKGROUND_RESOURCE_LOAD false
+#define WRAP_G_DEBUG false
+
+#define WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL true
+
+// count the heap allocations of every frame, the steady state loop should not allocate
+#define UTILS_TRACK_ALLOCATIONS true
+
+#include "../tests/1. triangle/triangle.hpp"
+#include "../tests/2. textured rect/textured_rect.hpp"
+#include "../tests/3. moving around cubes/moving_around_cubes.hpp"
+#include "../tests/4. materials/materials.hpp"
+#include "../tests/5. lights/lights.hpp"
+#include "../tests/7. terrain/terrain.hpp"
+
+namespace bench
+{
+
+////
+// settings
+
+constexpr const char *results_loc = "./bench/results.csv";
+constexpr const char *baseline_loc = "./bench/baseline.csv";
+
+// the dt used for every scripted frame so camera movement does not depend on the machine
+constexpr float scripted_dt = 0.01f;
+
+// a timer regressed when its mean is significantly larger (p < max_p) than the baseline mean
+// and larger by at least min_increase so tiny but significant differences are not reported
+constexpr double max_p = 0.01;
+constexpr double min_increase = 0.05;
+
+struct scene
+{
+    const char *name;
+    void (*run)(const wrap_tests::scene_options &) noexcept;
+    // whether the scene has a camera which follows the scripted path
+    bool camera;
+};
+
+constexpr std::array scenes{
+    scene{"triangle", wrap_tests::create_triangle, false},
+    scene{"textured_rect", wrap_tests::create_textured_rect, false},
+    scene{"moving_around_cubes", wrap_tests::create_moving_around_cubes, true},
+    scene{"materials", wrap_tests::create_materials, true},
+    scene{"lights", wrap_tests::create_lights, true},
+    scene{"terrain", wrap_tests::create_terrain, true},
+};
+
+////
+// results
+
+struct result
+{
+    std::string scene;
+    // cpu or gpu
+    std::string timer;
+    utils::metrics::distribution dist;
+    bool valid = false;
+};
+
+/**
+ * @brief Script the camera path by recording synthetic input. The left mouse button is held while the
+ * cursor sweeps around the center of the window to look around and w, d, s and a are held for a quarter
+ * of the frames each to walk a square.
+ *
+ * @param input The recorder, left ready to replay.
+ * @param frames The number of frames the path takes.
+ */
+void script_camera_path(wrap_g::input_recorder &input, unsigned int frames) noexcept
+{
+    using type = wrap_g::input_recorder::event_type;
+
+    // the center of the 800x600 scene windows
+    constexpr double center_x = 400.0;
+    constexpr double center_y = 300.0;
+
+    constexpr std::array<int, 4> keys{GLFW_KEY_W, GLFW_KEY_D, GLFW_KEY_S, GLFW_KEY_A};
+
+    input.start_recording();
+    input.record({.type = type::CURSOR_POSITION, .x = center_x, .y = center_y});
+    input.record({.type = type::MOUSE_BUTTON, .code = GLFW_MOUSE_BUTTON_LEFT, .action = GLFW_PRESS});
+
+    size_t held = keys.size();
+    for (unsigned int i = 0; i < frames; ++i)
+    {
+        size_t leg = (size_t)i * keys.size() / frames;
+        if (leg != held)
+        {
+            if (held < keys.size())
+                input.record({.type = type::KEY, .code = keys[held], .action = GLFW_RELEASE});
+
+            input.record({.type = type::KEY, .code = keys[leg], .action = GLFW_PRESS});
+            held = leg;
+        }
+
+        double angle = 2.0 * std::numbers::pi * i / frames;
+        input.record({.type = type::CURSOR_POSITION, .x = center_x + 100.0 * std::cos(angle), .y = center_y + 50.0 * std::sin(2.0 * angle)});
+
+        (void)input.frame(scripted_dt);
+    }
+
+    input.stop();
+    input.start_replay();
+}
+
+/**
+ * @brief Run one scene and summarize its frame times.
+ *
+ * @param s The scene.
+ * @param frames The number of frames to run.
+ * @param gl_debug Whether to run with a debug context and count the opengl debug messages.
+ * @param performance_messages Set to the number of GL_DEBUG_TYPE_PERFORMANCE messages, 0 without gl_debug.
+ * @return std::array<result, 2> The cpu and gpu results.
+ */
+std::array<result, 2> run_scene(const scene &s, unsigned int frames, bool gl_debug, size_t &performance_messages) noexcept
+{
+    utils::metrics tracker;
+    tracker.keep_samples();
+    tracker.track_allocations();
+
+    wrap_g::input_recorder input;
+    if (s.camera)
+        script_camera_path(input, frames);
+
+    std::cout << "[bench] Info: Running " << s.name << " for " << frames << " frames.\n";
+
+    tracker.start_tracking();
+    s.run({ .input = s.camera ? &input : nullptr, .headless = true, .max_frames = frames, .tracker = &tracker, .gl_debug = gl_debug });
+    tracker.finish_tracking();
+
+    const auto *performance = tracker.find_counter("gl performance messages");
+    performance_messages = performance != nullptr ? performance->total : 0;
+
+    return {
+        result{s.name, "cpu", utils::metrics::summarize(tracker.samples()), tracker.frames() != 0},
+        result{s.name, "gpu", utils::metrics::summarize(tracker.gpu_samples()), !tracker.gpu_samples().empty()},
+    };
+}
+
+bool save_results(const char *path, const std::vector<result> &results) noexcept
+{
+    std::ofstream file;
+    file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+    try
+    {
+        file.open(path, std::ios::trunc);
+
+        file << "scene,timer,count,mean,stddev,min,p50,p95,p99,max\n";
+        for (const auto &r : results)
+        {
+            if (!r.valid)
+                continue;
+
+            file << r.scene << ',' << r.timer << ',' << r.dist.count << ','
+                 << r.dist.mean << ',' << r.dist.stddev << ',' << r.dist.min << ','
+                 << r.dist.p50 << ',' << r.dist.p95 << ',' << r.dist.p99 << ',' << r.dist.max << '\n';
+        }
+
+        return true;
+    }
+    catch (const std::ofstream::failure &e)
+    {
+        std::cout << "[bench] Error: Failed to write results to " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+        return false;
+    }
+}
+
+std::vector<result> load_results(const char *path) noexcept
+{
+    auto [headers, results] = utils::read_csv_struct_sync<result>(path, true, [](const std::vector<std::string> &row){
+        result r;
+        if (row.size() < 10)
+            return r;
+
+        try
+        {
+            r.scene = row[0];
+            r.timer = row[1];
+            r.dist.count = std::stoull(row[2]);
+            r.dist.mean = std::stod(row[3]);
+            r.dist.stddev = std::stod(row[4]);
+            r.dist.min = std::stod(row[5]);
+            r.dist.p50 = std::stod(row[6]);
+            r.dist.p95 = std::stod(row[7]);
+            r.dist.p99 = std::stod(row[8]);
+            r.dist.max = std::stod(row[9]);
+            r.valid = true;
+        }
+        catch (const std::exception &)
+        {
+            r.valid = false;
+        }
+
+        return r;
+    });
+
+    return results;
+}
+
+/**
+ * @brief Compare the results with the baseline and print a report.
+ *
+ * @return true At least one timer regressed.
+ */
+bool compare(const std::vector<result> &results, const std::vector<result> &baseline) noexcept
+{
+    bool regressed = false;
+
+    std::cout << "[bench] Info: scene / timer: mean ms (baseline ms) change, p\n";
+
+    for (const auto &r : results)
+    {
+        if (!r.valid)
+            continue;
+
+        const result *base = nullptr;
+        for (const auto &b : baseline)
+            if (b.valid && b.scene == r.scene && b.timer == r.timer)
+                base = &b;
+
+        if (base == nullptr)
+        {
+            std::cout << "[bench] Info: " << r.scene << " / " << r.timer << ": " << r.dist.mean << " ms, no baseline.\n";
+            continue;
+        }
+
+        auto test = utils::welch_t_test(r.dist, base->dist);
+        double change = base->dist.mean > 0.0 ? r.dist.mean / base->dist.mean - 1.0 : 0.0;
+        bool slower = test.p < max_p && change > min_increase;
+
+        std::cout << (slower ? "[bench] Error: " : "[bench] Info: ") << r.scene << " / " << r.timer << ": "
+                  << r.dist.mean << " ms (" << base->dist.mean << " ms) "
+                  << (change >= 0.0 ? "+" : "") << change * 100.0 << "%, p = " << test.p
+                  << (slower ? " REGRESSION" : "") << "\n";
+
+        regressed |= slower;
+    }
+
+    return regressed;
+}
+
+} // namespace bench
+
+int main(int argc, char **argv)
+{
+    utils::alloc_tracker::enable();
+
+    unsigned int frames = 1000;
+    std::string_view filter;
+    bool update_baseline = false;
+    bool gl_performance = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+
+        if (arg == "--frames" && i + 1 < argc)
+            frames = std::stoul(argv[++i]);
+        else if (arg == "--scene" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--update-baseline")
+            update_baseline = true;
+        else if (arg == "--gl-performance")
+            gl_performance = true;
+        else
+        {
+            std::cout << "[bench] Error: Unknown argument " << arg << ".\n";
+            return 2;
+        }
+    }
+
+    std::vector<bench::result> results;
+    size_t performance_messages = 0;
+    for (const auto &s : bench::scenes)
+    {
+        if (!filter.empty() && std::string_view{s.name}.find(filter) == std::string_view::npos)
+            continue;
+
+        size_t scene_messages = 0;
+        for (auto &r : bench::run_scene(s, frames, gl_performance, scene_messages))
+            results.push_back(std::move(r));
+
+        if (scene_messages != 0)
+            std::cout << "[bench] Error: " << s.name << " raised " << scene_messages << " opengl performance messages.\n";
+        performance_messages += scene_messages;
+    }
+
+    (void)bench::save_results(bench::results_loc, results);
+
+    if (update_baseline)
+    {
+        std::cout << "[bench] Info: Updating the baseline " << bench::baseline_loc << ".\n";
+        return bench::save_results(bench::baseline_loc, results) ? 0 : 2;
+    }
+
+    bool regressed = bench::compare(results, bench::load_results(bench::baseline_loc));
+    return regressed || performance_messages != 0 ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+// Runs the stress scene headless at growing sizes to find where the per object cost of the wrapper
+// stops scaling. One knob is swept in powers of 10 while the others stay fixed.
+//
+// usage (from the repo root):
+//   stress.exe                         sweep 1 to 1M cubes with 1 texture, program and light
+//   stress.exe --shape rect            use rects instead of cubes
+//   stress.exe --sweep textures        sweep textures (or programs, lights) instead of objects
+//   stress.exe --max 10000             the largest value of the swept knob
+//   stress.exe --objects 5000 --textures 8 --programs 4 --lights 16
+//                                      the fixed value of each knob
+//   stress.exe --frames 60             frames per step
+//
+// every step is written to bench/stress_results.csv.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define WRAP_G_OPENGL_VERSION_MAJOR 4
+#define WRAP_G_OPENGL_VERSION_MINOR 6
+#define WRAP_G_BACKGROUND_RESOURCE_LOAD false
+#define WRAP_G_DEBUG false
+
+#define WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL true
+
+#include "../tests/6. stress/stress.hpp"
+
+namespace bench
+{
+
+constexpr const char *stress_results_loc = "./bench/stress_results.csv";
+
+// a step is a cliff when it submits less than this fraction of the best draws per second so far
+constexpr double cliff_fraction = 0.5;
+
+struct step
+{
+    wrap_tests::stress_options knobs;
+    wrap_tests::stress_stats stats;
+    utils::metrics::distribution gpu;
+};
+
+template <typename Shape>
+step run_step(const wrap_tests::stress_options &knobs, unsigned int frames) noexcept
+{
+    utils::metrics tracker;
+    tracker.keep_samples();
+    tracker.start_tracking();
+
+    step s{knobs, wrap_tests::create_stress<Shape>(knobs, { .headless = true, .max_frames = frames, .tracker = &tracker }), {}};
+    s.gpu = utils::metrics::summarize(tracker.gpu_samples());
+
+    return s;
+}
+
+bool save_steps(const char *path, std::string_view shape, const std::vector<step> &steps) noexcept
+{
+    std::ofstream file;
+    file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+    try
+    {
+        file.open(path, std::ios::trunc);
+
+        file << "shape,objects,textures,programs,lights,frames,frame_ms,submit_ms,gpu_ms,draws_per_second,start_memory,resident_memory,gpu_memory\n";
+        for (const auto &s : steps)
+        {
+            file << shape << ',' << s.knobs.objects << ',' << s.knobs.textures << ',' << s.knobs.programs << ',' << s.knobs.lights << ','
+                 << s.stats.frames << ',' << s.stats.frame_ms << ',' << s.stats.submit_ms << ',' << s.gpu.mean << ','
+                 << s.stats.draws_per_second << ',' << s.stats.start_memory << ',' << s.stats.resident_memory << ',' << s.stats.gpu_memory << '\n';
+        }
+
+        return true;
+    }
+    catch (const std::ofstream::failure &e)
+    {
+        std::cout << "[bench] Error: Failed to write results to " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+        return false;
+    }
+}
+
+} // namespace bench
+
+int main(int argc, char **argv)
+{
+    wrap_tests::stress_options knobs{ .objects = 1000, .textures = 1, .programs = 1, .lights = 1 };
+    std::string_view shape = "cube", sweep = "objects";
+    size_t max = 1'000'000;
+    unsigned int frames = 60;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--shape" && has_value)
+            shape = argv[++i];
+        else if (arg == "--sweep" && has_value)
+            sweep = argv[++i];
+        else if (arg == "--max" && has_value)
+            max = std::stoull(argv[++i]);
+        else if (arg == "--frames" && has_value)
+            frames = std::stoul(argv[++i]);
+        else if (arg == "--objects" && has_value)
+            knobs.objects = std::stoull(argv[++i]);
+        else if (arg == "--textures" && has_value)
+            knobs.textures = std::stoull(argv[++i]);
+        else if (arg == "--programs" && has_value)
+            knobs.programs = std::stoull(argv[++i]);
+        else if (arg == "--lights" && has_value)
+            knobs.lights = std::stoull(argv[++i]);
+        else
+        {
+            std::cout << "[bench] Error: Unknown argument " << arg << ".\n";
+            return 2;
+        }
+    }
+
+    size_t wrap_tests::stress_options::*swept = nullptr;
+    if (sweep == "objects")
+        swept = &wrap_tests::stress_options::objects;
+    else if (sweep == "textures")
+        swept = &wrap_tests::stress_options::textures;
+    else if (sweep == "programs")
+        swept = &wrap_tests::stress_options::programs;
+    else if (sweep == "lights")
+    {
+        swept = &wrap_tests::stress_options::lights;
+        max = std::min(max, wrap_tests::stress_options::max_lights);
+    }
+
+    if (swept == nullptr || (shape != "cube" && shape != "rect"))
+    {
+        std::cout << "[bench] Error: Unknown shape " << shape << " or swept knob " << sweep << ".\n";
+        return 2;
+    }
+
+    std::vector<bench::step> steps;
+    double best = 0.0;
+
+    for (size_t value = 1; value <= max; value *= 10)
+    {
+        knobs.*swept = value;
+
+        std::cout << "[bench] Info: " << shape << " x " << knobs.objects << ", textures: " << knobs.textures
+                  << ", programs: " << knobs.programs << ", lights: " << knobs.lights << "\n";
+
+        auto s = shape == "cube" ? bench::run_step<wrap_g::cube>(knobs, frames) : bench::run_step<wrap_g::rect>(knobs, frames);
+
+        std::cout << "[bench] Info: " << s.stats.draws_per_second << " draws/s, submit " << s.stats.submit_ms
+                  << " ms, frame " << s.stats.frame_ms << " ms, gpu " << s.gpu.mean << " ms, memory "
+                  << s.stats.resident_memory / (1024 * 1024) << " MiB\n";
+
+        if (best > 0.0 && s.stats.draws_per_second < best * bench::cliff_fraction)
+            std::cout << "[bench] Info: Draws per second fell below " << bench::cliff_fraction * 100.0 << "% of the best at " << sweep << " = " << value << ".\n";
+
+        best = std::max(best, s.stats.draws_per_second);
+        steps.push_back(s);
+    }
+
+    return bench::save_steps(bench::stress_results_loc, shape, steps) ? 0 : 2;
+}
@@ -0,0 +1,1184 @@
+// Microbenchmarks for the hot functions in utils, written with google benchmark.
+//
+// usage (from the repo root):
+//   utils_bench.exe --benchmark_out=bench/utils_results.json --benchmark_out_format=json
+//   utils_bench.exe --benchmark_filter=flip        only run the matching benchmarks
+//   utils_bench.exe --font C:/Windows/Fonts/arial.ttf
+//                                                  the font used by the stb_true_type benchmarks
+//
+// any google benchmark flag works, ex: --benchmark_repetitions=10 for the mean, median and stddev.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+
+#include "../src/utils.hpp"
+
+namespace bench
+{
+
+std::string font_path = "C:/Windows/Fonts/arial.ttf";
+
+// the files read by the file and csv benchmarks
+const std::filesystem::path temp_dir = std::filesystem::temp_directory_path() / "wrap_g_bench";
+
+// some text to lay out, repeated to the length that is benchmarked
+constexpr std::string_view sample_text = "The quick brown fox jumps over the lazy dog. Sphinx of black quartz, judge my vow! ";
+
+// localized text with codepoints past the stb_true_type table codepoints
+constexpr std::string_view sample_utf8_text = "Größere Übung — “Łódź” kostet €100, ŝanĝo ĉiuĵaŭde. Ωμέγα. ";
+
+std::string make_text(size_t len)
+{
+    std::string text;
+    text.reserve(len);
+    while (text.size() < len)
+        text.append(sample_text.substr(0, std::min(sample_text.size(), len - text.size())));
+    return text;
+}
+
+// whole repeats of the utf-8 sample so no codepoint is cut, at least len bytes
+std::string make_utf8_text(size_t len)
+{
+    std::string text;
+    while (text.size() < len)
+        text.append(sample_utf8_text);
+    return text;
+}
+
+// write a file once and reuse it for every run of the benchmark
+std::string make_file(std::string_view name, size_t size)
+{
+    std::filesystem::create_directories(temp_dir);
+    auto path = (temp_dir / (std::string(name) + "_" + std::to_string(size))).string();
+
+    if (!std::filesystem::exists(path) || std::filesystem::file_size(path) != size)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << make_text(size);
+    }
+
+    return path;
+}
+
+std::string make_csv(size_t rows)
+{
+    std::filesystem::create_directories(temp_dir);
+    auto path = (temp_dir / ("csv_" + std::to_string(rows) + ".csv")).string();
+
+    if (!std::filesystem::exists(path))
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "name,id,value,weight\n";
+        for (size_t i = 0; i < rows; ++i)
+            file << "row" << i << ',' << i << ',' << i * 0.25 << ',' << i * 1.5f << '\n';
+    }
+
+    return path;
+}
+
+// count png images of 512 x 512 rgba pixels, ex: the textures of a level
+std::vector<std::string> make_images(size_t count)
+{
+    constexpr int side = 512;
+
+    std::filesystem::create_directories(temp_dir);
+
+    std::vector<std::string> paths;
+    std::vector<unsigned char> pixels;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto path = (temp_dir / ("image_" + std::to_string(i) + ".png")).string();
+
+        if (!std::filesystem::exists(path))
+        {
+            // gradients with some noise so the png filters and deflate have work to do
+            std::mt19937 rng((unsigned int)i);
+            pixels.resize(side * side * 4);
+            for (size_t p = 0; p < pixels.size(); ++p)
+                pixels[p] = (unsigned char)((p / 4 % side + p / 4 / side * (i + 1) + rng() % 16) & 0xFF);
+
+            (void)stbi_write_png(path.c_str(), side, side, 4, pixels.data(), side * 4);
+        }
+
+        paths.push_back(std::move(path));
+    }
+
+    return paths;
+}
+
+utils::stb_true_type &font()
+{
+    static utils::stb_true_type loaded_font;
+    static bool loaded = loaded_font.load_file(font_path.c_str());
+    (void)loaded;
+    return loaded_font;
+}
+
+bool font_loaded()
+{
+    return font().font_info()->data != nullptr;
+}
+
+// an obj grid of quads with side * side faces
+std::string make_obj_grid(size_t side)
+{
+    std::string obj;
+    for (size_t y = 0; y <= side; ++y)
+        for (size_t x = 0; x <= side; ++x)
+            obj += "v " + std::to_string(x * 0.01) + " " + std::to_string(y * 0.01) + " 0.0\n";
+
+    obj += "vt 0.0 0.0\nvn 0.0 0.0 1.0\n";
+    for (size_t y = 0; y < side; ++y)
+    {
+        for (size_t x = 0; x < side; ++x)
+        {
+            size_t a = y * (side + 1) + x + 1;
+            obj += "f " + std::to_string(a) + "/1/1 " + std::to_string(a + 1) + "/1/1 " + std::to_string(a + side + 2) + "/1/1 " + std::to_string(a + side + 1) + "/1/1\n";
+        }
+    }
+
+    return obj;
+}
+
+// an obj of separate quads, each with its own 4 vertices and a face of relative indices to them
+std::string make_obj_quads(size_t count)
+{
+    std::string obj;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const std::string x = std::to_string(i % 1024 * 0.01), y = std::to_string(i / 1024 * 0.01);
+        const std::string x1 = std::to_string((i % 1024 + 1) * 0.01), y1 = std::to_string((i / 1024 + 1) * 0.01);
+        obj += "v " + x + " " + y + " 0.0\nv " + x1 + " " + y + " 0.0\nv " + x1 + " " + y1 + " 0.0\nv " + x + " " + y1 + " 0.0\n";
+        obj += "f -4 -3 -2 -1\n";
+    }
+
+    return obj;
+}
+
+} // namespace bench
+
+////
+// flip_array2d
+
+// range(0): width and height, range(1): 1 horizontal, 2 vertical, 3 both
+template <typename T>
+void BM_flip_array2d(benchmark::State &state)
+{
+    size_t size = state.range(0);
+    bool horizontally = state.range(1) & 1, vertically = state.range(1) & 2;
+    std::vector<T> image(size * size);
+
+    for (auto _ : state)
+    {
+        utils::flip_array2d(size, size, image.data(), horizontally, vertically);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * image.size() * sizeof(T));
+}
+// 1 byte grayscale and 4 byte rgba pixels
+BENCHMARK_TEMPLATE(BM_flip_array2d, unsigned char)->ArgsProduct({benchmark::CreateRange(64, 4096, 4), {1, 2, 3}});
+BENCHMARK_TEMPLATE(BM_flip_array2d, std::uint32_t)->ArgsProduct({benchmark::CreateRange(64, 4096, 4), {1, 2, 3}});
+
+// range(0): width and height, range(1): channels, range(2): 1 horizontal, 2 vertical, 3 both, range(3): 1 to use the job pool
+void BM_flip_image(benchmark::State &state)
+{
+    size_t size = state.range(0), channels = state.range(1);
+    bool horizontally = state.range(2) & 1, vertically = state.range(2) & 2;
+    utils::job_pool *pool = state.range(3) ? &utils::job_pool::shared() : nullptr;
+    std::vector<unsigned char> image(size * size * channels);
+
+    for (auto _ : state)
+    {
+        utils::flip_image(image.data(), size, size, channels, horizontally, vertically, pool);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * image.size());
+}
+BENCHMARK(BM_flip_image)->ArgsProduct({{4096}, {1, 3, 4}, {1, 2, 3}, {0, 1}})->UseRealTime();
+
+// range(0): width, the height is half of it, range(1): channels, range(2): 1 to use the job pool
+void BM_rotate_image90(benchmark::State &state)
+{
+    size_t width = state.range(0), height = width / 2, channels = state.range(1);
+    utils::job_pool *pool = state.range(2) ? &utils::job_pool::shared() : nullptr;
+    std::vector<unsigned char> image(width * height * channels), rotated(image.size());
+
+    for (auto _ : state)
+    {
+        utils::rotate_image90(image.data(), width, height, channels, rotated.data(), true, pool);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * image.size());
+}
+BENCHMARK(BM_rotate_image90)->ArgsProduct({{1024, 4096}, {1, 4}, {0, 1}})->UseRealTime();
+
+// range(0): channels, 3 for rgb to bgr and 4 for rgba to bgra, range(1): 1 to use the job pool
+void BM_swizzle_image(benchmark::State &state)
+{
+    constexpr size_t pixels = 2048 * 2048;
+    const size_t channels = state.range(0);
+    utils::job_pool *pool = state.range(1) ? &utils::job_pool::shared() : nullptr;
+    std::vector<unsigned char> image(pixels * channels);
+    const std::array<uint8_t, 4> order{2, 1, 0, 3};
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(utils::swizzle_image(image.data(), pixels, std::span(order.data(), channels), pool));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * image.size());
+}
+BENCHMARK(BM_swizzle_image)->ArgsProduct({{3, 4}, {0, 1}})->UseRealTime();
+
+// range(0): utils::block_format, range(1): 1 to use the job pool
+void BM_compress_image(benchmark::State &state)
+{
+    constexpr size_t size = 1024;
+    const auto format = (utils::block_format)state.range(0);
+    utils::job_pool *pool = state.range(1) ? &utils::job_pool::shared() : nullptr;
+
+    // gradients with some noise so the blocks are not flat
+    std::mt19937 rng(1);
+    std::vector<unsigned char> image(size * size * 4);
+    for (size_t p = 0; p < image.size(); ++p)
+        image[p] = (unsigned char)((p / 4 % size / 4 + p / 4 / size * (p % 4 + 1) / 8 + rng() % 16) & 0xFF);
+
+    std::vector<unsigned char> blocks(utils::compressed_size(format, size, size));
+
+    for (auto _ : state)
+    {
+        utils::compress_image(image.data(), size, size, 4, format, blocks.data(), pool);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_compress_image)->ArgsProduct({{0, 1, 2, 3}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_flip_array2d_fixed(benchmark::State &state)
+{
+    constexpr size_t size = 512;
+    std::vector<std::uint32_t> image(size * size);
+
+    for (auto _ : state)
+    {
+        utils::flip_array2d<size, size>(image.data(), false, true);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * image.size() * sizeof(std::uint32_t));
+}
+BENCHMARK(BM_flip_array2d_fixed);
+
+////
+// stb_true_type
+
+// range(0): text length
+void BM_get_string_width(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::stb_true_type::get_string_width(bench::font().font_info(), text.c_str(), 0, text.size(), 32));
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_get_string_width)->RangeMultiplier(4)->Range(16, 4096);
+
+// range(0): text length
+// the same width from the metrics and kerning tables made by load_file
+void BM_get_string_width_tables(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bench::font().get_string_width(text.c_str(), 0, text.size(), 32));
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_get_string_width_tables)->RangeMultiplier(4)->Range(16, 4096);
+
+// range(0): text length, range(1): 1 for utf-8 text, 0 for ascii
+void BM_utf8_decode(benchmark::State &state)
+{
+    auto text = state.range(1) ? bench::make_utf8_text(state.range(0)) : bench::make_text(state.range(0));
+    std::vector<uint32_t> codepoints;
+
+    for (auto _ : state)
+    {
+        codepoints.clear();
+        benchmark::DoNotOptimize(utils::utf8_decode(text, codepoints));
+        benchmark::DoNotOptimize(codepoints.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_utf8_decode)->ArgsProduct({{16, 256, 4096}, {0, 1}});
+
+// range(0): text length, range(1): 1 to cache the codepoints of the text first
+// the width of utf-8 text with and without the glyph index cache
+void BM_get_string_width_utf8(benchmark::State &state)
+{
+    utils::stb_true_type font;
+    if (!bench::font_loaded() || !font.load_file(bench::font_path.c_str()))
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_utf8_text(state.range(0));
+    if (state.range(1))
+        font.cache_codepoints(text);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(font.get_string_width(text.c_str(), 0, text.size(), 32));
+
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_get_string_width_utf8)->ArgsProduct({{256, 4096}, {0, 1}});
+
+// range(0): text length, range(1): font height
+void BM_make_bitmap(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bench::font().make_bitmap(512, 512, state.range(1), text.c_str()));
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_make_bitmap)->ArgsProduct({{16, 256, 1024}, {16, 48}});
+
+void BM_make_bitmap_fixed(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+    {
+        int width = 512, height = 512;
+        benchmark::DoNotOptimize(bench::font().make_bitmap_fixed(width, height, state.range(1), text.c_str()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_make_bitmap_fixed)->ArgsProduct({{16, 256, 1024}, {16, 48}});
+
+void BM_make_bitmap_line(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+    {
+        int width = 0, height = 0;
+        benchmark::DoNotOptimize(bench::font().make_bitmap_line(width, height, state.range(1), text.c_str()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_make_bitmap_line)->ArgsProduct({{16, 64, 256}, {16, 48}});
+
+void BM_make_bitmap_multiline(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+    {
+        int width = 512, height = 0;
+        benchmark::DoNotOptimize(bench::font().make_bitmap_multiline(width, height, state.range(1), text.c_str()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_make_bitmap_multiline)->ArgsProduct({{16, 256, 1024}, {16, 48}});
+
+void BM_make_bitmap_fit(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    for (auto _ : state)
+    {
+        int font_height = 0;
+        benchmark::DoNotOptimize(bench::font().make_bitmap_fit(512, 512, font_height, text.c_str()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_make_bitmap_fit)->Arg(16)->Arg(256)->Arg(1024);
+
+// range(0): text length, range(1): 1 to append to the previous layout, 0 to lay out a new text each time
+// appending a word to a paragraph, ex: typing, only breaks the last lines again
+void BM_text_layout_append(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    utils::text_layout layout(bench::font());
+    size_t broken = 0;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        if (!state.range(1))
+            layout = utils::text_layout(bench::font());
+        text += " word";
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(layout.layout(text, 16, 256.0f).data());
+        broken += layout.broken();
+    }
+
+    state.counters["broken lines"] = benchmark::Counter((double)broken, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_text_layout_append)->ArgsProduct({{256, 4096}, {0, 1}});
+
+// range(0): text length
+void BM_text_layout_fit(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    utils::text_layout layout(bench::font());
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(layout.fit(text, 512.0f, 512.0f));
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_text_layout_fit)->Arg(16)->Arg(256)->Arg(1024);
+
+// range(0): 1 to draw into one page, 0 for a bitmap each, range(1): 1 to use the job pool
+// the labels of a localized ui drawn at startup
+void BM_make_bitmaps(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    // 256 labels of one to four words, a quarter of them wrapped in a box
+    std::vector<std::string> labels;
+    std::vector<utils::stb_true_type::text_job> jobs;
+    for (size_t i = 0; i < 256; ++i)
+    {
+        const size_t offset = i * 7 % (bench::sample_utf8_text.size() - 40);
+        labels.emplace_back(bench::sample_utf8_text.substr(offset, 8 + i % 4 * 8));
+    }
+    for (size_t i = 0; i < labels.size(); ++i)
+        jobs.push_back({labels[i], 16 + (int)(i % 3) * 8, i % 4 == 0 ? 96 : 0, 0});
+
+    // cut codepoints in the labels only decode to the replacement codepoint
+    for (const auto &label : labels)
+        bench::font().cache_codepoints(label);
+
+    utils::job_pool *pool = state.range(1) ? &utils::job_pool::shared() : nullptr;
+    std::vector<unsigned char> page(2048 * 2048);
+
+    for (auto _ : state)
+    {
+        if (state.range(0))
+            benchmark::DoNotOptimize(bench::font().make_bitmaps(jobs, page, 2048, pool));
+        else
+            benchmark::DoNotOptimize(bench::font().make_bitmaps(jobs, pool));
+    }
+
+    state.SetItemsProcessed(state.iterations() * jobs.size());
+}
+BENCHMARK(BM_make_bitmaps)->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// range(0): text length, range(1): 1 for text_surface, 0 to draw the whole bitmap with make_bitmap
+// one digit of a label changes each iteration, ex: a frame time readout
+void BM_text_surface_update(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+    for (size_t i = 32; i < text.size(); i += 32)
+        text[i] = '\n';
+
+    const size_t digit = text.size() / 2;
+
+    utils::text_surface surface(bench::font(), 512, 512, 16);
+    (void)surface.update(text);
+    surface.clear_dirty();
+
+    size_t pixels = 0;
+    char c = '0';
+
+    for (auto _ : state)
+    {
+        text[digit] = c;
+        c = c == '9' ? '0' : c + 1;
+
+        if (state.range(1))
+        {
+            benchmark::DoNotOptimize(surface.update(text));
+            for (const auto &r : surface.dirty())
+                pixels += (size_t)r.width * r.height;
+            surface.clear_dirty();
+        }
+        else
+        {
+            benchmark::DoNotOptimize(bench::font().make_bitmap(512, 512, 16, text.c_str()));
+            pixels += 512 * 512;
+        }
+    }
+
+    state.counters["uploaded pixels"] = benchmark::Counter((double)pixels, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_text_surface_update)->ArgsProduct({{16, 256, 1024}, {0, 1}});
+
+// range(0): text length, range(1): font height
+// the glyphs are in the atlas after the first iteration so this is the per frame cost of redrawn text
+void BM_glyph_atlas_layout(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    auto text = bench::make_text(state.range(0));
+
+    utils::glyph_atlas atlas(bench::font());
+    std::vector<utils::glyph_quad> quads;
+    quads.reserve(text.size());
+
+    for (auto _ : state)
+    {
+        quads.clear();
+        benchmark::DoNotOptimize(atlas.layout(text, state.range(1), glm::vec2{0.0f}, glm::u8vec4{255}, quads));
+        benchmark::DoNotOptimize(quads.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_glyph_atlas_layout)->ArgsProduct({{16, 256, 1024}, {16, 48}});
+
+// range(0): 1 for distance fields, range(1): 1 to use the job pool
+// makes the printable ascii glyphs of an empty atlas, the startup cost of a font
+void BM_glyph_atlas_prepare(benchmark::State &state)
+{
+    if (!bench::font_loaded())
+    {
+        state.SkipWithError("font not loaded, pass --font");
+        return;
+    }
+
+    std::string text;
+    for (char c = 32; c < 127; ++c)
+        text += c;
+
+    utils::job_pool *pool = state.range(1) ? &utils::job_pool::shared() : nullptr;
+
+    for (auto _ : state)
+    {
+        utils::glyph_atlas atlas = state.range(0) ? utils::glyph_atlas(bench::font(), utils::sdf_settings{}, 512, 512) : utils::glyph_atlas(bench::font(), 512, 512);
+        benchmark::DoNotOptimize(atlas.prepare(text, 48, pool));
+    }
+
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_glyph_atlas_prepare)->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+////
+// files
+
+// range(0): file size in bytes
+void BM_read_file_sync(benchmark::State &state)
+{
+    auto path = bench::make_file("text", state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::read_file_sync(path.c_str()));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_file_sync)->RangeMultiplier(16)->Range(1 << 10, 1 << 24);
+
+void BM_read_file_bytes_sync(benchmark::State &state)
+{
+    auto path = bench::make_file("bytes", state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::read_file_bytes_sync(path.c_str()));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_file_bytes_sync)->RangeMultiplier(16)->Range(1 << 10, 1 << 24);
+
+void BM_read_file_async(benchmark::State &state)
+{
+    auto path = bench::make_file("text", state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::read_file_async(path.c_str()).get());
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+// the read happens on another thread so the wall time is what matters
+BENCHMARK(BM_read_file_async)->RangeMultiplier(16)->Range(1 << 10, 1 << 24)->UseRealTime();
+
+// range(0): decode on the job pool, range(1): keep the freed buffers in the image_buffer_pool
+void BM_load_files(benchmark::State &state)
+{
+    constexpr size_t count = 32;
+    auto names = bench::make_images(count);
+
+    std::vector<const char *> paths;
+    for (const auto &name : names)
+        paths.push_back(name.c_str());
+
+    utils::job_pool *pool = state.range(0) ? &utils::job_pool::shared() : nullptr;
+    utils::image_buffer_pool::set_budget(state.range(1) ? size_t{64} << 20 : 0);
+
+    const auto before = utils::image_buffer_pool::stats();
+    for (auto _ : state)
+    {
+        std::vector<utils::stb_image> images(count);
+        benchmark::DoNotOptimize(utils::stb_image::load_files(images, paths, false, pool, 4));
+    }
+
+    // the pooled buffers reused and allocated per load
+    const auto after = utils::image_buffer_pool::stats();
+    state.counters["reused"] = benchmark::Counter((double)(after.reused - before.reused) / count, benchmark::Counter::kAvgIterations);
+    state.counters["allocated"] = benchmark::Counter((double)(after.allocated - before.allocated) / count, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * count);
+
+    utils::image_buffer_pool::set_budget(size_t{64} << 20);
+}
+BENCHMARK(BM_load_files)->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// range(0): rows
+void BM_read_csv_struct_sync(benchmark::State &state)
+{
+    struct row
+    {
+        std::string name;
+        int id;
+        double value;
+        float weight;
+    };
+
+    auto path = bench::make_csv(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto result = utils::read_csv_struct_sync<row>(path.c_str(), true, [](const std::vector<std::string> &fields){
+            return row{fields[0], std::stoi(fields[1]), std::stod(fields[2]), std::stof(fields[3])};
+        });
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_csv_struct_sync)->RangeMultiplier(10)->Range(10, 100'000);
+
+void BM_read_csv_tuple_sync(benchmark::State &state)
+{
+    auto path = bench::make_csv(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto result = utils::read_csv_tuple_sync<std::string, int, double, float>(path.c_str(), true, utils::strto);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_read_csv_tuple_sync)->RangeMultiplier(10)->Range(10, 100'000);
+
+////
+// random
+
+// range(0): random<>::type, range(1): length
+void BM_random_string(benchmark::State &state)
+{
+    utils::random<> rand;
+    auto type = (utils::random<>::type)state.range(0);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(rand(type, state.range(1)));
+
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_random_string)->ArgsProduct({
+    {(int)utils::random<>::type::BIN, (int)utils::random<>::type::DEC, (int)utils::random<>::type::HEX,
+     (int)utils::random<>::type::LETTERS, (int)utils::random<>::type::ALPHANUMERIC},
+    benchmark::CreateRange(8, 4096, 8)
+});
+
+////
+// geometry generators
+// the inputs go through DoNotOptimize so the generators run at runtime instead of being folded
+
+void BM_gen_tri_verts_2d(benchmark::State &state)
+{
+    glm::vec2 start{-0.5f}, end{0.5f};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(start);
+        benchmark::DoNotOptimize(utils::gen_tri_verts<2>(start, end));
+    }
+}
+BENCHMARK(BM_gen_tri_verts_2d);
+
+void BM_gen_tri_verts_3d(benchmark::State &state)
+{
+    glm::vec3 start{-0.5f}, end{0.5f};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(start);
+        benchmark::DoNotOptimize(utils::gen_tri_verts<3>(start, end));
+    }
+}
+BENCHMARK(BM_gen_tri_verts_3d);
+
+void BM_gen_rect_indices(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::gen_rect_indices());
+}
+BENCHMARK(BM_gen_rect_indices);
+
+void BM_gen_cube_verts(benchmark::State &state)
+{
+    glm::vec3 start{-0.5f}, end{0.5f};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(start);
+        benchmark::DoNotOptimize(utils::gen_cube_verts(start, end));
+    }
+}
+BENCHMARK(BM_gen_cube_verts);
+
+void BM_gen_cube_texcoords(benchmark::State &state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utils::gen_cube_texcoords());
+}
+BENCHMARK(BM_gen_cube_texcoords);
+
+void BM_gen_cube_texcoords_single_face(benchmark::State &state)
+{
+    glm::vec2 start{0.0f}, end{1.0f};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(start);
+        benchmark::DoNotOptimize(utils::gen_cube_texcoords_single_face(start, end));
+    }
+}
+BENCHMARK(BM_gen_cube_texcoords_single_face);
+
+void BM_gen_cube_normals(benchmark::State &state)
+{
+    glm::vec3 start{-0.5f}, end{0.5f};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(start);
+        benchmark::DoNotOptimize(utils::gen_cube_normals(start, end));
+    }
+}
+BENCHMARK(BM_gen_cube_normals);
+
+void BM_gen_cube_indexed_verts(benchmark::State &state)
+{
+    glm::vec3 start{-0.5f}, end{0.5f};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(start);
+        benchmark::DoNotOptimize(utils::gen_cube_indexed_verts(start, end));
+    }
+}
+BENCHMARK(BM_gen_cube_indexed_verts);
+
+////
+// mesh optimization
+// a grid of quads made for glDrawArrays with the triangles shuffled, the worst case for the vertex
+// cache. The acmr before and after is reported as a counter.
+
+// range(0): quads per side
+void BM_optimize_mesh(benchmark::State &state)
+{
+    size_t side = state.range(0);
+    std::vector<glm::vec3> grid;
+    grid.reserve(side * side * 6);
+    for (size_t y = 0; y < side; ++y)
+    {
+        for (size_t x = 0; x < side; ++x)
+        {
+            auto quad = utils::gen_rect_verts<3>(glm::vec3{(float)x, (float)y, 0.0f}, glm::vec3{(float)x + 1.0f, (float)y + 1.0f, 0.0f});
+            for (auto i : utils::gen_rect_indices())
+                grid.insert(grid.end(), {quad[i.x], quad[i.y], quad[i.z]});
+        }
+    }
+
+    std::vector<std::array<glm::vec3, 3>> triangles(grid.size() / 3);
+    std::memcpy(triangles.data(), grid.data(), grid.size() * sizeof(glm::vec3));
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937{1});
+    std::memcpy(grid.data(), triangles.data(), grid.size() * sizeof(glm::vec3));
+
+    utils::mesh_report report;
+    for (auto _ : state)
+    {
+        auto verts = grid;
+        std::vector<uint32_t> indices;
+        report = utils::optimize_mesh(verts, indices);
+        benchmark::DoNotOptimize(indices.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * report.triangles);
+    state.counters["acmr_before"] = report.acmr_before;
+    state.counters["acmr_after"] = report.acmr_after;
+    state.counters["vertices_after"] = report.vertices_after;
+}
+BENCHMARK(BM_optimize_mesh)->RangeMultiplier(4)->Range(16, 256);
+
+////
+// mesh loading
+// an obj grid parsed from memory, and the same mesh mapped from its binary cache
+
+// range(0): quads per side
+void BM_parse_obj(benchmark::State &state)
+{
+    auto obj = bench::make_obj_grid(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto m = utils::parse_obj(obj, false);
+        benchmark::DoNotOptimize(m.vertices.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * obj.size());
+}
+BENCHMARK(BM_parse_obj)->RangeMultiplier(4)->Range(16, 1024)->UseRealTime();
+
+// range(0): quads. Files over a megabyte are parsed in chunks, so the relative indices of the faces at
+// the start of a chunk point into the chunk before it
+void BM_parse_obj_relative(benchmark::State &state)
+{
+    const size_t quads = state.range(0);
+    auto obj = bench::make_obj_quads(quads);
+
+    for (auto _ : state)
+    {
+        auto m = utils::parse_obj(obj, false);
+        if (m.indices.size() != quads * 6)
+        {
+            state.SkipWithError("the relative indices were not resolved");
+            break;
+        }
+        benchmark::DoNotOptimize(m.vertices.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * obj.size());
+}
+BENCHMARK(BM_parse_obj_relative)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)->UseRealTime();
+
+// range(0): quads per side
+void BM_load_mesh_cached(benchmark::State &state)
+{
+    std::filesystem::create_directories(bench::temp_dir);
+    auto obj_path = (bench::temp_dir / ("grid_" + std::to_string(state.range(0)) + ".obj")).string();
+    auto cache_path = obj_path + ".wgm";
+
+    {
+        std::ofstream file(obj_path, std::ios::trunc);
+        file << bench::make_obj_grid(state.range(0));
+    }
+    std::filesystem::remove(cache_path);
+
+    // the first load writes the cache
+    (void)utils::load_mesh_cached(obj_path.c_str());
+
+    for (auto _ : state)
+    {
+        auto file = utils::load_mesh_cached(obj_path.c_str());
+
+        // touch every page like an upload would
+        uint32_t sum = 0;
+        for (size_t i = 0; i < file.index_count(); i += 1024)
+            sum += file.indices()[i];
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_load_mesh_cached)->RangeMultiplier(4)->Range(16, 1024);
+
+////
+// parametric meshes
+// a grid of range(0) x range(0) cells generated on the calling thread (range(1) = 0) or the shared job pool
+
+// range(0): cells per side, range(1): use the pool
+void BM_gen_grid(benchmark::State &state)
+{
+    size_t cells = state.range(0);
+    std::vector<utils::mesh_vertex> verts(utils::grid_vertex_count(cells, cells));
+    std::vector<uint32_t> indices(utils::grid_index_count(cells, cells));
+    utils::job_pool *pool = state.range(1) != 0 ? &utils::job_pool::shared() : nullptr;
+
+    for (auto _ : state)
+    {
+        (void)utils::gen_grid(cells, cells, glm::vec2{1.0f}, verts, indices, pool);
+        benchmark::DoNotOptimize(verts.data());
+        benchmark::DoNotOptimize(indices.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * verts.size());
+    state.SetBytesProcessed(state.iterations() * (verts.size() * sizeof(utils::mesh_vertex) + indices.size() * sizeof(uint32_t)));
+}
+BENCHMARK(BM_gen_grid)->ArgsProduct({{256, 1024, 4096}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// range(0): frequency
+void BM_gen_icosphere(benchmark::State &state)
+{
+    size_t frequency = state.range(0);
+    std::vector<utils::mesh_vertex> verts(utils::icosphere_vertex_count(frequency));
+    std::vector<uint32_t> indices(utils::icosphere_index_count(frequency));
+
+    for (auto _ : state)
+    {
+        (void)utils::gen_icosphere(0.5f, frequency, verts, indices);
+        benchmark::DoNotOptimize(verts.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * verts.size());
+}
+BENCHMARK(BM_gen_icosphere)->RangeMultiplier(4)->Range(4, 256);
+
+////
+// terrain
+// the vertices of one terrain chunk of 64 x 64 cells from a noise heightmap at each lod, what a terrain
+// update generates for each chunk it streams in
+
+// range(0): lod
+void BM_gen_terrain_chunk(benchmark::State &state)
+{
+    constexpr size_t cells = 64;
+    constexpr int samples = 257;
+    size_t lod = state.range(0);
+
+    std::vector<float> heights(samples * samples);
+    std::mt19937 rng{1};
+    for (auto &h : heights)
+        h = std::uniform_real_distribution<float>{0.0f, 64.0f}(rng);
+    utils::heightmap map(samples, samples, std::move(heights));
+
+    std::vector<utils::mesh_vertex> verts(utils::terrain_chunk_vertex_count(cells, lod));
+
+    for (auto _ : state)
+    {
+        (void)utils::gen_terrain_chunk(map, cells, cells, cells, lod, 1.0f, verts);
+        benchmark::DoNotOptimize(verts.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * verts.size());
+    state.SetBytesProcessed(state.iterations() * verts.size() * sizeof(utils::mesh_vertex));
+}
+BENCHMARK(BM_gen_terrain_chunk)->DenseRange(0, 5);
+
+////
+// vertex compression
+// the batch packers over a mesh's worth of components, f16c and sse4.1 are used when the build targets them
+
+// range(0): floats
+void BM_pack_half(benchmark::State &state)
+{
+    std::vector<float> values(state.range(0));
+    std::vector<uint16_t> out(values.size());
+    std::mt19937 rng{1};
+    for (auto &v : values)
+        v = std::uniform_real_distribution<float>{-100.0f, 100.0f}(rng);
+
+    for (auto _ : state)
+    {
+        utils::pack_half(values.data(), out.data(), values.size());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * values.size());
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(float));
+}
+BENCHMARK(BM_pack_half)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+// range(0): floats
+void BM_pack_unorm16(benchmark::State &state)
+{
+    std::vector<float> values(state.range(0));
+    std::vector<uint16_t> out(values.size());
+    std::mt19937 rng{1};
+    for (auto &v : values)
+        v = std::uniform_real_distribution<float>{0.0f, 1.0f}(rng);
+
+    for (auto _ : state)
+    {
+        utils::pack_unorm16(values.data(), out.data(), values.size());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * values.size());
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(float));
+}
+BENCHMARK(BM_pack_unorm16)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+////
+// offset allocator
+// the cpu side of a buffer arena, mesh sized allocations churned at random in a 64 MiB range
+
+// range(0): live allocations
+void BM_offset_allocator(benchmark::State &state)
+{
+    size_t count = state.range(0);
+    utils::offset_allocator allocator(64 << 20);
+    std::vector<utils::offset_allocator::allocation> live(count);
+    std::mt19937 rng{1};
+
+    for (auto &alloc : live)
+        alloc = allocator.allocate(256 + rng() % 4096, 32);
+
+    for (auto _ : state)
+    {
+        auto &alloc = live[rng() % count];
+        allocator.free(alloc);
+        alloc = allocator.allocate(256 + rng() % 4096, 32);
+        benchmark::DoNotOptimize(alloc);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["largest_free"] = allocator.largest_free();
+    state.counters["free"] = allocator.free_size();
+}
+BENCHMARK(BM_offset_allocator)->RangeMultiplier(10)->Range(100, 10'000);
+
+////
+// 2d coords vs pseudo-2d coords in 3d (readme todo 1)
+// generates a batch of rects and moves them the way a sprite batch would every frame. The 3d
+// version carries a z of 0 which costs 50% more memory but matches what the shaders expect.
+
+// range(0): rects
+template <size_t Dimensions>
+void BM_rect_batch(benchmark::State &state)
+{
+    using vec = glm::vec<Dimensions, float>;
+
+    size_t rects = state.range(0);
+    std::vector<vec> verts(rects * 4);
+    vec offset{0.001f};
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < rects; ++i)
+        {
+            vec start{(float)i};
+            auto rect = utils::gen_rect_verts<Dimensions>(start, start + vec{1.0f});
+            std::copy(rect.begin(), rect.end(), verts.begin() + i * 4);
+        }
+
+        for (auto &vert : verts)
+            vert += offset;
+
+        benchmark::DoNotOptimize(verts.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * rects);
+    state.SetBytesProcessed(state.iterations() * verts.size() * sizeof(vec));
+}
+BENCHMARK_TEMPLATE(BM_rect_batch, 2)->RangeMultiplier(16)->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_rect_batch, 3)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+
+    // google benchmark removes its own flags
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+
+        if (arg == "--font" && i + 1 < argc)
+            bench::font_path = argv[++i];
+        else
+        {
+            std::cout << "[bench] Error: Unknown argument " << arg << ".\n";
+            return 2;
+        }
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -16,6 +16,8 @@
 // #include "tests/3. moving around cubes/moving_around_cubes.hpp"
 // #include "tests/4. materials/materials.hpp"
 #include "tests/5. lights/lights.hpp"
+// #include "tests/6. stress/stress.hpp"
+// #include "tests/7. terrain/terrain.hpp"
 
 int main()
 {
@@ -23,6 +25,22 @@ int main()
     // wrap_tests::create_textured_rect();
     // wrap_tests::create_moving_around_cubes();
     // wrap_tests::create_materials();
+    // wrap_tests::create_stress<wrap_g::cube>({ .objects = 10000, .textures = 4, .programs = 2, .lights = 8 });
+    // wrap_tests::create_terrain();
+
+    // pass an input recorder to scenes 3-5 to record the camera input
+    // and load() the log later to replay the exact same run
+    // wrap_g::input_recorder input;
+    // input.start_recording();
+    // wrap_tests::create_lights({ .input = &input });
+    // (void)input.save("./tests/5. lights/input.wgil");
+
+    // wrap_g::input_recorder replay;
+    // if (replay.load("./tests/5. lights/input.wgil"))
+    //     wrap_tests::create_lights({ .input = &replay });
+
+    // * see bench/scenes.cpp to benchmark every scene headless
+
     wrap_tests::create_lights();
 
     return 0;
@@ -1,6 +1,22 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+////
+// Controls
+
+// whether the global operator new and delete should be replaced to count every heap allocation
+// with utils::alloc_tracker. Tracking still has to be turned on with alloc_tracker::enable
+// ! the replacements are defined in utils_impl.hpp so utils must only be included in one translation unit
+#ifndef UTILS_TRACK_ALLOCATIONS
+#define UTILS_TRACK_ALLOCATIONS false
+#endif
+
+// the lowest utils::logger level that is compiled in, messages below it cost nothing
+// 0 debug, 1 info, 2 warning, 3 error, 4 none
+#ifndef UTILS_LOG_LEVEL
+#define UTILS_LOG_LEVEL 0
+#endif
+
 // stl
 
 #include <fstream>
@@ -13,6 +29,20 @@
 #include <concepts>
 #include <future>
 #include <utility>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <source_location>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <bit>
 
 // glm
 #include <glm/glm.hpp>
@@ -30,13 +60,21 @@ namespace utils
     ////////
 
     class stb_image;
+    class image_buffer_pool;
     class stb_true_type;
+    class text_layout;
+    class glyph_atlas;
+    class text_surface;
 
     template <class Engine>
     class random;
 
     class timer;
     class metrics;
+    class alloc_tracker;
+    class alloc_site;
+    class logger;
+    class job_pool;
 
     ////////
     // concepts
@@ -78,9 +116,9 @@ namespace utils
     {
     private:
         unsigned char *m_data = nullptr;
-        int m_width;
-        int m_height;
-        int m_nr_channels;
+        int m_width = 0;
+        int m_height = 0;
+        int m_nr_channels = 0;
 
     public:
         /**
@@ -95,6 +133,18 @@ namespace utils
          */
         ~stb_image() noexcept;
 
+        stb_image(const stb_image &) = delete;
+        stb_image &operator=(const stb_image &) = delete;
+
+        stb_image(stb_image &&other) noexcept;
+        stb_image &operator=(stb_image &&other) noexcept;
+
+        /**
+         * @brief Free the pixels, back into the image_buffer_pool. Loading again does this first.
+         *
+         */
+        void reset() noexcept;
+
         [[nodiscard]] inline constexpr unsigned char *data() noexcept { return m_data; }
         [[nodiscard]] inline constexpr int width() const noexcept { return m_width; }
         [[nodiscard]] inline constexpr int height() const noexcept { return m_height; }
@@ -111,26 +161,204 @@ namespace utils
         [[nodiscard]] bool load_file(const char *path, bool vertical_flip = false) noexcept;
 
         /**
-         * @brief Load an image async.
-         * * Call future.get() or future.wait() before accessing any of the data variables.
+         * @brief Load an image async. The image is decoded into its own loader which the future returns, so
+         * nothing has to stay in place while it loads. Its data is null if loading failed.
          *
-         * @param path The path to the image to be loaded.
+         * @param path The path to the image to be loaded, which must outlive the load.
          * @param vertical_flip Whether the image should be flipped vertically.
-         * @return std::future<bool>.
+         * @return std::future<stb_image>.
+         */
+        [[nodiscard]] static std::future<stb_image> load_file_async(const char *path, bool vertical_flip = false) noexcept;
+
+        /**
+         * @brief Load many images on the job pool. At most max_concurrent are decoded at once so the memory
+         * held by the decoders stays bounded, and their buffers come from the image_buffer_pool.
+         * Ex: the textures of a level.
+         * * The flip is set per thread so this can run alongside other loads.
+         *
+         * @param images The loaders, one per path.
+         * @param paths The paths to the images.
+         * @param vertical_flip Whether the images should be flipped vertically.
+         * @param pool The pool to decode on, nullptr decodes one at a time on the calling thread.
+         * @param max_concurrent The most images decoded at once, 0 for one per thread of the pool.
+         * @return size_t The number of images loaded, the loaders of the others are left empty.
+         */
+        [[nodiscard]] static size_t load_files(std::span<stb_image> images, std::span<const char *const> paths, bool vertical_flip = false,
+                                               job_pool *pool = nullptr, size_t max_concurrent = 0) noexcept;
+    };
+
+    /**
+     * @brief Keeps the buffers stb_image decodes into when they are freed and gives them to the next
+     * decodes of a similar size, so loading many images does not keep going back to the allocator.
+     * stb_image allocates through it with STBI_MALLOC, STBI_REALLOC and STBI_FREE.
+     * Buffers are kept in power of two size buckets up to a budget, smaller ones go straight to malloc.
+     * * Safe to use from any thread.
+     */
+    class image_buffer_pool
+    {
+    public:
+        // buffers smaller than this are not pooled
+        static constexpr const size_t min_pooled = size_t{1} << 16;
+        // buffers larger than this are not pooled
+        static constexpr const size_t max_pooled = size_t{1} << 30;
+        // the buffers kept per bucket
+        static constexpr const size_t max_kept = 8;
+
+        struct counters
+        {
+            // buffers handed out from the pool
+            size_t reused = 0;
+            // buffers which had to be allocated
+            size_t allocated = 0;
+            // bytes kept in the pool right now
+            size_t kept_bytes = 0;
+        };
+
+    private:
+        static constexpr const size_t buckets = std::bit_width(max_pooled) - std::bit_width(min_pooled) + 1;
+
+        static std::mutex s_mutex;
+        static std::array<std::array<void *, max_kept>, buckets> s_kept;
+        static std::array<size_t, buckets> s_counts;
+        static size_t s_budget;
+        static counters s_counters;
+
+        // a kept buffer of the bucket, nullptr if there are none
+        [[nodiscard]] static void *take(size_t bucket, size_t capacity) noexcept;
+
+    public:
+        /**
+         * @brief Set the most bytes kept in the pool, buffers freed past it go back to the allocator.
+         * Default is 64 MiB.
+         *
+         * @param bytes The budget.
+         */
+        static void set_budget(size_t bytes) noexcept;
+
+        /**
+         * @brief Free every buffer kept in the pool. Ex: once the loading screen is done.
+         *
          */
-        [[nodiscard]] std::future<bool> load_file_async(const char *path, bool vertical_flip = false) noexcept;
+        static void trim() noexcept;
+
+        [[nodiscard]] static counters stats() noexcept;
+
+        // the stb allocation functions
+        [[nodiscard]] static void *allocate(size_t size) noexcept;
+        [[nodiscard]] static void *reallocate(void *ptr, size_t size) noexcept;
+        static void release(void *ptr) noexcept;
     };
 
+    ////
+    // utf-8
+
+    // returned for bytes which are not valid utf-8
+    constexpr const uint32_t replacement_codepoint = 0xFFFD;
+
+    /**
+     * @brief The length of the run of ascii bytes at the start of a text, 16 bytes at a time with sse2.
+     *
+     * @param text The text.
+     * @param size The size of the text in bytes.
+     * @return size_t The index of the first byte which is not ascii, size if there is none.
+     */
+    [[nodiscard]] size_t utf8_ascii_run(const char *text, size_t size) noexcept;
+
+    /**
+     * @brief Decode the codepoint at a byte of a utf-8 text. Overlong encodings, surrogates, codepoints past
+     * U+10FFFF and cut sequences decode to replacement_codepoint and skip only the bytes they use.
+     *
+     * @param text The text.
+     * @param i The byte the codepoint starts at, moved past it.
+     * @return uint32_t The codepoint.
+     */
+    [[nodiscard]] uint32_t utf8_next(std::string_view text, size_t &i) noexcept;
+
+    /**
+     * @brief Decode a utf-8 text. The runs of ascii are found and widened 16 bytes at a time with sse2 so
+     * mostly ascii text costs little more than a copy.
+     *
+     * @param text The text.
+     * @param out The codepoints are appended to it.
+     * @return size_t The number of codepoints appended.
+     */
+    size_t utf8_decode(std::string_view text, std::vector<uint32_t> &out) noexcept;
+
     ////
     // stb true type
 
     class stb_true_type
     {
+    public:
+        // the metrics of a codepoint in font units, scale them with stbtt_ScaleForPixelHeight
+        struct glyph_metrics
+        {
+            // 0 if the font has no glyph for the codepoint
+            int glyph = 0;
+
+            int advance = 0;
+            int left_side_bearing = 0;
+
+            // the outline box, y up. Not set for glyphs without an outline, ex: a space
+            bool has_box = false;
+            int x0 = 0;
+            int y0 = 0;
+            int x1 = 0;
+            int y1 = 0;
+        };
+
+        // the codepoints whose metrics and kerning pairs load_file puts in tables, the rest are read from the font
+        static constexpr const uint32_t table_codepoints = 256;
+
+        // a text for make_bitmaps to draw
+        struct text_job
+        {
+            // utf-8, must stay valid until make_bitmaps returns
+            std::string_view text;
+            int font_height = 0;
+
+            // the box in pixels. The lines wrap at the width, 0 fits the width to the longest line and does
+            // not wrap. 0 height fits the height to the lines
+            int width = 0;
+            int height = 0;
+        };
+
+        // a text drawn by make_bitmaps, one byte of coverage per pixel
+        struct text_bitmap
+        {
+            // where the text is in the page, 0 for separate bitmaps
+            int x = 0;
+            int y = 0;
+
+            // 0 if the font height was invalid or it did not fit in the page
+            int width = 0;
+            int height = 0;
+
+            // width * height, empty when drawn into a page
+            std::vector<unsigned char> pixels;
+        };
+
     private:
         std::vector<unsigned char> m_font_file_data;
         stbtt_fontinfo m_font_info;
         bool loaded = false;
 
+        // indexed by codepoint
+        std::vector<glyph_metrics> m_metrics;
+
+        // the nonzero kerning of the pairs of table codepoints, open addressed by first << 16 | second
+        std::vector<uint32_t> m_kern_keys;
+        std::vector<int16_t> m_kern_values;
+        static constexpr const uint32_t empty_key = ~uint32_t{0};
+
+        // the metrics of the codepoints past the table codepoints added by cache_codepoints, open addressed by codepoint
+        std::vector<uint32_t> m_cached_keys;
+        std::vector<glyph_metrics> m_cached_metrics;
+        size_t m_cached_count = 0;
+
+        // the codepoints of the last text given to make_bitmap_*
+        std::vector<uint32_t> m_codepoints;
+
         std::vector<unsigned char> m_bitmap_data;
 
         // ? a garbage value
@@ -140,15 +368,80 @@ namespace utils
         // ! 4 is giving error fix it later
         static const int _bitmap_width_correcter = 8;
 
+        // decode a text into m_codepoints
+        const std::vector<uint32_t> &decode(const char *text) noexcept;
+
+        // lay a job out and get the size of its bitmap
+        [[nodiscard]] std::array<int, 2> measure(const text_job &job, text_layout &layout) const noexcept;
+
+        // clear a bitmap and draw the lines of a layout into it, the glyphs are rasterized into the scratch
+        void draw(const text_layout &layout, unsigned char *bitmap, int stride, int width, int height, std::vector<unsigned char> &scratch) const noexcept;
+
+        // whether a glyph drawn at the byte offset stays inside the bitmap
+        [[nodiscard]] bool glyph_fits(int byte_offset, int glyph_width, int glyph_height, int stride) const noexcept;
+
     public:
         inline unsigned char *data() noexcept { return m_bitmap_data.data(); }
+        [[nodiscard]] inline const stbtt_fontinfo *font_info() const noexcept { return &m_font_info; }
+        [[nodiscard]] inline constexpr bool valid() const noexcept { return loaded; }
 
         static float get_string_width(const stbtt_fontinfo *info, const char *str, size_t from, size_t to, int font_height, int bitmap_width = -1) noexcept;
 
+        /**
+         * @brief The same as the static get_string_width but walks the tables made by load_file instead of
+         * searching the font for every character.
+         *
+         */
+        [[nodiscard]] float get_string_width(const char *str, size_t from, size_t to, int font_height, int bitmap_width = -1) const noexcept;
+
+        /**
+         * @brief Load a font and make the metrics tables of the table codepoints and their kerning pairs.
+         *
+         * @param path The path to the font file.
+         * @return true The font was loaded.
+         */
         bool load_file(const char *path) noexcept;
+
+        /**
+         * @brief Keep the metrics, and so the glyph index, of every codepoint of a text past the table codepoints
+         * so they are not searched for in the font again. Ex: at startup with the localized text of the ui.
+         * * not thread safe, call it before the font is shared
+         *
+         * @param text The text, utf-8.
+         * @return size_t The number of codepoints added.
+         */
+        size_t cache_codepoints(std::string_view text) noexcept;
+
+        /**
+         * @brief The metrics of a codepoint, from the tables for the table codepoints and the cached codepoints.
+         *
+         * @param codepoint The codepoint.
+         * @return glyph_metrics In font units.
+         */
+        [[nodiscard]] glyph_metrics metrics(uint32_t codepoint) const noexcept;
+
+        /**
+         * @brief The kerning between two codepoints, from the table when both are table codepoints, otherwise
+         * between their glyphs.
+         *
+         * @return int In font units, add it to the advance of the first.
+         */
+        [[nodiscard]] int kern(uint32_t first, uint32_t second) const noexcept;
+
+        /**
+         * @brief The pixels a glyph covers at a scale, the same as stbtt_GetCodepointBitmapBoxSubpixel.
+         *
+         * @param m The metrics of the glyph.
+         * @param scale The scale. Ex: stbtt_ScaleForPixelHeight
+         * @param shift_x The subpixel shift.
+         * @return std::array<int, 4> x0, y0, x1 and y1, y down. All 0 without an outline.
+         */
+        [[nodiscard]] static std::array<int, 4> bitmap_box(const glyph_metrics &m, float scale, float shift_x = 0.0f) noexcept;
         
         ////
         // make bitmap
+
+        //? the texts are utf-8, their codepoints are decoded once per call
         
         //? make bitmap for specific width, height, font size and line gap ... even if full text does not appear in bitmap
         //? no error checking at [utils] level
@@ -166,139 +459,1190 @@ namespace utils
         
         //? make a bitmap within specific sizes and auto get the best font size to fit the entire text within the bitmap
         bool make_bitmap_fit(int bitmap_width, int bitmap_height, int& font_height, const char *text, float line_gap_scale = 1.0f) noexcept;
+
+        ////
+        // batches
+
+        /**
+         * @brief Draw a batch of texts into a bitmap each, split over a job pool. Ex: the labels of a ui at
+         * startup. The font is only read so the jobs run at once, each chunk of jobs with scratch memory of
+         * its own. The lines are broken the same as text_layout and the glyphs are placed at subpixel
+         * positions, overlapping glyphs keep the larger coverage.
+         * * cache_codepoints first for text past the table codepoints
+         *
+         * @param jobs The texts.
+         * @param pool The pool the texts are drawn on, nullptr draws them on the calling thread.
+         * @return std::vector<text_bitmap> A bitmap per job, in the same order.
+         */
+        [[nodiscard]] std::vector<text_bitmap> make_bitmaps(std::span<const text_job> jobs, job_pool *pool = nullptr) const noexcept;
+
+        /**
+         * @brief The same as make_bitmaps but the texts are packed into one page, tallest first on shelves,
+         * and drawn straight into it. Ex: one texture for every label of a ui.
+         *
+         * @param jobs The texts.
+         * @param page The pixels of the page, one byte each. Only the rects of the texts are written.
+         * @param page_width The width of the page in pixels, the height is page.size() / page_width.
+         * @param pool The pool the texts are drawn on, nullptr draws them on the calling thread.
+         * @return std::vector<text_bitmap> The rect of each job in the page, without pixels. 0 sized if it
+         * did not fit.
+         */
+        [[nodiscard]] std::vector<text_bitmap> make_bitmaps(std::span<const text_job> jobs, std::span<unsigned char> page, int page_width, job_pool *pool = nullptr) const noexcept;
     };
 
     ////
-    // random
+    // text layout
 
     /**
-     * @brief Create a random number generator.
+     * @brief Breaks text into lines no wider than a width, at spaces or inside words longer than a line, and
+     * keeps the result. The same text, font height and width again is a lookup in a small cache, and a text
+     * which only changed after some point, ex: appended to, is broken again from the line before the line
+     * with the first change. '\n' always ends a line. The widths use the advances and kerning of
+     * stb_true_type::metrics and kern, the same as glyph_atlas::layout.
+     * * the font must outlive the layout
      *
-     * @tparam Engine The generator engine to be used. Defaults to std mnist_rand.
      */
-    template <class Engine = std::minstd_rand>
-    class random
+    class text_layout
     {
     public:
-        using default_engine = Engine;
-        using result_type = default_engine::result_type;
-
-        enum class type
+        // a line of the text, the trailing spaces and the '\n' are not part of it
+        struct line
         {
-            BIN,
-            DEC,
-            HEX,
-            LETTERS,
-            ALPHANUMERIC,
-            // not sure what ALL implies
-            // ALL
+            uint32_t begin = 0;
+            uint32_t end = 0;
+
+            // in pixels
+            float width = 0.0f;
         };
 
+        // the most layouts besides the current one kept for reuse
+        static constexpr const size_t cache_size = 64;
+
     private:
-        std::random_device m_seed;
-        default_engine m_engine;
+        struct entry
+        {
+            std::string text;
+            int font_height = 0;
+            float width = 0.0f;
+            std::vector<line> lines;
+        };
+
+        const stb_true_type *m_font;
+
+        // the current layout
+        entry m_current;
+        // the lines broken by the last call to layout, 0 if it was found in the cache
+        size_t m_broken = 0;
+
+        // keyed by the hash of the text, font height and width
+        std::unordered_map<uint64_t, entry> m_cache;
+
+        // reused by fit
+        std::vector<line> m_scratch;
 
     public:
         /**
-         * @brief Construct a new random object.
+         * @brief Create an empty layout.
          *
+         * @param font A loaded font.
          */
-        random() noexcept;
+        text_layout(const stb_true_type &font) noexcept;
 
         /**
-         * @brief Generate a random number.
+         * @brief Break a text into lines, reusing the previous result or a cached one when possible.
          *
-         * @return result_type
+         * @param text The text, utf-8.
+         * @param font_height The font height in pixels.
+         * @param width The widest a line can be in pixels. A line has at least one character even if it is wider.
+         * @return const std::vector<line>& At least one line. Valid until the next call.
          */
-        result_type operator()() noexcept;
+        const std::vector<line> &layout(std::string_view text, int font_height, float width) noexcept;
 
         /**
-         * @brief Generate a random string.
+         * @brief The largest font height at which a text laid out to a width fits in a height, found with a
+         * binary search as the height of the lines grows with the font height. Does not change the layout.
          *
-         * @param string_type The type of string. Must be of type enum class 'type'. Ex: LETTERS only for letters.
-         * @param len The length of the string.
-         * @return std::string
+         * @param text The text.
+         * @param width The width of the box in pixels.
+         * @param height The height of the box in pixels.
+         * @return int The font height, 0 if not even 1 fits.
          */
-        std::string operator()(type string_type = type::ALPHANUMERIC, unsigned int len = 16) noexcept;
+        [[nodiscard]] int fit(std::string_view text, float width, float height) noexcept;
+
+        [[nodiscard]] inline const std::vector<line> &lines() const noexcept { return m_current.lines; }
+        [[nodiscard]] inline std::string_view text() const noexcept { return m_current.text; }
+        [[nodiscard]] inline int font_height() const noexcept { return m_current.font_height; }
+        [[nodiscard]] inline float width() const noexcept { return m_current.width; }
+        [[nodiscard]] inline size_t broken() const noexcept { return m_broken; }
+
+        // the distance between the tops of two lines in pixels
+        [[nodiscard]] float line_height(int font_height) const noexcept;
+
+        // the height of the lines from the top of the first to the bottom of the last in pixels
+        [[nodiscard]] float text_height(int font_height, size_t lines) const noexcept;
+
+        void clear_cache() noexcept;
+
+    private:
+        [[nodiscard]] static uint64_t hash(std::string_view text, int font_height, float width) noexcept;
+
+        // break the text from a byte at the start of a line to its end, appending the lines
+        void break_lines(std::string_view text, size_t from, int font_height, float width, std::vector<line> &out) const noexcept;
     };
 
     ////
-    // timer
+    // glyph atlas
 
-    class timer
+    /**
+     * @brief Where a glyph is in a glyph_atlas and how it is placed, in pixels.
+     *
+     */
+    struct atlas_glyph
     {
-    public:
-        using clock = std::chrono::high_resolution_clock;
+        // the rect in the atlas, empty for glyphs without pixels. Ex: a space
+        uint16_t x = 0;
+        uint16_t y = 0;
+        uint16_t width = 0;
+        uint16_t height = 0;
+
+        // from the pen on the baseline to the top left of the rect, y down
+        int16_t x_offset = 0;
+        int16_t y_offset = 0;
+
+        // how far the pen moves after the glyph, without kerning
+        float advance = 0.0f;
+    };
 
-        using y = std::chrono::year;
-        using m = std::chrono::month;
-        using d = std::chrono::day;
-        using hr = std::chrono::hours;
-        using min = std::chrono::minutes;
-        using s = std::chrono::seconds;
-        using ms = std::chrono::milliseconds;
-        using us = std::chrono::microseconds;
-        using ns = std::chrono::nanoseconds;
+    /**
+     * @brief One glyph of laid out text, drawn as one instanced quad. The same layout as
+     * wrap_g::glyph_format so a vector of them is uploaded as is.
+     *
+     */
+    struct glyph_quad
+    {
+        // x, y, width and height of the quad in pixels from the top left of the screen
+        glm::vec4 rect{0.0f};
 
-    private:
-        clock::time_point m_start;
-        const char *m_tag;
+        // x, y, width and height of the glyph in the atlas in pixels
+        glm::u16vec4 atlas_rect{0};
 
-    public:
-        timer(const char *tag = "") noexcept;
+        glm::u8vec4 color{255};
+    };
 
-        void start() noexcept;
+    /**
+     * @brief How the glyphs of a signed distance field glyph_atlas are made. Every font height is drawn
+     * from the fields made at one height, so they are made once per codepoint.
+     *
+     */
+    struct sdf_settings
+    {
+        // the font height in pixels the fields are made at. Larger keeps sharper corners at large sizes
+        int font_height = 48;
 
-        template <typename DurationUnit = ms>
-        requires is_one_of<DurationUnit, y, m, d, hr, min, s, ms, us, ns>
-        [[nodiscard]] int stop() noexcept;
+        // the distance in pixels the field covers outside and inside the outline, at font_height
+        int spread = 6;
     };
 
-    ////
-    // metrics
-
-    class metrics
+    /**
+     * @brief Rasterizes each (codepoint, font height) of a font once and packs it into one single channel
+     * image with a shelf packer, so text drawn every frame only looks its glyphs up. The rect of the atlas
+     * changed since the last take_dirty is kept so only it has to be uploaded. Ex: by wrap_g::text_renderer.
+     * With sdf_settings the glyphs are signed distance fields made with stbtt_GetCodepointSDF, 0.5 on the
+     * outline, and one glyph per codepoint serves every font height.
+     * The atlas can be saved to and loaded from a file so the glyphs are not made again at startup.
+     * * the font must outlive the atlas
+     *
+     */
+    class glyph_atlas
     {
+    public:
+        // "WGA1"
+        static constexpr uint32_t file_magic = 0x31414757;
+        static constexpr uint32_t file_version = 1;
+
+        // a rect of the atlas in pixels
+        struct rect
+        {
+            int x = 0;
+            int y = 0;
+            int width = 0;
+            int height = 0;
+
+            [[nodiscard]] inline constexpr bool empty() const noexcept { return width <= 0 || height <= 0; }
+        };
+
     private:
-        std::ostream& m_out;// console
+        // a row of glyphs as tall as the tallest glyph placed in it first
+        struct shelf
+        {
+            int y = 0;
+            int height = 0;
+            int used = 0;
+        };
 
-        // default tracking...
-        unsigned int m_frames = 0;
-        double m_total_time = 0.0;
-        double m_last_time = 0.0;
+        struct file_header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t sdf;
+            uint32_t sdf_font_height;
+            uint32_t sdf_spread;
+            uint32_t glyph_count;
+            uint32_t shelf_count;
+            uint32_t reserved;
+            // identifies the font so an atlas of another font is not used
+            uint64_t source_stamp;
+        };
+
+        // a glyph made but not packed yet
+        struct bitmap
+        {
+            uint64_t key = 0;
+            atlas_glyph glyph;
+            std::vector<unsigned char> pixels;
+        };
+
+        const stb_true_type *m_font;
+
+        int m_width;
+        int m_height;
+        std::vector<unsigned char> m_pixels;
+
+        // only used when m_sdf is set
+        sdf_settings m_sdf_settings;
+        bool m_sdf = false;
+
+        std::vector<shelf> m_shelves;
+        // keyed by font height << 32 | codepoint, the font height is 0 for distance fields
+        std::unordered_map<uint64_t, atlas_glyph> m_glyphs;
+
+        rect m_dirty;
+        bool m_full = false;
+
+        // the empty pixels around each glyph so filtering does not bleed into its neighbours
+        static constexpr const int padding = 1;
 
     public:
-        metrics(std::ostream& out = std::cout) noexcept;
+        /**
+         * @brief Create an empty atlas of coverage glyphs, one per font height.
+         *
+         * @param font A loaded font.
+         * @param width The width of the atlas in pixels, at most 65535.
+         * @param height The height of the atlas in pixels, at most 65535.
+         */
+        glyph_atlas(const stb_true_type &font, int width = 1024, int height = 1024) noexcept;
 
-        void start_tracking() noexcept;
-        void track_frame(double dt,  bool output = false) noexcept;
-        void finish_tracking() noexcept;
+        /**
+         * @brief Create an empty atlas of signed distance field glyphs, one for every font height.
+         *
+         * @param font A loaded font.
+         * @param sdf The height and spread the fields are made at.
+         * @param width The width of the atlas in pixels, at most 65535.
+         * @param height The height of the atlas in pixels, at most 65535.
+         */
+        glyph_atlas(const stb_true_type &font, const sdf_settings &sdf, int width = 1024, int height = 1024) noexcept;
 
-        void save(std::string_view filename, std::vector<std::string_view> extra_fields = {}) noexcept;
-    };
+        [[nodiscard]] inline const unsigned char *data() const noexcept { return m_pixels.data(); }
+        [[nodiscard]] inline constexpr int width() const noexcept { return m_width; }
+        [[nodiscard]] inline constexpr int height() const noexcept { return m_height; }
+        [[nodiscard]] inline size_t size() const noexcept { return m_glyphs.size(); }
 
-    ///
-    // functions
+        [[nodiscard]] inline constexpr bool sdf() const noexcept { return m_sdf; }
+        [[nodiscard]] inline constexpr const sdf_settings &get_sdf_settings() const noexcept { return m_sdf_settings; }
 
-    // just in case functions for each variant
+        // whether a glyph did not fit since the last clear
+        [[nodiscard]] inline constexpr bool full() const noexcept { return m_full; }
 
-    std::string read_file_sync(const char *path) noexcept;
-    std::future<std::string> read_file_async(const char *path) noexcept;
-    std::vector<unsigned char> read_file_bytes_sync(const char *path) noexcept;
-    std::future<std::vector<unsigned char>> read_file_bytes_async(const char *path) noexcept;
+        /**
+         * @brief Get a glyph, rasterizing and packing it the first time it is used.
+         *
+         * @param codepoint The codepoint.
+         * @param font_height The font height in pixels, ignored for distance fields.
+         * @return const atlas_glyph* nullptr if the glyph does not fit in the atlas. The rect and offsets of
+         * distance fields are at sdf_settings::font_height and include the spread.
+         */
+        [[nodiscard]] const atlas_glyph *find(uint32_t codepoint, int font_height) noexcept;
 
-    // ** NOTE: read_csv_tuple_sync vs read_csv_struct_sync work in different ways
-    // ** NOTE: the function provided in tuple version receives each seperate parameter
-    // ** NOTE: as a string and a reference to the tuple variable with the corresponding
-    // ** NOTE: data type. ** returns void, the reference should be set.
-    // ** NOTE: the function provided in struct version receives a vector containing
-    // ** NOTE: all the parameters as strings and should construct and return the type of struct
+        /**
+         * @brief Make every glyph of a text which the atlas does not have yet, split over a job pool, then
+         * pack them tallest first. Ex: at startup with the text of the ui so no frame has to rasterize.
+         *
+         * @param text The text, utf-8.
+         * @param font_height The font height in pixels, ignored for distance fields.
+         * @param pool The pool the glyphs are made on, nullptr makes them on the calling thread.
+         * @return size_t The number of glyphs added.
+         */
+        size_t prepare(std::string_view text, int font_height, job_pool *pool = nullptr) noexcept;
 
-    // * Does not work with read_csv_tuple_sync regular template function. Not sure why.
-    constexpr auto strto = []<typename data_t>(data_t& data, std::string str)
-    {
-        if constexpr (std::is_same_v<data_t, unsigned> || std::is_same_v<data_t, unsigned long>) {
-            data = std::stoul(str);
+        /**
+         * @brief Lay out a line or lines of text as one quad per visible glyph, rasterizing the glyphs the
+         * atlas does not have yet. '\n' starts a new line. Glyphs which do not fit in the atlas are skipped.
+         * Distance fields are scaled to the font height and not snapped to whole pixels.
+         *
+         * @param text The text, utf-8.
+         * @param font_height The font height in pixels.
+         * @param position The top left of the first line in pixels, y down.
+         * @param color The color of the quads.
+         * @param out The quads are appended to it.
+         * @return glm::vec2 The pen position after the last glyph, on the top of its line.
+         */
+        glm::vec2 layout(std::string_view text, int font_height, glm::vec2 position, glm::u8vec4 color, std::vector<glyph_quad> &out) noexcept;
+
+        /**
+         * @brief Lay out the lines of a text_layout, one under the other from the top left.
+         *
+         * @param lines The layout.
+         * @param position The top left of the first line in pixels, y down.
+         * @param color The color of the quads.
+         * @param out The quads are appended to it.
+         * @return glm::vec2 The pen position after the last glyph, on the top of its line.
+         */
+        glm::vec2 layout(const text_layout &lines, glm::vec2 position, glm::u8vec4 color, std::vector<glyph_quad> &out) noexcept;
+
+        /**
+         * @brief Get the rect rasterized into since the last call and reset it.
+         *
+         * @return rect Empty if nothing changed.
+         */
+        [[nodiscard]] rect take_dirty() noexcept;
+
+        /**
+         * @brief Remove every glyph. The next find rasterizes them again. Ex: when the atlas is full.
+         *
+         */
+        void clear() noexcept;
+
+        /**
+         * @brief Write the glyphs, the packing and the pixels to a file.
+         *
+         * @param path The path to the file, overwritten.
+         * @param source_stamp Identifies the font. Ex: mesh_file::source_stamp(font_path)
+         * @return true The file was written.
+         */
+        bool save(const char *path, uint64_t source_stamp = 0) const noexcept;
+
+        /**
+         * @brief Replace the glyphs with the ones saved in a file, the whole atlas is then dirty. Fails without
+         * changing the atlas if the file was saved from another font, size or mode.
+         *
+         * @param path The path to the file.
+         * @param source_stamp Identifies the font, must match the stamp it was saved with.
+         * @return true The glyphs were loaded.
+         */
+        bool load(const char *path, uint64_t source_stamp = 0) noexcept;
+
+    private:
+        [[nodiscard]] inline uint64_t key(uint32_t codepoint, int font_height) const noexcept
+        {
+            return (uint64_t)(uint32_t)(m_sdf ? 0 : font_height) << 32 | codepoint;
+        }
+
+        // make the pixels and metrics of a glyph, only reads the font so it is called from several threads
+        [[nodiscard]] bitmap rasterize(uint32_t codepoint, int font_height) const noexcept;
+
+        // pack a made glyph and copy its pixels in, nullptr if it does not fit
+        const atlas_glyph *place(const bitmap &b) noexcept;
+
+        // find room for a width x height rect on a shelf, false if there is none
+        [[nodiscard]] bool pack(int width, int height, int &x, int &y) noexcept;
+    };
+
+    ////
+    // text surface
+
+    /**
+     * @brief A fixed size single channel bitmap of one text which is drawn again only where it changed.
+     * Each update lays the text out into glyph cells, compares them with the cells of the previous text
+     * and clears and redraws only the rects of the cells which changed, so a label which changes a few
+     * characters at a time, ex: a frame time readout, costs about those characters instead of the whole
+     * bitmap like stb_true_type::make_bitmap. The changed rects are kept until clear_dirty so only they
+     * have to be uploaded. Ex: by wrap_g::text_label.
+     * Overlapping glyphs keep the larger coverage of each pixel so the result does not depend on the order
+     * the cells are redrawn in.
+     * * the font must outlive the surface
+     *
+     */
+    class text_surface
+    {
+    public:
+        using rect = glyph_atlas::rect;
+
+        // more changed rects than this are merged into one
+        static constexpr const size_t max_dirty_rects = 16;
+
+    private:
+        // a glyph placed on the surface, compared between updates
+        struct cell
+        {
+            uint32_t codepoint = 0;
+            // the top left of the glyph box in pixels
+            int x = 0;
+            int y = 0;
+
+            [[nodiscard]] inline constexpr bool operator==(const cell &) const noexcept = default;
+        };
+
+        // a glyph rasterized at the font height, the same at every whole pixel position
+        struct glyph
+        {
+            int width = 0;
+            int height = 0;
+            std::vector<unsigned char> pixels;
+        };
+
+        const stb_true_type *m_font;
+
+        int m_width;
+        int m_height;
+        int m_font_height;
+        std::vector<unsigned char> m_pixels;
+
+        std::string m_text;
+        std::vector<cell> m_cells;
+        // reused by update
+        std::vector<cell> m_next;
+        std::vector<rect> m_changed;
+
+        std::unordered_map<uint32_t, glyph> m_glyphs;
+
+        std::vector<rect> m_dirty;
+
+    public:
+        /**
+         * @brief Create an empty surface, all of it dirty so the first upload fills the texture.
+         *
+         * @param font A loaded font.
+         * @param width The width in pixels.
+         * @param height The height in pixels.
+         * @param font_height The font height in pixels.
+         */
+        text_surface(const stb_true_type &font, int width, int height, int font_height) noexcept;
+
+        [[nodiscard]] inline const unsigned char *data() const noexcept { return m_pixels.data(); }
+        [[nodiscard]] inline constexpr int width() const noexcept { return m_width; }
+        [[nodiscard]] inline constexpr int height() const noexcept { return m_height; }
+        [[nodiscard]] inline constexpr int font_height() const noexcept { return m_font_height; }
+        [[nodiscard]] inline std::string_view text() const noexcept { return m_text; }
+
+        // the rects changed since the last clear_dirty, they do not overlap
+        [[nodiscard]] inline const std::vector<rect> &dirty() const noexcept { return m_dirty; }
+        inline void clear_dirty() noexcept { m_dirty.clear(); }
+
+        /**
+         * @brief Draw a new text, only where its glyphs differ from the previous text. The glyphs outside the
+         * surface are cut off.
+         *
+         * @param text The text, utf-8. '\n' starts a new line.
+         * @return true Some pixels changed.
+         */
+        bool update(std::string_view text) noexcept;
+
+        /**
+         * @brief Change the font height and draw the whole text again.
+         *
+         * @param font_height The font height in pixels.
+         */
+        void set_font_height(int font_height) noexcept;
+
+    private:
+        // the glyph of a codepoint, rasterized the first time it is used
+        const glyph &find(uint32_t codepoint) noexcept;
+
+        // place the glyphs of the text
+        void layout(std::string_view text, std::vector<cell> &out) noexcept;
+
+        // clear a rect and draw the cells overlapping it
+        void redraw(const rect &r) noexcept;
+
+        // the rect of a cell cut to the surface
+        [[nodiscard]] rect bounds(const cell &c) noexcept;
+
+        // merge the rects which overlap or are close enough that one upload is cheaper than two
+        static void merge(std::vector<rect> &rects) noexcept;
+    };
+
+    ////
+    // random
+
+    /**
+     * @brief Create a random number generator.
+     *
+     * @tparam Engine The generator engine to be used. Defaults to std mnist_rand.
+     */
+    template <class Engine = std::minstd_rand>
+    class random
+    {
+    public:
+        using default_engine = Engine;
+        using result_type = default_engine::result_type;
+
+        enum class type
+        {
+            BIN,
+            DEC,
+            HEX,
+            LETTERS,
+            ALPHANUMERIC,
+            // not sure what ALL implies
+            // ALL
+        };
+
+    private:
+        std::random_device m_seed;
+        default_engine m_engine;
+
+    public:
+        /**
+         * @brief Construct a new random object.
+         *
+         */
+        random() noexcept;
+
+        /**
+         * @brief Generate a random number.
+         *
+         * @return result_type
+         */
+        result_type operator()() noexcept;
+
+        /**
+         * @brief Generate a random string.
+         *
+         * @param string_type The type of string. Must be of type enum class 'type'. Ex: LETTERS only for letters.
+         * @param len The length of the string.
+         * @return std::string
+         */
+        std::string operator()(type string_type = type::ALPHANUMERIC, unsigned int len = 16) noexcept;
+    };
+
+    ////
+    // timer
+
+    class timer
+    {
+    public:
+        using clock = std::chrono::high_resolution_clock;
+
+        using y = std::chrono::year;
+        using m = std::chrono::month;
+        using d = std::chrono::day;
+        using hr = std::chrono::hours;
+        using min = std::chrono::minutes;
+        using s = std::chrono::seconds;
+        using ms = std::chrono::milliseconds;
+        using us = std::chrono::microseconds;
+        using ns = std::chrono::nanoseconds;
+
+    private:
+        clock::time_point m_start;
+        const char *m_tag;
+
+    public:
+        timer(const char *tag = "") noexcept;
+
+        void start() noexcept;
+
+        template <typename DurationUnit = ms>
+        requires is_one_of<DurationUnit, y, m, d, hr, min, s, ms, us, ns>
+        [[nodiscard]] int stop() noexcept;
+
+        // the time elapsed in fractional milliseconds, for frames that take less than 1 ms
+        [[nodiscard]] double stop_ms() noexcept;
+    };
+
+    ////
+    // metrics
+
+    class metrics
+    {
+    public:
+        /**
+         * @brief A summary of a set of frame time samples in ms.
+         *
+         */
+        struct distribution
+        {
+            size_t count = 0;
+            double mean = 0.0;
+            double stddev = 0.0;
+            double min = 0.0;
+            double p50 = 0.0;
+            double p95 = 0.0;
+            double p99 = 0.0;
+            double max = 0.0;
+        };
+
+        /**
+         * @brief A count reported once per frame. Ex: the opengl debug messages of each frame.
+         *
+         */
+        struct counter
+        {
+            // ! must outlive the metrics. Ex: a string literal
+            const char *name = nullptr;
+            size_t last = 0;
+            size_t total = 0;
+            size_t max = 0;
+            // the frames with a count other than 0
+            unsigned int frames = 0;
+        };
+
+    private:
+        std::ostream& m_out;// console
+
+        // default tracking...
+        unsigned int m_frames = 0;
+        double m_total_time = 0.0;
+        double m_last_time = 0.0;
+
+        // gpu time per frame, tracked when a gpu timer is used
+        unsigned int m_gpu_frames = 0;
+        double m_total_gpu_time = 0.0;
+
+        // every frame time, only kept when asked for
+        bool m_keep_samples = false;
+        std::vector<double> m_samples;
+        std::vector<double> m_gpu_samples;
+
+        // heap allocations per frame, tracked when asked for and alloc_tracker is enabled
+        bool m_track_allocations = false;
+        size_t m_last_allocations = 0;
+        size_t m_last_allocated_bytes = 0;
+        size_t m_total_allocations = 0;
+        size_t m_total_allocated_bytes = 0;
+        size_t m_max_allocations = 0;
+        unsigned int m_allocating_frames = 0;
+        size_t m_alloc_mark = 0;
+        size_t m_alloc_bytes_mark = 0;
+
+        // per frame counts reported with track_count
+        std::vector<counter> m_counters;
+
+    public:
+        metrics(std::ostream& out = std::cout) noexcept;
+
+        [[nodiscard]] inline constexpr unsigned int frames() const noexcept { return m_frames; }
+        [[nodiscard]] inline const std::vector<double>& samples() const noexcept { return m_samples; }
+        [[nodiscard]] inline const std::vector<double>& gpu_samples() const noexcept { return m_gpu_samples; }
+
+        // keep every frame time so the distribution can be calculated, off by default
+        inline void keep_samples(bool keep = true) noexcept { m_keep_samples = keep; }
+
+        // count the heap allocations made between track_frame calls, off by default
+        // * needs UTILS_TRACK_ALLOCATIONS and alloc_tracker::enable
+        inline void track_allocations(bool track = true) noexcept { m_track_allocations = track; }
+
+        [[nodiscard]] inline constexpr size_t last_frame_allocations() const noexcept { return m_last_allocations; }
+        [[nodiscard]] inline constexpr size_t last_frame_allocated_bytes() const noexcept { return m_last_allocated_bytes; }
+        [[nodiscard]] inline constexpr unsigned int allocating_frames() const noexcept { return m_allocating_frames; }
+
+        void start_tracking() noexcept;
+        void track_frame(double dt,  bool output = false) noexcept;
+        void track_gpu_frame(double dt) noexcept;
+        void finish_tracking() noexcept;
+
+        /**
+         * @brief Report a count for the current frame. Counters are created the first time they are reported.
+         *
+         * @param name The name of the counter. ! must outlive the metrics. Ex: a string literal
+         * @param count The count this frame.
+         */
+        void track_count(const char *name, size_t count) noexcept;
+
+        // the counter with the name or nullptr if it was never reported
+        [[nodiscard]] const counter *find_counter(std::string_view name) const noexcept;
+        [[nodiscard]] inline const std::vector<counter>& counters() const noexcept { return m_counters; }
+
+        /**
+         * @brief Summarize frame time samples. Percentiles use the nearest rank.
+         *
+         * @param samples The samples. Taken by value as they are sorted.
+         * @return distribution
+         */
+        [[nodiscard]] static distribution summarize(std::vector<double> samples) noexcept;
+
+        // ! rows are only appended when at least one frame was tracked
+        void save(std::string_view filename, std::vector<std::string_view> extra_fields = {}) noexcept;
+    };
+
+    ////
+    // alloc tracker
+
+    /**
+     * @brief Counts heap allocations and bytes per thread and per call site. Needs UTILS_TRACK_ALLOCATIONS
+     * so operator new and delete report to it, then enable() to start counting. Give hot functions an
+     * alloc_site to see which of them allocate. metrics::track_allocations reports the counts per frame.
+     * * Nothing here allocates so it is safe to call from operator new.
+     */
+    class alloc_tracker
+    {
+    public:
+        // threads after this share the last slot
+        static constexpr const size_t max_threads = 64;
+        // sites after this are not captured
+        static constexpr const size_t max_sites = 128;
+
+        struct counters
+        {
+            size_t allocations = 0;
+            size_t bytes = 0;
+            size_t frees = 0;
+        };
+
+        struct thread_counters
+        {
+            std::thread::id id;
+            counters count;
+        };
+
+        struct site_counters
+        {
+            const char *name;
+            counters count;
+        };
+
+    private:
+        struct thread_slot
+        {
+            std::atomic<bool> used{false};
+            std::thread::id id;
+            std::atomic<size_t> allocations{0};
+            std::atomic<size_t> bytes{0};
+            std::atomic<size_t> frees{0};
+        };
+
+        struct site_slot
+        {
+            std::atomic<const char *> name{nullptr};
+            std::atomic<size_t> allocations{0};
+            std::atomic<size_t> bytes{0};
+        };
+
+        static inline std::atomic<bool> s_enabled{false};
+        static std::array<thread_slot, max_threads> s_threads;
+        static std::array<site_slot, max_sites> s_sites;
+
+        static inline thread_local thread_slot *t_slot = nullptr;
+        static inline thread_local const char *t_site = nullptr;
+
+        static thread_slot &slot() noexcept;
+
+    public:
+        // whether operator new and delete were replaced
+        static constexpr const bool available = UTILS_TRACK_ALLOCATIONS;
+
+        static inline void enable(bool enable = true) noexcept { s_enabled.store(enable, std::memory_order_relaxed); }
+        [[nodiscard]] static inline bool enabled() noexcept { return s_enabled.load(std::memory_order_relaxed); }
+
+        // called by operator new and delete. bytes is 0 for frees of unknown size
+        static void on_alloc(size_t bytes) noexcept;
+        static void on_free(size_t bytes) noexcept;
+
+        // the counts of every thread added up
+        [[nodiscard]] static counters totals() noexcept;
+
+        // the counts of the calling thread
+        [[nodiscard]] static counters this_thread() noexcept;
+
+        // ! these allocate, call them outside of the frames being measured
+        [[nodiscard]] static std::vector<thread_counters> threads() noexcept;
+        [[nodiscard]] static std::vector<site_counters> sites() noexcept;
+
+        friend class alloc_site;
+    };
+
+    /**
+     * @brief Tags the allocations made on this thread while it is alive with a call site name. Sites nest,
+     * the innermost one gets the allocation.
+     * Ex: utils::alloc_site site; at the top of a function tags it with the function name.
+     */
+    class alloc_site
+    {
+    private:
+        const char *m_prev;
+
+    public:
+        alloc_site(const char *name = std::source_location::current().function_name()) noexcept;
+        ~alloc_site() noexcept;
+
+        alloc_site(const alloc_site &) = delete;
+        alloc_site &operator=(const alloc_site &) = delete;
+    };
+
+    ////
+    // logger
+
+    enum class log_level : uint8_t
+    {
+        DEBUG,
+        INFO,
+        WARNING,
+        ERR,
+        NONE
+    };
+
+    /**
+     * @brief An asynchronous logger. Messages are pushed as small binary records (the format string pointer
+     * and the raw arguments) into a lock-free ring which any thread can write to, and are formatted and
+     * written to the output stream on a background thread. Repeated messages are collapsed into one line
+     * with a repeat count.
+     * Formats use {} for each argument. Ex: log.debug("[wrap_g] Debug: Created VAO #{}.\n", id);
+     * ! the format string must outlive the logger. Ex: a string literal. String arguments are copied.
+     * * when the ring is full debug and info messages are dropped and counted, warnings and errors wait.
+     */
+    class logger
+    {
+    public:
+        // the number of records in the ring, a power of 2
+        static constexpr const size_t capacity = 512;
+        // the max number of arguments of a message
+        static constexpr const size_t max_args = 8;
+        // the bytes available to the string arguments of a message, longer strings are cut
+        static constexpr const size_t max_text = 512;
+
+        // the lowest level compiled in, see UTILS_LOG_LEVEL
+        static constexpr const log_level compiled_level = (log_level)UTILS_LOG_LEVEL;
+
+    private:
+        struct argument
+        {
+            enum class kind : uint8_t
+            {
+                INT,
+                UINT,
+                FLOAT,
+                BOOL,
+                CHAR,
+                STRING
+            };
+
+            // where a copied string is in the record text
+            struct text_span
+            {
+                uint16_t offset;
+                uint16_t size;
+            };
+
+            kind type;
+            union
+            {
+                int64_t i;
+                uint64_t u;
+                double f;
+                bool b;
+                char c;
+                text_span s;
+            };
+        };
+
+        struct record
+        {
+            log_level level;
+            uint8_t arg_count;
+            uint16_t text_size;
+            const char *format;
+            std::array<argument, max_args> args;
+            std::array<char, max_text> text;
+        };
+
+        struct slot
+        {
+            // the ring position this slot can be written at, or that position + 1 once it is written
+            std::atomic<size_t> sequence;
+            record data;
+        };
+
+        std::ostream &m_out;
+        std::atomic<log_level> m_level = log_level::DEBUG;
+
+        std::unique_ptr<slot[]> m_ring;
+        // claimed by the writers
+        alignas(64) std::atomic<size_t> m_head = 0;
+        // read by the background thread
+        alignas(64) std::atomic<size_t> m_tail = 0;
+
+        std::atomic<size_t> m_dropped = 0;
+        std::atomic<bool> m_awake = true;
+        std::atomic<bool> m_stop = false;
+        std::thread m_thread;
+
+        // the last message written and how many times it was repeated since, only used by the background thread
+        record m_last{};
+        bool m_has_last = false;
+        size_t m_repeats = 0;
+
+        template <typename T>
+        static void encode(record &rec, argument &arg, const T &val) noexcept;
+
+        [[nodiscard]] bool push(const record &rec) noexcept;
+        void run() noexcept;
+        [[nodiscard]] bool drain() noexcept;
+        void print(const record &rec) noexcept;
+        void print_summary() noexcept;
+
+        [[nodiscard]] static bool same(const record &a, const record &b) noexcept;
+
+    public:
+        /**
+         * @brief Start the background thread writing to out. If the thread cannot be started messages are
+         * written immediately by the calling thread.
+         *
+         * @param out The stream the messages are written to.
+         */
+        logger(std::ostream &out = std::cout) noexcept;
+
+        /**
+         * @brief Write the remaining messages and stop the background thread.
+         *
+         */
+        ~logger() noexcept;
+
+        logger(const logger &) = delete;
+        logger &operator=(const logger &) = delete;
+
+        // messages below the level are ignored at runtime
+        inline void set_level(log_level level) noexcept { m_level.store(level, std::memory_order_relaxed); }
+        [[nodiscard]] inline log_level level() const noexcept { return m_level.load(std::memory_order_relaxed); }
+
+        // the debug and info messages dropped because the ring was full
+        [[nodiscard]] inline size_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Queue a message.
+         *
+         * @tparam Level The level of the message, checked against UTILS_LOG_LEVEL at compile time.
+         * @param format The format, each {} is replaced by the next argument.
+         * @param args Integers, floats, bools, chars, enums and strings.
+         */
+        template <log_level Level, typename... Ts>
+        void write(const char *format, const Ts &...args) noexcept;
+
+        template <typename... Ts>
+        inline void debug(const char *format, const Ts &...args) noexcept { write<log_level::DEBUG>(format, args...); }
+
+        template <typename... Ts>
+        inline void info(const char *format, const Ts &...args) noexcept { write<log_level::INFO>(format, args...); }
+
+        template <typename... Ts>
+        inline void warning(const char *format, const Ts &...args) noexcept { write<log_level::WARNING>(format, args...); }
+
+        template <typename... Ts>
+        inline void error(const char *format, const Ts &...args) noexcept { write<log_level::ERR>(format, args...); }
+
+        /**
+         * @brief Wait until every message queued before this call is written.
+         *
+         */
+        void flush() noexcept;
+    };
+
+    ////
+    // offset allocator
+
+    /**
+     * @brief A two level segregated fit (tlsf) allocator of offsets into a range it does not own. Ex: to
+     * sub-allocate a gpu buffer. Allocating and freeing take constant time and free ranges are merged
+     * with their free neighbours.
+     * The first level of bins is the power of two of the size and the second splits it into 8 bins so
+     * at most 1/8 of an allocation is wasted by rounding up to the bin.
+     *
+     */
+    class offset_allocator
+    {
+    public:
+        static constexpr uint32_t invalid = ~uint32_t{0};
+
+        struct allocation
+        {
+            uint32_t offset = invalid;
+            // the range in the allocator, used to free it
+            uint32_t node = invalid;
+
+            [[nodiscard]] inline constexpr bool valid() const noexcept { return offset != invalid; }
+        };
+
+    private:
+        static constexpr uint32_t second_level_log2 = 3;
+        static constexpr uint32_t second_level_count = 1 << second_level_log2;
+        static constexpr uint32_t first_level_count = 32;
+        static constexpr uint32_t bin_count = first_level_count * second_level_count;
+
+        // a used or free range
+        struct node
+        {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+            // the ranges before and after it
+            uint32_t prev = invalid;
+            uint32_t next = invalid;
+            // the free ranges in the same bin
+            uint32_t prev_free = invalid;
+            uint32_t next_free = invalid;
+            bool used = false;
+        };
+
+        uint32_t m_size;
+        uint32_t m_free_size;
+
+        std::vector<node> m_nodes;
+        // nodes which can be reused
+        std::vector<uint32_t> m_spare_nodes;
+
+        // a bit per first level with any free range and a bit per second level bin with any free range
+        uint32_t m_first_level_bits = 0;
+        std::array<uint32_t, first_level_count> m_second_level_bits{};
+        // the first free range of each bin
+        std::array<uint32_t, bin_count> m_bins;
+
+    public:
+        /**
+         * @brief Create an allocator with one free range.
+         *
+         * @param size The size of the range allocated from.
+         */
+        offset_allocator(uint32_t size) noexcept;
+
+        /**
+         * @brief Allocate a range.
+         *
+         * @param size The size of the range.
+         * @param alignment The offset is a multiple of it. Any value works. Ex: the stride of a vertex.
+         * @return allocation Invalid if no free range is large enough.
+         */
+        [[nodiscard]] allocation allocate(uint32_t size, uint32_t alignment = 1) noexcept;
+
+        /**
+         * @brief Free a range. Does nothing for invalid allocations.
+         *
+         * @param alloc The allocation.
+         */
+        void free(allocation alloc) noexcept;
+
+        /**
+         * @brief Free every range.
+         *
+         */
+        void reset() noexcept;
+
+        [[nodiscard]] inline constexpr uint32_t size() const noexcept { return m_size; }
+        [[nodiscard]] inline constexpr uint32_t free_size() const noexcept { return m_free_size; }
+        [[nodiscard]] inline constexpr uint32_t used_size() const noexcept { return m_size - m_free_size; }
+
+        /**
+         * @brief The largest free range. If less than free_size() the free space is fragmented.
+         *
+         * @return uint32_t
+         */
+        [[nodiscard]] uint32_t largest_free() const noexcept;
+
+    private:
+        // the bin a free range of the size is stored in, rounded down
+        [[nodiscard]] static uint32_t bin_of(uint32_t size) noexcept;
+
+        // the first bin at or above the one a size is stored in, rounded up so any range in it fits
+        [[nodiscard]] uint32_t find_bin(uint64_t size) const noexcept;
+
+        uint32_t create_node(uint32_t offset, uint32_t size) noexcept;
+        void release_node(uint32_t index) noexcept;
+
+        void insert_free(uint32_t index) noexcept;
+        void remove_free(uint32_t index) noexcept;
+    };
+
+    ////
+    // job pool
+
+    /**
+     * @brief A fixed set of worker threads which run jobs from one queue. parallel_for splits a range into
+     * chunks which the workers and the calling thread take until the range is done.
+     * Ex: utils::job_pool::shared().parallel_for(rows, 64, [&](size_t begin, size_t end){ ... });
+     *
+     */
+    class job_pool
+    {
+    private:
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<std::function<void()>> m_jobs;
+        bool m_stopping = false;
+
+    public:
+        /**
+         * @brief Start the workers.
+         *
+         * @param workers The number of worker threads. Default is one less than the hardware threads as the
+         * thread calling parallel_for works as well. With 0 every job runs on the thread submitting it.
+         */
+        job_pool(size_t workers = default_workers()) noexcept;
+
+        job_pool(const job_pool &) = delete;
+        job_pool &operator=(const job_pool &) = delete;
+
+        /**
+         * @brief Run the jobs left in the queue and stop the workers.
+         *
+         */
+        ~job_pool() noexcept;
+
+        [[nodiscard]] static size_t default_workers() noexcept;
+
+        /**
+         * @brief A pool shared by everything in the process, started on first use with default_workers().
+         *
+         * @return job_pool&
+         */
+        [[nodiscard]] static job_pool &shared() noexcept;
+
+        [[nodiscard]] inline size_t workers() const noexcept { return m_workers.size(); }
+
+        /**
+         * @brief Queue a job for the workers.
+         *
+         * @param job The job.
+         */
+        void submit(std::function<void()> job) noexcept;
+
+        /**
+         * @brief Call fn(begin, end) over [0, count) in chunks of grain on the workers and the calling thread.
+         * Returns when every chunk is done.
+         *
+         * @param count The size of the range.
+         * @param grain The size of each chunk. Ex: enough rows of a mesh for a few microseconds of work
+         * @param fn void(size_t begin, size_t end), called from several threads at once.
+         */
+        template <typename Fn>
+        void parallel_for(size_t count, size_t grain, Fn &&fn) noexcept;
+
+    private:
+        void work() noexcept;
+    };
+
+    ///
+    // functions
+
+    // just in case functions for each variant
+
+    std::string read_file_sync(const char *path) noexcept;
+    std::future<std::string> read_file_async(const char *path) noexcept;
+    std::vector<unsigned char> read_file_bytes_sync(const char *path) noexcept;
+    std::future<std::vector<unsigned char>> read_file_bytes_async(const char *path) noexcept;
+
+    // ** NOTE: read_csv_tuple_sync vs read_csv_struct_sync work in different ways
+    // ** NOTE: the function provided in tuple version receives each seperate parameter
+    // ** NOTE: as a string and a reference to the tuple variable with the corresponding
+    // ** NOTE: data type. ** returns void, the reference should be set.
+    // ** NOTE: the function provided in struct version receives a vector containing
+    // ** NOTE: all the parameters as strings and should construct and return the type of struct
+
+    // * Does not work with read_csv_tuple_sync regular template function. Not sure why.
+    constexpr auto strto = []<typename data_t>(data_t& data, std::string str)
+    {
+        if constexpr (std::is_same_v<data_t, unsigned> || std::is_same_v<data_t, unsigned long>) {
+            data = std::stoul(str);
         }
         if constexpr (std::is_same_v<data_t, unsigned long long>) {
             data = std::stoull(str);
@@ -340,6 +1684,35 @@ namespace utils
     requires std::is_invocable_r_v<Struct, Fn, const std::vector<std::string>&>
     [[nodiscard]] std::future<std::pair<std::vector<std::string>, std::vector<Struct>>>
     read_csv_struct_async(const char *path, bool has_headers, Fn&& fn) noexcept;
+
+    /**
+     * @brief The result of a one sided welch's t-test.
+     * p is the probability of seeing a difference this large if the sample mean was not larger
+     * than the baseline mean.
+     */
+    struct t_test_result
+    {
+        double t = 0.0;
+        double df = 0.0;
+        double p = 1.0;
+    };
+
+    /**
+     * @brief One sided welch's t-test of whether the sample mean is larger than the baseline mean.
+     * Does not assume equal variances or sample sizes.
+     * 
+     * @param sample The distribution being tested. Ex: the current frame times.
+     * @param baseline The distribution it is compared against.
+     * @return t_test_result 
+     */
+    [[nodiscard]] t_test_result welch_t_test(const metrics::distribution& sample, const metrics::distribution& baseline) noexcept;
+
+    /**
+     * @brief The memory currently used by the process (resident set / working set) in bytes.
+     * 
+     * @return size_t The size in bytes. 0 if the platform is not supported.
+     */
+    [[nodiscard]] size_t resident_memory() noexcept;
     
     template<typename DurationUnit = timer::ms, typename Fn>
     requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
@@ -365,9 +1738,119 @@ namespace utils
     requires std::swappable<T> && (Width > 0) && (Height > 0)
     void flip_array2d(T *ptr, bool horizontally = false, bool vertically = false) noexcept;
 
-    template<typename T>
-    requires std::swappable<T>
-    void flip_array2d(size_t width, size_t height, T *ptr, bool horizontally = false, bool vertically = false) noexcept;
+    /**
+     * @brief Flip a row major 2d array of any width and height in place. Trivially copyable elements are
+     * flipped as pixels by flip_image, the rest with std::swap_ranges and std::reverse.
+     *
+     * @param width The elements in a row.
+     * @param height The rows.
+     * @param ptr The first element.
+     * @param horizontally Mirror each row.
+     * @param vertically Reverse the order of the rows.
+     * @param pool The pool large arrays are split over, nullptr flips on the calling thread.
+     */
+    template<typename T>
+    requires std::swappable<T>
+    void flip_array2d(size_t width, size_t height, T *ptr, bool horizontally = false, bool vertically = false, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief Flip an image in place. Vertical flips swap rows in blocks with memcpy, horizontal flips
+     * reverse 16 bytes of 1, 3 or 4 channel pixels at a time with sse shuffles and other pixel sizes one at
+     * a time. Flipping both ways is a 180 degree rotation.
+     *
+     * @param pixels The rows of the image, tightly packed.
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @param channels The bytes per pixel.
+     * @param horizontally Mirror each row.
+     * @param vertically Reverse the order of the rows.
+     * @param pool The pool images over a megabyte are split over by rows, nullptr flips on the calling thread.
+     */
+    void flip_image(unsigned char *pixels, size_t width, size_t height, size_t channels, bool horizontally, bool vertically, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief Rotate an image by 90 degrees into another image, a tile at a time so the reads and the
+     * writes both stay in the cache. Use flip_image for 180 degrees.
+     *
+     * @param src The rows of the image, tightly packed.
+     * @param width The width of src in pixels.
+     * @param height The height of src in pixels.
+     * @param channels The bytes per pixel.
+     * @param dst The rotated image, height pixels wide and width pixels high. Must not overlap src.
+     * @param clockwise The direction of the rotation.
+     * @param pool The pool large images are split over by tiles, nullptr rotates on the calling thread.
+     */
+    void rotate_image90(const unsigned char *src, size_t width, size_t height, size_t channels, unsigned char *dst, bool clockwise = true, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief Reorder the channels of every pixel in place. Ex: {2, 1, 0, 3} turns rgba into bgra.
+     * 3 and 4 channel pixels are reordered 16 bytes at a time with sse shuffles.
+     *
+     * @param pixels The pixels, tightly packed.
+     * @param count The number of pixels.
+     * @param order The channel of the old pixel each channel of the new pixel is taken from, one per channel.
+     * @param pool The pool large images are split over, nullptr reorders on the calling thread.
+     * @return true The order was valid, at most 4 channels each below the number of channels.
+     */
+    bool swizzle_image(unsigned char *pixels, size_t count, std::span<const uint8_t> order, job_pool *pool = nullptr) noexcept;
+
+    // the block compressed texture formats of compress_image, each 4 x 4 block of pixels takes 8 or 16 bytes
+    enum class block_format : uint8_t
+    {
+        // rgb, 4 bits per pixel. Ex: a diffuse map
+        BC1,
+        // rgb like BC1 and alpha like BC4, 8 bits per pixel
+        BC3,
+        // one channel, 4 bits per pixel. Ex: a specular or height map
+        BC4,
+        // two channels like BC4, 8 bits per pixel. Ex: the x and y of a normal map
+        BC5
+    };
+
+    [[nodiscard]] inline constexpr size_t block_bytes(block_format format) noexcept
+    {
+        return format == block_format::BC1 || format == block_format::BC4 ? 8 : 16;
+    }
+
+    /**
+     * @brief The bytes of an image compressed by compress_image, the blocks of the last row and column
+     * cover the pixels past the edge as well.
+     *
+     * @param format The format.
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @return size_t
+     */
+    [[nodiscard]] size_t compressed_size(block_format format, size_t width, size_t height) noexcept;
+
+    /**
+     * @brief Compress an image into 4 x 4 pixel blocks for a compressed texture upload.
+     * BC1 colors are fit to the principal axis of each block and refined by least squares. BC4 channels and
+     * the BC3 alpha use the block range. The indices of the pixels are picked 4 (bc1) or 16 (bc4) at a time with sse2.
+     * * 1 and 2 channel images are read as grey and grey alpha for BC1 and BC3, like stb_image loads them.
+     * BC4 reads the first channel and BC5 the first two.
+     *
+     * @param pixels The rows of the image, tightly packed.
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @param channels The bytes per pixel, 1 to 4.
+     * @param format The format of the blocks.
+     * @param out compressed_size(format, width, height) bytes, the blocks in rows.
+     * @param pool The pool large images are split over by rows of blocks, nullptr compresses on the calling thread.
+     */
+    void compress_image(const unsigned char *pixels, size_t width, size_t height, size_t channels, block_format format, unsigned char *out, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief Halve an image with a 2 x 2 box filter. Ex: for the next mip level of a compressed texture.
+     *
+     * @param src The rows of the image, tightly packed.
+     * @param width The width of src in pixels.
+     * @param height The height of src in pixels.
+     * @param channels The bytes per pixel.
+     * @param dst The halved image, max(width / 2, 1) x max(height / 2, 1) pixels. Must not overlap src.
+     * @param pool The pool large images are split over by rows, nullptr halves on the calling thread.
+     */
+    void downsample_image(const unsigned char *src, size_t width, size_t height, size_t channels, unsigned char *dst, job_pool *pool = nullptr) noexcept;
 
     template <typename T>
     requires std::equality_comparable<T>
@@ -536,6 +2019,628 @@ namespace utils
      */
     constexpr std::array<glm::vec3, 36> gen_cube_normals(const glm::vec3& start, const glm::vec3& end) noexcept;
 
+    /**
+     * @brief Creates the 24 vertices of a cube, 4 per face, using the two points given.
+     * * NOTE: Needs an element array buffer with the indices from gen_cube_indices().
+     * The faces are in the same order as gen_cube_verts() so the indexed versions of the normals and
+     * texture coordinates line up with these vertices.
+     * 
+     * @param start the bottom left back point
+     * @param end the front right top point
+     * @return constexpr std::array<glm::vec3, 24> 
+     */
+    constexpr std::array<glm::vec3, 24> gen_cube_indexed_verts(const glm::vec3& start, const glm::vec3& end) noexcept;
+
+    /**
+     * @brief Creates the cubemap texture coordinates for the vertices from gen_cube_indexed_verts().
+     * See gen_cube_texcoords().
+     * 
+     * @return constexpr std::array<glm::vec2, 24> 
+     */
+    constexpr std::array<glm::vec2, 24> gen_cube_indexed_texcoords() noexcept;
+
+    /**
+     * @brief Creates the texture coordinates for the vertices from gen_cube_indexed_verts() when the same
+     * texture is used for all sides of the cube. See gen_cube_texcoords_single_face().
+     * 
+     * @param start The bottom left coordinate. Default is (0.0f, 0.0f).
+     * @param end The top right coordinate. Default is (1.0f, 1.0f).
+     * @return constexpr std::array<glm::vec2, 24> 
+     */
+    constexpr std::array<glm::vec2, 24> gen_cube_indexed_texcoords_single_face(const glm::vec2& start = glm::vec2{0.0f}, const glm::vec2& end = glm::vec2{1.0f}) noexcept;
+
+    /**
+     * @brief Creates the normals for the vertices from gen_cube_indexed_verts(). See gen_cube_normals().
+     * 
+     * @param start the bottom left back point
+     * @param end the front right top point
+     * @return constexpr std::array<glm::vec3, 24> 
+     */
+    constexpr std::array<glm::vec3, 24> gen_cube_indexed_normals(const glm::vec3& start, const glm::vec3& end) noexcept;
+
+    /**
+     * @brief Creates the indices for a cube, two triangles per face. Assuming verts were provided by
+     * gen_cube_indexed_verts(). Indices should be provided to the element array buffer.
+     * 
+     * @return constexpr std::array<glm::uvec3, 12> 
+     */
+    constexpr std::array<glm::uvec3, 12> gen_cube_indices() noexcept;
+
+    ////
+    // mesh optimization
+    // for meshes drawn with glDrawElements and GL_TRIANGLES. Vertices are compared byte by byte so
+    // vertex types must not have padding between their members. Ex: vertex_format::vertex_type
+
+    // the fifo post transform cache size assumed by the optimizations. Close to what most gpus have
+    constexpr size_t vertex_cache_size = 16;
+
+    /**
+     * @brief The result of optimize_mesh().
+     * ACMR is the average cache miss ratio, the vertex shader invocations per triangle. 0.5 is the best
+     * possible for a large grid and 3 is the worst.
+     *
+     */
+    struct mesh_report
+    {
+        size_t vertices_before = 0;
+        size_t vertices_after = 0;
+        size_t triangles = 0;
+        double acmr_before = 0.0;
+        double acmr_after = 0.0;
+    };
+
+    /**
+     * @brief The average cache miss ratio of drawing the indices with a fifo vertex cache.
+     * 
+     * @param indices Three indices per triangle.
+     * @param cache_size The number of vertices the cache holds.
+     * @return double The cache misses per triangle, 0 if there are no triangles.
+     */
+    [[nodiscard]] double acmr(const std::vector<uint32_t> &indices, size_t cache_size = vertex_cache_size) noexcept;
+
+    /**
+     * @brief Merge vertices which are exactly the same and point the indices at the kept copy.
+     * The kept vertices stay in the order they were first seen.
+     * 
+     * @tparam Vertex A trivially copyable vertex without padding.
+     * @param verts The vertices, shrunk to the unique ones.
+     * @param indices The indices, remapped. If empty every vertex is treated as its own index. Ex: for vertices made for glDrawArrays
+     * @return size_t The number of vertices removed.
+     */
+    template <typename Vertex>
+    requires std::is_trivially_copyable_v<Vertex>
+    size_t weld_vertices(std::vector<Vertex> &verts, std::vector<uint32_t> &indices) noexcept;
+
+    /**
+     * @brief Reorder the triangles so their vertices are reused while still in the post transform cache.
+     * Uses tipsify (Sander, Nehab and Barczak, Fast Triangle Reordering for Vertex Locality and Reduced
+     * Overdraw) which runs in linear time. The vertices are not touched.
+     * 
+     * @param indices Three indices per triangle, reordered in place.
+     * @param vertex_count The number of vertices the indices point into.
+     * @param cache_size The number of vertices the cache holds.
+     */
+    void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count, size_t cache_size = vertex_cache_size) noexcept;
+
+    /**
+     * @brief Reorder the vertices in the order the indices first use them so the vertex fetches walk the
+     * buffer forwards. Vertices which are not used by any index are removed.
+     * * NOTE: Run after optimize_vertex_cache(), this order depends on the triangle order.
+     * 
+     * @tparam Vertex Any copyable vertex.
+     * @param verts The vertices, reordered.
+     * @param indices The indices, remapped.
+     */
+    template <typename Vertex>
+    void optimize_vertex_fetch(std::vector<Vertex> &verts, std::vector<uint32_t> &indices) noexcept;
+
+    /**
+     * @brief Weld the vertices and reorder the triangles and vertices for the vertex cache and fetches.
+     * 
+     * @tparam Vertex A trivially copyable vertex without padding.
+     * @param verts The vertices.
+     * @param indices The indices. If empty every vertex is treated as its own index.
+     * @param cache_size The number of vertices the cache holds.
+     * @return mesh_report The vertex counts and ACMR before and after.
+     */
+    template <typename Vertex>
+    requires std::is_trivially_copyable_v<Vertex>
+    mesh_report optimize_mesh(std::vector<Vertex> &verts, std::vector<uint32_t> &indices, size_t cache_size = vertex_cache_size) noexcept;
+
+    ////
+    // vertex compression
+    // smaller encodings of vertex attributes which the gpu expands when the vertices are fetched.
+    // Ex: wrap_g::half_float, wrap_g::normalized and wrap_g::snorm_10_10_10_2 attributes
+
+    /**
+     * @brief Convert a float to a half float, rounded to the nearest even. Values too large become infinity.
+     * 
+     * @param value The float.
+     * @return constexpr uint16_t The bits of the half float.
+     */
+    [[nodiscard]] constexpr uint16_t pack_half(float value) noexcept;
+
+    /**
+     * @brief Convert a half float to a float.
+     * 
+     * @param bits The bits of the half float.
+     * @return constexpr float 
+     */
+    [[nodiscard]] constexpr float unpack_half(uint16_t bits) noexcept;
+
+    /**
+     * @brief Quantize a float in [0, 1] to an unsigned normalized 16 bit integer. Values outside are clamped.
+     * 
+     * @param value The float.
+     * @return constexpr uint16_t 
+     */
+    [[nodiscard]] constexpr uint16_t pack_unorm16(float value) noexcept;
+
+    /**
+     * @brief Quantize a float in [-1, 1] to a signed normalized 16 bit integer. Values outside are clamped.
+     * 
+     * @param value The float.
+     * @return constexpr int16_t 
+     */
+    [[nodiscard]] constexpr int16_t pack_snorm16(float value) noexcept;
+
+    /**
+     * @brief Pack a vector in [-1, 1] into 10 bits for x, y and z and 2 for w as signed normalized integers,
+     * the layout of GL_INT_2_10_10_10_REV. Ex: a unit normal in 4 bytes instead of 12.
+     * 
+     * @param value x, y and z.
+     * @param w The fourth component, only -1, 0 and 1 can be stored. Default is 0.
+     * @return constexpr uint32_t 
+     */
+    [[nodiscard]] constexpr uint32_t pack_snorm_10_10_10_2(const glm::vec3 &value, float w = 0.0f) noexcept;
+
+    /**
+     * @brief Map a unit vector onto the octahedron unfolded into [-1, 1]^2. Two components are enough to
+     * store a normal, ex: as two snorm16 in 4 bytes or two snorm8 in 2, and the error is spread evenly over
+     * the sphere. The shader decodes it with the same steps as unpack_octahedral().
+     * 
+     * @param normal The unit vector.
+     * @return constexpr glm::vec2 
+     */
+    [[nodiscard]] constexpr glm::vec2 pack_octahedral(const glm::vec3 &normal) noexcept;
+
+    /**
+     * @brief The unit vector of an octahedral encoding from pack_octahedral().
+     * 
+     * @param encoded The encoding.
+     * @return glm::vec3 
+     */
+    [[nodiscard]] glm::vec3 unpack_octahedral(const glm::vec2 &encoded) noexcept;
+
+    // batch versions for large meshes, vectorized with f16c and sse4.1 when the compiler targets them
+
+    /**
+     * @brief Convert floats to half floats. Ex: the components of a mesh's positions.
+     * 
+     * @param values The floats.
+     * @param out The half floats, can not overlap values.
+     * @param count The number of floats.
+     */
+    void pack_half(const float *values, uint16_t *out, size_t count) noexcept;
+
+    /**
+     * @brief Quantize floats in [0, 1] to unsigned normalized 16 bit integers. Ex: the components of a
+     * mesh's texture coordinates.
+     * 
+     * @param values The floats.
+     * @param out The integers, can not overlap values.
+     * @param count The number of floats.
+     */
+    void pack_unorm16(const float *values, uint16_t *out, size_t count) noexcept;
+
+    /**
+     * @brief Pack unit vectors with pack_snorm_10_10_10_2(). Ex: a mesh's normals.
+     * 
+     * @param values The vectors.
+     * @param out The packed vectors.
+     * @param count The number of vectors.
+     */
+    void pack_snorm_10_10_10_2(const glm::vec3 *values, uint32_t *out, size_t count) noexcept;
+
+    ////
+    // meshes
+
+    /**
+     * @brief A vertex of a loaded mesh. Laid out like wrap_g::mesh_format so an array of them can be uploaded
+     * as it is. Ex: vao.create_array_buffer(0, file.vertex_bytes(), file.vertices(), GL_MAP_READ_BIT)
+     *
+     */
+    struct mesh_vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texcoord;
+    };
+
+    /**
+     * @brief An indexed triangle mesh.
+     *
+     */
+    struct mesh
+    {
+        std::vector<mesh_vertex> vertices;
+        std::vector<uint32_t> indices;
+
+        [[nodiscard]] inline bool empty() const noexcept { return indices.empty(); }
+    };
+
+    /**
+     * @brief Parse the text of a wavefront obj file. Only the geometry is read (v, vt, vn and f), faces
+     * with more than 3 corners are split into a fan and faces without normals get the normal of the face.
+     * Large files are split at line ends and parsed on several threads.
+     * 
+     * @param text The obj text.
+     * @param optimize Whether to reorder the mesh with optimize_mesh(). The duplicate vertices are always welded.
+     * @return mesh Empty if the text has an error. Ex: an index out of range
+     */
+    [[nodiscard]] mesh parse_obj(std::string_view text, bool optimize = true) noexcept;
+
+    /**
+     * @brief Read and parse a wavefront obj file. See parse_obj().
+     * 
+     * @param path The path to the file.
+     * @param optimize Whether to reorder the mesh with optimize_mesh().
+     * @return mesh Empty if the file could not be read or parsed.
+     */
+    [[nodiscard]] mesh load_obj_sync(const char *path, bool optimize = true) noexcept;
+
+    /**
+     * @brief Write a mesh in the binary format read by mesh_file.
+     * 
+     * @param path The path to the file, overwritten.
+     * @param m The mesh.
+     * @param source_stamp Identifies what the mesh was made from. Ex: mesh_file::source_stamp(obj_path)
+     * @return true The file was written.
+     */
+    bool write_mesh_file(const char *path, const mesh &m, uint64_t source_stamp = 0) noexcept;
+
+    /**
+     * @brief A mesh in a binary format which is memory mapped instead of parsed. The file is a header and
+     * then the vertices and indices in the layout they are uploaded in, so loading costs a map and the
+     * page faults of the first upload.
+     * * the numbers are stored in the byte order of the machine that wrote the file
+     *
+     */
+    class mesh_file
+    {
+    public:
+        // "WGM1"
+        static constexpr uint32_t file_magic = 0x314d4757;
+        static constexpr uint32_t file_version = 1;
+
+        struct header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t vertex_count;
+            uint32_t index_count;
+            uint32_t vertex_stride;
+            uint32_t reserved;
+            // identifies what the mesh was made from so a stale cache is not used
+            uint64_t source_stamp;
+        };
+
+    private:
+        const unsigned char *m_data = nullptr;
+        size_t m_size = 0;
+        bool m_mapped = false;
+
+        // the data when it is not mapped. Ex: the cache could not be written
+        std::vector<unsigned char> m_owned;
+
+    public:
+        mesh_file() noexcept = default;
+
+        /**
+         * @brief Map a mesh file. Check valid() for errors.
+         * 
+         * @param path The path to the file.
+         */
+        mesh_file(const char *path) noexcept;
+
+        /**
+         * @brief A mesh file kept in memory.
+         * 
+         * @param bytes The contents of the file.
+         */
+        mesh_file(std::vector<unsigned char> &&bytes) noexcept;
+
+        mesh_file(const mesh_file &) = delete;
+        mesh_file &operator=(const mesh_file &) = delete;
+
+        mesh_file(mesh_file &&other) noexcept;
+        mesh_file &operator=(mesh_file &&other) noexcept;
+
+        ~mesh_file() noexcept;
+
+        /**
+         * @brief The stamp of a source file from its size and last write time. 0 if it does not exist.
+         * 
+         * @param path The path to the source file.
+         * @return uint64_t 
+         */
+        [[nodiscard]] static uint64_t source_stamp(const char *path) noexcept;
+
+        /**
+         * @brief The contents of a mesh file.
+         * 
+         * @param m The mesh.
+         * @param source_stamp Identifies what the mesh was made from.
+         * @return std::vector<unsigned char> 
+         */
+        [[nodiscard]] static std::vector<unsigned char> serialize(const mesh &m, uint64_t source_stamp) noexcept;
+
+        [[nodiscard]] inline bool valid() const noexcept { return m_data != nullptr; }
+        [[nodiscard]] inline const header &get_header() const noexcept { return *reinterpret_cast<const header *>(m_data); }
+
+        [[nodiscard]] inline const mesh_vertex *vertices() const noexcept { return reinterpret_cast<const mesh_vertex *>(m_data + sizeof(header)); }
+        [[nodiscard]] inline size_t vertex_count() const noexcept { return get_header().vertex_count; }
+        [[nodiscard]] inline size_t vertex_bytes() const noexcept { return vertex_count() * sizeof(mesh_vertex); }
+
+        [[nodiscard]] inline const uint32_t *indices() const noexcept { return reinterpret_cast<const uint32_t *>(m_data + sizeof(header) + vertex_bytes()); }
+        [[nodiscard]] inline size_t index_count() const noexcept { return get_header().index_count; }
+        [[nodiscard]] inline size_t index_bytes() const noexcept { return index_count() * sizeof(uint32_t); }
+
+    private:
+        // check the header and the size, unmaps and clears the data if they are wrong
+        bool validate(const char *name) noexcept;
+        void release() noexcept;
+    };
+
+    /**
+     * @brief Load an obj file through a binary cache next to it. The first load parses and optimizes the obj
+     * and writes the cache, later loads map the cache and skip parsing until the obj changes.
+     * 
+     * @param obj_path The path to the obj file.
+     * @param cache_path The path to the cache. Default is the obj path with .wgm added.
+     * @return mesh_file Invalid if the obj could not be loaded. Kept in memory if the cache could not be written.
+     */
+    [[nodiscard]] mesh_file load_mesh_cached(const char *obj_path, const char *cache_path = nullptr) noexcept;
+
+    ////
+    // parametric meshes
+    // indexed generators which fill spans given by the caller, sized with the *_count functions. They are
+    // constexpr for small fixed sizes, ex: gen_uv_sphere<16, 8>(), and split the rows over a job pool when one
+    // is given. Triangles are counter clockwise seen from outside and texcoords are in [0, 1], except on the
+    // seam of the icosphere where they run past it so a repeating texture wraps
+    // each returns false without writing anything if a span is too small
+
+    template <size_t Vertices, size_t Indices>
+    struct fixed_mesh
+    {
+        std::array<mesh_vertex, Vertices> vertices;
+        std::array<uint32_t, Indices> indices;
+    };
+
+    [[nodiscard]] constexpr size_t grid_vertex_count(size_t columns, size_t rows) noexcept { return (columns + 1) * (rows + 1); }
+    [[nodiscard]] constexpr size_t grid_index_count(size_t columns, size_t rows) noexcept { return columns * rows * 6; }
+
+    [[nodiscard]] constexpr size_t uv_sphere_vertex_count(size_t segments, size_t rings) noexcept { return (segments + 1) * (rings + 1); }
+    [[nodiscard]] constexpr size_t uv_sphere_index_count(size_t segments, size_t rings) noexcept { return rings < 2 ? 0 : segments * (rings - 1) * 6; }
+
+    [[nodiscard]] constexpr size_t icosphere_vertex_count(size_t frequency) noexcept { return 20 * (frequency + 1) * (frequency + 2) / 2; }
+    [[nodiscard]] constexpr size_t icosphere_index_count(size_t frequency) noexcept { return 20 * frequency * frequency * 3; }
+
+    [[nodiscard]] constexpr size_t cylinder_vertex_count(size_t segments, size_t rings) noexcept { return (segments + 1) * (rings + 1) + 2 * (segments + 2); }
+    [[nodiscard]] constexpr size_t cylinder_index_count(size_t segments, size_t rings) noexcept { return segments * rings * 6 + 2 * segments * 3; }
+
+    [[nodiscard]] constexpr size_t torus_vertex_count(size_t segments, size_t sides) noexcept { return (segments + 1) * (sides + 1); }
+    [[nodiscard]] constexpr size_t torus_index_count(size_t segments, size_t sides) noexcept { return segments * sides * 6; }
+
+    /**
+     * @brief A flat grid on the xz plane centered on the origin with its normal up (+y). Ex: a subdivided
+     * plane or the base of a terrain.
+     * 
+     * @param columns The number of cells along x.
+     * @param rows The number of cells along z.
+     * @param size The size along x and z.
+     * @param verts grid_vertex_count(columns, rows) vertices, row by row from -z.
+     * @param indices grid_index_count(columns, rows) indices.
+     * @param pool The pool to generate on, nullptr generates on the calling thread.
+     * @return true The grid was generated.
+     */
+    constexpr bool gen_grid(size_t columns, size_t rows, const glm::vec2 &size, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief A sphere of rings of latitude and segments of longitude centered on the origin with its poles
+     * on y. The seam and the poles repeat vertices so the texcoords wrap.
+     * 
+     * @param radius The radius.
+     * @param segments The number of segments around y, at least 3.
+     * @param rings The number of rings from pole to pole, at least 2.
+     * @param verts uv_sphere_vertex_count(segments, rings) vertices.
+     * @param indices uv_sphere_index_count(segments, rings) indices.
+     * @param pool The pool to generate on, nullptr generates on the calling thread.
+     * @return true The sphere was generated.
+     */
+    constexpr bool gen_uv_sphere(float radius, size_t segments, size_t rings, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief A sphere made by splitting each face of an icosahedron into frequency * frequency triangles and
+     * pushing the points out to the sphere. The triangles are close to the same size unlike a uv sphere.
+     * Each face has its own vertices, weld_vertices() merges the ones on the edges if needed.
+     * 
+     * @param radius The radius.
+     * @param frequency The number of splits of each edge, at least 1.
+     * @param verts icosphere_vertex_count(frequency) vertices.
+     * @param indices icosphere_index_count(frequency) indices.
+     * @param pool The pool to generate on, nullptr generates on the calling thread.
+     * @return true The sphere was generated.
+     */
+    constexpr bool gen_icosphere(float radius, size_t frequency, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief A capped cylinder centered on the origin along y.
+     * 
+     * @param radius The radius.
+     * @param height The height.
+     * @param segments The number of segments around y, at least 3.
+     * @param rings The number of rings along the side, at least 1.
+     * @param verts cylinder_vertex_count(segments, rings) vertices, the side then the top and bottom caps.
+     * @param indices cylinder_index_count(segments, rings) indices.
+     * @param pool The pool to generate on, nullptr generates on the calling thread.
+     * @return true The cylinder was generated.
+     */
+    constexpr bool gen_cylinder(float radius, float height, size_t segments, size_t rings, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool = nullptr) noexcept;
+
+    /**
+     * @brief A torus centered on the origin around y.
+     * 
+     * @param radius The distance from the center to the middle of the tube.
+     * @param tube_radius The radius of the tube.
+     * @param segments The number of segments around y, at least 3.
+     * @param sides The number of sides around the tube, at least 3.
+     * @param verts torus_vertex_count(segments, sides) vertices.
+     * @param indices torus_index_count(segments, sides) indices.
+     * @param pool The pool to generate on, nullptr generates on the calling thread.
+     * @return true The torus was generated.
+     */
+    constexpr bool gen_torus(float radius, float tube_radius, size_t segments, size_t sides, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool = nullptr) noexcept;
+
+    // fixed size versions for compile time meshes. Ex: static constexpr auto sphere = utils::gen_uv_sphere<16, 8>();
+
+    template <size_t Columns, size_t Rows>
+    [[nodiscard]] constexpr fixed_mesh<grid_vertex_count(Columns, Rows), grid_index_count(Columns, Rows)> gen_grid(const glm::vec2 &size = glm::vec2{1.0f}) noexcept;
+
+    template <size_t Segments, size_t Rings>
+    requires(Segments >= 3 && Rings >= 2)
+    [[nodiscard]] constexpr fixed_mesh<uv_sphere_vertex_count(Segments, Rings), uv_sphere_index_count(Segments, Rings)> gen_uv_sphere(float radius = 0.5f) noexcept;
+
+    template <size_t Frequency>
+    requires(Frequency >= 1)
+    [[nodiscard]] constexpr fixed_mesh<icosphere_vertex_count(Frequency), icosphere_index_count(Frequency)> gen_icosphere(float radius = 0.5f) noexcept;
+
+    template <size_t Segments, size_t Rings = 1>
+    requires(Segments >= 3 && Rings >= 1)
+    [[nodiscard]] constexpr fixed_mesh<cylinder_vertex_count(Segments, Rings), cylinder_index_count(Segments, Rings)> gen_cylinder(float radius = 0.5f, float height = 1.0f) noexcept;
+
+    template <size_t Segments, size_t Sides>
+    requires(Segments >= 3 && Sides >= 3)
+    [[nodiscard]] constexpr fixed_mesh<torus_vertex_count(Segments, Sides), torus_index_count(Segments, Sides)> gen_torus(float radius = 0.5f, float tube_radius = 0.2f) noexcept;
+
+    ////
+    // terrain
+
+    /**
+     * @brief A grid of heights, ex: loaded from a grayscale image, sampled by the terrain chunks. Sample x
+     * runs along the width and z along the depth of the grid.
+     *
+     */
+    class heightmap
+    {
+    private:
+        std::vector<float> m_heights;
+        int m_width = 0;
+        int m_depth = 0;
+
+    public:
+        heightmap() noexcept = default;
+
+        /**
+         * @brief Use heights made some other way. Ex: generated noise.
+         *
+         * @param width The number of samples along x.
+         * @param depth The number of samples along z.
+         * @param heights width * depth heights, row by row from z = 0.
+         */
+        heightmap(int width, int depth, std::vector<float> heights) noexcept;
+
+        /**
+         * @brief Read the heights from the first channel of a loaded image, 0 to 255 is 0 to scale.
+         *
+         * @param image The image. Ex: loaded with load_file.
+         * @param scale The height of the brightest pixel.
+         * @return true The heights were read.
+         * @return false The image is not loaded.
+         */
+        [[nodiscard]] bool load(stb_image &image, float scale = 1.0f) noexcept;
+
+        [[nodiscard]] inline bool valid() const noexcept { return !m_heights.empty(); }
+        [[nodiscard]] inline int width() const noexcept { return m_width; }
+        [[nodiscard]] inline int depth() const noexcept { return m_depth; }
+        [[nodiscard]] inline const float *data() const noexcept { return m_heights.data(); }
+
+        // the height of a sample, clamped to the edges
+        [[nodiscard]] inline float at(int x, int z) const noexcept
+        {
+            return m_heights[(size_t)std::clamp(z, 0, m_depth - 1) * m_width + std::clamp(x, 0, m_width - 1)];
+        }
+
+        /**
+         * @brief The bilinear height between samples.
+         *
+         * @param x The x in samples.
+         * @param z The z in samples.
+         * @return float
+         */
+        [[nodiscard]] float sample(float x, float z) const noexcept;
+
+        /**
+         * @brief The normal of a sample from the slope to its neighbours.
+         *
+         * @param x The x of the sample.
+         * @param z The z of the sample.
+         * @param spacing The distance between samples.
+         * @return glm::vec3
+         */
+        [[nodiscard]] glm::vec3 normal(int x, int z, float spacing) const noexcept;
+
+        /**
+         * @brief The lowest and highest heights in a rectangle of samples. Ex: the bounding box of a chunk.
+         *
+         * @return glm::vec2 The min and max.
+         */
+        [[nodiscard]] glm::vec2 range(int x, int z, int width, int depth) const noexcept;
+    };
+
+    // the edges of a terrain chunk, used as bits to mark the edges next to a coarser chunk
+    enum terrain_edge : uint32_t
+    {
+        TERRAIN_NEG_X = 1,
+        TERRAIN_POS_X = 2,
+        TERRAIN_NEG_Z = 4,
+        TERRAIN_POS_Z = 8
+    };
+
+    // a chunk of cells * cells cells at a lod uses every 2^lod sample
+    [[nodiscard]] constexpr size_t terrain_chunk_vertex_count(size_t cells, size_t lod) noexcept { return ((cells >> lod) + 1) * ((cells >> lod) + 1); }
+    [[nodiscard]] constexpr size_t terrain_chunk_index_count(size_t cells, size_t lod) noexcept { return (cells >> lod) * (cells >> lod) * 6; }
+
+    /**
+     * @brief The vertices of a terrain chunk at a lod, the same grid of vertices as gen_grid over the samples
+     * [x, x + cells] * [z, z + cells] of the heightmap. The normals are taken from the full heightmap so the
+     * lighting stays the same across lods.
+     *
+     * @param map The heightmap.
+     * @param x The first sample of the chunk along x.
+     * @param z The first sample of the chunk along z.
+     * @param cells The cells per side at lod 0, a power of 2.
+     * @param lod The lod, every 2^lod sample is used.
+     * @param spacing The distance between samples.
+     * @param verts terrain_chunk_vertex_count(cells, lod) vertices.
+     * @return true The vertices were generated.
+     * @return false verts is too small or the chunk is outside the heightmap.
+     */
+    bool gen_terrain_chunk(const heightmap &map, size_t x, size_t z, size_t cells, size_t lod, float spacing, std::span<mesh_vertex> verts) noexcept;
+
+    /**
+     * @brief The indices of a terrain chunk at a lod. The vertices of an edge next to a chunk one lod coarser
+     * are skipped every other one so the edges meet without cracks, which needs neighbours to differ by at
+     * most one lod. The indices only depend on the lod and edges so one set is shared by every chunk.
+     *
+     * @param cells The cells per side at lod 0.
+     * @param lod The lod.
+     * @param coarser_edges The terrain_edge bits of the edges next to a coarser chunk.
+     * @param indices terrain_chunk_index_count(cells, lod) indices, less are used with coarser edges.
+     * @return size_t The number of indices written, 0 if indices is too small.
+     */
+    size_t gen_terrain_indices(size_t cells, size_t lod, uint32_t coarser_edges, std::span<uint32_t> indices) noexcept;
+
 } // namespace utils
 
 #include "utils_impl.hpp"
@@ -6,12 +6,49 @@
 #include <fstream>
 #include <sstream>
 #include <limits>
+#include <bit>
 #include <ranges>
 #include <algorithm>
 #include <ctime>
 #include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <numbers>
+#include <numeric>
+
+// simd, used when the compiler targets it
+#if defined(__F16C__) || defined(__SSE4_1__) || defined(__AVX__) || defined(__SSSE3__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// process memory
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+// memory mapped files
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // stb image
+// the decoded pixels and the decoders' own buffers come from the pool, see image_buffer_pool
+#define STBI_MALLOC(size) utils::image_buffer_pool::allocate(size)
+#define STBI_REALLOC(ptr, size) utils::image_buffer_pool::reallocate(ptr, size)
+#define STBI_FREE(ptr) utils::image_buffer_pool::release(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "../dep//stb/stb_image.h"
 
@@ -41,362 +78,686 @@ namespace utils
     }
     
     stb_image::~stb_image() noexcept
+    {
+        reset();
+    }
+
+    stb_image::stb_image(stb_image &&other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_width(std::exchange(other.m_width, 0)),
+          m_height(std::exchange(other.m_height, 0)), m_nr_channels(std::exchange(other.m_nr_channels, 0))
+    {
+    }
+
+    stb_image &stb_image::operator=(stb_image &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_width = std::exchange(other.m_width, 0);
+            m_height = std::exchange(other.m_height, 0);
+            m_nr_channels = std::exchange(other.m_nr_channels, 0);
+        }
+
+        return *this;
+    }
+
+    void stb_image::reset() noexcept
     {
         if (m_data != NULL)
             stbi_image_free(m_data);
+
+        m_data = nullptr;
+        m_width = m_height = m_nr_channels = 0;
     }
 
     [[nodiscard]] bool stb_image::load_file(const char *path, bool vertical_flip) noexcept
     {
-        stbi_set_flip_vertically_on_load(vertical_flip);
+        // the previous image would leak otherwise
+        reset();
+
+        // the flip is per thread so loads on other threads are not affected
+        stbi_set_flip_vertically_on_load_thread(vertical_flip);
         m_data = stbi_load(path, &m_width, &m_height, &m_nr_channels, 0);
         
         // stbi load does not throw exceptions
-        if (m_width <= 0 || m_height <= 0)
+        if (m_data == NULL || m_width <= 0 || m_height <= 0)
         {
             std::cout << "[utils] Error: Failed to load texture image from " << path << ".\n";
+            reset();
             return false;
         }
 
         return true;
     }
 
-    [[nodiscard]] std::future<bool> stb_image::load_file_async(const char *path, bool vertical_flip) noexcept
+    [[nodiscard]] std::future<stb_image> stb_image::load_file_async(const char *path, bool vertical_flip) noexcept
     {
-        return std::async(std::launch::async, [
-            path, vertical_flip,
-            &data = m_data, &width = m_width, &height = m_height, &nr_channels = m_nr_channels
-        ](){
-            stbi_set_flip_vertically_on_load_thread(vertical_flip);
-            data = stbi_load(path, &width, &height, &nr_channels, 0);
-        
-            // stbi load does not throw exceptions
-            if (width <= 0 || height <= 0)
+        return std::async(std::launch::async, [path, vertical_flip](){
+            stb_image image;
+            (void)image.load_file(path, vertical_flip);
+            return image;
+        });
+    }
+
+    [[nodiscard]] size_t stb_image::load_files(std::span<stb_image> images, std::span<const char *const> paths, bool vertical_flip,
+                                               job_pool *pool, size_t max_concurrent) noexcept
+    {
+        const size_t count = std::min(images.size(), paths.size());
+        if (count == 0)
+            return 0;
+
+        // each lane takes the next image until none are left, so only as many decode at once as there are lanes
+        size_t lanes = max_concurrent != 0 ? max_concurrent : (pool != nullptr ? pool->workers() + 1 : 1);
+        lanes = std::min(pool != nullptr ? lanes : 1, count);
+
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> loaded{0};
+
+        auto decode = [&](size_t begin, size_t end) {
+            for (size_t lane = begin; lane < end; ++lane)
             {
-                std::cout << "[utils] Error: Failed to load texture image from " << path << ".\n";
-                return false;
+                for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+                {
+                    if (images[i].load_file(paths[i], vertical_flip))
+                        loaded.fetch_add(1, std::memory_order_relaxed);
+                }
             }
+        };
 
-            return true;
-        });
+        if (pool != nullptr && lanes > 1)
+            pool->parallel_for(lanes, 1, decode);
+        else
+            decode(0, 1);
+
+        return loaded.load(std::memory_order_relaxed);
     }
 
     ////
-    // stb true type
+    // image_buffer_pool
 
-    float stb_true_type::get_string_width(const stbtt_fontinfo *info, const char *str, size_t from, size_t to, int font_height, int bitmap_width) noexcept
+    std::mutex image_buffer_pool::s_mutex;
+    std::array<std::array<void *, image_buffer_pool::max_kept>, image_buffer_pool::buckets> image_buffer_pool::s_kept{};
+    std::array<size_t, image_buffer_pool::buckets> image_buffer_pool::s_counts{};
+    size_t image_buffer_pool::s_budget = size_t{64} << 20;
+    image_buffer_pool::counters image_buffer_pool::s_counters;
+
+    namespace detail
     {
-        float width = 0.0f, scale = stbtt_ScaleForPixelHeight(info, font_height);
-        int lines = 1;
+        // sits in front of every buffer of the pool, the size keeps the buffer after it aligned for any type
+        struct alignas(std::max_align_t) image_buffer_header
+        {
+            size_t capacity;
+            // the bucket the buffer goes back to, unpooled for the ones from malloc
+            size_t bucket;
+        };
+
+        constexpr const size_t unpooled_bucket = std::numeric_limits<size_t>::max();
 
-        for (size_t i = from; i < to; ++i)
+        [[nodiscard]] inline image_buffer_header *image_buffer_header_of(void *ptr) noexcept
         {
-            int ax, lsb;
-            stbtt_GetCodepointHMetrics(info, str[i], &ax, &lsb);
-            
-            float x_shift = width - (float)std::floor(width);
-            int c_x1, c_y1, c_x2, c_y2;
-            stbtt_GetCodepointBitmapBoxSubpixel(info, str[i], scale, scale, x_shift, 0, &c_x1, &c_y1, &c_x2, &c_y2);
-            
-            width += ax * scale;// linear movement of characters
+            return static_cast<image_buffer_header *>(ptr) - 1;
+        }
 
-            if (bitmap_width != -1 && std::ceil(width) >= lines * bitmap_width)
-            {
-                width += lines * bitmap_width - (width - ax * scale);
-                ++lines;
-            }
-            else if (str[i + 1] != '\0')
-            {
-                int kern;
-                kern = stbtt_GetCodepointKernAdvance(info, str[i], str[i + 1]);
-                width += kern * scale; // add kerning to make words look nice.
-            }
+        [[nodiscard]] inline void *image_buffer_from_header(image_buffer_header *header) noexcept
+        {
+            return header + 1;
         }
+    }
 
-        return width;
+    void image_buffer_pool::set_budget(size_t bytes) noexcept
+    {
+        {
+            std::lock_guard lock(s_mutex);
+            s_budget = bytes;
+        }
+
+        // drop what no longer fits, the pool refills from the next frees
+        if (stats().kept_bytes > bytes)
+            trim();
     }
 
-    bool stb_true_type::load_file(const char *path) noexcept
+    void image_buffer_pool::trim() noexcept
     {
-        m_font_file_data = utils::read_file_bytes_sync(path);
+        std::lock_guard lock(s_mutex);
 
-       if (!stbtt_InitFont(&m_font_info, m_font_file_data.cbegin().base(), 0))
+        for (size_t b = 0; b < buckets; ++b)
         {
-            std::cout << "[utils] Error: Failed to initialize font from file at " << path << ".\n";
-            return false;
+            for (size_t i = 0; i < s_counts[b]; ++i)
+                std::free(detail::image_buffer_header_of(s_kept[b][i]));
+            s_counts[b] = 0;
         }
 
-        loaded = true;
+        s_counters.kept_bytes = 0;
+    }
 
-        return true;
+    [[nodiscard]] image_buffer_pool::counters image_buffer_pool::stats() noexcept
+    {
+        std::lock_guard lock(s_mutex);
+        return s_counters;
     }
 
-    bool stb_true_type::make_bitmap(int bitmap_width, int bitmap_height, int font_height, const char *text, float line_gap_scale) noexcept
+    [[nodiscard]] void *image_buffer_pool::allocate(size_t size) noexcept
     {
-        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
+        using detail::image_buffer_header;
 
-        int ascent, descent, line_gap;
+        size = std::max<size_t>(size, 1);
 
-        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
+        size_t capacity = size;
+        size_t bucket = detail::unpooled_bucket;
+        if (size >= min_pooled && size <= max_pooled)
+        {
+            capacity = std::bit_ceil(size);
+            bucket = std::countr_zero(capacity) - std::countr_zero(min_pooled);
 
-        ascent = std::round(ascent * scale);
-        descent = std::round(descent * scale);
-        line_gap = std::round(line_gap * line_gap_scale);
+            if (void *kept = take(bucket, capacity))
+                return kept;
+        }
 
-        if (line_gap == 0)
+        auto *header = static_cast<image_buffer_header *>(std::malloc(sizeof(image_buffer_header) + capacity));
+        if (header == nullptr)
+            return nullptr;
+
+        header->capacity = capacity;
+        header->bucket = bucket;
+        return detail::image_buffer_from_header(header);
+    }
+
+    [[nodiscard]] void *image_buffer_pool::reallocate(void *ptr, size_t size) noexcept
+    {
+        using detail::image_buffer_header;
+
+        if (ptr == nullptr)
+            return allocate(size);
+
+        auto *header = detail::image_buffer_header_of(ptr);
+        if (size <= header->capacity)
+            return ptr;
+
+        size_t capacity = size;
+        size_t bucket = detail::unpooled_bucket;
+        if (size >= min_pooled && size <= max_pooled)
         {
-            line_gap = font_height * line_gap_scale;
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: No line gap value provided by font file. Setting it to font height (" << font_height << ").\n";
-#endif
+            capacity = std::bit_ceil(size);
+            bucket = std::countr_zero(capacity) - std::countr_zero(min_pooled);
+
+            if (void *kept = take(bucket, capacity))
+            {
+                std::memcpy(kept, ptr, header->capacity);
+                release(ptr);
+                return kept;
+            }
         }
 
-        m_bitmap_data.resize(bitmap_width * bitmap_height);
-        m_bitmap_data.clear();
+        // otherwise realloc, which can grow large buffers by remapping their pages instead of copying them
+        auto *grown = static_cast<image_buffer_header *>(std::realloc(header, sizeof(image_buffer_header) + capacity));
+        if (grown == nullptr)
+            return nullptr;
 
-        int x = 0;
-        int line = 0;
-        
-        for (size_t i = 0; i < strlen(text); ++i)
+        grown->capacity = capacity;
+        grown->bucket = bucket;
+        return detail::image_buffer_from_header(grown);
+    }
+
+    [[nodiscard]] void *image_buffer_pool::take(size_t bucket, size_t capacity) noexcept
+    {
+        std::lock_guard lock(s_mutex);
+        if (s_counts[bucket] == 0)
         {
-            int ax, lsb;
-            stbtt_GetCodepointHMetrics(&m_font_info, text[i], &ax, &lsb);
+            ++s_counters.allocated;
+            return nullptr;
+        }
 
-            int c_x1, c_y1, c_x2, c_y2;
-            stbtt_GetCodepointBitmapBox(&m_font_info, text[i], scale, scale, &c_x1, &c_y1, &c_x2, &c_y2);
+        ++s_counters.reused;
+        s_counters.kept_bytes -= capacity;
+        return s_kept[bucket][--s_counts[bucket]];
+    }
 
-            if (x + c_x2 - c_x1 >= bitmap_width)
+    void image_buffer_pool::release(void *ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        auto *header = detail::image_buffer_header_of(ptr);
+        if (header->bucket != detail::unpooled_bucket)
+        {
+            std::lock_guard lock(s_mutex);
+            if (s_counts[header->bucket] < max_kept && s_counters.kept_bytes + header->capacity <= s_budget)
             {
-                x = 0;
-                ++line;
+                s_counters.kept_bytes += header->capacity;
+                s_kept[header->bucket][s_counts[header->bucket]++] = ptr;
+                return;
             }
+        }
 
-            int y = ascent + c_y1 // makes characters like t and h be on the same line as e. from bottom
-                    + line * line_gap; // controls height if in another line
-
-            if (y >= bitmap_height)
-                break;  
+        std::free(header);
+    }
 
-            int byte_offset = x// linear movement of characters 
-                            + std::round(lsb * scale) // moves characters to top instead of being at the bottom.
-                            + (y * bitmap_width); // moves characters like e to be one same line as larger ones like l. from top
+    ////
+    // utf-8
 
-            stbtt_MakeCodepointBitmap(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, text[i]);
+    [[nodiscard]] size_t utf8_ascii_run(const char *text, size_t size) noexcept
+    {
+        size_t i = 0;
 
-            x += std::round(ax * scale); // linear movement of characters
+#if defined(__SSE2__) || defined(__AVX__)
+        // the top bit of every ascii byte is 0
+        for (; i + 16 <= size; i += 16)
+        {
+            const int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i)));
+            if (mask != 0)
+                return i + std::countr_zero((unsigned int)mask);
+        }
+#endif
 
-            int kern;
-            kern = stbtt_GetCodepointKernAdvance(&m_font_info, text[i], text[i + 1]);
-            x += std::round(kern * scale); // add kerning to make words look nice.
+        // 8 bytes at a time without simd
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, text + i, sizeof(word));
+            if (word & 0x8080808080808080ull)
+                break;
         }
 
-        return true;
+        while (i < size && (unsigned char)text[i] < 0x80)
+            ++i;
+
+        return i;
     }
 
-    bool stb_true_type::make_bitmap_fixed(int& bitmap_width, int& bitmap_height, int font_height, const char *text, float line_gap_scale) noexcept
+    [[nodiscard]] uint32_t utf8_next(std::string_view text, size_t &i) noexcept
     {
-        if (!loaded)
+        const unsigned char lead = text[i];
+        if (lead < 0x80)
         {
-            std::cout << "[utils] Error: Font not loaded.\n";
-            return false;
+            ++i;
+            return lead;
         }
 
-        if (bitmap_width <= 0)
+        size_t length;
+        uint32_t codepoint, min;
+        if ((lead & 0xE0) == 0xC0)
         {
-            std::cout << "[utils] Error: Invalid bitmap width.\n";
-            return false;
+            length = 2;
+            codepoint = lead & 0x1F;
+            min = 0x80;
         }
-
-        if (bitmap_height < font_height)
+        else if ((lead & 0xF0) == 0xE0)
         {
-            std::cout << "[utils] Error: Bitmap height provided too small.\n";
-            return false;
+            length = 3;
+            codepoint = lead & 0x0F;
+            min = 0x800;
         }
-        
-        if (font_height <= 0)
+        else if ((lead & 0xF8) == 0xF0)
         {
-            std::cout << "[utils] Error: Invalid font height.\n";
-            return false;
+            length = 4;
+            codepoint = lead & 0x07;
+            min = 0x10000;
+        }
+        else
+        {
+            // a continuation byte without a lead or a lead which is never valid
+            ++i;
+            return replacement_codepoint;
         }
 
-        int width = bitmap_width;
-        
-        if (width % _bitmap_width_correcter != 0)
+        for (size_t k = 1; k < length; ++k)
         {
-            width += _bitmap_width_correcter - (bitmap_width % _bitmap_width_correcter);
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Bitmap width provided too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
-#endif
-            bitmap_width = width;
+            // a cut sequence, the byte which cut it starts the next codepoint
+            if (i + k >= text.size() || ((unsigned char)text[i + k] & 0xC0) != 0x80)
+            {
+                i += k;
+                return replacement_codepoint;
+            }
+
+            codepoint = codepoint << 6 | ((unsigned char)text[i + k] & 0x3F);
         }
 
-        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
+        i += length;
 
-        int ascent, descent, line_gap;
+        if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+            return replacement_codepoint;
 
-        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
+        return codepoint;
+    }
 
-        ascent = std::round(ascent * scale);
-        descent = std::round(descent * scale);
-        line_gap = std::round(line_gap * line_gap_scale);
+    size_t utf8_decode(std::string_view text, std::vector<uint32_t> &out) noexcept
+    {
+        const size_t start = out.size();
 
-        if (line_gap == 0)
+        // at most one codepoint per byte
+        out.reserve(start + text.size());
+
+        size_t i = 0;
+        while (i < text.size())
         {
-            line_gap = font_height * line_gap_scale;
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: No line gap value provided by font file. Setting it to font height (" << font_height << ").\n";
+            const size_t run = utf8_ascii_run(text.data() + i, text.size() - i);
+
+            const size_t at = out.size();
+            out.resize(at + run);
+            uint32_t *dst = out.data() + at;
+
+            size_t k = 0;
+#if defined(__SSE2__) || defined(__AVX__)
+            // zero extend 16 bytes to 16 codepoints
+            const __m128i zero = _mm_setzero_si128();
+            for (; k + 16 <= run; k += 16)
+            {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i + k));
+                const __m128i low = _mm_unpacklo_epi8(bytes, zero), high = _mm_unpackhi_epi8(bytes, zero);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k), _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k + 4), _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k + 8), _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k + 12), _mm_unpackhi_epi16(high, zero));
+            }
 #endif
+            for (; k < run; ++k)
+                dst[k] = (unsigned char)text[i + k];
+
+            i += run;
+
+            if (i < text.size())
+                out.push_back(utf8_next(text, i));
         }
 
-        m_bitmap_data.resize(bitmap_width * bitmap_height);
-        m_bitmap_data.clear();
+        return out.size() - start;
+    }
 
-        int x = 0;
-        int line = 0;
-        
-        for (size_t i = 0; i < strlen(text); ++i)
+    ////
+    // stb true type
+
+    float stb_true_type::get_string_width(const stbtt_fontinfo *info, const char *str, size_t from, size_t to, int font_height, int bitmap_width) noexcept
+    {
+        float width = 0.0f, scale = stbtt_ScaleForPixelHeight(info, font_height);
+        int lines = 1;
+
+        if (from >= to)
+            return width;
+
+        // str is null terminated, the codepoint after to is only read for its kerning
+        const std::string_view text(str, to + strlen(str + to));
+
+        // each codepoint is searched for once and the glyph is used after
+        size_t i = from;
+        int glyph = stbtt_FindGlyphIndex(info, utf8_next(text, i));
+
+        while (true)
         {
+            const size_t next_at = i;
+
             int ax, lsb;
-            stbtt_GetCodepointHMetrics(&m_font_info, text[i], &ax, &lsb);
+            stbtt_GetGlyphHMetrics(info, glyph, &ax, &lsb);
+
+            width += ax * scale;// linear movement of characters
 
-            int c_x1, c_y1, c_x2, c_y2;
-            stbtt_GetCodepointBitmapBox(&m_font_info, text[i], scale, scale, &c_x1, &c_y1, &c_x2, &c_y2);
+            const bool has_next = i < text.size();
+            const int next = has_next ? stbtt_FindGlyphIndex(info, utf8_next(text, i)) : 0;
 
-            if (x + c_x2 - c_x1 >= bitmap_width)
+            if (bitmap_width != -1 && std::ceil(width) >= lines * bitmap_width)
             {
-                x = 0;
-                ++line;
+                width += lines * bitmap_width - (width - ax * scale);
+                ++lines;
+            }
+            else if (has_next)
+            {
+                int kern;
+                kern = stbtt_GetGlyphKernAdvance(info, glyph, next);
+                width += kern * scale; // add kerning to make words look nice.
             }
 
-            int y = ascent + c_y1 // makes characters like t and h be on the same line as e. from bottom
-                    + line * line_gap; // controls height if in another line
-            
-            if (y >= bitmap_height)
-                break;  
-            
-
-            int byte_offset = x// linear movement of characters 
-                            + std::round(lsb * scale) // moves characters to top instead of being at the bottom.
-                            + (y * bitmap_width); // moves characters like e to be one same line as larger ones like l. from top
-
-            stbtt_MakeCodepointBitmap(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, text[i]);
-
-            x += std::round(ax * scale); // linear movement of characters
+            if (next_at >= to)
+                break;
 
-            int kern;
-            kern = stbtt_GetCodepointKernAdvance(&m_font_info, text[i], text[i + 1]);
-            x += std::round(kern * scale); // add kerning to make words look nice.
+            glyph = next;
         }
 
-        return true;
+        return width;
     }
 
-    bool stb_true_type::make_bitmap_line(int& bitmap_width, int& bitmap_height, int font_height, const char *text) noexcept
+    float stb_true_type::get_string_width(const char *str, size_t from, size_t to, int font_height, int bitmap_width) const noexcept
     {
-        if (!loaded)
-        {
-            std::cout << "[utils] Error: Font not loaded.\n";
-            return false;
-        }
-        
-        if (font_height <= 0)
-        {
-            std::cout << "[utils] Error: Invalid font height.\n";
-            return false;
-        }
+        float width = 0.0f, scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
+        int lines = 1;
 
-        if (bitmap_height < font_height)
-        {
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Bitmap height provided too small, moving up to nearest line.\n";
-#endif
-            bitmap_height = font_height;
-        }
+        if (from >= to)
+            return width;
 
-        int width = get_string_width(&m_font_info, text, 0, strlen(text), font_height);
+        // str is null terminated, the codepoint after to is only read for its kerning
+        const std::string_view text(str, to + strlen(str + to));
 
-        width = std::max(width, bitmap_width);
+        size_t i = from;
+        uint32_t c = utf8_next(text, i);
 
-        if (width % _bitmap_width_correcter != 0)
+        while (true)
         {
-            width += _bitmap_width_correcter - (width % _bitmap_width_correcter);
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Bitmap width calculated too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
-#endif
+            const size_t next_at = i;
+            const int ax = metrics(c).advance;
+
+            width += ax * scale;// linear movement of characters
+
+            const bool has_next = i < text.size();
+            const uint32_t next = has_next ? utf8_next(text, i) : 0;
+
+            if (bitmap_width != -1 && std::ceil(width) >= lines * bitmap_width)
+            {
+                width += lines * bitmap_width - (width - ax * scale);
+                ++lines;
+            }
+            else if (has_next)
+                width += kern(c, next) * scale; // add kerning to make words look nice.
+
+            if (next_at >= to)
+                break;
+
+            c = next;
         }
 
-        if (bitmap_width != width)
+        return width;
+    }
+
+    namespace detail
+    {
+        [[nodiscard]] inline stb_true_type::glyph_metrics read_glyph_metrics(const stbtt_fontinfo *info, uint32_t codepoint) noexcept
         {
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Bitmap width provided too small moving up to string width (" << width << ").\n";
-#endif
-            bitmap_width = width;
+            stb_true_type::glyph_metrics m;
+            m.glyph = stbtt_FindGlyphIndex(info, codepoint);
+
+            stbtt_GetGlyphHMetrics(info, m.glyph, &m.advance, &m.left_side_bearing);
+            m.has_box = stbtt_GetGlyphBox(info, m.glyph, &m.x0, &m.y0, &m.x1, &m.y1) != 0;
+
+            return m;
         }
-        
-        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
 
-        int ascent, descent;
-        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, 0);
+        [[nodiscard]] inline size_t hash_slot(uint32_t key, size_t mask) noexcept
+        {
+            return (size_t)((uint64_t)key * 0x9E3779B97F4A7C15ull >> 32) & mask;
+        }
 
-        ascent = std::round(ascent * scale);
-        descent = std::round(descent * scale);
-        
-        m_bitmap_data.resize(bitmap_width * bitmap_height);
-        m_bitmap_data.clear();
+        // the slot of a key in an open addressed table, or the empty slot which ends its probe
+        [[nodiscard]] inline size_t probe(const std::vector<uint32_t> &keys, uint32_t key, uint32_t empty) noexcept
+        {
+            const size_t mask = keys.size() - 1;
+            size_t i = hash_slot(key, mask);
+            while (keys[i] != key && keys[i] != empty)
+                i = (i + 1) & mask;
 
-        float xpos = 0.0f;
-        for (size_t i = 0; i < strlen(text); ++i)
+            return i;
+        }
+    }
+
+    [[nodiscard]] stb_true_type::glyph_metrics stb_true_type::metrics(uint32_t codepoint) const noexcept
+    {
+        if (codepoint < m_metrics.size())
+            return m_metrics[codepoint];
+
+        if (m_cached_count != 0)
         {
-            int ax, lsb;
-            stbtt_GetCodepointHMetrics(&m_font_info, text[i], &ax, &lsb);
-            
-            float x_shift = xpos - (float)std::floor(xpos);
-            int c_x1, c_y1, c_x2, c_y2;
-            stbtt_GetCodepointBitmapBoxSubpixel(&m_font_info, text[i], scale, scale, x_shift, 0, &c_x1, &c_y1, &c_x2, &c_y2);
+            const size_t i = detail::probe(m_cached_keys, codepoint, empty_key);
+            if (m_cached_keys[i] == codepoint)
+                return m_cached_metrics[i];
+        }
 
-            auto stride = width * (ascent + c_y1) + (int)xpos + c_x1;
-            stbtt_MakeCodepointBitmapSubpixel(&m_font_info, m_bitmap_data.data() + stride, c_x2 - c_x1, c_y2 - c_y1, width, scale, scale, x_shift, 0, text[i]);
+        return loaded ? detail::read_glyph_metrics(&m_font_info, codepoint) : glyph_metrics{};
+    }
 
-            xpos += ax * scale;
+    [[nodiscard]] int stb_true_type::kern(uint32_t first, uint32_t second) const noexcept
+    {
+        if (!loaded)
+            return 0;
+
+        // the glyphs come from the tables or the cached codepoints so the font is not searched for them
+        if (first >= table_codepoints || second >= table_codepoints)
+            return stbtt_GetGlyphKernAdvance(&m_font_info, metrics(first).glyph, metrics(second).glyph);
+
+        if (m_kern_keys.empty())
+            return 0;
+
+        // only the nonzero pairs are stored, an empty slot ends the probe
+        const uint32_t key = first << 16 | second;
+        const size_t i = detail::probe(m_kern_keys, key, empty_key);
+
+        return m_kern_keys[i] == key ? m_kern_values[i] : 0;
+    }
+
+    size_t stb_true_type::cache_codepoints(std::string_view text) noexcept
+    {
+        if (!loaded)
+            return 0;
+
+        size_t added = 0;
+        for (size_t i = 0; i < text.size();)
+        {
+            const uint32_t c = utf8_next(text, i);
+            if (c < table_codepoints || (m_cached_count != 0 && m_cached_keys[detail::probe(m_cached_keys, c, empty_key)] == c))
+                continue;
 
-            if (text[i + 1] != '\0')
+            // at most half full so the probes stay short
+            if ((m_cached_count + 1) * 2 > m_cached_keys.size())
             {
-                int kern = stbtt_GetGlyphKernAdvance(&m_font_info, text[i], text[i + 1]);
-                xpos += kern * scale;
+                std::vector<uint32_t> keys(std::max<size_t>(m_cached_keys.size() * 2, 64), empty_key);
+                std::vector<glyph_metrics> values(keys.size());
+
+                for (size_t k = 0; k < m_cached_keys.size(); ++k)
+                {
+                    if (m_cached_keys[k] == empty_key)
+                        continue;
+
+                    const size_t slot = detail::probe(keys, m_cached_keys[k], empty_key);
+                    keys[slot] = m_cached_keys[k];
+                    values[slot] = m_cached_metrics[k];
+                }
+
+                m_cached_keys = std::move(keys);
+                m_cached_metrics = std::move(values);
             }
+
+            const size_t slot = detail::probe(m_cached_keys, c, empty_key);
+            m_cached_keys[slot] = c;
+            m_cached_metrics[slot] = detail::read_glyph_metrics(&m_font_info, c);
+
+            ++m_cached_count;
+            ++added;
         }
 
-        return true;
+        return added;
     }
-    
-    bool stb_true_type::make_bitmap_multiline(int& bitmap_width, int& bitmap_height, int font_height, const char *text, float line_gap_scale) noexcept
+
+    const std::vector<uint32_t> &stb_true_type::decode(const char *text) noexcept
     {
-        if (!loaded)
+        m_codepoints.clear();
+        utf8_decode(text, m_codepoints);
+        return m_codepoints;
+    }
+
+    [[nodiscard]] std::array<int, 4> stb_true_type::bitmap_box(const glyph_metrics &m, float scale, float shift_x) noexcept
+    {
+        if (!m.has_box)
+            return {0, 0, 0, 0};
+
+        return {
+            (int)std::floor(m.x0 * scale + shift_x),
+            (int)std::floor(-m.y1 * scale),
+            (int)std::ceil(m.x1 * scale + shift_x),
+            (int)std::ceil(-m.y0 * scale)
+        };
+    }
+
+    [[nodiscard]] bool stb_true_type::glyph_fits(int byte_offset, int glyph_width, int glyph_height, int stride) const noexcept
+    {
+        if (byte_offset < 0 || glyph_width < 0 || glyph_height < 0)
+            return false;
+
+        if (glyph_width == 0 || glyph_height == 0)
+            return true;
+
+        return (size_t)byte_offset + (size_t)(glyph_height - 1) * stride + glyph_width <= m_bitmap_data.size();
+    }
+
+    bool stb_true_type::load_file(const char *path) noexcept
+    {
+        m_font_file_data = utils::read_file_bytes_sync(path);
+
+        loaded = false;
+        m_metrics.clear();
+        m_kern_keys.clear();
+        m_kern_values.clear();
+        m_cached_keys.clear();
+        m_cached_metrics.clear();
+        m_cached_count = 0;
+
+       if (!stbtt_InitFont(&m_font_info, m_font_file_data.cbegin().base(), 0))
         {
-            std::cout << "[utils] Error: Font not loaded.\n";
+            std::cout << "[utils] Error: Failed to initialize font from file at " << path << ".\n";
             return false;
         }
 
-        if (bitmap_width <= 0)
+        loaded = true;
+
+        // the metrics of the table codepoints so layout does not search the font for each character
+        m_metrics.resize(table_codepoints);
+        std::vector<uint32_t> present;
+        for (uint32_t c = 0; c < table_codepoints; ++c)
         {
-            std::cout << "[utils] Error: Invalid bitmap width.\n";
-            return false;
+            m_metrics[c] = detail::read_glyph_metrics(&m_font_info, c);
+            if (m_metrics[c].glyph != 0)
+                present.push_back(c);
         }
-        
-        if (font_height <= 0)
+
+        // every pair is asked once so the kern and GPOS tables are both covered. Ex: ~1 ms for 200 glyphs
+        std::vector<std::pair<uint32_t, int16_t>> pairs;
+        for (uint32_t first : present)
         {
-            std::cout << "[utils] Error: Invalid font height.\n";
-            return false;
+            for (uint32_t second : present)
+            {
+                int k = stbtt_GetGlyphKernAdvance(&m_font_info, m_metrics[first].glyph, m_metrics[second].glyph);
+                if (k != 0)
+                    pairs.emplace_back(first << 16 | second, (int16_t)k);
+            }
         }
 
-        int string_width = get_string_width(&m_font_info, text, 0, strlen(text), font_height, bitmap_width);
-        
-        if (string_width <= bitmap_width)
+        if (!pairs.empty())
         {
-            return make_bitmap_line(bitmap_width,  bitmap_height, font_height, text);
+            // at most half full so the probes stay short
+            const size_t size = std::bit_ceil(pairs.size() * 2);
+            m_kern_keys.assign(size, empty_key);
+            m_kern_values.assign(size, 0);
+
+            for (const auto &[key, value] : pairs)
+            {
+                const size_t i = detail::probe(m_kern_keys, key, empty_key);
+                m_kern_keys[i] = key;
+                m_kern_values[i] = value;
+            }
         }
 
+        return true;
+    }
+
+    bool stb_true_type::make_bitmap(int bitmap_width, int bitmap_height, int font_height, const char *text, float line_gap_scale) noexcept
+    {
         float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
+
         int ascent, descent, line_gap;
 
         stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
@@ -413,46 +774,23 @@ namespace utils
 #endif
         }
 
-        int lines = std::ceil((float)string_width / (float)bitmap_width);
-        int height = line_gap * (lines - 1) + (ascent - descent);
-        height = std::max(height, bitmap_height);
-
-        if (bitmap_height != height)
-        {
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Bitmap height provided too small, moving up to fit text (" << height << ").\n";
-#endif
-            bitmap_height = height;
-        }
-
-        int width = bitmap_width;
-
-        if (width % _bitmap_width_correcter != 0)
-        {
-            width += _bitmap_width_correcter - (width % _bitmap_width_correcter);
-
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Bitmap width provided too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
-#endif
-            bitmap_width = width;
-        }
-
-        m_bitmap_data.resize(bitmap_width * bitmap_height);
-        m_bitmap_data.clear();
+        // clear the previous text
+        m_bitmap_data.assign(bitmap_width * bitmap_height, 0);
 
-        float x = 0;
+        int x = 0;
         int line = 0;
         
-        for (size_t i = 0; i < strlen(text); ++i)
+        // decoded once, the glyphs come from the tables or the cached codepoints
+        const auto &codepoints = decode(text);
+        const size_t length = codepoints.size();
+        
+        for (size_t i = 0; i < length; ++i)
         {
-            int ax, lsb;
-            stbtt_GetCodepointHMetrics(&m_font_info, text[i], &ax, &lsb);
+            const glyph_metrics m = metrics(codepoints[i]);
+            int ax = m.advance, lsb = m.left_side_bearing;
 
-            float x_shift = x - (float)std::floor(x);
+            auto [c_x1, c_y1, c_x2, c_y2] = bitmap_box(m, scale);
 
-            int c_x1, c_y1, c_x2, c_y2;
-            stbtt_GetCodepointBitmapBoxSubpixel(&m_font_info, text[i], scale, scale, x_shift, 0, &c_x1, &c_y1, &c_x2, &c_y2);
-            
             if (x + c_x2 - c_x1 >= bitmap_width)
             {
                 x = 0;
@@ -461,24 +799,30 @@ namespace utils
 
             int y = ascent + c_y1 // makes characters like t and h be on the same line as e. from bottom
                     + line * line_gap; // controls height if in another line
-            
+
+            if (y >= bitmap_height)
+                break;  
+
             int byte_offset = x// linear movement of characters 
                             + std::round(lsb * scale) // moves characters to top instead of being at the bottom.
                             + (y * bitmap_width); // moves characters like e to be one same line as larger ones like l. from top
 
-            stbtt_MakeCodepointBitmapSubpixel(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, x_shift, 0, text[i]);
+            // the rest of the text does not fit
+            if (!glyph_fits(byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width))
+                break;
 
-            x += ax * scale; // linear movement of characters
+            stbtt_MakeGlyphBitmap(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, m.glyph);
 
-            int kern;
-            kern = stbtt_GetCodepointKernAdvance(&m_font_info, text[i], text[i + 1]);
-            x += kern * scale; // add kerning to make words look nice.
+            x += std::round(ax * scale); // linear movement of characters
+
+            int kern = this->kern(codepoints[i], i + 1 < length ? codepoints[i + 1] : 0);
+            x += std::round(kern * scale); // add kerning to make words look nice.
         }
 
         return true;
     }
 
-    bool stb_true_type::make_bitmap_fit(int bitmap_width, int bitmap_height, int& font_height, const char *text, float line_gap_scale) noexcept
+    bool stb_true_type::make_bitmap_fixed(int& bitmap_width, int& bitmap_height, int font_height, const char *text, float line_gap_scale) noexcept
     {
         if (!loaded)
         {
@@ -486,72 +830,45 @@ namespace utils
             return false;
         }
 
-        if (bitmap_height <= 0)
+        if (bitmap_width <= 0)
         {
-            std::cout << "[utils] Error: Invalid bitmap height.\n";
+            std::cout << "[utils] Error: Invalid bitmap width.\n";
             return false;
         }
 
-        if (bitmap_width <= 0)
+        if (bitmap_height < font_height)
         {
-            std::cout << "[utils] Error: Invalid bitmap width.\n";
+            std::cout << "[utils] Error: Bitmap height provided too small.\n";
+            return false;
+        }
+        
+        if (font_height <= 0)
+        {
+            std::cout << "[utils] Error: Invalid font height.\n";
             return false;
         }
 
         int width = bitmap_width;
-
+        
         if (width % _bitmap_width_correcter != 0)
         {
-            width += _bitmap_width_correcter - (width % _bitmap_width_correcter);
-
+            width += _bitmap_width_correcter - (bitmap_width % _bitmap_width_correcter);
 #if WRAP_G_DEBUG
             std::cout << "[utils] Info: Bitmap width provided too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
 #endif
             bitmap_width = width;
         }
 
-        // const float f10_width = get_string_width(&m_font_info, text, 0, strlen(text), 10.0, bitmap_width);
-        // const float f20_width = get_string_width(&m_font_info, text, 0, strlen(text), 20.0, bitmap_width);
+        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
 
         int ascent, descent, line_gap;
+
         stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
 
+        ascent = std::round(ascent * scale);
+        descent = std::round(descent * scale);
         line_gap = std::round(line_gap * line_gap_scale);
 
-        int font_height_calc = 0;
-
-        // TODO: find a more math way to calculate the font height
-        while (true)
-        {
-            // int lines =  std::ceil(f10_width * font_height_calc / (10.0 * bitmap_width));
-            const float strw = get_string_width(&m_font_info, text, 0, strlen(text), font_height_calc, bitmap_width);
-            int lines = std::ceil(strw/bitmap_width);
-            int height = (line_gap == 0 ? font_height_calc * line_gap_scale : line_gap) * (lines - 1) + font_height_calc;
-
-            if (height >= bitmap_height)
-            {
-                --font_height_calc;
-                break;
-            }
-
-            ++font_height_calc;
-        }
-
-        if (font_height_calc <= 0)
-        {
-            std::cout << "[utils] Error: Failed to calculate appropriate font height.\n";
-            return false;
-        }
-
-        if (font_height <= 0 || font_height > font_height_calc)
-        {
-#if WRAP_G_DEBUG
-            std::cout << "[utils] Info: Font height provided does not fit inside, moving to " << font_height_calc << "\n";
-#endif
-            font_height = font_height_calc;
-        }
-
-        // TODO: add this smh
         if (line_gap == 0)
         {
             line_gap = font_height * line_gap_scale;
@@ -560,25 +877,23 @@ namespace utils
 #endif
         }
 
-        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
-
-        ascent = std::round(ascent * scale);
-        descent = std::round(descent * scale);
-        
-        m_bitmap_data.resize(bitmap_width * bitmap_height);
-        m_bitmap_data.clear();
+        // clear the previous text
+        m_bitmap_data.assign(bitmap_width * bitmap_height, 0);
 
         int x = 0;
         int line = 0;
         
-        for (size_t i = 0; i < strlen(text); ++i)
+        // decoded once, the glyphs come from the tables or the cached codepoints
+        const auto &codepoints = decode(text);
+        const size_t length = codepoints.size();
+        
+        for (size_t i = 0; i < length; ++i)
         {
-            int ax, lsb;
-            stbtt_GetCodepointHMetrics(&m_font_info, text[i], &ax, &lsb);
+            const glyph_metrics m = metrics(codepoints[i]);
+            int ax = m.advance, lsb = m.left_side_bearing;
+
+            auto [c_x1, c_y1, c_x2, c_y2] = bitmap_box(m, scale);
 
-            int c_x1, c_y1, c_x2, c_y2;
-            stbtt_GetCodepointBitmapBox(&m_font_info, text[i], scale, scale, &c_x1, &c_y1, &c_x2, &c_y2);
-            
             if (x + c_x2 - c_x1 >= bitmap_width)
             {
                 x = 0;
@@ -587,1065 +902,5964 @@ namespace utils
 
             int y = ascent + c_y1 // makes characters like t and h be on the same line as e. from bottom
                     + line * line_gap; // controls height if in another line
+            
+            if (y >= bitmap_height)
+                break;  
+            
+
             int byte_offset = x// linear movement of characters 
                             + std::round(lsb * scale) // moves characters to top instead of being at the bottom.
                             + (y * bitmap_width); // moves characters like e to be one same line as larger ones like l. from top
 
-            stbtt_MakeCodepointBitmap(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, text[i]);
+            // the rest of the text does not fit
+            if (!glyph_fits(byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width))
+                break;
+
+            stbtt_MakeGlyphBitmap(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, m.glyph);
 
             x += std::round(ax * scale); // linear movement of characters
 
-            int kern;
-            kern = stbtt_GetCodepointKernAdvance(&m_font_info, text[i], text[i + 1]);
+            int kern = this->kern(codepoints[i], i + 1 < length ? codepoints[i + 1] : 0);
             x += std::round(kern * scale); // add kerning to make words look nice.
         }
 
         return true;
     }
-    
-    // TODO: make bitmap that assigns size based on height and width
-
-    ////
-    // random
-
-    template <class Engine>
-    random<Engine>::random() noexcept
-        : m_engine(m_seed())
-    {
-    }
-
-    template <class Engine>
-    random<Engine>::result_type random<Engine>::operator()() noexcept
-    {
-        return m_engine();
-    }
 
-    template <class Engine>
-    std::string random<Engine>::operator()(random<Engine>::type string_type, unsigned int len) noexcept
+    bool stb_true_type::make_bitmap_line(int& bitmap_width, int& bitmap_height, int font_height, const char *text) noexcept
     {
-        std::stringstream ss;
-
-        for (unsigned int i = 0; i < len; ++i)
+        if (!loaded)
         {
-            result_type val = m_engine();
-            auto rem = 0;
-
-            switch (string_type)
-            {
-            case type::BIN:
-                ss << val % 2;
-                break;
-            case type::DEC:
-                ss << val % 10;
-                break;
-            case type::HEX:
-                rem = val % 16;
-                ss << (rem < 10 ? rem : (char)(rem - 10 + (int)'a'));
-                break;
-            case type::LETTERS:
-                ss << (char)('a' + val % 26);
-                break;
-            case type::ALPHANUMERIC:
-                rem = val % 36;
-                ss << (rem < 10 ? rem : (char)(rem - 10 + (int)'a'));
-                break;
-            default:
-                break;
-            }
+            std::cout << "[utils] Error: Font not loaded.\n";
+            return false;
+        }
+        
+        if (font_height <= 0)
+        {
+            std::cout << "[utils] Error: Invalid font height.\n";
+            return false;
         }
 
-        return ss.str();
-    }
-
-    ////
-    // timer
-
-    timer::timer(const char *tag) noexcept
-        : m_tag(tag)
-    {
-        start();
-    }
-
-    void timer::start() noexcept
-    {
-        m_start = clock::now();
-    }
+        if (bitmap_height < font_height)
+        {
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Bitmap height provided too small, moving up to nearest line.\n";
+#endif
+            bitmap_height = font_height;
+        }
 
-    template <typename DurationUnit>
-    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
-    [[nodiscard]] int timer::stop() noexcept
-    {
-        return std::chrono::duration_cast<DurationUnit>(clock::now() - m_start).count();
-    }
+        int width = get_string_width(text, 0, strlen(text), font_height);
 
-    ////
-    // metrics
+        width = std::max(width, bitmap_width);
 
-    metrics::metrics(std::ostream& out) noexcept
-        : m_out(out)
-    {
-    }
+        if (width % _bitmap_width_correcter != 0)
+        {
+            width += _bitmap_width_correcter - (width % _bitmap_width_correcter);
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Bitmap width calculated too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
+#endif
+        }
 
-    void metrics::start_tracking() noexcept
-    {
-        m_frames = 0;
-        m_total_time = 0.0;
-        m_last_time = 0.0;
+        if (bitmap_width != width)
+        {
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Bitmap width provided too small moving up to string width (" << width << ").\n";
+#endif
+            bitmap_width = width;
+        }
         
-        m_out << "------------------------------------------\n";
-        m_out << "[metrcis] Debug: Starting tracking.\n";
-    }
-
-    void metrics::track_frame(double dt, bool output) noexcept
-    {
-        ++m_frames;
-        m_last_time = dt;
-        m_total_time += dt;
+        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
 
-        if (output)
-            m_out << "[metrcis] Debug: FPS: " << 1e3 / m_last_time << ", Frame render took " << m_last_time << " ms.\n";
-    }
+        int ascent, descent;
+        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, 0);
 
-    void metrics::finish_tracking() noexcept
-    {
-        m_out << "[metrcis] Debug: Finishing tracking..\n";
-        m_out << "------------------------------------------\n";
-        m_out << "[metrcis] Debug: Total frames: " << m_frames << ".\n";
-        m_out << "[metrcis] Debug: Average frame render time: " << m_total_time / m_frames << " ms.\n";
-        m_out << "[metrcis] Debug: FPS: " << 1e3 * m_frames / m_total_time << "\n";
-        m_out << "[metrcis] Debug: Total rendering code time elapsed: " << m_total_time << " ms \n";
-        m_out << "------------------------------------------\n";
-    }
+        ascent = std::round(ascent * scale);
+        descent = std::round(descent * scale);
+        
+        // clear the previous text
+        m_bitmap_data.assign(bitmap_width * bitmap_height, 0);
 
-    void metrics::save(std::string_view filename, std::vector<std::string_view> extra_fields) noexcept
-    {
-        try
+        float xpos = 0.0f;
+        const auto &codepoints = decode(text);
+        const size_t length = codepoints.size();
+        for (size_t i = 0; i < length; ++i)
         {
-            std::fstream file(filename.data(), std::fstream::app);
-            // file headers must have headers to start
-            // Date, Time, Avg. Render time(ms), FPS, Total Render time (ms),
+            const glyph_metrics m = metrics(codepoints[i]);
+            int ax = m.advance;
             
-            std::stringstream ss{};
+            float x_shift = xpos - (float)std::floor(xpos);
+            auto [c_x1, c_y1, c_x2, c_y2] = bitmap_box(m, scale, x_shift);
 
-            auto now = std::chrono::high_resolution_clock::to_time_t(std::chrono::high_resolution_clock::now());
-            auto now_tm = *std::localtime(&now);            
+            auto stride = width * (ascent + c_y1) + (int)xpos + c_x1;
+            if (!glyph_fits(stride, c_x2 - c_x1, c_y2 - c_y1, width))
+                break;
 
-            ss << std::put_time(&now_tm, "%a, %d %b %Y %H:%M:%S") << ", ";
+            stbtt_MakeGlyphBitmapSubpixel(&m_font_info, m_bitmap_data.data() + stride, c_x2 - c_x1, c_y2 - c_y1, width, scale, scale, x_shift, 0, m.glyph);
 
-            ss << m_total_time / m_frames << ", " << 1e3 * m_frames / m_total_time << ", " << m_total_time;
-            for (auto& field : extra_fields)
+            xpos += ax * scale;
+
+            if (i + 1 < length)
             {
-                ss << ", " << field;
+                int kern = this->kern(codepoints[i], codepoints[i + 1]);
+                xpos += kern * scale;
             }
-            ss << ",\n";
-
-            std::string str = ss.str();
-
-            file.write(str.c_str(), str.size());
-            file.close();
         }
-        catch (const std::fstream::failure& e)
+
+        return true;
+    }
+    
+    bool stb_true_type::make_bitmap_multiline(int& bitmap_width, int& bitmap_height, int font_height, const char *text, float line_gap_scale) noexcept
+    {
+        if (!loaded)
         {
-            std::cout << "[metrics] Error (#" << e.code() << "): " << e.what() << "\n";
+            std::cout << "[utils] Error: Font not loaded.\n";
+            return false;
         }
-    }
-
-    ////
-    // functions
 
-    std::string read_file_sync(const char *path) noexcept
-    {
-        std::string str;
-        std::ifstream file;
-        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
-        try
+        if (bitmap_width <= 0)
         {
-            file.open(path);
-            std::stringstream ss;
-            ss << file.rdbuf();
-            str = ss.str();
-            file.close();
-            return str;
+            std::cout << "[utils] Error: Invalid bitmap width.\n";
+            return false;
         }
-        catch (const std::ifstream::failure &e)
+        
+        if (font_height <= 0)
         {
-            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
-            return str;
+            std::cout << "[utils] Error: Invalid font height.\n";
+            return false;
         }
-    }
 
-    std::future<std::string> read_file_async(const char *path) noexcept
-    {
-        return std::async(std::launch::async, [path](){
-            return read_file_sync(path);
-        });
-    }
-    
-    std::vector<unsigned char> read_file_bytes_sync(const char *path) noexcept
-    {
-        std::vector<unsigned char> data;
-        std::ifstream file;
-        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
-        try
+        int string_width = get_string_width(text, 0, strlen(text), font_height, bitmap_width);
+        
+        if (string_width <= bitmap_width)
         {
-            file.open(path, std::ios::binary);
-            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-            file.close();
-            return data;
+            return make_bitmap_line(bitmap_width,  bitmap_height, font_height, text);
         }
-        catch (const std::ifstream::failure &e)
+
+        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
+        int ascent, descent, line_gap;
+
+        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
+
+        ascent = std::round(ascent * scale);
+        descent = std::round(descent * scale);
+        line_gap = std::round(line_gap * line_gap_scale);
+
+        if (line_gap == 0)
         {
-            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
-            return data;
+            line_gap = font_height * line_gap_scale;
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: No line gap value provided by font file. Setting it to font height (" << font_height << ").\n";
+#endif
         }
-    }
-    
-    std::future<std::vector<unsigned char>> read_file_bytes_async(const char *path) noexcept
-    {
-        return std::async(std::launch::async, [path](){
-            return read_file_bytes_sync(path);
-        });
-    }
 
-    template<typename ... Ts, typename Fn>
-    [[nodiscard]] std::pair<std::array<std::string, sizeof...(Ts)>, std::vector<std::tuple<Ts...>>>
-    read_csv_tuple_sync(const char *path, bool has_headers, Fn&& fn) noexcept
-    {
-        std::vector<std::tuple<Ts...>> data;
-        constexpr size_t data_size = sizeof...(Ts);
-        std::array<std::string, data_size> headers;
+        int lines = std::ceil((float)string_width / (float)bitmap_width);
+        int height = line_gap * (lines - 1) + (ascent - descent);
+        height = std::max(height, bitmap_height);
 
-        std::ifstream file;
-        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
-        try
+        if (bitmap_height != height)
         {
-            file.open(path);
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Bitmap height provided too small, moving up to fit text (" << height << ").\n";
+#endif
+            bitmap_height = height;
+        }
 
-            std::array<std::string, data_size> row_str_arr;
-            std::string row_str;
+        int width = bitmap_width;
 
-            std::getline(file, row_str);
+        if (width % _bitmap_width_correcter != 0)
+        {
+            width += _bitmap_width_correcter - (width % _bitmap_width_correcter);
 
-            auto start = 0;
-            bool is_header = has_headers;
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Bitmap width provided too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
+#endif
+            bitmap_width = width;
+        }
 
-            int param = 0;
+        // clear the previous text
+        m_bitmap_data.assign(bitmap_width * bitmap_height, 0);
 
-            while (row_str.find_first_of(',') != std::string::npos)
-            {
-                auto end = row_str.find_first_of(',', start);
-                if (end == std::string::npos)
-                {
-                    end = row_str.find_first_of('\n', start);
-                }
-                if (end == std::string::npos)
+        float x = 0;
+        int line = 0;
+        
+        // decoded once, the glyphs come from the tables or the cached codepoints
+        const auto &codepoints = decode(text);
+        const size_t length = codepoints.size();
+        
+        for (size_t i = 0; i < length; ++i)
+        {
+            const glyph_metrics m = metrics(codepoints[i]);
+            int ax = m.advance, lsb = m.left_side_bearing;
+
+            float x_shift = x - (float)std::floor(x);
+
+            auto [c_x1, c_y1, c_x2, c_y2] = bitmap_box(m, scale, x_shift);
+            
+            if (x + c_x2 - c_x1 >= bitmap_width)
+            {
+                x = 0;
+                ++line;
+            }
+
+            int y = ascent + c_y1 // makes characters like t and h be on the same line as e. from bottom
+                    + line * line_gap; // controls height if in another line
+            
+            int byte_offset = x// linear movement of characters 
+                            + std::round(lsb * scale) // moves characters to top instead of being at the bottom.
+                            + (y * bitmap_width); // moves characters like e to be one same line as larger ones like l. from top
+
+            // the rest of the text does not fit
+            if (!glyph_fits(byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width))
+                break;
+
+            stbtt_MakeGlyphBitmapSubpixel(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, x_shift, 0, m.glyph);
+
+            x += ax * scale; // linear movement of characters
+
+            int kern = this->kern(codepoints[i], i + 1 < length ? codepoints[i + 1] : 0);
+            x += kern * scale; // add kerning to make words look nice.
+        }
+
+        return true;
+    }
+
+    bool stb_true_type::make_bitmap_fit(int bitmap_width, int bitmap_height, int& font_height, const char *text, float line_gap_scale) noexcept
+    {
+        if (!loaded)
+        {
+            std::cout << "[utils] Error: Font not loaded.\n";
+            return false;
+        }
+
+        if (bitmap_height <= 0)
+        {
+            std::cout << "[utils] Error: Invalid bitmap height.\n";
+            return false;
+        }
+
+        if (bitmap_width <= 0)
+        {
+            std::cout << "[utils] Error: Invalid bitmap width.\n";
+            return false;
+        }
+
+        int width = bitmap_width;
+
+        if (width % _bitmap_width_correcter != 0)
+        {
+            width += _bitmap_width_correcter - (width % _bitmap_width_correcter);
+
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Bitmap width provided too small, moving up to nearest multiple of " << _bitmap_width_correcter <<" (" << width << ").\n";
+#endif
+            bitmap_width = width;
+        }
+
+        // const float f10_width = get_string_width(&m_font_info, text, 0, strlen(text), 10.0, bitmap_width);
+        // const float f20_width = get_string_width(&m_font_info, text, 0, strlen(text), 20.0, bitmap_width);
+
+        int ascent, descent, line_gap;
+        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
+
+        line_gap = std::round(line_gap * line_gap_scale);
+
+        const size_t text_length = strlen(text);
+
+        // the height of the text at a font height, it grows with the font height
+        auto text_height = [&](int font_height_calc) {
+            const float strw = get_string_width(text, 0, text_length, font_height_calc, bitmap_width);
+            int lines = std::ceil(strw/bitmap_width);
+            return (int)((line_gap == 0 ? font_height_calc * line_gap_scale : line_gap) * (lines - 1) + font_height_calc);
+        };
+
+        // binary search for the largest font height whose text is shorter than the bitmap, -1 if none is.
+        // the text is at least as tall as the font height so the answer is below the bitmap height
+        int low = -1, high = bitmap_height - 1;
+        while (low < high)
+        {
+            int mid = low + (high - low + 1) / 2;
+            if (text_height(mid) < bitmap_height)
+                low = mid;
+            else
+                high = mid - 1;
+        }
+
+        int font_height_calc = low;
+
+        if (font_height_calc <= 0)
+        {
+            std::cout << "[utils] Error: Failed to calculate appropriate font height.\n";
+            return false;
+        }
+
+        if (font_height <= 0 || font_height > font_height_calc)
+        {
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: Font height provided does not fit inside, moving to " << font_height_calc << "\n";
+#endif
+            font_height = font_height_calc;
+        }
+
+        // TODO: add this smh
+        if (line_gap == 0)
+        {
+            line_gap = font_height * line_gap_scale;
+#if WRAP_G_DEBUG
+            std::cout << "[utils] Info: No line gap value provided by font file. Setting it to font height (" << font_height << ").\n";
+#endif
+        }
+
+        float scale = stbtt_ScaleForPixelHeight(&m_font_info, font_height);
+
+        ascent = std::round(ascent * scale);
+        descent = std::round(descent * scale);
+        
+        // clear the previous text
+        m_bitmap_data.assign(bitmap_width * bitmap_height, 0);
+
+        int x = 0;
+        int line = 0;
+        
+        const auto &codepoints = decode(text);
+        const size_t length = codepoints.size();
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const glyph_metrics m = metrics(codepoints[i]);
+            int ax = m.advance, lsb = m.left_side_bearing;
+
+            auto [c_x1, c_y1, c_x2, c_y2] = bitmap_box(m, scale);
+            
+            if (x + c_x2 - c_x1 >= bitmap_width)
+            {
+                x = 0;
+                ++line;
+            }
+
+            int y = ascent + c_y1 // makes characters like t and h be on the same line as e. from bottom
+                    + line * line_gap; // controls height if in another line
+            int byte_offset = x// linear movement of characters 
+                            + std::round(lsb * scale) // moves characters to top instead of being at the bottom.
+                            + (y * bitmap_width); // moves characters like e to be one same line as larger ones like l. from top
+
+            // the rest of the text does not fit
+            if (!glyph_fits(byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width))
+                break;
+
+            stbtt_MakeGlyphBitmap(&m_font_info, m_bitmap_data.data() + byte_offset, c_x2 - c_x1, c_y2 - c_y1, bitmap_width, scale, scale, m.glyph);
+
+            x += std::round(ax * scale); // linear movement of characters
+
+            int kern = this->kern(codepoints[i], i + 1 < length ? codepoints[i + 1] : 0);
+            x += std::round(kern * scale); // add kerning to make words look nice.
+        }
+
+        return true;
+    }
+    
+    ////
+    // batches
+
+    [[nodiscard]] std::array<int, 2> stb_true_type::measure(const text_job &job, text_layout &layout) const noexcept
+    {
+        if (job.font_height <= 0)
+            return {0, 0};
+
+        const float wrap = job.width > 0 ? (float)job.width : std::numeric_limits<float>::infinity();
+        const auto &lines = layout.layout(job.text, job.font_height, wrap);
+
+        float widest = 0.0f;
+        for (const auto &l : lines)
+            widest = std::max(widest, l.width);
+
+        return {
+            job.width > 0 ? job.width : (int)std::ceil(widest),
+            job.height > 0 ? job.height : (int)std::ceil(layout.text_height(job.font_height, lines.size()))
+        };
+    }
+
+    void stb_true_type::draw(const text_layout &layout, unsigned char *bitmap, int stride, int width, int height, std::vector<unsigned char> &scratch) const noexcept
+    {
+        for (int y = 0; y < height; ++y)
+            std::memset(bitmap + (size_t)y * stride, 0, width);
+
+        const float scale = stbtt_ScaleForPixelHeight(&m_font_info, layout.font_height());
+
+        int ascent, descent, line_gap;
+        stbtt_GetFontVMetrics(&m_font_info, &ascent, &descent, &line_gap);
+
+        // rounded the same as glyph_atlas::layout
+        const int baseline = std::round(ascent * scale);
+        const float line_height = layout.line_height(layout.font_height());
+
+        for (size_t n = 0; n < layout.lines().size(); ++n)
+        {
+            const auto &l = layout.lines()[n];
+            const std::string_view text = layout.text().substr(l.begin, l.end - l.begin);
+
+            const int top = (int)(n * line_height) + baseline;
+            if (top - baseline >= height)
+                break;
+
+            float pen = 0.0f;
+            uint32_t previous = 0;
+
+            for (size_t i = 0; i < text.size();)
+            {
+                const uint32_t c = utf8_next(text, i);
+
+                if (previous != 0)
+                    pen += kern(previous, c) * scale;
+                previous = c;
+
+                const glyph_metrics m = metrics(c);
+                const float x_shift = pen - std::floor(pen);
+                auto [x0, y0, x1, y1] = bitmap_box(m, scale, x_shift);
+
+                const int gx = (int)std::floor(pen) + x0, gy = top + y0;
+                const int gw = x1 - x0, gh = y1 - y0;
+                pen += m.advance * scale;
+
+                // the part of the glyph inside the bitmap
+                const int cx0 = std::max(gx, 0), cx1 = std::min(gx + gw, width);
+                const int cy0 = std::max(gy, 0), cy1 = std::min(gy + gh, height);
+                if (cx0 >= cx1 || cy0 >= cy1)
+                    continue;
+
+                scratch.assign((size_t)gw * gh, 0);
+                stbtt_MakeGlyphBitmapSubpixel(&m_font_info, scratch.data(), gw, gh, gw, scale, scale, x_shift, 0, m.glyph);
+
+                for (int y = cy0; y < cy1; ++y)
                 {
-                    end = row_str.size();
+                    const unsigned char *src = scratch.data() + (size_t)(y - gy) * gw + (cx0 - gx);
+                    unsigned char *dst = bitmap + (size_t)y * stride + cx0;
+
+                    for (int x = 0; x < cx1 - cx0; ++x)
+                        dst[x] = std::max(dst[x], src[x]);
                 }
+            }
+        }
+    }
+
+    [[nodiscard]] std::vector<stb_true_type::text_bitmap> stb_true_type::make_bitmaps(std::span<const text_job> jobs, job_pool *pool) const noexcept
+    {
+        std::vector<text_bitmap> out(jobs.size());
+
+        if (!loaded)
+        {
+            std::cout << "[utils] Error: Font not loaded.\n";
+            return out;
+        }
+
+        auto make = [&](size_t begin, size_t end) {
+            // reused by the jobs of the chunk
+            std::vector<unsigned char> scratch;
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                text_layout layout(*this);
+                auto [width, height] = measure(jobs[i], layout);
+
+                out[i].width = width;
+                out[i].height = height;
+                out[i].pixels.resize((size_t)width * height);
+
+                if (width > 0 && height > 0)
+                    draw(layout, out[i].pixels.data(), width, width, height, scratch);
+            }
+        };
+
+        // a label takes tens of microseconds
+        if (pool != nullptr)
+            pool->parallel_for(jobs.size(), 4, make);
+        else
+            make(0, jobs.size());
+
+        return out;
+    }
+
+    [[nodiscard]] std::vector<stb_true_type::text_bitmap> stb_true_type::make_bitmaps(std::span<const text_job> jobs, std::span<unsigned char> page, int page_width, job_pool *pool) const noexcept
+    {
+        std::vector<text_bitmap> out(jobs.size());
+
+        if (!loaded)
+        {
+            std::cout << "[utils] Error: Font not loaded.\n";
+            return out;
+        }
+
+        if (page_width <= 0)
+        {
+            std::cout << "[utils] Error: Invalid page width.\n";
+            return out;
+        }
+
+        const int page_height = (int)(page.size() / page_width);
+
+        std::vector<text_layout> layouts;
+        layouts.reserve(jobs.size());
+        for (size_t i = 0; i < jobs.size(); ++i)
+            layouts.emplace_back(*this);
+
+        auto run = [&](auto &&fn) {
+            if (pool != nullptr)
+                pool->parallel_for(jobs.size(), 4, fn);
+            else
+                fn(0, jobs.size());
+        };
+
+        // the sizes are needed to pack the rects so the texts are laid out first
+        run([&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto [width, height] = measure(jobs[i], layouts[i]);
+                out[i].width = width;
+                out[i].height = height;
+            }
+        });
+
+        // tallest first on shelves, the same as glyph_atlas, with a pixel between the texts
+        constexpr int padding = 1;
+
+        std::vector<size_t> order(jobs.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::sort(order.begin(), order.end(), [&](size_t l, size_t r) { return out[l].height > out[r].height; });
+
+        int shelf_y = 0, shelf_height = 0, used = 0;
+        for (size_t i : order)
+        {
+            text_bitmap &b = out[i];
+            if (b.width <= 0 || b.height <= 0)
+                continue;
+
+            if (used != 0 && used + b.width > page_width)
+            {
+                shelf_y += shelf_height + padding;
+                shelf_height = 0;
+                used = 0;
+            }
+
+            if (b.width > page_width || shelf_y + b.height > page_height)
+            {
+                b.width = 0;
+                b.height = 0;
+                continue;
+            }
+
+            b.x = used;
+            b.y = shelf_y;
+            used += b.width + padding;
+            shelf_height = std::max(shelf_height, b.height);
+        }
+
+        // the rects do not overlap so the jobs draw into the page at once
+        run([&](size_t begin, size_t end) {
+            std::vector<unsigned char> scratch;
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const text_bitmap &b = out[i];
+                if (b.width > 0 && b.height > 0)
+                    draw(layouts[i], page.data() + (size_t)b.y * page_width + b.x, page_width, b.width, b.height, scratch);
+            }
+        });
+
+        return out;
+    }
+
+    // TODO: make bitmap that assigns size based on height and width
+
+    ////
+    // text layout
+
+    text_layout::text_layout(const stb_true_type &font) noexcept
+        : m_font(&font)
+    {
+        if (!font.valid())
+            std::cout << "[utils] Error: Font not loaded.\n";
+    }
+
+    const std::vector<text_layout::line> &text_layout::layout(std::string_view text, int font_height, float width) noexcept
+    {
+        m_broken = 0;
+
+        if (!m_current.lines.empty() && m_current.font_height == font_height && m_current.width == width && m_current.text == text)
+            return m_current.lines;
+
+        // the previous layout is kept for reuse whichever way the new one is made
+        auto stash = [this]() {
+            if (m_current.lines.empty())
+                return;
+
+            if (m_cache.size() >= cache_size)
+                m_cache.clear();
+            m_cache.insert_or_assign(hash(m_current.text, m_current.font_height, m_current.width), std::move(m_current));
+        };
+
+        auto it = m_cache.find(hash(text, font_height, width));
+        if (it != m_cache.end() && it->second.font_height == font_height && it->second.width == width && it->second.text == text)
+        {
+            entry found = std::move(it->second);
+            m_cache.erase(it);
+
+            stash();
+            m_current = std::move(found);
+            return m_current.lines;
+        }
+
+        entry next{std::string(text), font_height, width, {}};
+        size_t from = 0, kept = 0;
+
+        // the lines before the one with the first change are the same. The line before that can take the
+        // start of the changed word so it is broken again too
+        if (!m_current.lines.empty() && m_current.font_height == font_height && m_current.width == width)
+        {
+            const auto &old = m_current.lines;
+            const size_t common = std::mismatch(text.begin(), text.end(), m_current.text.begin(), m_current.text.end()).first - text.begin();
+
+            size_t changed = 0;
+            while (changed + 1 < old.size() && old[changed + 1].begin <= common)
+                ++changed;
+
+            kept = changed > 0 ? changed - 1 : 0;
+            next.lines.assign(old.begin(), old.begin() + kept);
+            from = old[kept].begin;
+        }
+
+        if (m_font->valid() && font_height > 0)
+            break_lines(text, from, font_height, width, next.lines);
+        else
+            next.lines.assign(1, line{0, (uint32_t)text.size(), 0.0f});
+
+        m_broken = next.lines.size() - kept;
+
+        stash();
+        m_current = std::move(next);
+        return m_current.lines;
+    }
+
+    [[nodiscard]] int text_layout::fit(std::string_view text, float width, float height) noexcept
+    {
+        if (!m_font->valid() || width <= 0.0f || height <= 0.0f)
+            return 0;
+
+        auto fits = [&](int font_height) {
+            m_scratch.clear();
+            break_lines(text, 0, font_height, width, m_scratch);
+
+            if (text_height(font_height, m_scratch.size()) > height)
+                return false;
+
+            return std::all_of(m_scratch.begin(), m_scratch.end(), [width](const line &l) { return l.width <= width; });
+        };
+
+        // one line is as tall as the font height so it is the most that can fit
+        int low = 0, high = (int)height;
+        while (low < high)
+        {
+            int mid = low + (high - low + 1) / 2;
+            if (fits(mid))
+                low = mid;
+            else
+                high = mid - 1;
+        }
+
+        return low;
+    }
+
+    [[nodiscard]] float text_layout::line_height(int font_height) const noexcept
+    {
+        if (!m_font->valid())
+            return 0.0f;
+
+        int ascent, descent, line_gap;
+        stbtt_GetFontVMetrics(m_font->font_info(), &ascent, &descent, &line_gap);
+
+        // rounded the same as glyph_atlas::layout
+        return std::round((ascent - descent + line_gap) * stbtt_ScaleForPixelHeight(m_font->font_info(), font_height));
+    }
+
+    [[nodiscard]] float text_layout::text_height(int font_height, size_t lines) const noexcept
+    {
+        if (!m_font->valid() || lines == 0)
+            return 0.0f;
+
+        int ascent, descent, line_gap;
+        stbtt_GetFontVMetrics(m_font->font_info(), &ascent, &descent, &line_gap);
+
+        return (lines - 1) * line_height(font_height) + (ascent - descent) * stbtt_ScaleForPixelHeight(m_font->font_info(), font_height);
+    }
+
+    void text_layout::clear_cache() noexcept
+    {
+        m_cache.clear();
+    }
+
+    [[nodiscard]] uint64_t text_layout::hash(std::string_view text, int font_height, float width) noexcept
+    {
+        return std::hash<std::string_view>{}(text) ^ ((uint64_t)(uint32_t)font_height << 32 | std::bit_cast<uint32_t>(width)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    void text_layout::break_lines(std::string_view text, size_t from, int font_height, float width, std::vector<line> &out) const noexcept
+    {
+        constexpr size_t none = ~size_t{0};
+        const float scale = stbtt_ScaleForPixelHeight(m_font->font_info(), font_height);
+
+        size_t i = from;
+        while (true)
+        {
+            const size_t begin = i;
+            float pen = 0.0f;
+            uint32_t previous = 0;
+
+            // the run of spaces the pen is in and the width before it
+            size_t spaces = none;
+            float spaces_width = 0.0f;
+
+            // the last place the line can end, before a run of spaces, and the word after it
+            size_t wrap = none, wrap_next = 0;
+            float wrap_width = 0.0f;
+
+            line l{(uint32_t)begin, 0, 0.0f};
+            size_t next = none;
+
+            for (size_t after = i; i < text.size(); i = after)
+            {
+                const uint32_t c = utf8_next(text, after);
+                if (c == '\n')
+                {
+                    next = i + 1;
+                    break;
+                }
+
+                const float advance = (previous != 0 ? m_font->kern(previous, c) * scale : 0.0f) + m_font->metrics(c).advance * scale;
+
+                if (c == ' ')
+                {
+                    if (spaces == none)
+                    {
+                        spaces = i;
+                        spaces_width = pen;
+                    }
+                }
+                else
+                {
+                    // leading spaces, ex: an indent after a '\n', are not a place to wrap
+                    if (spaces != none && spaces > begin)
+                    {
+                        wrap = spaces;
+                        wrap_width = spaces_width;
+                        wrap_next = i;
+                    }
+                    spaces = none;
+
+                    // spaces hang past the width, the first other character which does not fit ends the line
+                    if (pen + advance > width && i > begin)
+                    {
+                        if (wrap != none)
+                        {
+                            l.end = wrap;
+                            l.width = wrap_width;
+                            next = wrap_next;
+                        }
+                        else
+                        {
+                            // a word longer than the line is split
+                            l.end = i;
+                            l.width = pen;
+                            next = i;
+                        }
+
+                        out.push_back(l);
+                        break;
+                    }
+                }
+
+                pen += advance;
+                previous = c;
+            }
+
+            // ended by a '\n' or the end of the text, without its trailing spaces
+            if (i == text.size() || text[i] == '\n')
+            {
+                l.end = spaces != none ? spaces : i;
+                l.width = spaces != none ? spaces_width : pen;
+                out.push_back(l);
+
+                if (i == text.size())
+                    return;
+            }
+
+            i = next;
+        }
+    }
+
+    ////
+    // glyph atlas
+
+    glyph_atlas::glyph_atlas(const stb_true_type &font, int width, int height) noexcept
+        : m_font(&font), m_width(std::clamp(width, 1, 65535)), m_height(std::clamp(height, 1, 65535)), m_pixels((size_t)m_width * m_height, 0)
+    {
+        if (!font.valid())
+            std::cout << "[utils] Error: Font not loaded.\n";
+    }
+
+    glyph_atlas::glyph_atlas(const stb_true_type &font, const sdf_settings &sdf, int width, int height) noexcept
+        : glyph_atlas(font, width, height)
+    {
+        m_sdf = true;
+        m_sdf_settings = sdf_settings{std::max(sdf.font_height, 1), std::clamp(sdf.spread, 1, 127)};
+    }
+
+    const atlas_glyph *glyph_atlas::find(uint32_t codepoint, int font_height) noexcept
+    {
+        // references to the glyphs stay valid when the map grows
+        auto it = m_glyphs.find(key(codepoint, font_height));
+        if (it != m_glyphs.end())
+            return &it->second;
+
+        if (!m_font->valid() || (!m_sdf && font_height <= 0))
+            return nullptr;
+
+        return place(rasterize(codepoint, font_height));
+    }
+
+    size_t glyph_atlas::prepare(std::string_view text, int font_height, job_pool *pool) noexcept
+    {
+        if (!m_font->valid() || (!m_sdf && font_height <= 0))
+            return 0;
+
+        // the codepoints missing from the atlas, once each
+        std::vector<uint32_t> missing;
+        for (size_t i = 0; i < text.size();)
+            if (const uint32_t c = utf8_next(text, i); c != '\n' && !m_glyphs.contains(key(c, font_height)) && std::find(missing.begin(), missing.end(), c) == missing.end())
+                missing.push_back(c);
+
+        std::vector<bitmap> made(missing.size());
+        auto make = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                made[i] = rasterize(missing[i], font_height);
+        };
+
+        // a distance field takes a few hundred microseconds, a coverage glyph a few
+        if (pool != nullptr)
+            pool->parallel_for(made.size(), m_sdf ? 1 : 16, make);
+        else
+            make(0, made.size());
+
+        // tallest first fills each shelf with glyphs of about its height
+        std::sort(made.begin(), made.end(), [](const bitmap &l, const bitmap &r) { return l.glyph.height > r.glyph.height; });
+
+        size_t added = 0;
+        for (const auto &b : made)
+            added += place(b) != nullptr;
+
+        return added;
+    }
+
+    glyph_atlas::bitmap glyph_atlas::rasterize(uint32_t codepoint, int font_height) const noexcept
+    {
+        const stbtt_fontinfo *info = m_font->font_info();
+        const int height = m_sdf ? m_sdf_settings.font_height : font_height;
+        const float scale = stbtt_ScaleForPixelHeight(info, height);
+
+        bitmap b;
+        b.key = key(codepoint, font_height);
+
+        const auto m = m_font->metrics(codepoint);
+        b.glyph.advance = m.advance * scale;
+
+        int width = 0, rows = 0, x_offset = 0, y_offset = 0;
+        if (m_sdf)
+        {
+            // 0.5 on the outline, spread pixels away it reaches 0 outside and 1 inside
+            const int spread = m_sdf_settings.spread;
+            unsigned char *field = stbtt_GetGlyphSDF(info, scale, m.glyph, spread, 128, 128.0f / spread, &width, &rows, &x_offset, &y_offset);
+
+            // nullptr for glyphs without an outline. Ex: a space
+            if (field != nullptr)
+            {
+                b.pixels.assign(field, field + (size_t)width * rows);
+                stbtt_FreeSDF(field, nullptr);
+            }
+            else
+                width = rows = 0;
+        }
+        else
+        {
+            auto [x1, y1, x2, y2] = stb_true_type::bitmap_box(m, scale);
+
+            width = x2 - x1;
+            rows = y2 - y1;
+            x_offset = x1;
+            y_offset = y1;
+
+            if (width > 0 && rows > 0)
+            {
+                b.pixels.resize((size_t)width * rows);
+                stbtt_MakeGlyphBitmap(info, b.pixels.data(), width, rows, width, scale, scale, m.glyph);
+            }
+        }
+
+        b.glyph.x_offset = x_offset;
+        b.glyph.y_offset = y_offset;
+        if (!b.pixels.empty())
+        {
+            b.glyph.width = width;
+            b.glyph.height = rows;
+        }
+
+        return b;
+    }
+
+    const atlas_glyph *glyph_atlas::place(const bitmap &b) noexcept
+    {
+        atlas_glyph glyph = b.glyph;
+        const int width = glyph.width, height = glyph.height;
+
+        if (width > 0 && height > 0)
+        {
+            int x, y;
+            if (!pack(width + padding, height + padding, x, y))
+            {
+                m_full = true;
+                return nullptr;
+            }
+
+            for (int row = 0; row < height; ++row)
+                std::memcpy(&m_pixels[(size_t)(y + row) * m_width + x], &b.pixels[(size_t)row * width], width);
+
+            glyph.x = x;
+            glyph.y = y;
+
+            // grow the dirty rect to cover the glyph
+            if (m_dirty.empty())
+                m_dirty = rect{x, y, width, height};
+            else
+            {
+                int right = std::max(m_dirty.x + m_dirty.width, x + width);
+                int bottom = std::max(m_dirty.y + m_dirty.height, y + height);
+                m_dirty.x = std::min(m_dirty.x, x);
+                m_dirty.y = std::min(m_dirty.y, y);
+                m_dirty.width = right - m_dirty.x;
+                m_dirty.height = bottom - m_dirty.y;
+            }
+        }
+
+        return &m_glyphs.emplace(b.key, glyph).first->second;
+    }
+
+    glm::vec2 glyph_atlas::layout(std::string_view text, int font_height, glm::vec2 position, glm::u8vec4 color, std::vector<glyph_quad> &out) noexcept
+    {
+        if (!m_font->valid() || font_height <= 0)
+            return position;
+
+        const stbtt_fontinfo *info = m_font->font_info();
+        float scale = stbtt_ScaleForPixelHeight(info, font_height);
+
+        // the glyph metrics are at the font height the fields were made at
+        const float glyph_scale = m_sdf ? font_height / (float)m_sdf_settings.font_height : 1.0f;
+
+        int ascent, descent, line_gap;
+        stbtt_GetFontVMetrics(info, &ascent, &descent, &line_gap);
+
+        const float baseline = m_sdf ? ascent * scale : std::round(ascent * scale);
+        const float line_height = std::round((ascent - descent + line_gap) * scale);
+
+        glm::vec2 pen = position;
+        uint32_t previous = 0;
+
+        for (size_t i = 0; i < text.size();)
+        {
+            const uint32_t c = utf8_next(text, i);
+            if (c == '\n')
+            {
+                pen.x = position.x;
+                pen.y += line_height;
+                previous = 0;
+                continue;
+            }
+
+            if (previous != 0)
+                pen.x += m_font->kern(previous, c) * scale;
+            previous = c;
+
+            const atlas_glyph *glyph = find(c, font_height);
+            if (glyph == nullptr)
+                continue;
+
+            if (glyph->width != 0)
+            {
+                // whole pixels so each texel of a coverage glyph covers one pixel of the screen
+                glm::vec2 origin = m_sdf ? glm::vec2{pen.x, pen.y + baseline} : glm::vec2{std::round(pen.x), std::round(pen.y) + baseline};
+
+                out.push_back(glyph_quad{
+                    glm::vec4{origin.x + glyph->x_offset * glyph_scale, origin.y + glyph->y_offset * glyph_scale, glyph->width * glyph_scale, glyph->height * glyph_scale},
+                    glm::u16vec4{glyph->x, glyph->y, glyph->width, glyph->height},
+                    color
+                });
+            }
+
+            pen.x += glyph->advance * glyph_scale;
+        }
+
+        return pen;
+    }
+
+    glm::vec2 glyph_atlas::layout(const text_layout &lines, glm::vec2 position, glm::u8vec4 color, std::vector<glyph_quad> &out) noexcept
+    {
+        const float line_height = lines.line_height(lines.font_height());
+
+        glm::vec2 pen = position;
+        for (size_t i = 0; i < lines.lines().size(); ++i)
+        {
+            const auto &l = lines.lines()[i];
+            pen = layout(lines.text().substr(l.begin, l.end - l.begin), lines.font_height(), glm::vec2{position.x, position.y + i * line_height}, color, out);
+        }
+
+        return pen;
+    }
+
+    glyph_atlas::rect glyph_atlas::take_dirty() noexcept
+    {
+        return std::exchange(m_dirty, rect{});
+    }
+
+    void glyph_atlas::clear() noexcept
+    {
+        m_glyphs.clear();
+        m_shelves.clear();
+        std::fill(m_pixels.begin(), m_pixels.end(), 0);
+
+        m_dirty = rect{0, 0, m_width, m_height};
+        m_full = false;
+    }
+
+    bool glyph_atlas::save(const char *path, uint64_t source_stamp) const noexcept
+    {
+        const file_header h{file_magic, file_version, (uint32_t)m_width, (uint32_t)m_height, m_sdf, (uint32_t)m_sdf_settings.font_height,
+            (uint32_t)m_sdf_settings.spread, (uint32_t)m_glyphs.size(), (uint32_t)m_shelves.size(), 0, source_stamp};
+
+        std::ofstream file;
+        file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+        try
+        {
+            file.open(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+
+            for (const auto &[k, glyph] : m_glyphs)
+            {
+                file.write(reinterpret_cast<const char *>(&k), sizeof(k));
+                file.write(reinterpret_cast<const char *>(&glyph), sizeof(glyph));
+            }
+
+            file.write(reinterpret_cast<const char *>(m_shelves.data()), m_shelves.size() * sizeof(shelf));
+            file.write(reinterpret_cast<const char *>(m_pixels.data()), m_pixels.size());
+            file.close();
+            return true;
+        }
+        catch (const std::ofstream::failure &e)
+        {
+            std::cout << "[utils] Error: Failed to write glyph atlas " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return false;
+        }
+    }
+
+    bool glyph_atlas::load(const char *path, uint64_t source_stamp) noexcept
+    {
+        if (std::error_code error; !std::filesystem::exists(path, error))
+            return false;
+
+        auto bytes = read_file_bytes_sync(path);
+
+        file_header h;
+        if (bytes.size() < sizeof(h))
+        {
+            std::cout << "[utils] Error: Glyph atlas " << path << " is too small.\n";
+            return false;
+        }
+        std::memcpy(&h, bytes.data(), sizeof(h));
+
+        const size_t glyph_bytes = sizeof(uint64_t) + sizeof(atlas_glyph);
+        if (h.magic != file_magic || h.version != file_version
+            || bytes.size() != sizeof(h) + h.glyph_count * glyph_bytes + h.shelf_count * sizeof(shelf) + m_pixels.size())
+        {
+            std::cout << "[utils] Error: Glyph atlas " << path << " is not a glyph atlas file or is corrupted.\n";
+            return false;
+        }
+
+        // a stale atlas, ex: of another font, is made again instead
+        if (h.source_stamp != source_stamp || h.width != (uint32_t)m_width || h.height != (uint32_t)m_height || (h.sdf != 0) != m_sdf
+            || (m_sdf && (h.sdf_font_height != (uint32_t)m_sdf_settings.font_height || h.sdf_spread != (uint32_t)m_sdf_settings.spread)))
+            return false;
+
+        const unsigned char *at = bytes.data() + sizeof(h);
+
+        m_glyphs.clear();
+        m_glyphs.reserve(h.glyph_count);
+        for (uint32_t i = 0; i < h.glyph_count; ++i, at += glyph_bytes)
+        {
+            uint64_t k;
+            atlas_glyph glyph;
+            std::memcpy(&k, at, sizeof(k));
+            std::memcpy(&glyph, at + sizeof(k), sizeof(glyph));
+            m_glyphs.emplace(k, glyph);
+        }
+
+        m_shelves.resize(h.shelf_count);
+        std::memcpy(m_shelves.data(), at, h.shelf_count * sizeof(shelf));
+        at += h.shelf_count * sizeof(shelf);
+
+        std::memcpy(m_pixels.data(), at, m_pixels.size());
+
+        m_dirty = rect{0, 0, m_width, m_height};
+        m_full = false;
+
+        return true;
+    }
+
+    bool glyph_atlas::pack(int width, int height, int &x, int &y) noexcept
+    {
+        // the shortest shelf the rect fits on wastes the least height
+        shelf *best = nullptr;
+        for (auto &s : m_shelves)
+            if (s.height >= height && m_width - s.used >= width && (best == nullptr || s.height < best->height))
+                best = &s;
+
+        // a shelf twice as tall as the rect wastes over half its height, start a new one while there is room
+        const int top = m_shelves.empty() ? padding : m_shelves.back().y + m_shelves.back().height;
+        if ((best == nullptr || best->height > height * 2) && top + height <= m_height && padding + width <= m_width)
+            best = &m_shelves.emplace_back(shelf{top, height, padding});
+
+        if (best == nullptr)
+            return false;
+
+        x = best->used;
+        y = best->y;
+        best->used += width;
+
+        return true;
+    }
+
+    ////
+    // text surface
+
+    text_surface::text_surface(const stb_true_type &font, int width, int height, int font_height) noexcept
+        : m_font(&font), m_width(std::max(width, 0)), m_height(std::max(height, 0)), m_font_height(font_height),
+          m_pixels((size_t)m_width * m_height, 0)
+    {
+        if (!font.valid())
+            std::cout << "[utils] Error: Font not loaded.\n";
+
+        if (m_width != 0 && m_height != 0)
+            m_dirty.push_back(rect{0, 0, m_width, m_height});
+    }
+
+    bool text_surface::update(std::string_view text) noexcept
+    {
+        if (text == m_text || !m_font->valid() || m_font_height <= 0)
+            return false;
+
+        m_text.assign(text);
+
+        m_next.clear();
+        layout(text, m_next);
+
+        // the cells are in text order so an edit only misaligns the cells after it, which moved anyway
+        m_changed.clear();
+        const size_t count = std::max(m_cells.size(), m_next.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const bool in_old = i < m_cells.size(), in_new = i < m_next.size();
+            if (in_old && in_new && m_cells[i] == m_next[i])
+                continue;
+
+            if (in_old)
+                m_changed.push_back(bounds(m_cells[i]));
+            if (in_new)
+                m_changed.push_back(bounds(m_next[i]));
+        }
+
+        std::swap(m_cells, m_next);
+
+        std::erase_if(m_changed, [](const rect &r) { return r.empty(); });
+        if (m_changed.empty())
+            return false;
+
+        merge(m_changed);
+        for (const auto &r : m_changed)
+            redraw(r);
+
+        m_dirty.insert(m_dirty.end(), m_changed.begin(), m_changed.end());
+        merge(m_dirty);
+
+        return true;
+    }
+
+    void text_surface::set_font_height(int font_height) noexcept
+    {
+        if (font_height == m_font_height)
+            return;
+
+        m_font_height = font_height;
+        m_glyphs.clear();
+
+        m_cells.clear();
+        if (m_font->valid() && m_font_height > 0)
+            layout(m_text, m_cells);
+
+        const rect all{0, 0, m_width, m_height};
+        if (all.empty())
+            return;
+
+        redraw(all);
+        m_dirty.assign(1, all);
+    }
+
+    const text_surface::glyph &text_surface::find(uint32_t codepoint) noexcept
+    {
+        auto [it, inserted] = m_glyphs.try_emplace(codepoint);
+        if (!inserted)
+            return it->second;
+
+        const float scale = stbtt_ScaleForPixelHeight(m_font->font_info(), m_font_height);
+        const auto m = m_font->metrics(codepoint);
+        auto [x0, y0, x1, y1] = stb_true_type::bitmap_box(m, scale);
+
+        glyph &g = it->second;
+        g.width = x1 - x0;
+        g.height = y1 - y0;
+        g.pixels.assign((size_t)g.width * g.height, 0);
+
+        if (!g.pixels.empty())
+            stbtt_MakeGlyphBitmap(m_font->font_info(), g.pixels.data(), g.width, g.height, g.width, scale, scale, m.glyph);
+
+        return g;
+    }
+
+    void text_surface::layout(std::string_view text, std::vector<cell> &out) noexcept
+    {
+        const stbtt_fontinfo *info = m_font->font_info();
+        const float scale = stbtt_ScaleForPixelHeight(info, m_font_height);
+
+        int ascent, descent, line_gap;
+        stbtt_GetFontVMetrics(info, &ascent, &descent, &line_gap);
+
+        // rounded the same as glyph_atlas::layout
+        const int baseline = std::round(ascent * scale);
+        const int line_height = std::round((ascent - descent + line_gap) * scale);
+
+        float pen_x = 0.0f;
+        int pen_y = 0;
+        uint32_t previous = 0;
+
+        for (size_t i = 0; i < text.size();)
+        {
+            const uint32_t c = utf8_next(text, i);
+            if (c == '\n')
+            {
+                pen_x = 0.0f;
+                pen_y += line_height;
+                previous = 0;
+                continue;
+            }
+
+            if (previous != 0)
+                pen_x += m_font->kern(previous, c) * scale;
+            previous = c;
+
+            const auto m = m_font->metrics(c);
+            auto [x0, y0, x1, y1] = stb_true_type::bitmap_box(m, scale);
+
+            // whole pixels so a glyph is the same wherever it is
+            const int x = (int)std::round(pen_x) + x0;
+            const int y = pen_y + baseline + y0;
+
+            if (x1 > x0 && y1 > y0 && x < m_width && y < m_height && x + x1 - x0 > 0 && y + y1 - y0 > 0)
+                out.push_back(cell{c, x, y});
+
+            pen_x += m.advance * scale;
+        }
+    }
+
+    void text_surface::redraw(const rect &r) noexcept
+    {
+        for (int y = r.y; y < r.y + r.height; ++y)
+            std::memset(m_pixels.data() + (size_t)y * m_width + r.x, 0, r.width);
+
+        for (const auto &c : m_cells)
+        {
+            const glyph &g = find(c.codepoint);
+
+            const int x0 = std::max(c.x, r.x), x1 = std::min(c.x + g.width, r.x + r.width);
+            const int y0 = std::max(c.y, r.y), y1 = std::min(c.y + g.height, r.y + r.height);
+            if (x0 >= x1 || y0 >= y1)
+                continue;
+
+            for (int y = y0; y < y1; ++y)
+            {
+                const unsigned char *src = g.pixels.data() + (size_t)(y - c.y) * g.width + (x0 - c.x);
+                unsigned char *dst = m_pixels.data() + (size_t)y * m_width + x0;
+
+                for (int x = 0; x < x1 - x0; ++x)
+                    dst[x] = std::max(dst[x], src[x]);
+            }
+        }
+    }
+
+    text_surface::rect text_surface::bounds(const cell &c) noexcept
+    {
+        const glyph &g = find(c.codepoint);
+
+        const int x0 = std::max(c.x, 0), x1 = std::min(c.x + g.width, m_width);
+        const int y0 = std::max(c.y, 0), y1 = std::min(c.y + g.height, m_height);
+
+        return rect{x0, y0, x1 - x0, y1 - y0};
+    }
+
+    void text_surface::merge(std::vector<rect> &rects) noexcept
+    {
+        auto area = [](const rect &r) { return (int64_t)r.width * r.height; };
+
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+
+            for (size_t i = 0; i < rects.size() && !merged; ++i)
+            {
+                for (size_t j = i + 1; j < rects.size(); ++j)
+                {
+                    const rect &a = rects[i], &b = rects[j];
+
+                    const int x0 = std::min(a.x, b.x), x1 = std::max(a.x + a.width, b.x + b.width);
+                    const int y0 = std::min(a.y, b.y), y1 = std::max(a.y + a.height, b.y + b.height);
+                    const rect u{x0, y0, x1 - x0, y1 - y0};
+
+                    const bool overlap = a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+
+                    // neighbouring glyphs of a line are merged, rects far apart are uploaded on their own
+                    if (overlap || area(u) <= 2 * (area(a) + area(b)))
+                    {
+                        rects[i] = u;
+                        rects.erase(rects.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (rects.size() > max_dirty_rects)
+        {
+            rect u = rects[0];
+            for (const auto &r : rects)
+            {
+                const int x1 = std::max(u.x + u.width, r.x + r.width), y1 = std::max(u.y + u.height, r.y + r.height);
+                u.x = std::min(u.x, r.x);
+                u.y = std::min(u.y, r.y);
+                u.width = x1 - u.x;
+                u.height = y1 - u.y;
+            }
+
+            rects.assign(1, u);
+        }
+    }
+
+    ////
+    // random
+
+    template <class Engine>
+    random<Engine>::random() noexcept
+        : m_engine(m_seed())
+    {
+    }
+
+    template <class Engine>
+    random<Engine>::result_type random<Engine>::operator()() noexcept
+    {
+        return m_engine();
+    }
+
+    template <class Engine>
+    std::string random<Engine>::operator()(random<Engine>::type string_type, unsigned int len) noexcept
+    {
+        // one allocation for the string instead of a stringstream
+        constexpr std::string_view digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+        std::string str(len, '\0');
+
+        for (unsigned int i = 0; i < len; ++i)
+        {
+            result_type val = m_engine();
+
+            switch (string_type)
+            {
+            case type::BIN:
+                str[i] = digits[val % 2];
+                break;
+            case type::DEC:
+                str[i] = digits[val % 10];
+                break;
+            case type::HEX:
+                str[i] = digits[val % 16];
+                break;
+            case type::LETTERS:
+                str[i] = digits[10 + val % 26];
+                break;
+            case type::ALPHANUMERIC:
+                str[i] = digits[val % 36];
+                break;
+            default:
+                break;
+            }
+        }
+
+        return str;
+    }
+
+    ////
+    // timer
+
+    timer::timer(const char *tag) noexcept
+        : m_tag(tag)
+    {
+        start();
+    }
+
+    void timer::start() noexcept
+    {
+        m_start = clock::now();
+    }
+
+    template <typename DurationUnit>
+    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
+    [[nodiscard]] int timer::stop() noexcept
+    {
+        return std::chrono::duration_cast<DurationUnit>(clock::now() - m_start).count();
+    }
+
+    [[nodiscard]] double timer::stop_ms() noexcept
+    {
+        return std::chrono::duration<double, std::milli>(clock::now() - m_start).count();
+    }
+
+    ////
+    // metrics
+
+    metrics::metrics(std::ostream& out) noexcept
+        : m_out(out)
+    {
+    }
+
+    void metrics::start_tracking() noexcept
+    {
+        m_frames = 0;
+        m_total_time = 0.0;
+        m_last_time = 0.0;
+        m_gpu_frames = 0;
+        m_total_gpu_time = 0.0;
+        m_samples.clear();
+        m_gpu_samples.clear();
+
+        m_last_allocations = 0;
+        m_last_allocated_bytes = 0;
+        m_total_allocations = 0;
+        m_total_allocated_bytes = 0;
+        m_max_allocations = 0;
+        m_allocating_frames = 0;
+
+        m_counters.clear();
+
+        auto allocs = alloc_tracker::totals();
+        m_alloc_mark = allocs.allocations;
+        m_alloc_bytes_mark = allocs.bytes;
+        
+        m_out << "------------------------------------------\n";
+        m_out << "[metrcis] Debug: Starting tracking.\n";
+    }
+
+    void metrics::track_frame(double dt, bool output) noexcept
+    {
+        ++m_frames;
+        m_last_time = dt;
+        m_total_time += dt;
+
+        if (m_track_allocations)
+        {
+            auto allocs = alloc_tracker::totals();
+            m_last_allocations = allocs.allocations - m_alloc_mark;
+            m_last_allocated_bytes = allocs.bytes - m_alloc_bytes_mark;
+
+            m_total_allocations += m_last_allocations;
+            m_total_allocated_bytes += m_last_allocated_bytes;
+            m_max_allocations = std::max(m_max_allocations, m_last_allocations);
+            if (m_last_allocations != 0)
+                ++m_allocating_frames;
+        }
+
+        if (m_keep_samples)
+            m_samples.push_back(dt);
+
+        // set the mark after the samples so their allocations are not blamed on the next frame
+        if (m_track_allocations)
+        {
+            auto allocs = alloc_tracker::totals();
+            m_alloc_mark = allocs.allocations;
+            m_alloc_bytes_mark = allocs.bytes;
+        }
+
+        if (output)
+            m_out << "[metrcis] Debug: FPS: " << 1e3 / m_last_time << ", Frame render took " << m_last_time << " ms.\n";
+    }
+
+    void metrics::track_gpu_frame(double dt) noexcept
+    {
+        ++m_gpu_frames;
+        m_total_gpu_time += dt;
+
+        if (m_keep_samples)
+            m_gpu_samples.push_back(dt);
+    }
+
+    void metrics::finish_tracking() noexcept
+    {
+        m_out << "[metrcis] Debug: Finishing tracking..\n";
+        m_out << "------------------------------------------\n";
+        m_out << "[metrcis] Debug: Total frames: " << m_frames << ".\n";
+        m_out << "[metrcis] Debug: Average frame render time: " << m_total_time / m_frames << " ms.\n";
+        m_out << "[metrcis] Debug: FPS: " << 1e3 * m_frames / m_total_time << "\n";
+        m_out << "[metrcis] Debug: Total rendering code time elapsed: " << m_total_time << " ms \n";
+        if (m_gpu_frames != 0)
+            m_out << "[metrcis] Debug: Average gpu frame time: " << m_total_gpu_time / m_gpu_frames << " ms.\n";
+
+        if (m_track_allocations && m_frames != 0)
+        {
+            if (!alloc_tracker::available || !alloc_tracker::enabled())
+                m_out << "[metrcis] Debug: Allocations not counted, define UTILS_TRACK_ALLOCATIONS and call alloc_tracker::enable.\n";
+
+            m_out << "[metrcis] Debug: Allocations per frame: " << (double)m_total_allocations / m_frames
+                  << " (max " << m_max_allocations << "), bytes per frame: " << (double)m_total_allocated_bytes / m_frames
+                  << ", frames that allocated: " << m_allocating_frames << ".\n";
+
+            for (const auto &thread : alloc_tracker::threads())
+                m_out << "[metrcis] Debug: Thread " << thread.id << ": " << thread.count.allocations << " allocations, "
+                      << thread.count.bytes << " bytes, " << thread.count.frees << " frees in total.\n";
+
+            for (const auto &site : alloc_tracker::sites())
+                m_out << "[metrcis] Debug: Site " << site.name << ": " << site.count.allocations << " allocations, "
+                      << site.count.bytes << " bytes in total.\n";
+        }
+
+        for (const auto &c : m_counters)
+            m_out << "[metrcis] Debug: " << c.name << ": " << c.total << " in total, " << (m_frames != 0 ? (double)c.total / m_frames : 0.0)
+                  << " per frame (max " << c.max << "), in " << c.frames << " frames.\n";
+
+        m_out << "------------------------------------------\n";
+    }
+
+    void metrics::track_count(const char *name, size_t count) noexcept
+    {
+        auto it = std::ranges::find_if(m_counters, [name](const counter &c){ return c.name == name || std::string_view{c.name} == name; });
+        if (it == m_counters.end())
+            it = m_counters.insert(m_counters.end(), counter{name});
+
+        it->last = count;
+        it->total += count;
+        it->max = std::max(it->max, count);
+        if (count != 0)
+            ++it->frames;
+    }
+
+    [[nodiscard]] const metrics::counter *metrics::find_counter(std::string_view name) const noexcept
+    {
+        auto it = std::ranges::find_if(m_counters, [name](const counter &c){ return c.name == name; });
+        return it == m_counters.end() ? nullptr : &*it;
+    }
+
+    [[nodiscard]] metrics::distribution metrics::summarize(std::vector<double> samples) noexcept
+    {
+        distribution dist;
+        dist.count = samples.size();
+
+        if (samples.empty())
+            return dist;
+
+        std::sort(samples.begin(), samples.end());
+
+        // nearest rank percentile
+        auto percentile = [&samples](double p){
+            size_t rank = (size_t)std::ceil(p * samples.size());
+            return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+        };
+
+        double sum = 0.0;
+        for (double sample : samples)
+            sum += sample;
+        dist.mean = sum / samples.size();
+
+        double sq_sum = 0.0;
+        for (double sample : samples)
+            sq_sum += (sample - dist.mean) * (sample - dist.mean);
+        // sample standard deviation
+        dist.stddev = samples.size() > 1 ? std::sqrt(sq_sum / (samples.size() - 1)) : 0.0;
+
+        dist.min = samples.front();
+        dist.p50 = percentile(0.50);
+        dist.p95 = percentile(0.95);
+        dist.p99 = percentile(0.99);
+        dist.max = samples.back();
+
+        return dist;
+    }
+
+    void metrics::save(std::string_view filename, std::vector<std::string_view> extra_fields) noexcept
+    {
+        // aborted runs would otherwise leave rows like "0, inf, 0"
+        if (m_frames == 0 || m_total_time <= 0.0)
+        {
+            m_out << "[metrics] Info: No frames tracked, not saving to " << filename << ".\n";
+            return;
+        }
+
+        try
+        {
+            std::fstream file(filename.data(), std::fstream::app);
+            // file headers must have headers to start
+            // Date, Time, Avg. Render time(ms), FPS, Total Render time (ms),
+            
+            std::stringstream ss{};
+
+            auto now = std::chrono::high_resolution_clock::to_time_t(std::chrono::high_resolution_clock::now());
+            auto now_tm = *std::localtime(&now);            
+
+            ss << std::put_time(&now_tm, "%a, %d %b %Y %H:%M:%S") << ", ";
+
+            ss << m_total_time / m_frames << ", " << 1e3 * m_frames / m_total_time << ", " << m_total_time;
+            for (auto& field : extra_fields)
+            {
+                ss << ", " << field;
+            }
+            ss << ",\n";
+
+            std::string str = ss.str();
+
+            file.write(str.c_str(), str.size());
+            file.close();
+        }
+        catch (const std::fstream::failure& e)
+        {
+            std::cout << "[metrics] Error (#" << e.code() << "): " << e.what() << "\n";
+        }
+    }
+
+    ////
+    // alloc tracker
+
+    std::array<alloc_tracker::thread_slot, alloc_tracker::max_threads> alloc_tracker::s_threads;
+    std::array<alloc_tracker::site_slot, alloc_tracker::max_sites> alloc_tracker::s_sites;
+
+    alloc_tracker::thread_slot &alloc_tracker::slot() noexcept
+    {
+        if (t_slot != nullptr)
+            return *t_slot;
+
+        // claim the first free slot, the last slot is shared by every thread after max_threads
+        for (size_t i = 0; i < max_threads - 1; ++i)
+        {
+            bool expected = false;
+            if (s_threads[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                s_threads[i].id = std::this_thread::get_id();
+                t_slot = &s_threads[i];
+                return *t_slot;
+            }
+        }
+
+        t_slot = &s_threads[max_threads - 1];
+        t_slot->used.store(true, std::memory_order_release);
+        return *t_slot;
+    }
+
+    void alloc_tracker::on_alloc(size_t bytes) noexcept
+    {
+        if (!enabled())
+            return;
+
+        auto &thread = slot();
+        thread.allocations.fetch_add(1, std::memory_order_relaxed);
+        thread.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        const char *site = t_site;
+        if (site == nullptr)
+            return;
+
+        // open addressing on the name pointer, names are string literals so pointers are enough
+        size_t start = (reinterpret_cast<uintptr_t>(site) >> 3) % max_sites;
+        for (size_t i = 0; i < max_sites; ++i)
+        {
+            auto &entry = s_sites[(start + i) % max_sites];
+            const char *name = entry.name.load(std::memory_order_acquire);
+
+            if (name == nullptr && entry.name.compare_exchange_strong(name, site, std::memory_order_acq_rel))
+                name = site;
+
+            if (name == site)
+            {
+                entry.allocations.fetch_add(1, std::memory_order_relaxed);
+                entry.bytes.fetch_add(bytes, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    void alloc_tracker::on_free(size_t bytes) noexcept
+    {
+        if (!enabled())
+            return;
+
+        (void)bytes;
+        slot().frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] alloc_tracker::counters alloc_tracker::totals() noexcept
+    {
+        counters total;
+
+        for (const auto &thread : s_threads)
+        {
+            if (!thread.used.load(std::memory_order_acquire))
+                continue;
+
+            total.allocations += thread.allocations.load(std::memory_order_relaxed);
+            total.bytes += thread.bytes.load(std::memory_order_relaxed);
+            total.frees += thread.frees.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+    [[nodiscard]] alloc_tracker::counters alloc_tracker::this_thread() noexcept
+    {
+        auto &thread = slot();
+        return counters{
+            thread.allocations.load(std::memory_order_relaxed),
+            thread.bytes.load(std::memory_order_relaxed),
+            thread.frees.load(std::memory_order_relaxed)
+        };
+    }
+
+    [[nodiscard]] std::vector<alloc_tracker::thread_counters> alloc_tracker::threads() noexcept
+    {
+        std::vector<thread_counters> result;
+
+        for (const auto &thread : s_threads)
+        {
+            if (!thread.used.load(std::memory_order_acquire))
+                continue;
+
+            result.push_back(thread_counters{thread.id, counters{
+                thread.allocations.load(std::memory_order_relaxed),
+                thread.bytes.load(std::memory_order_relaxed),
+                thread.frees.load(std::memory_order_relaxed)
+            }});
+        }
+
+        return result;
+    }
+
+    [[nodiscard]] std::vector<alloc_tracker::site_counters> alloc_tracker::sites() noexcept
+    {
+        std::vector<site_counters> result;
+
+        for (const auto &site : s_sites)
+        {
+            const char *name = site.name.load(std::memory_order_acquire);
+            if (name == nullptr)
+                continue;
+
+            result.push_back(site_counters{name, counters{
+                site.allocations.load(std::memory_order_relaxed),
+                site.bytes.load(std::memory_order_relaxed),
+                0
+            }});
+        }
+
+        // most allocations first
+        std::sort(result.begin(), result.end(), [](const auto &a, const auto &b){ return a.count.allocations > b.count.allocations; });
+
+        return result;
+    }
+
+    alloc_site::alloc_site(const char *name) noexcept
+        : m_prev(alloc_tracker::t_site)
+    {
+        alloc_tracker::t_site = name;
+    }
+
+    alloc_site::~alloc_site() noexcept
+    {
+        alloc_tracker::t_site = m_prev;
+    }
+
+    ////
+    // logger
+
+    logger::logger(std::ostream &out) noexcept
+        : m_out(out), m_ring(new slot[capacity])
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            m_ring[i].sequence.store(i, std::memory_order_relaxed);
+
+        try
+        {
+            m_thread = std::thread(&logger::run, this);
+        }
+        catch (const std::system_error &e)
+        {
+            m_out << "[utils] Error: Failed to start the logger thread, writing messages immediately. Code: " << e.code() << ", Message: " << e.what() << ".\n";
+        }
+    }
+
+    logger::~logger() noexcept
+    {
+        if (m_thread.joinable())
+        {
+            m_stop.store(true, std::memory_order_release);
+            m_awake.store(true, std::memory_order_release);
+            m_awake.notify_one();
+            m_thread.join();
+        }
+        else
+            m_out.flush();
+    }
+
+    template <typename T>
+    void logger::encode(record &rec, argument &arg, const T &val) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            arg.type = argument::kind::BOOL;
+            arg.b = val;
+        }
+        else if constexpr (std::is_same_v<T, char>)
+        {
+            arg.type = argument::kind::CHAR;
+            arg.c = val;
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            encode(rec, arg, (std::underlying_type_t<T>)val);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            arg.type = argument::kind::INT;
+            arg.i = val;
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            arg.type = argument::kind::UINT;
+            arg.u = val;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            arg.type = argument::kind::FLOAT;
+            arg.f = val;
+        }
+        else if constexpr (Stringable<T>)
+        {
+            // cut the string to the space left in the record
+            std::string_view str = val;
+            size_t size = std::min(str.size(), max_text - rec.text_size);
+
+            arg.type = argument::kind::STRING;
+            arg.s = {rec.text_size, (uint16_t)size};
+
+            std::copy_n(str.data(), size, rec.text.data() + rec.text_size);
+            rec.text_size += (uint16_t)size;
+        }
+        else
+        {
+            static_assert(!sizeof(T), "utils::logger arguments must be integers, floats, bools, chars, enums or strings");
+        }
+    }
+
+    template <log_level Level, typename... Ts>
+    void logger::write(const char *format, const Ts &...args) noexcept
+    {
+        static_assert(sizeof...(Ts) <= max_args, "utils::logger messages can have at most max_args arguments");
+
+        if constexpr (Level < compiled_level)
+            return;
+        else
+        {
+            if (Level < m_level.load(std::memory_order_relaxed))
+                return;
+
+            record rec;
+            rec.level = Level;
+            rec.arg_count = (uint8_t)sizeof...(Ts);
+            rec.text_size = 0;
+            rec.format = format;
+
+            size_t i = 0;
+            (encode(rec, rec.args[i++], args), ...);
+
+            if (m_thread.joinable())
+            {
+                // warnings and errors wait for space, the rest are dropped
+                while (!push(rec))
+                {
+                    if constexpr (Level < log_level::WARNING)
+                    {
+                        m_dropped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    else
+                        std::this_thread::yield();
+                }
+            }
+            else
+                print(rec);
+        }
+    }
+
+    [[nodiscard]] bool logger::push(const record &rec) noexcept
+    {
+        // bounded mpmc ring, the writers race for the head and the background thread is the only reader
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        slot *target;
+
+        for (;;)
+        {
+            target = &m_ring[pos & (capacity - 1)];
+            size_t sequence = target->sequence.load(std::memory_order_acquire);
+            auto diff = (intptr_t)sequence - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            // full
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_head.load(std::memory_order_relaxed);
+        }
+
+        target->data = rec;
+        target->sequence.store(pos + 1, std::memory_order_release);
+
+        // wake the background thread if it is asleep
+        // the fence pairs with the one in run so either the write or the wake up is seen
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_awake.load(std::memory_order_relaxed))
+        {
+            m_awake.store(true, std::memory_order_relaxed);
+            m_awake.notify_one();
+        }
+
+        return true;
+    }
+
+    void logger::run() noexcept
+    {
+        for (;;)
+        {
+            while (drain())
+                ;
+
+            // report while idle so the output does not lag behind
+            print_summary();
+            m_out.flush();
+
+            if (m_stop.load(std::memory_order_acquire))
+            {
+                // writes that were claimed before the stop
+                if (drain())
+                    continue;
+                return;
+            }
+
+            m_awake.store(false, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // check again in case a writer missed that this thread is going to sleep
+            if (drain())
+            {
+                m_awake.store(true, std::memory_order_relaxed);
+                continue;
+            }
+
+            m_awake.wait(false, std::memory_order_acquire);
+        }
+    }
+
+    [[nodiscard]] bool logger::drain() noexcept
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        slot &target = m_ring[pos & (capacity - 1)];
+
+        if (target.sequence.load(std::memory_order_acquire) != pos + 1)
+            return false;
+
+        if (m_has_last && same(target.data, m_last))
+            ++m_repeats;
+        else
+        {
+            print_summary();
+            print(target.data);
+
+            m_last = target.data;
+            m_has_last = true;
+        }
+
+        // free the slot for the writer one lap ahead
+        target.sequence.store(pos + capacity, std::memory_order_release);
+        m_tail.store(pos + 1, std::memory_order_release);
+        m_tail.notify_all();
+
+        return true;
+    }
+
+    void logger::print(const record &rec) noexcept
+    {
+        size_t arg = 0;
+
+        for (const char *c = rec.format; *c != '\0'; ++c)
+        {
+            if (c[0] != '{' || c[1] != '}' || arg == rec.arg_count)
+            {
+                m_out.put(*c);
+                continue;
+            }
+
+            const auto &a = rec.args[arg++];
+            switch (a.type)
+            {
+            case argument::kind::INT:
+                m_out << a.i;
+                break;
+            case argument::kind::UINT:
+                m_out << a.u;
+                break;
+            case argument::kind::FLOAT:
+                m_out << a.f;
+                break;
+            case argument::kind::BOOL:
+                m_out << (a.b ? "true" : "false");
+                break;
+            case argument::kind::CHAR:
+                m_out.put(a.c);
+                break;
+            case argument::kind::STRING:
+                m_out.write(rec.text.data() + a.s.offset, a.s.size);
+                break;
+            }
+
+            ++c;
+        }
+    }
+
+    void logger::print_summary() noexcept
+    {
+        if (m_repeats != 0)
+        {
+            m_out << "[utils] Info: Last message repeated " << m_repeats << " more times.\n";
+            m_repeats = 0;
+            m_has_last = false;
+        }
+
+        if (size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed); dropped != 0)
+            m_out << "[utils] Warning: Dropped " << dropped << " log messages, the log ring was full.\n";
+    }
+
+    [[nodiscard]] bool logger::same(const record &a, const record &b) noexcept
+    {
+        if (a.format != b.format || a.level != b.level || a.arg_count != b.arg_count || a.text_size != b.text_size)
+            return false;
+
+        for (size_t i = 0; i < a.arg_count; ++i)
+        {
+            const auto &x = a.args[i];
+            const auto &y = b.args[i];
+
+            if (x.type != y.type)
+                return false;
+
+            switch (x.type)
+            {
+            case argument::kind::INT:
+                if (x.i != y.i) return false;
+                break;
+            case argument::kind::UINT:
+                if (x.u != y.u) return false;
+                break;
+            case argument::kind::FLOAT:
+                if (x.f != y.f) return false;
+                break;
+            case argument::kind::BOOL:
+                if (x.b != y.b) return false;
+                break;
+            case argument::kind::CHAR:
+                if (x.c != y.c) return false;
+                break;
+            case argument::kind::STRING:
+                if (x.s.offset != y.s.offset || x.s.size != y.s.size) return false;
+                break;
+            }
+        }
+
+        return std::equal(a.text.begin(), a.text.begin() + a.text_size, b.text.begin());
+    }
+
+    void logger::flush() noexcept
+    {
+        if (!m_thread.joinable())
+        {
+            m_out.flush();
+            return;
+        }
+
+        size_t target = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+
+        while (tail < target)
+        {
+            m_tail.wait(tail, std::memory_order_acquire);
+            tail = m_tail.load(std::memory_order_acquire);
+        }
+    }
+
+    ////
+    // offset allocator
+
+    offset_allocator::offset_allocator(uint32_t size) noexcept
+        : m_size(size), m_free_size(0)
+    {
+        reset();
+    }
+
+    void offset_allocator::reset() noexcept
+    {
+        m_nodes.clear();
+        m_spare_nodes.clear();
+        m_first_level_bits = 0;
+        m_second_level_bits.fill(0);
+        m_bins.fill(invalid);
+
+        m_free_size = m_size;
+        if (m_size != 0)
+            insert_free(create_node(0, m_size));
+    }
+
+    uint32_t offset_allocator::bin_of(uint32_t size) noexcept
+    {
+        // small sizes get a bin each
+        if (size < second_level_count)
+            return size;
+
+        uint32_t log2 = std::bit_width(size) - 1;
+        uint32_t first = log2 - second_level_log2 + 1;
+        uint32_t second = (size >> (log2 - second_level_log2)) - second_level_count;
+        return first * second_level_count + second;
+    }
+
+    uint32_t offset_allocator::find_bin(uint64_t size) const noexcept
+    {
+        if (size > m_size)
+            return invalid;
+
+        // round up to the start of the next bin so every range in the bin found is large enough
+        if (size >= second_level_count)
+        {
+            uint32_t log2 = std::bit_width(size) - 1;
+            size = std::min<uint64_t>(size + (uint64_t{1} << (log2 - second_level_log2)) - 1, ~uint32_t{0});
+        }
+
+        uint32_t bin = bin_of(size);
+        uint32_t first = bin / second_level_count;
+        uint32_t second = bin % second_level_count;
+
+        // a larger bin in the same first level
+        uint32_t second_bits = m_second_level_bits[first] & (~uint32_t{0} << second);
+        if (second_bits != 0)
+            return first * second_level_count + std::countr_zero(second_bits);
+
+        // the smallest bin of a larger first level
+        if (first + 1 >= first_level_count)
+            return invalid;
+
+        uint32_t first_bits = m_first_level_bits & (~uint32_t{0} << (first + 1));
+        if (first_bits == 0)
+            return invalid;
+
+        first = std::countr_zero(first_bits);
+        return first * second_level_count + std::countr_zero(m_second_level_bits[first]);
+    }
+
+    uint32_t offset_allocator::create_node(uint32_t offset, uint32_t size) noexcept
+    {
+        uint32_t index;
+        if (!m_spare_nodes.empty())
+        {
+            index = m_spare_nodes.back();
+            m_spare_nodes.pop_back();
+        }
+        else
+        {
+            index = m_nodes.size();
+            m_nodes.emplace_back();
+        }
+
+        m_nodes[index] = node{.offset = offset, .size = size};
+        return index;
+    }
+
+    void offset_allocator::release_node(uint32_t index) noexcept
+    {
+        m_nodes[index] = node{};
+        m_spare_nodes.push_back(index);
+    }
+
+    void offset_allocator::insert_free(uint32_t index) noexcept
+    {
+        auto &n = m_nodes[index];
+        uint32_t bin = bin_of(n.size);
+
+        n.used = false;
+        n.prev_free = invalid;
+        n.next_free = m_bins[bin];
+        if (n.next_free != invalid)
+            m_nodes[n.next_free].prev_free = index;
+        m_bins[bin] = index;
+
+        m_first_level_bits |= 1u << (bin / second_level_count);
+        m_second_level_bits[bin / second_level_count] |= 1u << (bin % second_level_count);
+    }
+
+    void offset_allocator::remove_free(uint32_t index) noexcept
+    {
+        auto &n = m_nodes[index];
+        uint32_t bin = bin_of(n.size);
+
+        if (n.prev_free != invalid)
+            m_nodes[n.prev_free].next_free = n.next_free;
+        else
+            m_bins[bin] = n.next_free;
+
+        if (n.next_free != invalid)
+            m_nodes[n.next_free].prev_free = n.prev_free;
+
+        n.prev_free = n.next_free = invalid;
+
+        if (m_bins[bin] == invalid)
+        {
+            m_second_level_bits[bin / second_level_count] &= ~(1u << (bin % second_level_count));
+            if (m_second_level_bits[bin / second_level_count] == 0)
+                m_first_level_bits &= ~(1u << (bin / second_level_count));
+        }
+    }
+
+    offset_allocator::allocation offset_allocator::allocate(uint32_t size, uint32_t alignment) noexcept
+    {
+        size = std::max(size, 1u);
+        alignment = std::max(alignment, 1u);
+
+        // room to move the offset up to the alignment
+        uint64_t needed = uint64_t{size} + alignment - 1;
+
+        uint32_t index = invalid;
+        if (uint32_t bin = find_bin(needed); bin != invalid)
+            index = m_bins[bin];
+        else if (needed <= m_size)
+        {
+            // the larger ranges in the bin of the size itself fit but are not guaranteed to. Ex: one
+            // free range of exactly the size asked for
+            for (uint32_t i = m_bins[bin_of(needed)]; i != invalid && index == invalid; i = m_nodes[i].next_free)
+                if (m_nodes[i].size >= needed)
+                    index = i;
+        }
+
+        if (index == invalid)
+            return {};
+
+        remove_free(index);
+
+        // the front before the aligned offset stays free, the range before it is used so it is not merged
+        uint32_t aligned = (m_nodes[index].offset + alignment - 1) / alignment * alignment;
+        if (uint32_t padding = aligned - m_nodes[index].offset; padding != 0)
+        {
+            uint32_t front = create_node(m_nodes[index].offset, padding);
+            m_nodes[front].prev = m_nodes[index].prev;
+            m_nodes[front].next = index;
+            if (m_nodes[front].prev != invalid)
+                m_nodes[m_nodes[front].prev].next = front;
+
+            m_nodes[index].prev = front;
+            m_nodes[index].offset = aligned;
+            m_nodes[index].size -= padding;
+            insert_free(front);
+        }
+
+        // the rest after the allocation stays free
+        if (m_nodes[index].size > size)
+        {
+            uint32_t back = create_node(aligned + size, m_nodes[index].size - size);
+            m_nodes[back].prev = index;
+            m_nodes[back].next = m_nodes[index].next;
+            if (m_nodes[back].next != invalid)
+                m_nodes[m_nodes[back].next].prev = back;
+
+            m_nodes[index].next = back;
+            m_nodes[index].size = size;
+            insert_free(back);
+        }
+
+        m_nodes[index].used = true;
+        m_free_size -= size;
+
+        return {aligned, index};
+    }
+
+    void offset_allocator::free(allocation alloc) noexcept
+    {
+        if (!alloc.valid() || alloc.node >= m_nodes.size() || !m_nodes[alloc.node].used)
+            return;
+
+        uint32_t index = alloc.node;
+        m_nodes[index].used = false;
+        m_free_size += m_nodes[index].size;
+
+        // merge with the free range before
+        if (uint32_t prev = m_nodes[index].prev; prev != invalid && !m_nodes[prev].used)
+        {
+            remove_free(prev);
+            m_nodes[prev].size += m_nodes[index].size;
+            m_nodes[prev].next = m_nodes[index].next;
+            if (m_nodes[prev].next != invalid)
+                m_nodes[m_nodes[prev].next].prev = prev;
+
+            release_node(index);
+            index = prev;
+        }
+
+        // merge with the free range after
+        if (uint32_t next = m_nodes[index].next; next != invalid && !m_nodes[next].used)
+        {
+            remove_free(next);
+            m_nodes[index].size += m_nodes[next].size;
+            m_nodes[index].next = m_nodes[next].next;
+            if (m_nodes[index].next != invalid)
+                m_nodes[m_nodes[index].next].prev = index;
+
+            release_node(next);
+        }
+
+        insert_free(index);
+    }
+
+    uint32_t offset_allocator::largest_free() const noexcept
+    {
+        if (m_first_level_bits == 0)
+            return 0;
+
+        // the sizes in the last non empty bin overlap so check all of them
+        uint32_t first = std::bit_width(m_first_level_bits) - 1;
+        uint32_t bin = first * second_level_count + std::bit_width(m_second_level_bits[first]) - 1;
+
+        uint32_t largest = 0;
+        for (uint32_t index = m_bins[bin]; index != invalid; index = m_nodes[index].next_free)
+            largest = std::max(largest, m_nodes[index].size);
+
+        return largest;
+    }
+
+    ////
+    // job pool
+
+    job_pool::job_pool(size_t workers) noexcept
+    {
+        for (size_t i = 0; i < workers; ++i)
+        {
+            try
+            {
+                m_workers.emplace_back(&job_pool::work, this);
+            }
+            catch (const std::system_error &e)
+            {
+                std::cout << "[utils] Error: Failed to start job pool worker " << i << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+                break;
+            }
+        }
+    }
+
+    job_pool::~job_pool() noexcept
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+
+        for (auto &worker : m_workers)
+            worker.join();
+    }
+
+    size_t job_pool::default_workers() noexcept
+    {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1;
+    }
+
+    job_pool &job_pool::shared() noexcept
+    {
+        static job_pool pool;
+        return pool;
+    }
+
+    void job_pool::submit(std::function<void()> job) noexcept
+    {
+        if (m_workers.empty())
+        {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_wake.notify_one();
+    }
+
+    void job_pool::work() noexcept
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [this]{ return m_stopping || !m_jobs.empty(); });
+
+                // the queue is emptied before stopping
+                if (m_jobs.empty())
+                    return;
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    template <typename Fn>
+    void job_pool::parallel_for(size_t count, size_t grain, Fn &&fn) noexcept
+    {
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (count + grain - 1) / grain;
+
+        if (chunks <= 1 || m_workers.empty())
+        {
+            if (count != 0)
+                fn(size_t{0}, count);
+            return;
+        }
+
+        // shared with the helpers which may only start after the range is done, they never call fn then
+        struct range
+        {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+        };
+        auto state = std::make_shared<range>();
+
+        auto run = [state, chunks, count, grain, body = &fn]() {
+            for (size_t chunk; (chunk = state->next.fetch_add(1)) < chunks;)
+            {
+                (*body)(chunk * grain, std::min(count, (chunk + 1) * grain));
+                if (state->done.fetch_add(1) + 1 == chunks)
+                    state->done.notify_all();
+            }
+        };
+
+        for (size_t i = 0, helpers = std::min(m_workers.size(), chunks - 1); i < helpers; ++i)
+            submit(run);
+        run();
+
+        for (size_t done; (done = state->done.load()) < chunks;)
+            state->done.wait(done);
+    }
+
+    ////
+    // functions
+
+    namespace detail
+    {
+        // continued fraction for the regularized incomplete beta function
+        // numerical recipes betacf
+        inline double beta_continued_fraction(double a, double b, double x) noexcept
+        {
+            constexpr int max_iterations = 200;
+            constexpr double eps = 3.0e-12;
+            constexpr double fpmin = 1.0e-300;
+
+            double qab = a + b, qap = a + 1.0, qam = a - 1.0;
+            double c = 1.0, d = 1.0 - qab * x / qap;
+
+            if (std::fabs(d) < fpmin)
+                d = fpmin;
+            d = 1.0 / d;
+            double h = d;
+
+            for (int m = 1; m <= max_iterations; ++m)
+            {
+                int m2 = 2 * m;
+                double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+                d = 1.0 + aa * d;
+                if (std::fabs(d) < fpmin)
+                    d = fpmin;
+                c = 1.0 + aa / c;
+                if (std::fabs(c) < fpmin)
+                    c = fpmin;
+                d = 1.0 / d;
+                h *= d * c;
+
+                aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+                d = 1.0 + aa * d;
+                if (std::fabs(d) < fpmin)
+                    d = fpmin;
+                c = 1.0 + aa / c;
+                if (std::fabs(c) < fpmin)
+                    c = fpmin;
+                d = 1.0 / d;
+                double del = d * c;
+                h *= del;
+
+                if (std::fabs(del - 1.0) < eps)
+                    break;
+            }
+
+            return h;
+        }
+
+        // regularized incomplete beta function I_x(a, b)
+        inline double incomplete_beta(double a, double b, double x) noexcept
+        {
+            if (x <= 0.0)
+                return 0.0;
+            if (x >= 1.0)
+                return 1.0;
+
+            double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+
+            // use the symmetry relation where the continued fraction converges faster
+            if (x < (a + 1.0) / (a + b + 2.0))
+                return front * beta_continued_fraction(a, b, x) / a;
+
+            return 1.0 - front * beta_continued_fraction(b, a, 1.0 - x) / b;
+        }
+    } // namespace detail
+
+    [[nodiscard]] t_test_result welch_t_test(const metrics::distribution& sample, const metrics::distribution& baseline) noexcept
+    {
+        t_test_result result;
+
+        if (sample.count < 2 || baseline.count < 2)
+            return result;
+
+        double sample_var = sample.stddev * sample.stddev / sample.count;
+        double baseline_var = baseline.stddev * baseline.stddev / baseline.count;
+        double se = std::sqrt(sample_var + baseline_var);
+
+        if (se <= 0.0)
+        {
+            // no variance at all so any increase is significant
+            result.p = sample.mean > baseline.mean ? 0.0 : 1.0;
+            return result;
+        }
+
+        result.t = (sample.mean - baseline.mean) / se;
+
+        // welch-satterthwaite degrees of freedom
+        result.df = (sample_var + baseline_var) * (sample_var + baseline_var)
+                    / (sample_var * sample_var / (sample.count - 1) + baseline_var * baseline_var / (baseline.count - 1));
+
+        // two sided tail of the student t distribution halved for the one sided test
+        double tail = 0.5 * detail::incomplete_beta(result.df / 2.0, 0.5, result.df / (result.df + result.t * result.t));
+        result.p = result.t > 0.0 ? tail : 1.0 - tail;
+
+        return result;
+    }
+
+    [[nodiscard]] size_t resident_memory() noexcept
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.WorkingSetSize;
+        return 0;
+#elif defined(__linux__)
+        // the second field of statm is the resident page count
+        std::ifstream file("/proc/self/statm");
+        size_t pages = 0, resident = 0;
+        if (!(file >> pages >> resident))
+            return 0;
+        return resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+        return 0;
+#endif
+    }
+
+    std::string read_file_sync(const char *path) noexcept
+    {
+        std::string str;
+        std::ifstream file;
+        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+        try
+        {
+            file.open(path);
+            std::stringstream ss;
+            ss << file.rdbuf();
+            str = ss.str();
+            file.close();
+            return str;
+        }
+        catch (const std::ifstream::failure &e)
+        {
+            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return str;
+        }
+    }
+
+    std::future<std::string> read_file_async(const char *path) noexcept
+    {
+        return std::async(std::launch::async, [path](){
+            return read_file_sync(path);
+        });
+    }
+    
+    std::vector<unsigned char> read_file_bytes_sync(const char *path) noexcept
+    {
+        std::vector<unsigned char> data;
+        std::ifstream file;
+        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+        try
+        {
+            file.open(path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            file.close();
+            return data;
+        }
+        catch (const std::ifstream::failure &e)
+        {
+            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return data;
+        }
+    }
+    
+    std::future<std::vector<unsigned char>> read_file_bytes_async(const char *path) noexcept
+    {
+        return std::async(std::launch::async, [path](){
+            return read_file_bytes_sync(path);
+        });
+    }
+
+    template<typename ... Ts, typename Fn>
+    [[nodiscard]] std::pair<std::array<std::string, sizeof...(Ts)>, std::vector<std::tuple<Ts...>>>
+    read_csv_tuple_sync(const char *path, bool has_headers, Fn&& fn) noexcept
+    {
+        std::vector<std::tuple<Ts...>> data;
+        constexpr size_t data_size = sizeof...(Ts);
+        std::array<std::string, data_size> headers;
+
+        std::ifstream file;
+        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+        try
+        {
+            file.open(path);
+
+            std::array<std::string, data_size> row_str_arr;
+            std::string row_str;
+
+            std::getline(file, row_str);
+
+            auto start = 0;
+            bool is_header = has_headers;
+
+            int param = 0;
+
+            while (row_str.find_first_of(',') != std::string::npos)
+            {
+                auto end = row_str.find_first_of(',', start);
+                if (end == std::string::npos)
+                {
+                    end = row_str.find_first_of('\n', start);
+                }
+                if (end == std::string::npos)
+                {
+                    end = row_str.size();
+                }
+
+                std::string str = row_str.substr(start, end - start);
+
+                if (is_header)
+                {
+                    headers[param] = str;
+                }
+                else
+                {
+                    row_str_arr[param] = str;
+                }
+
+                ++param;
+                
+                start = row_str.find_first_of(',', start) + 1;
+
+                if (param == std::tuple_size_v<std::tuple<Ts...>>)
+                {
+                    if (!is_header)
+                    {
+                        std::tuple<Ts ...> tup{};
+
+                        utils::constexpr_for<0, row_str_arr.size(), 1>([&row_str_arr, &tup, fn](auto i){
+                            fn(std::get<i>(tup), row_str_arr[i]);
+                        });
+
+                        data.push_back(tup);
+                    }
+                    else
+                    {
+                        is_header = false;
+                    }
+
+                    try {
+                        std::getline(file, row_str);
+                    }
+                    catch (const std::ifstream::failure &e)
+                    {
+                        break;
+                    }
+
+                    start = 0;
+                    param = 0;
+                }
+            }
+
+            file.close();
+            return std::make_pair(headers, data);
+        }
+        catch (const std::ifstream::failure &e)
+        {
+            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return std::make_pair(headers, data);
+        }
+    }
+
+    template<typename ... Ts, typename Fn>
+    [[nodiscard]] std::future<std::pair<std::array<std::string, sizeof...(Ts)>, std::vector<std::tuple<Ts...>>>>
+    read_csv_tuple_async(const char *path, bool has_headers, Fn&& fn) noexcept
+    {
+        return std::async(std::launch::async, [path, has_headers, &fn](){
+            return read_csv_tuple_sync<Ts ...>(path, has_headers, fn);
+        });
+    }
+
+    template<typename Struct, typename Fn>
+    requires std::is_invocable_r_v<Struct, Fn, const std::vector<std::string>&>
+    [[nodiscard]] std::pair<std::vector<std::string>, std::vector<Struct>>
+    read_csv_struct_sync(const char *path, bool has_headers, Fn&& fn) noexcept
+    {
+        std::vector<std::string> headers;
+        std::vector<Struct> data;
+
+        bool is_headers = has_headers;
+
+        std::ifstream file;
+        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+        try
+        {
+            file.open(path);
+
+            while (!file.eof())
+            {
+                std::string str;
+                try
+                {
+                    std::getline(file, str);
+                }
+                catch (const std::ifstream::failure& e)
+                {
+                    continue;
+                }
+
+                std::vector<std::string> row_str;
+                
+                size_t start = 0;
+                size_t end = str.find_first_of(',');
+                while (end != std::string::npos)
+                {
+                    row_str.push_back(str.substr(start, end - start));
+
+                    start = end + 1;
+                    end = str.find_first_of(',', start);
+                }
+
+                // the last field, which has no comma after it
+                if (start < str.size()) {
+                    end = str.size();
+                    row_str.push_back(str.substr(start, end - start));
+                }
+
+                if (is_headers)
+                {
+                    headers = row_str;
+                    is_headers = false;
+                }
+                else
+                {
+                    // utils::print_vecs<11>(row_str.data());
+                    data.push_back(fn(row_str));
+                }
+            };
+
+            return std::make_pair(headers, data);
+        }
+        catch (const std::ifstream::failure& e)
+        {
+            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return std::make_pair(headers, data);
+        }
+    }
+    
+    template<typename Struct, typename Fn>
+    requires std::is_invocable_r_v<Struct, Fn, const std::vector<std::string>&>
+    [[nodiscard]] std::future<std::pair<std::vector<std::string>, std::vector<Struct>>>
+    read_csv_struct_async(const char *path, bool has_headers, Fn&& fn) noexcept
+    {
+        return std::async([path, has_headers, &fn](){
+            return read_csv_struct_sync<Struct>(path, has_headers, fn);
+        });
+    }
+
+    template<typename DurationUnit, typename Fn>
+    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
+            && std::is_invocable_v<Fn>
+    void set_timeout(int timeout, Fn&& fn) noexcept
+    {
+        utils::timer t1;
+        t1.start();
+        while (timeout > t1.stop<DurationUnit>()){};
+        fn();
+    }
+
+    template<typename DurationUnit, typename Fn>
+    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
+            && std::is_invocable_v<Fn, bool&>
+    void set_interval(int interval, Fn&& fn) noexcept
+    {
+        utils::timer t1;
+        t1.start();
+        int now = 0, old = 0;
+        bool end = false;
+        while (!end)
+        {
+            now = t1.stop<DurationUnit>();
+            if (now - old > interval) {
+                old = now;
+                fn(end);
+            }
+        }
+    }
+    
+    template<typename DurationUnit, typename Fn>
+    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
+            && std::is_invocable_v<Fn>
+    [[nodiscard]] std::future<void> set_timeout_async(int timeout, Fn&& fn) noexcept
+    {
+        return std::async(std::launch::async, [timeout, &fn](){
+            std::this_thread::sleep_for(DurationUnit(timeout));
+
+            fn();
+        });
+    }
+
+    template<typename DurationUnit, typename Fn>
+    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
+            && std::is_invocable_v<Fn, bool&>
+    [[nodiscard]] std::future<void> set_interval_async(int interval, Fn&& fn) noexcept
+    {
+        return std::async(std::launch::async, [interval, &fn](){
+            bool end = false;
+            while (!end)
+            {
+                std::this_thread::sleep_for(DurationUnit(interval));
+                fn(end);
+            }
+        });
+    }
+
+    template<size_t Width, size_t Height, typename T>
+    requires std::swappable<T> && (Width > 0) && (Height > 0)
+    void flip_array2d(T *ptr, bool horizontally, bool vertically) noexcept
+    {
+        flip_array2d(Width, Height, ptr, horizontally, vertically);
+    }
+
+    template<typename T>
+    requires std::swappable<T>
+    void flip_array2d(size_t width, size_t height, T *ptr, bool horizontally, bool vertically, job_pool *pool) noexcept
+    {
+        if (!horizontally && !vertically)
+            return;
+
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            flip_image(reinterpret_cast<unsigned char *>(ptr), width, height, sizeof(T), horizontally, vertically, pool);
+        }
+        else
+        {
+            // flipped both ways the array is reversed whatever its width and height
+            if (horizontally && vertically)
+            {
+                std::reverse(ptr, ptr + width * height);
+                return;
+            }
+
+            if (horizontally)
+            {
+                for (size_t i = 0; i < height; ++i)
+                    std::reverse(ptr + i * width, ptr + (i + 1) * width);
+                return;
+            }
+
+            for (size_t i = 0; i < height / 2; ++i)
+                std::swap_ranges(ptr + i * width, ptr + (i + 1) * width, ptr + (height - i - 1) * width);
+        }
+    }
+
+    namespace detail
+    {
+        // images at least this large are split over the job pool
+        constexpr const size_t parallel_image_bytes = 1 << 20;
+
+        // the bytes each job of the pool works on at once
+        constexpr const size_t image_grain_bytes = 256 << 10;
+
+        // write the pixels of a row into another row in reverse order
+        inline void reverse_row(const unsigned char *src, unsigned char *dst, size_t width, size_t channels) noexcept
+        {
+            const size_t bytes = width * channels;
+
+            // the bytes of dst written so far, from the left. src is read from the right
+            size_t done = 0;
+
+#if defined(__SSSE3__) || defined(__AVX__)
+            if (channels == 1)
+            {
+                const __m128i mask = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+                for (; done + 16 <= bytes; done += 16)
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + done), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + bytes - done - 16)), mask));
+            }
+#elif defined(__SSE2__)
+            // without pshufb the dwords, the words in them and the bytes in those are swapped in turn
+            if (channels == 1)
+            {
+                for (; done + 16 <= bytes; done += 16)
+                {
+                    __m128i v = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + bytes - done - 16)), _MM_SHUFFLE(0, 1, 2, 3));
+                    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + done), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+                }
+            }
+#endif
+#if defined(__SSSE3__) || defined(__AVX__)
+            if (channels == 3)
+            {
+                // 5 pixels in the last 15 bytes of each load. The 16th byte stored is written again by the
+                // next block or the rest, which always follow as at least one more byte is left
+                const __m128i mask = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4, 5, 6, 1, 2, 3, -128);
+                for (; done + 16 <= bytes; done += 15)
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + done), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + bytes - done - 16)), mask));
+            }
+#endif
+#if defined(__SSE2__) || defined(__AVX__)
+            if (channels == 4)
+            {
+                for (; done + 16 <= bytes; done += 16)
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + done), _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + bytes - done - 16)), _MM_SHUFFLE(0, 1, 2, 3)));
+            }
+#endif
+
+            // the rest a pixel at a time, with a constant size for the common pixels so each is one move
+            auto copy = [&]<size_t Size>(std::integral_constant<size_t, Size>) {
+                for (; done < bytes; done += Size)
+                    std::memcpy(dst + done, src + bytes - done - Size, Size);
+            };
+
+            switch (channels)
+            {
+            case 1: copy(std::integral_constant<size_t, 1>{}); break;
+            case 2: copy(std::integral_constant<size_t, 2>{}); break;
+            case 3: copy(std::integral_constant<size_t, 3>{}); break;
+            case 4: copy(std::integral_constant<size_t, 4>{}); break;
+            default:
+                for (; done < bytes; done += channels)
+                    std::memcpy(dst + done, src + bytes - done - channels, channels);
+            }
+        }
+
+        // swap two rows through a block on the stack
+        inline void swap_rows(unsigned char *first, unsigned char *second, size_t bytes) noexcept
+        {
+            unsigned char block[4096];
+            for (size_t at = 0; at < bytes; at += sizeof(block))
+            {
+                const size_t size = std::min(sizeof(block), bytes - at);
+                std::memcpy(block, first + at, size);
+                std::memcpy(first + at, second + at, size);
+                std::memcpy(second + at, block, size);
+            }
+        }
+
+        // rotate the pixels of src rows [y0, y1) and columns [x0, x1)
+        template <size_t Channels>
+        inline void rotate_tile(const unsigned char *src, size_t width, size_t height, size_t channels, unsigned char *dst, bool clockwise,
+                                size_t x0, size_t x1, size_t y0, size_t y1) noexcept
+        {
+            // a constant pixel size lets the copies compile to single moves
+            const size_t size = Channels != 0 ? Channels : channels;
+
+            // a dst row at a time so the writes are contiguous and the strided reads stay in the tile
+            const size_t stride = width * size;
+            for (size_t x = x0; x < x1; ++x)
+            {
+                // dst is height pixels wide
+                const unsigned char *from = src + y0 * stride + x * size;
+                if (clockwise)
+                {
+                    unsigned char *to = dst + (x * height + (height - 1 - y0)) * size;
+                    for (size_t y = y0; y < y1; ++y, from += stride, to -= size)
+                        std::memcpy(to, from, size);
+                }
+                else
+                {
+                    unsigned char *to = dst + ((width - 1 - x) * height + y0) * size;
+                    for (size_t y = y0; y < y1; ++y, from += stride, to += size)
+                        std::memcpy(to, from, size);
+                }
+            }
+        }
+    }
+
+    void flip_image(unsigned char *pixels, size_t width, size_t height, size_t channels, bool horizontally, bool vertically, job_pool *pool) noexcept
+    {
+        if ((!horizontally && !vertically) || width == 0 || height == 0 || channels == 0)
+            return;
+
+        const size_t row = width * channels;
+
+        // a vertical flip goes over the pairs of rows from the top and the bottom, the middle row is on its own
+        const size_t count = vertically ? (height + 1) / 2 : height;
+
+        auto flip = [&](size_t begin, size_t end) {
+            // a reversed row waits here while the row it replaces is reversed into its place
+            std::vector<unsigned char> scratch(horizontally ? row : 0);
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                unsigned char *top = pixels + i * row;
+                unsigned char *bottom = vertically ? pixels + (height - 1 - i) * row : top;
+
+                if (!horizontally)
+                {
+                    detail::swap_rows(top, bottom, row);
+                    continue;
+                }
+
+                detail::reverse_row(top, scratch.data(), width, channels);
+                if (bottom != top)
+                    detail::reverse_row(bottom, top, width, channels);
+                std::memcpy(bottom, scratch.data(), row);
+            }
+        };
+
+        if (pool != nullptr && row * height >= detail::parallel_image_bytes)
+            pool->parallel_for(count, std::max<size_t>(detail::image_grain_bytes / row, 1), flip);
+        else
+            flip(0, count);
+    }
+
+    void rotate_image90(const unsigned char *src, size_t width, size_t height, size_t channels, unsigned char *dst, bool clockwise, job_pool *pool) noexcept
+    {
+        if (width == 0 || height == 0 || channels == 0)
+            return;
+
+        // 64 x 64 pixels of 4 bytes read and written are 32 KiB
+        constexpr size_t tile = 64;
+        const size_t tiles = (height + tile - 1) / tile;
+
+        auto rotate = [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t)
+            {
+                const size_t y0 = t * tile, y1 = std::min(y0 + tile, height);
+                for (size_t x0 = 0; x0 < width; x0 += tile)
+                {
+                    const size_t x1 = std::min(x0 + tile, width);
+                    switch (channels)
+                    {
+                    case 1: detail::rotate_tile<1>(src, width, height, channels, dst, clockwise, x0, x1, y0, y1); break;
+                    case 3: detail::rotate_tile<3>(src, width, height, channels, dst, clockwise, x0, x1, y0, y1); break;
+                    case 4: detail::rotate_tile<4>(src, width, height, channels, dst, clockwise, x0, x1, y0, y1); break;
+                    default: detail::rotate_tile<0>(src, width, height, channels, dst, clockwise, x0, x1, y0, y1); break;
+                    }
+                }
+            }
+        };
+
+        const size_t row = width * channels;
+        if (pool != nullptr && row * height >= detail::parallel_image_bytes)
+            pool->parallel_for(tiles, std::max<size_t>(detail::image_grain_bytes / (row * tile), 1), rotate);
+        else
+            rotate(0, tiles);
+    }
+
+    bool swizzle_image(unsigned char *pixels, size_t count, std::span<const uint8_t> order, job_pool *pool) noexcept
+    {
+        const size_t channels = order.size();
+        if (channels == 0 || channels > 4 || std::any_of(order.begin(), order.end(), [channels](uint8_t c) { return c >= channels; }))
+        {
+            std::cout << "[utils] Error: Invalid channel order.\n";
+            return false;
+        }
+
+        const size_t bytes = count * channels;
+
+        auto swizzle = [&](size_t begin, size_t end) {
+            // begin and end are pixels
+            size_t at = begin * channels;
+            const size_t last = end * channels;
+
+#if defined(__SSSE3__) || defined(__AVX__)
+            if (channels == 3 || channels == 4)
+            {
+                // as many whole pixels as fit in 16 bytes, the bytes past them are stored unchanged
+                const size_t step = channels == 3 ? 15 : 16;
+
+                alignas(16) int8_t lanes[16];
+                for (size_t i = 0; i < 16; ++i)
+                    lanes[i] = i < step ? (int8_t)(i / channels * channels + order[i % channels]) : (int8_t)i;
+                const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i *>(lanes));
+
+                for (; at + 16 <= last; at += step)
+                {
+                    __m128i *block = reinterpret_cast<__m128i *>(pixels + at);
+                    _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), mask));
+                }
+            }
+#endif
+
+            // the rest a pixel at a time
+            unsigned char pixel[4];
+            for (; at < last; at += channels)
+            {
+                std::memcpy(pixel, pixels + at, channels);
+                for (size_t c = 0; c < channels; ++c)
+                    pixels[at + c] = pixel[order[c]];
+            }
+        };
+
+        if (pool != nullptr && bytes >= detail::parallel_image_bytes)
+            pool->parallel_for(count, detail::image_grain_bytes / channels, swizzle);
+        else
+            swizzle(0, count);
+
+        return true;
+    }
+
+    namespace detail
+    {
+        // a 4 x 4 block of pixels, one array per channel so the 16 values of a channel fill an sse register
+        struct pixel_block
+        {
+            alignas(16) uint8_t c[4][16];
+        };
+
+        // gather the block at bx, by as rgba, the pixels past the edges repeat the last row and column
+        inline void load_block(const unsigned char *pixels, size_t width, size_t height, size_t channels, bool grey,
+                               size_t bx, size_t by, pixel_block &block) noexcept
+        {
+            for (size_t py = 0; py < 4; ++py)
+            {
+                const unsigned char *row = pixels + std::min(by * 4 + py, height - 1) * width * channels;
+                for (size_t px = 0; px < 4; ++px)
+                {
+                    const unsigned char *pixel = row + std::min(bx * 4 + px, width - 1) * channels;
+                    const size_t i = py * 4 + px;
+
+                    if (grey && channels < 3)
+                    {
+                        block.c[0][i] = block.c[1][i] = block.c[2][i] = pixel[0];
+                        block.c[3][i] = channels == 2 ? pixel[1] : 255;
+                        continue;
+                    }
+
+                    for (size_t c = 0; c < 4; ++c)
+                        block.c[c][i] = c < channels ? pixel[c] : (c == 3 ? 255 : 0);
+                }
+            }
+        }
+
+        // one channel in 8 bytes, the range of the block and a 3 bit index per pixel
+        inline void encode_bc4(const uint8_t *values, unsigned char *out) noexcept
+        {
+            alignas(16) uint8_t index[16];
+
+#if defined(__SSE2__) || defined(__AVX__)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(values));
+
+            __m128i lo_v = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+            __m128i hi_v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+            lo_v = _mm_min_epu8(lo_v, _mm_srli_si128(lo_v, 4));
+            hi_v = _mm_max_epu8(hi_v, _mm_srli_si128(hi_v, 4));
+            lo_v = _mm_min_epu8(lo_v, _mm_srli_si128(lo_v, 2));
+            hi_v = _mm_max_epu8(hi_v, _mm_srli_si128(hi_v, 2));
+            lo_v = _mm_min_epu8(lo_v, _mm_srli_si128(lo_v, 1));
+            hi_v = _mm_max_epu8(hi_v, _mm_srli_si128(hi_v, 1));
+
+            const int lo = _mm_cvtsi128_si32(lo_v) & 0xFF;
+            const int hi = _mm_cvtsi128_si32(hi_v) & 0xFF;
+#else
+            int lo = values[0], hi = values[0];
+            for (size_t p = 1; p < 16; ++p)
+            {
+                lo = std::min<int>(lo, values[p]);
+                hi = std::max<int>(hi, values[p]);
+            }
+#endif
+
+            out[0] = (unsigned char)hi;
+            out[1] = (unsigned char)lo;
+
+            // every index 0 is hi
+            if (hi == lo)
+            {
+                std::memset(out + 2, 0, 6);
+                return;
+            }
+
+            const int range = hi - lo;
+
+            // t is the nearest of the 7 steps from lo to hi, one past each threshold the distance from lo is above
+#if defined(__SSE2__) || defined(__AVX__)
+            const __m128i d = _mm_subs_epu8(v, _mm_set1_epi8((char)lo));
+            __m128i t = _mm_set1_epi8(7);
+            for (int k = 0; k < 7; ++k)
+            {
+                const __m128i threshold = _mm_set1_epi8((char)((2 * k + 1) * range / 14));
+                t = _mm_add_epi8(t, _mm_cmpeq_epi8(_mm_subs_epu8(d, threshold), zero));
+            }
+
+            // bc4 orders the palette hi, lo, then the steps from hi down to lo. (8 - t) & 7 is right but for
+            // the two ends, which are swapped by flipping the low bit of indices 0 and 1
+            __m128i i = _mm_and_si128(_mm_sub_epi8(_mm_set1_epi8(8), t), _mm_set1_epi8(7));
+            const __m128i ends = _mm_cmpeq_epi8(_mm_and_si128(i, _mm_set1_epi8((char)0xFE)), zero);
+            i = _mm_xor_si128(i, _mm_and_si128(ends, _mm_set1_epi8(1)));
+            _mm_store_si128(reinterpret_cast<__m128i *>(index), i);
+#else
+            for (size_t p = 0; p < 16; ++p)
+            {
+                int t = 0;
+                for (int k = 0; k < 7; ++k)
+                    t += 14 * (values[p] - lo) > (2 * k + 1) * range;
+                index[p] = (uint8_t)(t == 7 ? 0 : t == 0 ? 1 : 8 - t);
+            }
+#endif
+
+            uint64_t bits = 0;
+            for (size_t p = 0; p < 16; ++p)
+                bits |= (uint64_t)index[p] << (3 * p);
+            for (size_t b = 0; b < 6; ++b)
+                out[2 + b] = (unsigned char)(bits >> (8 * b));
+        }
+
+        [[nodiscard]] inline uint16_t to_565(int r, int g, int b) noexcept
+        {
+            return (uint16_t)(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+        }
+
+        inline void from_565(uint16_t color, int *rgb) noexcept
+        {
+            const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+            rgb[0] = (r << 3) | (r >> 2);
+            rgb[1] = (g << 2) | (g >> 4);
+            rgb[2] = (b << 3) | (b >> 2);
+        }
+
+        // pick the bc1 index of each pixel for the endpoints c0 and c1 and return the squared error
+        [[nodiscard]] inline int bc1_indices(const pixel_block &block, uint16_t c0, uint16_t c1, uint32_t &indices) noexcept
+        {
+            int e0[3], e1[3];
+            from_565(c0, e0);
+            from_565(c1, e1);
+
+            const int dir[3] = {e0[0] - e1[0], e0[1] - e1[1], e0[2] - e1[2]};
+            const int lo = e1[0] * dir[0] + e1[1] * dir[1] + e1[2] * dir[2];
+            const int range = e0[0] * dir[0] + e0[1] * dir[1] + e0[2] * dir[2] - lo;
+
+            // t is the nearest of the thirds from c1 to c0 of the projection of each pixel on the endpoints
+            alignas(16) int32_t t[16];
+            if (range <= 0)
+            {
+                std::fill(std::begin(t), std::end(t), 3);
+            }
+            else
+            {
+#if defined(__SSE2__) || defined(__AVX__)
+                const __m128i zero = _mm_setzero_si128();
+                // the direction as pairs of 16 bit lanes for madd, r g and b 0
+                const __m128i rg_dir = _mm_set1_epi32((int)(((uint32_t)dir[1] << 16) | ((uint32_t)dir[0] & 0xFFFF)));
+                const __m128i b_dir = _mm_set1_epi32(dir[2] & 0xFFFF);
+                const __m128i lo_v = _mm_set1_epi32(lo);
+
+                __m128i thresholds[3];
+                for (int k = 0; k < 3; ++k)
+                    thresholds[k] = _mm_set1_epi32((2 * k + 1) * range);
+
+                const __m128i r = _mm_load_si128(reinterpret_cast<const __m128i *>(block.c[0]));
+                const __m128i g = _mm_load_si128(reinterpret_cast<const __m128i *>(block.c[1]));
+                const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i *>(block.c[2]));
+
+                const __m128i r16[2] = {_mm_unpacklo_epi8(r, zero), _mm_unpackhi_epi8(r, zero)};
+                const __m128i g16[2] = {_mm_unpacklo_epi8(g, zero), _mm_unpackhi_epi8(g, zero)};
+                const __m128i b16[2] = {_mm_unpacklo_epi8(b, zero), _mm_unpackhi_epi8(b, zero)};
+
+                for (size_t q = 0; q < 4; ++q)
+                {
+                    const __m128i rg = q & 1 ? _mm_unpackhi_epi16(r16[q / 2], g16[q / 2]) : _mm_unpacklo_epi16(r16[q / 2], g16[q / 2]);
+                    const __m128i bz = q & 1 ? _mm_unpackhi_epi16(b16[q / 2], zero) : _mm_unpacklo_epi16(b16[q / 2], zero);
+
+                    const __m128i d = _mm_sub_epi32(_mm_add_epi32(_mm_madd_epi16(rg, rg_dir), _mm_madd_epi16(bz, b_dir)), lo_v);
+                    const __m128i d6 = _mm_add_epi32(_mm_slli_epi32(d, 2), _mm_slli_epi32(d, 1));
+
+                    __m128i tq = zero;
+                    for (int k = 0; k < 3; ++k)
+                        tq = _mm_sub_epi32(tq, _mm_cmpgt_epi32(d6, thresholds[k]));
+                    _mm_store_si128(reinterpret_cast<__m128i *>(t + q * 4), tq);
+                }
+#else
+                for (size_t p = 0; p < 16; ++p)
+                {
+                    const int d = block.c[0][p] * dir[0] + block.c[1][p] * dir[1] + block.c[2][p] * dir[2] - lo;
+                    t[p] = 0;
+                    for (int k = 0; k < 3; ++k)
+                        t[p] += 6 * d > (2 * k + 1) * range;
+                }
+#endif
+            }
+
+            // bc1 orders the palette c0, c1, 2/3 of the way to c0 then 1/3
+            constexpr uint32_t order[4] = {1, 3, 2, 0};
+
+            int palette[4][3];
+            for (size_t c = 0; c < 3; ++c)
+            {
+                palette[0][c] = e0[c];
+                palette[1][c] = e1[c];
+                palette[2][c] = (2 * e0[c] + e1[c]) / 3;
+                palette[3][c] = (e0[c] + 2 * e1[c]) / 3;
+            }
+
+            int error = 0;
+            indices = 0;
+            for (size_t p = 0; p < 16; ++p)
+            {
+                const uint32_t i = order[t[p]];
+                indices |= i << (2 * p);
+
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    const int diff = block.c[c][p] - palette[i][c];
+                    error += diff * diff;
+                }
+            }
+
+            return error;
+        }
+
+        // the endpoints which fit the pixels best by least squares for the indices, false if every pixel has the same weight
+        [[nodiscard]] inline bool bc1_refine(const pixel_block &block, uint32_t indices, uint16_t &c0, uint16_t &c1) noexcept
+        {
+            // the weights of c0 by index, in thirds
+            constexpr int weights[4] = {3, 0, 2, 1};
+
+            int aa = 0, bb = 0, ab = 0;
+            int ax[3] = {}, bx[3] = {};
+            for (size_t p = 0; p < 16; ++p)
+            {
+                const int a = weights[(indices >> (2 * p)) & 3];
+                const int b = 3 - a;
+                aa += a * a;
+                bb += b * b;
+                ab += a * b;
+
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    ax[c] += a * 3 * block.c[c][p];
+                    bx[c] += b * 3 * block.c[c][p];
+                }
+            }
+
+            const float det = (float)aa * bb - (float)ab * ab;
+            if (det == 0.0f)
+                return false;
+
+            int e0[3], e1[3];
+            for (size_t c = 0; c < 3; ++c)
+            {
+                e0[c] = std::clamp((int)std::lround((ax[c] * (float)bb - bx[c] * (float)ab) / det), 0, 255);
+                e1[c] = std::clamp((int)std::lround((bx[c] * (float)aa - ax[c] * (float)ab) / det), 0, 255);
+            }
+
+            c0 = to_565(e0[0], e0[1], e0[2]);
+            c1 = to_565(e1[0], e1[1], e1[2]);
+            return true;
+        }
+
+        // rgb in 8 bytes, two 565 endpoints and a 2 bit index per pixel
+        inline void encode_bc1(const pixel_block &block, unsigned char *out) noexcept
+        {
+            int sum[3] = {}, lo[3] = {255, 255, 255}, hi[3] = {};
+            for (size_t c = 0; c < 3; ++c)
+            {
+                for (size_t p = 0; p < 16; ++p)
+                {
+                    sum[c] += block.c[c][p];
+                    lo[c] = std::min<int>(lo[c], block.c[c][p]);
+                    hi[c] = std::max<int>(hi[c], block.c[c][p]);
+                }
+            }
+
+            uint16_t c0, c1;
+            uint32_t indices = 0;
+
+            if (lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2])
+            {
+                c0 = c1 = to_565(lo[0], lo[1], lo[2]);
+            }
+            else
+            {
+                // the principal axis of the colors by power iteration on their covariance, starting from the
+                // diagonal of their bounds
+                float mean[3], cov[6] = {};
+                for (size_t c = 0; c < 3; ++c)
+                    mean[c] = sum[c] / 16.0f;
+
+                for (size_t p = 0; p < 16; ++p)
+                {
+                    const float r = block.c[0][p] - mean[0], g = block.c[1][p] - mean[1], b = block.c[2][p] - mean[2];
+                    cov[0] += r * r;
+                    cov[1] += r * g;
+                    cov[2] += r * b;
+                    cov[3] += g * g;
+                    cov[4] += g * b;
+                    cov[5] += b * b;
+                }
+
+                float axis[3] = {(float)(hi[0] - lo[0]), (float)(hi[1] - lo[1]), (float)(hi[2] - lo[2])};
+                for (int i = 0; i < 4; ++i)
+                {
+                    const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+                    const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+                    const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+                    const float m = std::max({std::abs(x), std::abs(y), std::abs(z)});
+                    if (m < 1e-6f)
+                        break;
+
+                    axis[0] = x / m;
+                    axis[1] = y / m;
+                    axis[2] = z / m;
+                }
+
+                // the pixels furthest along the axis are the endpoints
+                size_t lo_p = 0, hi_p = 0;
+                float lo_d = std::numeric_limits<float>::max(), hi_d = std::numeric_limits<float>::lowest();
+                for (size_t p = 0; p < 16; ++p)
+                {
+                    const float d = block.c[0][p] * axis[0] + block.c[1][p] * axis[1] + block.c[2][p] * axis[2];
+                    if (d < lo_d)
+                    {
+                        lo_d = d;
+                        lo_p = p;
+                    }
+                    if (d > hi_d)
+                    {
+                        hi_d = d;
+                        hi_p = p;
+                    }
+                }
+
+                c0 = to_565(block.c[0][hi_p], block.c[1][hi_p], block.c[2][hi_p]);
+                c1 = to_565(block.c[0][lo_p], block.c[1][lo_p], block.c[2][lo_p]);
+                int error = bc1_indices(block, c0, c1, indices);
+
+                // refine while the error drops
+                for (int i = 0; i < 2 && error != 0; ++i)
+                {
+                    uint16_t r0, r1;
+                    uint32_t refined;
+                    if (!bc1_refine(block, indices, r0, r1))
+                        break;
+
+                    const int refined_error = bc1_indices(block, r0, r1, refined);
+                    if (refined_error >= error)
+                        break;
+
+                    c0 = r0;
+                    c1 = r1;
+                    indices = refined;
+                    error = refined_error;
+                }
+            }
+
+            // c0 above c1 selects the 4 color palette, swapping them swaps indices 0 and 1 and 2 and 3
+            if (c0 < c1)
+            {
+                std::swap(c0, c1);
+                indices ^= 0x55555555u;
+            }
+            else if (c0 == c1)
+            {
+                indices = 0;
+            }
+
+            out[0] = (unsigned char)c0;
+            out[1] = (unsigned char)(c0 >> 8);
+            out[2] = (unsigned char)c1;
+            out[3] = (unsigned char)(c1 >> 8);
+            for (size_t b = 0; b < 4; ++b)
+                out[4 + b] = (unsigned char)(indices >> (8 * b));
+        }
+    }
+
+    [[nodiscard]] size_t compressed_size(block_format format, size_t width, size_t height) noexcept
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * block_bytes(format);
+    }
+
+    void compress_image(const unsigned char *pixels, size_t width, size_t height, size_t channels, block_format format, unsigned char *out, job_pool *pool) noexcept
+    {
+        if (width == 0 || height == 0)
+            return;
+
+        if (channels == 0 || channels > 4)
+        {
+            std::cout << "[utils] Error: Cannot compress images with " << channels << " channels.\n";
+            return;
+        }
+
+        const size_t blocks_x = (width + 3) / 4;
+        const size_t blocks_y = (height + 3) / 4;
+        const size_t bytes = block_bytes(format);
+        const bool grey = format == block_format::BC1 || format == block_format::BC3;
+
+        auto compress = [&](size_t begin, size_t end) {
+            detail::pixel_block block;
+            for (size_t by = begin; by < end; ++by)
+            {
+                for (size_t bx = 0; bx < blocks_x; ++bx)
+                {
+                    detail::load_block(pixels, width, height, channels, grey, bx, by, block);
+
+                    unsigned char *dst = out + (by * blocks_x + bx) * bytes;
+                    switch (format)
+                    {
+                    case block_format::BC1:
+                        detail::encode_bc1(block, dst);
+                        break;
+                    case block_format::BC3:
+                        detail::encode_bc4(block.c[3], dst);
+                        detail::encode_bc1(block, dst + 8);
+                        break;
+                    case block_format::BC4:
+                        detail::encode_bc4(block.c[0], dst);
+                        break;
+                    case block_format::BC5:
+                        detail::encode_bc4(block.c[0], dst);
+                        detail::encode_bc4(block.c[1], dst + 8);
+                        break;
+                    }
+                }
+            }
+        };
+
+        // a block takes far longer than copying its pixels, so images are split from 1024 blocks. Ex: 128 x 128
+        constexpr size_t parallel_blocks = 1024;
+        if (pool != nullptr && blocks_x * blocks_y >= parallel_blocks)
+            pool->parallel_for(blocks_y, std::max<size_t>(parallel_blocks / blocks_x, 1), compress);
+        else
+            compress(0, blocks_y);
+    }
+
+    void downsample_image(const unsigned char *src, size_t width, size_t height, size_t channels, unsigned char *dst, job_pool *pool) noexcept
+    {
+        if (width == 0 || height == 0 || channels == 0)
+            return;
+
+        const size_t half_width = std::max<size_t>(width / 2, 1);
+        const size_t half_height = std::max<size_t>(height / 2, 1);
+        const size_t row = width * channels;
+
+        auto halve = [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y)
+            {
+                // an odd last row or column is averaged with itself
+                const unsigned char *top = src + std::min(2 * y, height - 1) * row;
+                const unsigned char *bottom = src + std::min(2 * y + 1, height - 1) * row;
+                unsigned char *to = dst + y * half_width * channels;
+
+                for (size_t x = 0; x < half_width; ++x)
+                {
+                    const size_t left = std::min(2 * x, width - 1) * channels;
+                    const size_t right = std::min(2 * x + 1, width - 1) * channels;
+                    for (size_t c = 0; c < channels; ++c)
+                        to[x * channels + c] = (unsigned char)((top[left + c] + top[right + c] + bottom[left + c] + bottom[right + c] + 2) / 4);
+                }
+            }
+        };
+
+        if (pool != nullptr && row * height >= detail::parallel_image_bytes)
+            pool->parallel_for(half_height, std::max<size_t>(detail::image_grain_bytes / (2 * row), 1), halve);
+        else
+            halve(0, half_height);
+    }
+    
+    template <typename T>
+    requires std::equality_comparable<T>
+    bool one_of(const T &val, const std::initializer_list<T> &list) noexcept
+    {
+        for (const auto &item : list)
+        {
+            if (val == item)
+                return true;
+        }
+        return false;
+    }
+
+    template<auto Start, auto End, auto Inc, typename Fn>
+    constexpr void constexpr_for(Fn&& fn) noexcept
+    {
+        if constexpr (Start < End)
+        {
+            fn(std::integral_constant<decltype(Start), Start>());
+            constexpr_for<Start + Inc, End, Inc>(fn);
+        }
+    }
+
+    template<typename T, typename U, typename V, typename W>
+    requires (std::is_floating_point_v<T> || std::is_integral_v<T>)
+        && (std::is_floating_point_v<U> || std::is_integral_v<U>)
+        && (std::is_floating_point_v<V> || std::is_integral_v<V>)
+        && (std::is_floating_point_v<W> || std::is_integral_v<W>)
+    consteval glm::vec4 rgba(T&& r, U&& g, V&& b, W&& a) noexcept
+    {
+        glm::vec4 col{r, g, b, a};
+        if constexpr (std::is_integral_v<T>) {
+            col.r /= 256.0f;
+        }
+        if constexpr (std::is_integral_v<U>) {
+            col.g /= 256.0f;
+        }
+        if constexpr (std::is_integral_v<V>) {
+            col.b /= 256.0f;
+        }
+        if constexpr (std::is_integral_v<W>) {
+            col.a /= 256.0f;
+        }
+        return col;
+    }
+
+    consteval glm::vec4 hex(std::string_view&& code) noexcept
+    {
+        // const hex size
+        // #RRGGBB --> 7
+        // #RRGGBBAA --> 9
+        // #RGBA or #RGB -- > 5 or 4
+
+        if (code.size() > 9)
+        {
+            // * Compile time detects and prevents compile if this line is reached.
+            // ? For use if funciton is converted to constexpr
+            std::cout << "[utils] Error: Failed to create color glm::vec4 due to invalid hex code: " << code << "\n";
+            return glm::vec4{0};
+        }
+
+        auto heximal = [](char c)->double{
+            if ('0' <= c && c <= '9')
+            {
+                return c - '0';
+            }
+            if ('a' <= c && c <= 'f')
+            {
+                return c - 'a' + 10;
+            }
+            if ('A' <= c && c <= 'F')
+            {
+                return c - 'A' + 10;
+            }
+            return 0;
+        };
+        
+        return code.size() > 5 ?
+                    glm::vec4{
+                        (heximal(code[2]) + heximal(code[1]) * 16.0) / 255.0,
+                        (heximal(code[4]) + heximal(code[3]) * 16.0) / 255.0,
+                        (heximal(code[6]) + heximal(code[5]) * 16.0) / 255.0,
+                        code.size() > 7 ? (heximal(code[8]) + heximal(code[7]) * 16.0) / 255.0 : 1.0,
+                    }
+                    :
+                    glm::vec4{
+                        ((heximal(code[1]) + heximal(code[1])) * 16.0) / 255.0,
+                        ((heximal(code[2]) + heximal(code[2])) * 16.0) / 255.0,
+                        ((heximal(code[3]) + heximal(code[3])) * 16.0) / 255.0,
+                        code.size() > 4 ? (heximal(code[4]) + heximal(code[4]) * 16.0) / 255.0 : 1.0,
+                    };
+    }
+
+    template <size_t rows, size_t cols, typename T>
+    requires Printable<T>
+    void print_mat(const T *ptr) noexcept
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            std::cout << "[";
+            for (size_t j = 0; j < cols; ++j)
+            {
+                std::cout << *(ptr + i * cols + j);
+                // std::cout << ptr[i][j];
+                if (j != cols - 1)
+                    std::cout << ", ";
+            }
+            std::cout << "]\n";
+        }
+    }
+
+    template <size_t rows, size_t cols, typename T, typename Fn>
+    requires PrintableFn<T, Fn>
+    void print_mat(const T *ptr, Fn&& fn) noexcept
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            std::cout << "[";
+            for (size_t j = 0; j < cols; ++j)
+            {
+                std::cout << fn(*(ptr + i * cols + j));
+                // std::cout << ptr[i][j];
+                if (j != cols - 1)
+                    std::cout << ", ";
+            }
+            std::cout << "]\n";
+        }
+    }
+
+    template <size_t vec_size, size_t n, typename T>
+    requires Printable<T>
+    void print_vecs(const T *ptr) noexcept
+    {
+        if (n != 1)
+            std::cout << "[ ";
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::cout << "[";
+            for (size_t j = 0; j < vec_size; ++j)
+            {
+                std::cout << *(ptr + j + i * vec_size);
+                if (j != vec_size - 1)
+                    std::cout << ", ";
+            }
+            std::cout << "]";
+
+            if (i != n - 1)
+                std::cout << ", ";
+        }
+
+        if (n != 1)
+            std::cout << " ]";
+        
+        
+        std::cout << "\n";    
+    }
+
+    template <size_t vec_size, size_t n, typename T, typename Fn>
+    requires PrintableFn<T, Fn>
+    void print_vecs(const T *ptr, Fn&& fn) noexcept
+    {
+        if (n != 1)
+            std::cout << "[ ";
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::cout << "[";
+            for (size_t j = 0; j < vec_size; ++j)
+            {
+                std::cout << fn(*(ptr + j + i * vec_size));
+                if (j != vec_size - 1)
+                    std::cout << ", ";
+            }
+            std::cout << "]";
+
+            if (i != n - 1)
+                std::cout << ", ";
+        }
+
+        if (n != 1)
+            std::cout << " ]";
+        
+        
+        std::cout << "\n";    
+    }
+
+    template<typename Tuple, size_t ... Is>
+    void print_tuple_impl(const Tuple& tup, std::index_sequence<Is...>)
+    {
+        ((std::cout << (Is == 0 ? "" : ", ") << std::get<Is>(tup)), ... );
+    }
+
+    template<typename ... Ts>
+    requires (Printable<Ts> && ...)
+    void print_tuple(const std::tuple<Ts...>& tup) noexcept
+    {
+        std::cout << "(";
+        print_tuple_impl(tup, std::make_index_sequence<sizeof...(Ts)>{});
+        std::cout << ")\n";
+    }
+
+    template <typename T>
+    requires Printable<T>
+    void print(const T *ptr) noexcept
+    {
+        std::cout << ptr << "\n";
+    }
+
+    template <typename T, typename Fn>
+    requires PrintableFn<T, Fn>
+    void print(const T* ptr, Fn fn) noexcept
+    {
+        std::cout << fn(ptr) << "\n";
+    }
+
+    template<typename ... Ts>
+    requires (Printable<Ts> && ...)
+    void print_all(const Ts&... args)
+    {
+        (std::cout << ... << args) << '\n';
+    }
+
+    template<size_t Dimensions>
+    requires (Dimensions > 1 && Dimensions < 4)
+    constexpr std::array<glm::vec<Dimensions, float>, 3> gen_tri_verts(const glm::vec<Dimensions, float> &start, const glm::vec<Dimensions, float> &end) noexcept
+    {
+        if constexpr (Dimensions == 2) {
+            return {
+                glm::vec2{start.x, start.y},
+                glm::vec2{start.x + (end.x - start.x) / 2.0, end.y},
+                glm::vec2{end.x, start.y},
+            };
+        }
+        if constexpr (Dimensions == 3) {
+            return {
+                glm::vec3{start.x, start.y, start.z},
+                glm::vec3{start.x + (end.x - start.x) / 2.0, end.y, start.z + (end.z - start.z) / 2.0},
+                glm::vec3{end.x, start.y, end.z},
+            };
+        }
+    }
+
+    template<size_t Dimensions>
+    requires (Dimensions > 1 && Dimensions < 4)
+    constexpr std::array<glm::vec<Dimensions, float>, 4> gen_rect_verts(const glm::vec<Dimensions, float> &start, const glm::vec<Dimensions, float> &end) noexcept
+    {
+        if constexpr (Dimensions == 2) {
+            return {
+                glm::vec2{start.x, start.y},
+                glm::vec2{start.x, end.y},
+                glm::vec2{end.x, end.y},
+                glm::vec2{end.x, start.y},
+            };
+        }
+        if constexpr (Dimensions == 3) {
+            return {
+                glm::vec3{start.x, start.y, start.z},
+                glm::vec3{start.x, end.y, start.z},
+                glm::vec3{end.x, end.y, end.z},
+                glm::vec3{end.x, start.y, end.z},
+            };
+        }
+    }
+
+    constexpr std::array<glm::uvec3, 2> gen_rect_indices() noexcept
+    {
+        using V = utils::GEN_RECT_FACE_VERTS;
+
+        return std::array{
+            glm::uvec3{
+                V::BOTTOM_LEFT,
+                V::TOP_LEFT,
+                V::TOP_RIGHT
+            },
+            glm::uvec3{
+                V::BOTTOM_LEFT,
+                V::TOP_RIGHT,
+                V::BOTTOM_RIGHT
+            }
+        };
+    }
+
+    constexpr std::array<glm::vec3, 36> gen_cube_verts(const glm::vec3& start, const glm::vec3& end) noexcept
+    {
+        return std::array{
+            // BACK FACE
+            glm::vec3{start.x, start.y, start.z},
+            glm::vec3{start.x, end.y, start.z},
+            glm::vec3{end.x, end.y, start.z},
+
+            glm::vec3{start.x, start.y, start.z},
+            glm::vec3{end.x, end.y, start.z},
+            glm::vec3{end.x, start.y, start.z},
+
+            // BOTTOM FACE
+            glm::vec3{start.x, start.y, start.z},
+            glm::vec3{start.x, start.y, end.z},
+            glm::vec3{end.x, start.y, end.z},
+            
+            glm::vec3{start.x, start.y, start.z},
+            glm::vec3{end.x, start.y, end.z},
+            glm::vec3{end.x, start.y, start.z},
+
+            // LEFT FACE
+            glm::vec3{start.x, start.y, start.z},
+            glm::vec3{start.x, end.y, start.z},
+            glm::vec3{start.x, end.y, end.z},
+            
+            glm::vec3{start.x, start.y, start.z},
+            glm::vec3{start.x, end.y, end.z},
+            glm::vec3{start.x, start.y, end.z},
+
+            // reflect on primary axis
+
+            // FRONT FACE
+            glm::vec3{start.x, start.y, end.z},
+            glm::vec3{start.x, end.y, end.z},
+            glm::vec3{end.x, end.y, end.z},
+
+            glm::vec3{start.x, start.y, end.z},
+            glm::vec3{end.x, end.y, end.z},
+            glm::vec3{end.x, start.y, end.z},
+
+            // TOP FACE
+            glm::vec3{start.x, end.y, start.z},
+            glm::vec3{start.x, end.y, end.z},
+            glm::vec3{end.x, end.y, end.z},
+            
+            glm::vec3{start.x, end.y, start.z},
+            glm::vec3{end.x, end.y, end.z},
+            glm::vec3{end.x, end.y, start.z},
+
+            // RIGHT FACE
+            glm::vec3{end.x, start.y, start.z},
+            glm::vec3{end.x, end.y, start.z},
+            glm::vec3{end.x, end.y, end.z},
+            
+            glm::vec3{end.x, start.y, start.z},
+            glm::vec3{end.x, end.y, end.z},
+            glm::vec3{end.x, start.y, end.z},
+        };
+    }
+
+    constexpr std::array<glm::vec2, 36> gen_cube_texcoords() noexcept
+    {
+        constexpr auto LEFT_START = -1.0f;
+        constexpr auto LEFT_END = 0.0f;
+        constexpr auto MIDDLE_START = LEFT_START;
+        constexpr auto MIDDLE_END = 1.0f;
+        constexpr auto RIGHT_START = MIDDLE_END;
+        constexpr auto RIGHT_END = 2.0f;
+
+        constexpr auto TOP_START = -1.0f;
+        constexpr auto TOP_END = 0.0f;
+        constexpr auto TOP_SECOND_START = TOP_END;
+        constexpr auto TOP_SECOND_END = 1.0f;
+        constexpr auto BOTTOM_SECOND_START = TOP_SECOND_END;
+        constexpr auto BOTTOM_SECOND_END = 2.0f;
+        constexpr auto BOTTOM_START = BOTTOM_SECOND_END;
+        constexpr auto BOTTOM_END = 3.0f;
+
+        return std::array{
+            // BACK FACE
+            glm::vec2{MIDDLE_START, BOTTOM_END},
+            glm::vec2{MIDDLE_START, BOTTOM_START},
+            glm::vec2{MIDDLE_END, BOTTOM_START},
+            
+            glm::vec2{MIDDLE_START, BOTTOM_END},
+            glm::vec2{MIDDLE_END, BOTTOM_START},
+            glm::vec2{MIDDLE_END, BOTTOM_END},
+            
+            // BOTTOM FACE
+            glm::vec2{MIDDLE_START, BOTTOM_SECOND_END},
+            glm::vec2{MIDDLE_START, BOTTOM_SECOND_START},
+            glm::vec2{MIDDLE_END, BOTTOM_SECOND_START},
+            
+            glm::vec2{MIDDLE_START, BOTTOM_SECOND_END},
+            glm::vec2{MIDDLE_END, BOTTOM_SECOND_START},
+            glm::vec2{MIDDLE_END, BOTTOM_SECOND_END},
+
+            // LEFT FACE
+            glm::vec2{LEFT_START, TOP_SECOND_END},
+            glm::vec2{LEFT_START, TOP_SECOND_START},
+            glm::vec2{LEFT_END, TOP_SECOND_START},
+            
+            glm::vec2{LEFT_START, TOP_SECOND_END},
+            glm::vec2{LEFT_END, TOP_SECOND_START},
+            glm::vec2{LEFT_END, TOP_SECOND_END},
+
+            // FRONT FACE
+            glm::vec2{MIDDLE_START, TOP_SECOND_END},
+            glm::vec2{MIDDLE_START, TOP_SECOND_START},
+            glm::vec2{MIDDLE_END, TOP_SECOND_START},
+            
+            glm::vec2{MIDDLE_START, TOP_SECOND_END},
+            glm::vec2{MIDDLE_END, TOP_SECOND_START},
+            glm::vec2{MIDDLE_END, TOP_SECOND_END},
+
+            // TOP FACE
+            glm::vec2{MIDDLE_START, TOP_END},
+            glm::vec2{MIDDLE_START, TOP_START},
+            glm::vec2{MIDDLE_END, TOP_START},
+            
+            glm::vec2{MIDDLE_START, TOP_END},
+            glm::vec2{MIDDLE_END, TOP_START},
+            glm::vec2{MIDDLE_END, TOP_END},
+
+            // RIGHT FACE
+            glm::vec2{RIGHT_START, TOP_SECOND_END},
+            glm::vec2{RIGHT_START, TOP_SECOND_START},
+            glm::vec2{RIGHT_END, TOP_SECOND_START},
+            
+            glm::vec2{RIGHT_START, TOP_SECOND_END},
+            glm::vec2{RIGHT_END, TOP_SECOND_START},
+            glm::vec2{RIGHT_END, TOP_SECOND_END},
+        };
+    }
+
+    constexpr std::array<glm::vec2, 36> gen_cube_texcoords_single_face(const glm::vec2& start, const glm::vec2& end) noexcept
+    {
+        return std::array{
+            // BACK FACE
+            glm::vec2{start.x, start.y},
+            glm::vec2{start.x, end.y},
+            glm::vec2{end.x, end.y},
+            
+            glm::vec2{start.x, start.y},
+            glm::vec2{end.x, end.y},
+            glm::vec2{end.x, start.y},
+
+            // BOTTOM FACE
+            glm::vec2{start.x, start.y},
+            glm::vec2{start.x, end.y},
+            glm::vec2{end.x, end.y},
+            
+            glm::vec2{start.x, start.y},
+            glm::vec2{end.x, end.y},
+            glm::vec2{end.x, start.y},
+
+            // LEFT FACE
+            glm::vec2{start.x, start.y},
+            glm::vec2{start.x, end.y},
+            glm::vec2{end.x, end.y},
+            
+            glm::vec2{start.x, start.y},
+            glm::vec2{end.x, end.y},
+            glm::vec2{end.x, start.y},
+
+            // reflect on primary axis
+            
+            // FRONT FACE
+            glm::vec2{start.x, start.y},
+            glm::vec2{start.x, end.y},
+            glm::vec2{end.x, end.y},
+            
+            glm::vec2{start.x, start.y},
+            glm::vec2{end.x, end.y},
+            glm::vec2{end.x, start.y},
+
+            // TOP FACE
+            glm::vec2{start.x, start.y},
+            glm::vec2{start.x, end.y},
+            glm::vec2{end.x, end.y},
+            
+            glm::vec2{start.x, start.y},
+            glm::vec2{end.x, end.y},
+            glm::vec2{end.x, start.y},
+
+            // RIGHT FACE
+            glm::vec2{start.x, start.y},
+            glm::vec2{start.x, end.y},
+            glm::vec2{end.x, end.y},
+            
+            glm::vec2{start.x, start.y},
+            glm::vec2{end.x, end.y},
+            glm::vec2{end.x, start.y},
+        };
+    }
+
+    constexpr std::array<glm::vec3, 36> gen_cube_normals(const glm::vec3& start, const glm::vec3& end) noexcept
+    {
+        glm::vec3 dir = end - start;
+        glm::vec3 right, up, forward;
+        right = glm::vec3{dir.x, 0.0f, 0.0f};
+        up = glm::vec3{0.0f, dir.y, 0.0f};
+        forward = glm::vec3{0.0f, 0.0f, dir.z};
+
+        return std::array{
+            // BACK FACE
+            -forward, -forward, -forward, -forward, -forward, -forward,
+
+            // BOTTOM FACE
+            -up, -up, -up, -up, -up, -up,
+
+            // LEFT FACE
+            -right, -right, -right, -right, -right, -right,
+
+            // reflect on primary axis
+
+            // FRONT FACE
+            forward, forward, forward, forward, forward, forward,
+
+            // TOP FACE
+            up, up, up, up, up, up,
+
+            // RIGHT FACE
+            right, right, right, right, right, right,
+        };
+    }
+
+    // the 4 corners of each face from the 6 vertices of its two triangles (0, 1, 2) and (0, 2, 5)
+    template <typename T>
+    constexpr std::array<T, 24> cube_face_corners(const std::array<T, 36>& unindexed) noexcept
+    {
+        std::array<T, 24> corners{};
+        for (size_t face = 0; face < 6; ++face)
+        {
+            corners[face * 4 + 0] = unindexed[face * 6 + 0];
+            corners[face * 4 + 1] = unindexed[face * 6 + 1];
+            corners[face * 4 + 2] = unindexed[face * 6 + 2];
+            corners[face * 4 + 3] = unindexed[face * 6 + 5];
+        }
+        return corners;
+    }
+
+    constexpr std::array<glm::vec3, 24> gen_cube_indexed_verts(const glm::vec3& start, const glm::vec3& end) noexcept
+    {
+        return cube_face_corners(gen_cube_verts(start, end));
+    }
+
+    constexpr std::array<glm::vec2, 24> gen_cube_indexed_texcoords() noexcept
+    {
+        return cube_face_corners(gen_cube_texcoords());
+    }
+
+    constexpr std::array<glm::vec2, 24> gen_cube_indexed_texcoords_single_face(const glm::vec2& start, const glm::vec2& end) noexcept
+    {
+        return cube_face_corners(gen_cube_texcoords_single_face(start, end));
+    }
+
+    constexpr std::array<glm::vec3, 24> gen_cube_indexed_normals(const glm::vec3& start, const glm::vec3& end) noexcept
+    {
+        return cube_face_corners(gen_cube_normals(start, end));
+    }
+
+    constexpr std::array<glm::uvec3, 12> gen_cube_indices() noexcept
+    {
+        std::array<glm::uvec3, 12> indices{};
+        for (unsigned int face = 0; face < 6; ++face)
+        {
+            indices[face * 2 + 0] = glm::uvec3{face * 4 + 0, face * 4 + 1, face * 4 + 2};
+            indices[face * 2 + 1] = glm::uvec3{face * 4 + 0, face * 4 + 2, face * 4 + 3};
+        }
+        return indices;
+    }
+
+    ////
+    // mesh optimization
+
+    [[nodiscard]] double acmr(const std::vector<uint32_t> &indices, size_t cache_size) noexcept
+    {
+        size_t triangles = indices.size() / 3;
+        if (triangles == 0)
+            return 0.0;
+        if (cache_size == 0)
+            return 3.0;
+
+        // fifo, the oldest vertex is replaced on a miss and hits do not change the order
+        std::vector<uint32_t> cache(cache_size, std::numeric_limits<uint32_t>::max());
+        size_t oldest = 0, misses = 0;
+
+        for (size_t i = 0; i < triangles * 3; ++i)
+        {
+            if (std::find(cache.begin(), cache.end(), indices[i]) != cache.end())
+                continue;
+
+            cache[oldest] = indices[i];
+            oldest = (oldest + 1) % cache_size;
+            ++misses;
+        }
+
+        return (double)misses / triangles;
+    }
+
+    template <typename Vertex>
+    requires std::is_trivially_copyable_v<Vertex>
+    size_t weld_vertices(std::vector<Vertex> &verts, std::vector<uint32_t> &indices) noexcept
+    {
+        if (indices.empty())
+        {
+            indices.resize(verts.size());
+            for (size_t i = 0; i < verts.size(); ++i)
+                indices[i] = i;
+        }
+
+        // open addressing table of the kept vertices, kept at most half full
+        constexpr uint32_t empty = std::numeric_limits<uint32_t>::max();
+        size_t table_size = 16;
+        while (table_size < verts.size() * 2)
+            table_size *= 2;
+
+        std::vector<uint32_t> table(table_size, empty);
+        std::vector<uint32_t> remap(verts.size());
+        size_t kept = 0;
+
+        for (size_t i = 0; i < verts.size(); ++i)
+        {
+            // fnv-1a of the vertex bytes
+            const auto *bytes = reinterpret_cast<const unsigned char *>(&verts[i]);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t b = 0; b < sizeof(Vertex); ++b)
+                hash = (hash ^ bytes[b]) * 1099511628211ull;
+
+            size_t slot = hash & (table_size - 1);
+            while (table[slot] != empty && std::memcmp(&verts[table[slot]], &verts[i], sizeof(Vertex)) != 0)
+                slot = (slot + 1) & (table_size - 1);
+
+            // kept vertices are compacted in place, kept <= i so nothing unread is overwritten
+            if (table[slot] == empty)
+            {
+                table[slot] = kept;
+                verts[kept++] = verts[i];
+            }
+
+            remap[i] = table[slot];
+        }
 
-                std::string str = row_str.substr(start, end - start);
+        for (auto &index : indices)
+            index = remap[index];
 
-                if (is_header)
-                {
-                    headers[param] = str;
-                }
-                else
+        size_t removed = verts.size() - kept;
+        verts.resize(kept);
+        return removed;
+    }
+
+    void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count, size_t cache_size) noexcept
+    {
+        size_t triangles = indices.size() / 3;
+        if (triangles == 0)
+            return;
+
+        for (size_t i = 0; i < triangles * 3; ++i)
+        {
+            if (indices[i] >= vertex_count)
+            {
+#if WRAP_G_DEBUG
+                std::cout << "[utils] Error: Index " << indices[i] << " is out of range of " << vertex_count << " vertices, the triangles were not reordered.\n";
+#endif
+                return;
+            }
+        }
+
+        // the number of triangles still to be emitted around each vertex
+        std::vector<uint32_t> live(vertex_count, 0);
+        for (size_t i = 0; i < triangles * 3; ++i)
+            ++live[indices[i]];
+
+        // the triangles around each vertex, the triangles of vertex v are at [offsets[v], offsets[v + 1])
+        std::vector<uint32_t> offsets(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; ++v)
+            offsets[v + 1] = offsets[v] + live[v];
+
+        std::vector<uint32_t> adjacency(triangles * 3);
+        {
+            std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+            for (size_t t = 0; t < triangles; ++t)
+                for (size_t k = 0; k < 3; ++k)
+                    adjacency[next[indices[t * 3 + k]]++] = t;
+        }
+
+        // the time each vertex last entered the cache, a vertex is cached while time - its time <= cache_size
+        std::vector<size_t> cache_time(vertex_count, 0);
+        std::vector<bool> emitted(triangles, false);
+        // recently used vertices to continue from when a fan runs out
+        std::vector<uint32_t> dead_ends;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(triangles * 3);
+
+        constexpr size_t none = std::numeric_limits<size_t>::max();
+        size_t time = cache_size + 1;
+        size_t cursor = 0;
+        size_t fanning = 0;
+
+        while (fanning != none)
+        {
+            // emit every triangle left around the fanning vertex
+            candidates.clear();
+            for (size_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+            {
+                uint32_t t = adjacency[a];
+                if (emitted[t])
+                    continue;
+
+                for (size_t k = 0; k < 3; ++k)
                 {
-                    row_str_arr[param] = str;
+                    uint32_t v = indices[t * 3 + k];
+                    output.push_back(v);
+                    dead_ends.push_back(v);
+                    candidates.push_back(v);
+                    --live[v];
+
+                    if (time - cache_time[v] > cache_size)
+                        cache_time[v] = time++;
                 }
+                emitted[t] = true;
+            }
 
-                ++param;
-                
-                start = row_str.find_first_of(',', start) + 1;
+            // the next fanning vertex is the oldest candidate which will still be cached after its fan
+            fanning = none;
+            int64_t best = -1;
+            for (auto v : candidates)
+            {
+                if (live[v] == 0)
+                    continue;
 
-                if (param == std::tuple_size_v<std::tuple<Ts...>>)
+                int64_t priority = 0;
+                if (time - cache_time[v] + 2 * live[v] <= cache_size)
+                    priority = time - cache_time[v];
+
+                if (priority > best)
                 {
-                    if (!is_header)
-                    {
-                        std::tuple<Ts ...> tup{};
+                    best = priority;
+                    fanning = v;
+                }
+            }
 
-                        utils::constexpr_for<0, row_str_arr.size(), 1>([&row_str_arr, &tup, fn](auto i){
-                            fn(std::get<i>(tup), row_str_arr[i]);
-                        });
+            // otherwise continue from a recent vertex or the next vertex in the input with triangles left
+            while (fanning == none && !dead_ends.empty())
+            {
+                uint32_t v = dead_ends.back();
+                dead_ends.pop_back();
+                if (live[v] != 0)
+                    fanning = v;
+            }
 
-                        data.push_back(tup);
-                    }
-                    else
-                    {
-                        is_header = false;
-                    }
+            for (; fanning == none && cursor < vertex_count; ++cursor)
+                if (live[cursor] != 0)
+                    fanning = cursor;
+        }
 
-                    try {
-                        std::getline(file, row_str);
-                    }
-                    catch (const std::ifstream::failure &e)
-                    {
-                        break;
-                    }
+        indices = std::move(output);
+    }
 
-                    start = 0;
-                    param = 0;
-                }
+    template <typename Vertex>
+    void optimize_vertex_fetch(std::vector<Vertex> &verts, std::vector<uint32_t> &indices) noexcept
+    {
+        constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(verts.size(), unused);
+        std::vector<Vertex> fetched;
+        fetched.reserve(verts.size());
+
+        for (auto &index : indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = fetched.size();
+                fetched.push_back(verts[index]);
             }
+            index = remap[index];
+        }
 
-            file.close();
-            return std::make_pair(headers, data);
+        verts = std::move(fetched);
+    }
+
+    template <typename Vertex>
+    requires std::is_trivially_copyable_v<Vertex>
+    mesh_report optimize_mesh(std::vector<Vertex> &verts, std::vector<uint32_t> &indices, size_t cache_size) noexcept
+    {
+        if (indices.empty())
+        {
+            indices.resize(verts.size());
+            for (size_t i = 0; i < verts.size(); ++i)
+                indices[i] = i;
         }
-        catch (const std::ifstream::failure &e)
+
+        mesh_report report;
+        report.vertices_before = verts.size();
+        report.triangles = indices.size() / 3;
+        report.acmr_before = acmr(indices, cache_size);
+
+        (void)weld_vertices(verts, indices);
+        optimize_vertex_cache(indices, verts.size(), cache_size);
+        optimize_vertex_fetch(verts, indices);
+
+        report.vertices_after = verts.size();
+        report.acmr_after = acmr(indices, cache_size);
+
+#if WRAP_G_DEBUG
+        std::cout << "[utils] Info: Optimized mesh of " << report.triangles << " triangles. Vertices: "
+                  << report.vertices_before << " -> " << report.vertices_after << ", ACMR: "
+                  << report.acmr_before << " -> " << report.acmr_after << ".\n";
+#endif
+
+        return report;
+    }
+
+    ////
+    // vertex compression
+
+    constexpr uint16_t pack_half(float value) noexcept
+    {
+        uint32_t bits = std::bit_cast<uint32_t>(value);
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t exponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        // infinity and nan, nan keeps a mantissa bit so it stays nan
+        if (exponent == 0xff)
+            return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+
+        int32_t half_exponent = (int32_t)exponent - 127 + 15;
+        if (half_exponent >= 0x1f)
+            return sign | 0x7c00;
+
+        // too small for a normal half, the implicit bit is shifted into the mantissa of a subnormal
+        if (half_exponent <= 0)
         {
-            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
-            return std::make_pair(headers, data);
+            if (half_exponent < -10)
+                return sign;
+
+            mantissa |= 0x800000;
+            uint32_t shift = 14 - half_exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+
+            if (rest > halfway || (rest == halfway && (half & 1) != 0))
+                ++half;
+            return sign | half;
         }
+
+        // rounding up can carry into the exponent which is still the correct result
+        uint32_t half = sign | (half_exponent << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0))
+            ++half;
+        return half;
     }
 
-    template<typename ... Ts, typename Fn>
-    [[nodiscard]] std::future<std::pair<std::array<std::string, sizeof...(Ts)>, std::vector<std::tuple<Ts...>>>>
-    read_csv_tuple_async(const char *path, bool has_headers, Fn&& fn) noexcept
+    constexpr float unpack_half(uint16_t bits) noexcept
     {
-        return std::async(std::launch::async, [path, has_headers, &fn](){
-            return read_csv_tuple_sync<Ts ...>(path, has_headers, fn);
-        });
+        uint32_t sign = uint32_t(bits & 0x8000) << 16;
+        uint32_t exponent = (bits >> 10) & 0x1f;
+        uint32_t mantissa = bits & 0x3ff;
+
+        if (exponent == 0)
+        {
+            float value = mantissa * (1.0f / 16777216.0f);
+            return sign != 0 ? -value : value;
+        }
+
+        if (exponent == 0x1f)
+            return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+
+        return std::bit_cast<float>(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
     }
 
-    template<typename Struct, typename Fn>
-    requires std::is_invocable_r_v<Struct, Fn, const std::vector<std::string>&>
-    [[nodiscard]] std::pair<std::vector<std::string>, std::vector<Struct>>
-    read_csv_struct_sync(const char *path, bool has_headers, Fn&& fn) noexcept
+    constexpr uint16_t pack_unorm16(float value) noexcept
     {
-        std::vector<std::string> headers;
-        std::vector<Struct> data;
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return uint16_t(value * 65535.0f + 0.5f);
+    }
 
-        bool is_headers = has_headers;
+    constexpr int16_t pack_snorm16(float value) noexcept
+    {
+        value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+        return int16_t(value >= 0.0f ? value * 32767.0f + 0.5f : value * 32767.0f - 0.5f);
+    }
 
-        std::ifstream file;
-        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
-        try
+    constexpr uint32_t pack_snorm_10_10_10_2(const glm::vec3 &value, float w) noexcept
+    {
+        // round and clamp to [-max, max] then keep the low bits of the two's complement
+        auto snorm = [](float v, float max, uint32_t mask) {
+            v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+            int32_t i = int32_t(v >= 0.0f ? v * max + 0.5f : v * max - 0.5f);
+            return uint32_t(i) & mask;
+        };
+
+        return snorm(value.x, 511.0f, 0x3ff)
+            | snorm(value.y, 511.0f, 0x3ff) << 10
+            | snorm(value.z, 511.0f, 0x3ff) << 20
+            | snorm(w, 1.0f, 0x3) << 30;
+    }
+
+    constexpr glm::vec2 pack_octahedral(const glm::vec3 &normal) noexcept
+    {
+        auto abs = [](float v) { return v < 0.0f ? -v : v; };
+        auto sign = [](float v) { return v < 0.0f ? -1.0f : 1.0f; };
+
+        float length = abs(normal.x) + abs(normal.y) + abs(normal.z);
+        if (length == 0.0f)
+            return glm::vec2{0.0f};
+
+        // project onto the octahedron then fold the lower half over the upper half
+        float x = normal.x / length, y = normal.y / length;
+        if (normal.z < 0.0f)
+            return glm::vec2{(1.0f - abs(y)) * sign(x), (1.0f - abs(x)) * sign(y)};
+
+        return glm::vec2{x, y};
+    }
+
+    [[nodiscard]] glm::vec3 unpack_octahedral(const glm::vec2 &encoded) noexcept
+    {
+        glm::vec3 v{encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y)};
+
+        // unfold the lower half
+        if (v.z < 0.0f)
         {
-            file.open(path);
+            float x = v.x;
+            v.x = (1.0f - std::abs(v.y)) * (x < 0.0f ? -1.0f : 1.0f);
+            v.y = (1.0f - std::abs(x)) * (v.y < 0.0f ? -1.0f : 1.0f);
+        }
 
-            while (!file.eof())
+        return v / std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    }
+
+    void pack_half(const float *values, uint16_t *out, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#if defined(__F16C__)
+        // 8 at a time, rounded to the nearest even like the scalar version
+        for (; i + 8 <= count; i += 8)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+
+        for (; i < count; ++i)
+            out[i] = pack_half(values[i]);
+    }
+
+    void pack_unorm16(const float *values, uint16_t *out, size_t count) noexcept
+    {
+        size_t i = 0;
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+        // 8 at a time, clamped, scaled and rounded then packed with unsigned saturation
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(65535.0f);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128 low = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(values + i), zero), one), scale);
+            __m128 high = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(values + i + 4), zero), one), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+        }
+#endif
+
+        for (; i < count; ++i)
+            out[i] = pack_unorm16(values[i]);
+    }
+
+    void pack_snorm_10_10_10_2(const glm::vec3 *values, uint32_t *out, size_t count) noexcept
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = pack_snorm_10_10_10_2(values[i]);
+    }
+
+    ////
+    // meshes
+
+    namespace detail
+    {
+        // whether 8 bytes are all ascii digits, checked 8 at a time in one register
+        inline bool is_eight_digits(uint64_t chars) noexcept
+        {
+            return ((chars & 0xF0F0F0F0F0F0F0F0) | (((chars + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+        }
+
+        // the value of 8 ascii digits in memory order, combined in pairs, then fours, then eights
+        inline uint32_t parse_eight_digits(uint64_t chars) noexcept
+        {
+            chars -= 0x3030303030303030;
+            chars = chars * 10 + (chars >> 8);
+            chars = (((chars & 0x000000FF000000FF) * (100 + (1000000ull << 32))) + (((chars >> 16) & 0x000000FF000000FF) * (1 + (10000ull << 32)))) >> 32;
+            return uint32_t(chars);
+        }
+
+        // read digits into the mantissa, 8 at a time while they fit. Leading zeros do not count towards the
+        // 19 significant digits a mantissa holds, the digits after them are dropped
+        // appended is the number of digits multiplied into the mantissa and dropped the number left out
+        inline const char *parse_digits(const char *p, const char *end, uint64_t &mantissa, int &significant, int &appended, int &dropped) noexcept
+        {
+            if constexpr (std::endian::native == std::endian::little)
             {
-                std::string str;
-                try
+                while (significant <= 11 && end - p >= 8)
                 {
-                    std::getline(file, str);
+                    uint64_t chars;
+                    std::memcpy(&chars, p, 8);
+                    if (!is_eight_digits(chars))
+                        break;
+
+                    uint32_t value = parse_eight_digits(chars);
+                    if (mantissa != 0)
+                        significant += 8;
+                    else
+                        for (uint32_t v = value; v != 0; v /= 10)
+                            ++significant;
+
+                    mantissa = mantissa * 100000000 + value;
+                    appended += 8;
+                    p += 8;
                 }
-                catch (const std::ifstream::failure& e)
+            }
+
+            for (; p != end && *p >= '0' && *p <= '9'; ++p)
+            {
+                if (significant >= 19)
                 {
+                    ++dropped;
                     continue;
                 }
 
-                std::vector<std::string> row_str;
-                
-                size_t start = 0;
-                size_t end = str.find_first_of(',');
-                while (end != std::string::npos)
-                {
-                    row_str.push_back(str.substr(start, end - start));
+                mantissa = mantissa * 10 + (*p - '0');
+                ++appended;
+                if (mantissa != 0)
+                    ++significant;
+            }
 
-                    start = end + 1;
-                    end = str.find_first_of(',', start);
-                }
+            return p;
+        }
 
-                if (start < str.size() - 1) {
-                    end = str.size();
-                    row_str.push_back(str.substr(start, end - start));
-                }
+        // parse a float like 1, -0.5, .25 or 1.5e-3. Returns nullptr if there is no number
+        inline const char *parse_float(const char *p, const char *end, float &out) noexcept
+        {
+            constexpr double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
 
-                if (is_headers)
-                {
-                    headers = row_str;
-                    is_headers = false;
-                }
-                else
+            bool negative = p != end && *p == '-';
+            if (p != end && (*p == '-' || *p == '+'))
+                ++p;
+
+            uint64_t mantissa = 0;
+            int significant = 0, appended = 0, dropped = 0;
+
+            p = parse_digits(p, end, mantissa, significant, appended, dropped);
+            int exponent = dropped;
+            bool any = appended + dropped != 0;
+
+            // each fraction digit in the mantissa moves the point one place
+            if (p != end && *p == '.')
+            {
+                appended = dropped = 0;
+                p = parse_digits(p + 1, end, mantissa, significant, appended, dropped);
+                exponent -= appended;
+                any |= appended + dropped != 0;
+            }
+
+            if (!any)
+                return nullptr;
+
+            if (p != end && (*p == 'e' || *p == 'E'))
+            {
+                const char *e = p + 1;
+                bool negative_exponent = e != end && *e == '-';
+                if (e != end && (*e == '-' || *e == '+'))
+                    ++e;
+
+                int value = 0;
+                const char *digits_start = e;
+                for (; e != end && *e >= '0' && *e <= '9'; ++e)
+                    value = std::min(value * 10 + (*e - '0'), 10000);
+
+                if (e != digits_start)
                 {
-                    // utils::print_vecs<11>(row_str.data());
-                    data.push_back(fn(row_str));
+                    exponent += negative_exponent ? -value : value;
+                    p = e;
                 }
-            };
+            }
 
-            return std::make_pair(headers, data);
-        }
-        catch (const std::ifstream::failure& e)
-        {
-            std::cout << "[utils] Error: Failed to read file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
-            return std::make_pair(headers, data);
+            // one rounding for powers up to 22 which covers every number written by a 3d tool
+            double value = (double)mantissa;
+            if (exponent >= 0)
+                value *= exponent <= 22 ? powers[exponent] : std::pow(10.0, exponent);
+            else
+                value /= exponent >= -22 ? powers[-exponent] : std::pow(10.0, -exponent);
+
+            out = float(negative ? -value : value);
+            return p;
         }
-    }
-    
-    template<typename Struct, typename Fn>
-    requires std::is_invocable_r_v<Struct, Fn, const std::vector<std::string>&>
-    [[nodiscard]] std::future<std::pair<std::vector<std::string>, std::vector<Struct>>>
-    read_csv_struct_async(const char *path, bool has_headers, Fn&& fn) noexcept
-    {
-        return std::async([path, has_headers, &fn](){
-            return read_csv_struct_sync<Struct>(path, has_headers, fn);
-        });
-    }
 
-    template<typename DurationUnit, typename Fn>
-    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
-            && std::is_invocable_v<Fn>
-    void set_timeout(int timeout, Fn&& fn) noexcept
-    {
-        utils::timer t1;
-        t1.start();
-        while (timeout > t1.stop<DurationUnit>()){};
-        fn();
-    }
+        // a parsed index, 0 based. Relative (negative) indices are stored from the start of their chunk
+        // with obj_local set until the chunk's offset is known. Those reaching back past the start of their
+        // chunk also have obj_before set and store how far before the start they point
+        constexpr uint32_t obj_missing = ~uint32_t{0};
+        constexpr uint32_t obj_local = uint32_t{1} << 31;
+        constexpr uint32_t obj_before = uint32_t{1} << 30;
 
-    template<typename DurationUnit, typename Fn>
-    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
-            && std::is_invocable_v<Fn, bool&>
-    void set_interval(int interval, Fn&& fn) noexcept
-    {
-        utils::timer t1;
-        t1.start();
-        int now = 0, old = 0;
-        bool end = false;
-        while (!end)
+        struct obj_corner
         {
-            now = t1.stop<DurationUnit>();
-            if (now - old > interval) {
-                old = now;
-                fn(end);
-            }
+            uint32_t position = obj_missing;
+            uint32_t texcoord = obj_missing;
+            uint32_t normal = obj_missing;
+        };
+
+        struct obj_chunk
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec2> texcoords;
+            std::vector<glm::vec3> normals;
+            // 3 corners per triangle
+            std::vector<obj_corner> corners;
+            bool failed = false;
+        };
+
+        inline const char *skip_spaces(const char *p, const char *end) noexcept
+        {
+            while (p != end && (*p == ' ' || *p == '\t'))
+                ++p;
+            return p;
         }
-    }
-    
-    template<typename DurationUnit, typename Fn>
-    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
-            && std::is_invocable_v<Fn>
-    [[nodiscard]] std::future<void> set_timeout_async(int timeout, Fn&& fn) noexcept
-    {
-        return std::async(std::launch::async, [timeout, &fn](){
-            std::this_thread::sleep_for(DurationUnit(timeout));
 
-            fn();
-        });
-    }
+        // parse an obj index into a 0 based one, count is the number of elements in the chunk so far
+        inline const char *parse_obj_index(const char *p, const char *end, size_t count, uint32_t &out) noexcept
+        {
+            bool negative = p != end && *p == '-';
+            if (negative)
+                ++p;
 
-    template<typename DurationUnit, typename Fn>
-    requires is_one_of<DurationUnit, timer::y, timer::m, timer::d, timer::hr, timer::min, timer::s, timer::ms, timer::us, timer::ns>
-            && std::is_invocable_v<Fn, bool&>
-    [[nodiscard]] std::future<void> set_interval_async(int interval, Fn&& fn) noexcept
-    {
-        return std::async(std::launch::async, [interval, &fn](){
-            bool end = false;
-            while (!end)
+            int64_t value = 0;
+            const char *start = p;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p)
+                value = std::min<int64_t>(value * 10 + (*p - '0'), obj_before - 1);
+
+            if (p == start || value == 0)
             {
-                std::this_thread::sleep_for(DurationUnit(interval));
-                fn(end);
+                out = obj_missing;
+                return p;
             }
-        });
-    }
 
-    template<size_t Width, size_t Height, typename T>
-    requires std::swappable<T> && (Width > 0) && (Height > 0)
-    void flip_array2d(T *ptr, bool horizontally, bool vertically) noexcept
-    {
-        if (!horizontally && !vertically)
-            return;
+            if (!negative)
+                out = uint32_t(value - 1);
+            else
+                out = (int64_t)count >= value ? uint32_t(count - value) | obj_local : uint32_t(value - count) | obj_local | obj_before;
+
+            return p;
+        }
 
-        if (horizontally ^ vertically)
+        inline void parse_obj_chunk(const char *p, const char *end, obj_chunk &chunk) noexcept
         {
-            for (size_t i = 0; i < Height * (vertically ? 0.5 : 1.0); ++i)
+            std::vector<obj_corner> face;
+
+            while (p != end)
             {
-                for (size_t j = 0; j < Width * (horizontally ? 0.5 : 1.0); ++j)
+                p = skip_spaces(p, end);
+                const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+                if (line_end == nullptr)
+                    line_end = end;
+
+                if (line_end - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
                 {
-                    auto* first = ptr + j + i * Width;
-                    auto* second = ptr + (horizontally ? Width - j - 1: j) + (vertically ? Height - i - 1 : i) * Width;
+                    glm::vec3 v{0.0f};
+                    const char *q = p + 1;
+                    for (int i = 0; i < 3 && q != nullptr; ++i)
+                        q = parse_float(skip_spaces(q, line_end), line_end, v[i]);
 
-                    auto temp = *first;
-                    *first = *second;
-                    *second = temp;
+                    chunk.failed |= q == nullptr;
+                    chunk.positions.push_back(v);
                 }
-            }
-        }
-        else
-        {
-            // assume square
-            for (size_t i = 0; i < Height; ++i)
-            {
-                for (size_t j = 0; j <= i; ++j)
+                else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+                {
+                    // a third w coordinate is ignored
+                    glm::vec2 v{0.0f};
+                    const char *q = p + 2;
+                    for (int i = 0; i < 2 && q != nullptr; ++i)
+                        q = parse_float(skip_spaces(q, line_end), line_end, v[i]);
+
+                    chunk.failed |= q == nullptr;
+                    chunk.texcoords.push_back(v);
+                }
+                else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+                {
+                    glm::vec3 v{0.0f};
+                    const char *q = p + 2;
+                    for (int i = 0; i < 3 && q != nullptr; ++i)
+                        q = parse_float(skip_spaces(q, line_end), line_end, v[i]);
+
+                    chunk.failed |= q == nullptr;
+                    chunk.normals.push_back(v);
+                }
+                else if (line_end - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
                 {
-                    if (i == j && i > std::ceil(Width / 2))
+                    // v, v/vt, v//vn or v/vt/vn for each corner
+                    face.clear();
+                    const char *q = skip_spaces(p + 1, line_end);
+                    while (q != line_end && *q != '\r' && *q != '#')
                     {
-                        continue;
+                        obj_corner corner;
+                        q = parse_obj_index(q, line_end, chunk.positions.size(), corner.position);
+                        if (q != line_end && *q == '/')
+                        {
+                            q = parse_obj_index(q + 1, line_end, chunk.texcoords.size(), corner.texcoord);
+                            if (q != line_end && *q == '/')
+                                q = parse_obj_index(q + 1, line_end, chunk.normals.size(), corner.normal);
+                        }
+
+                        if (corner.position == obj_missing || (q != line_end && *q != ' ' && *q != '\t' && *q != '\r'))
+                        {
+                            chunk.failed = true;
+                            break;
+                        }
+
+                        face.push_back(corner);
+                        q = skip_spaces(q, line_end);
                     }
 
-                    auto* first = ptr + j + i * Width;
-                    auto* second = ptr + (horizontally ? Width - j - 1: j) + (vertically ? Height - i - 1 : i) * Width;
-
-                    auto temp = *first;
-                    *first = *second;
-                    *second = temp;
+                    // a fan around the first corner
+                    for (size_t i = 2; i < face.size(); ++i)
+                        chunk.corners.insert(chunk.corners.end(), {face[0], face[i - 1], face[i]});
                 }
+
+                // comments, objects, groups, materials, lines and points are skipped
+                p = line_end == end ? end : line_end + 1;
+            }
+        }
+
+        // resolve an index of a chunk to the index in all of the chunks, obj_missing if it is out of range
+        inline uint32_t resolve_obj_index(uint32_t index, size_t offset, size_t total) noexcept
+        {
+            if (index == obj_missing)
+                return obj_missing;
+
+            if ((index & obj_before) != 0)
+            {
+                // an earlier chunk, the offset is where this chunk starts
+                size_t before = index & ~(obj_local | obj_before);
+                return before <= offset ? uint32_t(offset - before) : obj_missing;
             }
 
-            // non square
-            // TODO: add factor based algorithm here
+            size_t resolved = (index & obj_local) != 0 ? (index & ~obj_local) + offset : index;
+            return resolved < total ? uint32_t(resolved) : obj_missing;
         }
-    }
+    } // namespace detail
 
-    template<typename T>
-    requires std::swappable<T>
-    void flip_array2d(size_t width, size_t height, T *ptr, bool horizontally, bool vertically) noexcept
+    [[nodiscard]] mesh parse_obj(std::string_view text, bool optimize) noexcept
     {
-        if (!horizontally && !vertically)
-            return;
+        // a chunk per thread, at least 1 MiB each so small files do not pay for threads
+        constexpr size_t min_chunk_size = 1 << 20;
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        size_t chunk_count = std::clamp<size_t>(text.size() / min_chunk_size, 1, threads);
+
+        // split at line ends
+        std::vector<const char *> bounds{text.data()};
+        for (size_t i = 1; i < chunk_count; ++i)
+        {
+            const char *split = std::max(text.data() + text.size() * i / chunk_count, bounds.back());
+            const char *line_end = static_cast<const char *>(std::memchr(split, '\n', text.data() + text.size() - split));
+            bounds.push_back(line_end == nullptr ? text.data() + text.size() : line_end + 1);
+        }
+        bounds.push_back(text.data() + text.size());
 
+        std::vector<detail::obj_chunk> chunks(chunk_count);
+        {
+            // the first chunk is parsed on this thread
+            std::vector<std::future<void>> parsing;
+            for (size_t i = 1; i < chunk_count; ++i)
+                parsing.push_back(std::async(std::launch::async, [&bounds, &chunks, i](){
+                    detail::parse_obj_chunk(bounds[i], bounds[i + 1], chunks[i]);
+                }));
+
+            detail::parse_obj_chunk(bounds[0], bounds[1], chunks[0]);
+            for (auto &f : parsing)
+                f.wait();
+        }
 
-       if (horizontally ^ vertically)
+        size_t positions = 0, texcoords = 0, normals = 0, corners = 0;
+        for (const auto &chunk : chunks)
         {
-            for (size_t i = 0; i < height * (vertically ? 0.5 : 1.0); ++i)
+            if (chunk.failed)
             {
-                for (size_t j = 0; j < width * (horizontally ? 0.5 : 1.0); ++j)
-                {
-                    auto* first = ptr + j + i * width;
-                    auto* second = ptr + (horizontally ? width - j - 1: j) + (vertically ? height - i - 1 : i) * width;
-
-                    auto temp = *first;
-                    *first = *second;
-                    *second = temp;
-                }
+                std::cout << "[utils] Error: Failed to parse obj, a vertex or face is malformed.\n";
+                return {};
             }
+
+            positions += chunk.positions.size();
+            texcoords += chunk.texcoords.size();
+            normals += chunk.normals.size();
+            corners += chunk.corners.size();
         }
-        else
+
+        // one vertex per corner, welded afterwards
+        std::vector<mesh_vertex> verts;
+        verts.reserve(corners);
+
+        size_t position_offset = 0, texcoord_offset = 0, normal_offset = 0;
+        auto at = [&chunks](auto member, uint32_t index) {
+            for (const auto &chunk : chunks)
+            {
+                if (index < (chunk.*member).size())
+                    return (chunk.*member)[index];
+                index -= (chunk.*member).size();
+            }
+            return typename std::remove_cvref_t<decltype(chunks[0].*member)>::value_type{0.0f};
+        };
+
+        for (const auto &chunk : chunks)
         {
-            // assume square
-            for (size_t i = 0; i < height; ++i)
+            for (size_t c = 0; c < chunk.corners.size(); c += 3)
             {
-                for (size_t j = 0; j < i; ++j)
+                std::array<mesh_vertex, 3> triangle{};
+                bool has_normals = true;
+
+                for (size_t k = 0; k < 3; ++k)
                 {
-                    if (i == j && i > std::ceil(width / 2))
+                    const auto &corner = chunk.corners[c + k];
+                    uint32_t position = detail::resolve_obj_index(corner.position, position_offset, positions);
+                    uint32_t texcoord = detail::resolve_obj_index(corner.texcoord, texcoord_offset, texcoords);
+                    uint32_t normal = detail::resolve_obj_index(corner.normal, normal_offset, normals);
+
+                    if (position == detail::obj_missing || (corner.texcoord != detail::obj_missing && texcoord == detail::obj_missing)
+                        || (corner.normal != detail::obj_missing && normal == detail::obj_missing))
                     {
-                        continue;
+                        std::cout << "[utils] Error: Failed to parse obj, a face uses an index out of range.\n";
+                        return {};
                     }
 
-                    auto* first = ptr + j + i * width;
-                    auto* second = ptr + (horizontally ? width - j - 1: j) + (vertically ? height - i - 1 : i) * width;
+                    // most indices point into their own chunk
+                    triangle[k].position = position - position_offset < chunk.positions.size() ? chunk.positions[position - position_offset] : at(&detail::obj_chunk::positions, position);
+                    if (texcoord != detail::obj_missing)
+                        triangle[k].texcoord = texcoord - texcoord_offset < chunk.texcoords.size() ? chunk.texcoords[texcoord - texcoord_offset] : at(&detail::obj_chunk::texcoords, texcoord);
+                    if (normal != detail::obj_missing)
+                        triangle[k].normal = normal - normal_offset < chunk.normals.size() ? chunk.normals[normal - normal_offset] : at(&detail::obj_chunk::normals, normal);
+                    else
+                        has_normals = false;
+                }
 
-                    auto temp = *first;
-                    *first = *second;
-                    *second = temp;
+                // the normal of the face for faces without normals
+                if (!has_normals)
+                {
+                    glm::vec3 a = triangle[1].position - triangle[0].position, b = triangle[2].position - triangle[0].position;
+                    glm::vec3 n{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+                    float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+                    if (length > 0.0f)
+                        n /= length;
+
+                    for (auto &v : triangle)
+                        v.normal = n;
                 }
+
+                verts.insert(verts.end(), triangle.begin(), triangle.end());
             }
 
-            // non square
-            // TODO: add factor based algorithm here
+            position_offset += chunk.positions.size();
+            texcoord_offset += chunk.texcoords.size();
+            normal_offset += chunk.normals.size();
         }
+
+        mesh m;
+        m.vertices = std::move(verts);
+        if (optimize)
+            (void)optimize_mesh(m.vertices, m.indices);
+        else
+            (void)weld_vertices(m.vertices, m.indices);
+
+        return m;
     }
-    
-    template <typename T>
-    requires std::equality_comparable<T>
-    bool one_of(const T &val, const std::initializer_list<T> &list) noexcept
+
+    [[nodiscard]] mesh load_obj_sync(const char *path, bool optimize) noexcept
     {
-        for (const auto &item : list)
+        auto bytes = read_file_bytes_sync(path);
+        if (bytes.empty())
+            return {};
+
+        return parse_obj(std::string_view{reinterpret_cast<const char *>(bytes.data()), bytes.size()}, optimize);
+    }
+
+    bool write_mesh_file(const char *path, const mesh &m, uint64_t source_stamp) noexcept
+    {
+        auto bytes = mesh_file::serialize(m, source_stamp);
+
+        std::ofstream file;
+        file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+        try
         {
-            if (val == item)
-                return true;
+            file.open(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+            file.close();
+            return true;
+        }
+        catch (const std::ofstream::failure &e)
+        {
+            std::cout << "[utils] Error: Failed to write mesh file " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return false;
         }
-        return false;
     }
 
-    template<auto Start, auto End, auto Inc, typename Fn>
-    constexpr void constexpr_for(Fn&& fn) noexcept
+    mesh_file::mesh_file(const char *path) noexcept
     {
-        if constexpr (Start < End)
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
         {
-            fn(std::integral_constant<decltype(Start), Start>());
-            constexpr_for<Start + Inc, End, Inc>(fn);
+            std::cout << "[utils] Error: Failed to open mesh file " << path << ".\n";
+            return;
+        }
+
+        LARGE_INTEGER size;
+        HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart != 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        // the view keeps the file open
+        void *view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        CloseHandle(file);
+
+        if (view == nullptr)
+        {
+            std::cout << "[utils] Error: Failed to map mesh file " << path << ".\n";
+            return;
+        }
+
+        m_size = size.QuadPart;
+#else
+        int file = open(path, O_RDONLY);
+        if (file < 0)
+        {
+            std::cout << "[utils] Error: Failed to open mesh file " << path << ".\n";
+            return;
+        }
+
+        struct stat info;
+        void *view = fstat(file, &info) == 0 && info.st_size != 0 ? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+        // the mapping keeps the file open
+        close(file);
+
+        if (view == MAP_FAILED)
+        {
+            std::cout << "[utils] Error: Failed to map mesh file " << path << ".\n";
+            return;
         }
+
+        m_size = info.st_size;
+#endif
+
+        m_data = static_cast<const unsigned char *>(view);
+        m_mapped = true;
+
+        (void)validate(path);
     }
 
-    template<typename T, typename U, typename V, typename W>
-    requires (std::is_floating_point_v<T> || std::is_integral_v<T>)
-        && (std::is_floating_point_v<U> || std::is_integral_v<U>)
-        && (std::is_floating_point_v<V> || std::is_integral_v<V>)
-        && (std::is_floating_point_v<W> || std::is_integral_v<W>)
-    consteval glm::vec4 rgba(T&& r, U&& g, V&& b, W&& a) noexcept
+    mesh_file::mesh_file(std::vector<unsigned char> &&bytes) noexcept
+        : m_owned(std::move(bytes))
     {
-        glm::vec4 col{r, g, b, a};
-        if constexpr (std::is_integral_v<T>) {
-            col.r /= 256.0f;
+        m_data = m_owned.data();
+        m_size = m_owned.size();
+
+        (void)validate("in memory");
+    }
+
+    mesh_file::mesh_file(mesh_file &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    mesh_file &mesh_file::operator=(mesh_file &&other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        release();
+
+        // the data of a moved vector stays where it is
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_mapped = std::exchange(other.m_mapped, false);
+        m_owned = std::move(other.m_owned);
+
+        return *this;
+    }
+
+    mesh_file::~mesh_file() noexcept
+    {
+        release();
+    }
+
+    void mesh_file::release() noexcept
+    {
+        if (m_mapped && m_data != nullptr)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(m_data);
+#else
+            munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
         }
-        if constexpr (std::is_integral_v<U>) {
-            col.g /= 256.0f;
+
+        m_data = nullptr;
+        m_size = 0;
+        m_mapped = false;
+        m_owned.clear();
+    }
+
+    bool mesh_file::validate(const char *name) noexcept
+    {
+        const auto *h = reinterpret_cast<const header *>(m_data);
+        bool valid = m_size >= sizeof(header) && h->magic == file_magic && h->version == file_version
+            && h->vertex_stride == sizeof(mesh_vertex)
+            && m_size >= sizeof(header) + (uint64_t)h->vertex_count * sizeof(mesh_vertex) + (uint64_t)h->index_count * sizeof(uint32_t);
+
+        if (!valid)
+        {
+            std::cout << "[utils] Error: Mesh file " << name << " is not a version " << file_version << " mesh file or is truncated.\n";
+            release();
         }
-        if constexpr (std::is_integral_v<V>) {
-            col.b /= 256.0f;
+
+        return valid;
+    }
+
+    [[nodiscard]] uint64_t mesh_file::source_stamp(const char *path) noexcept
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error)
+            return 0;
+
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error)
+            return 0;
+
+        return (uint64_t)size * 0x9E3779B97F4A7C15ull ^ (uint64_t)time.time_since_epoch().count();
+    }
+
+    [[nodiscard]] std::vector<unsigned char> mesh_file::serialize(const mesh &m, uint64_t source_stamp) noexcept
+    {
+        header h{file_magic, file_version, (uint32_t)m.vertices.size(), (uint32_t)m.indices.size(), sizeof(mesh_vertex), 0, source_stamp};
+
+        std::vector<unsigned char> bytes(sizeof(header) + m.vertices.size() * sizeof(mesh_vertex) + m.indices.size() * sizeof(uint32_t));
+        std::memcpy(bytes.data(), &h, sizeof(header));
+        std::memcpy(bytes.data() + sizeof(header), m.vertices.data(), m.vertices.size() * sizeof(mesh_vertex));
+        std::memcpy(bytes.data() + sizeof(header) + m.vertices.size() * sizeof(mesh_vertex), m.indices.data(), m.indices.size() * sizeof(uint32_t));
+
+        return bytes;
+    }
+
+    [[nodiscard]] mesh_file load_mesh_cached(const char *obj_path, const char *cache_path) noexcept
+    {
+        std::string cache = cache_path != nullptr ? cache_path : std::string(obj_path) + ".wgm";
+        uint64_t stamp = mesh_file::source_stamp(obj_path);
+
+        // the cache is used while the obj is unchanged
+        if (std::error_code error; std::filesystem::exists(cache, error))
+        {
+            mesh_file file(cache.c_str());
+            if (file.valid() && file.get_header().source_stamp == stamp)
+                return file;
         }
-        if constexpr (std::is_integral_v<W>) {
-            col.a /= 256.0f;
+
+        mesh m = load_obj_sync(obj_path, true);
+        if (m.empty())
+            return {};
+
+        if (write_mesh_file(cache.c_str(), m, stamp))
+        {
+            mesh_file file(cache.c_str());
+            if (file.valid())
+                return file;
         }
-        return col;
+
+        return mesh_file(mesh_file::serialize(m, stamp));
     }
 
-    consteval glm::vec4 hex(std::string_view&& code) noexcept
+    ////
+    // parametric meshes
+
+    namespace detail
     {
-        // const hex size
-        // #RRGGBB --> 7
-        // #RRGGBBAA --> 9
-        // #RGBA or #RGB -- > 5 or 4
+        // math which also works in constant evaluation, where it is accurate to a few ulps of a float
 
-        if (code.size() > 9)
+        constexpr double pi = std::numbers::pi_v<double>;
+
+        constexpr float sqrt(float x) noexcept
         {
-            // * Compile time detects and prevents compile if this line is reached.
-            // ? For use if funciton is converted to constexpr
-            std::cout << "[utils] Error: Failed to create color glm::vec4 due to invalid hex code: " << code << "\n";
-            return glm::vec4{0};
+            if !consteval
+            {
+                return std::sqrt(x);
+            }
+
+            if (x <= 0.0f)
+                return 0.0f;
+
+            double y = x > 1.0f ? x : 1.0;
+            for (int i = 0; i < 64; ++i)
+            {
+                double next = 0.5 * (y + x / y);
+                if (next == y)
+                    break;
+                y = next;
+            }
+            return (float)y;
         }
 
-        auto heximal = [](char c)->double{
-            if ('0' <= c && c <= '9')
+        constexpr float sin(double x) noexcept
+        {
+            if !consteval
             {
-                return c - '0';
+                return (float)std::sin(x);
             }
-            if ('a' <= c && c <= 'f')
+
+            // reduce to [-pi, pi] then sum the taylor series until the terms vanish
+            x -= 2.0 * pi * (double)(long long)(x / (2.0 * pi));
+            if (x > pi)
+                x -= 2.0 * pi;
+            else if (x < -pi)
+                x += 2.0 * pi;
+
+            double term = x, sum = x;
+            for (int n = 1; n < 16; ++n)
+            {
+                term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+                sum += term;
+            }
+            return (float)sum;
+        }
+
+        constexpr float cos(double x) noexcept
+        {
+            if !consteval
+            {
+                return (float)std::cos(x);
+            }
+
+            return sin(x + 0.5 * pi);
+        }
+
+        constexpr float atan2(float y, float x) noexcept
+        {
+            if !consteval
+            {
+                return std::atan2(y, x);
+            }
+
+            if (x == 0.0f && y == 0.0f)
+                return 0.0f;
+
+            // atan of |y / x| in [0, 1] halved twice so the series converges quickly
+            double ay = y < 0.0f ? -y : y, ax = x < 0.0f ? -x : x;
+            bool swap = ay > ax;
+            double t = swap ? ax / ay : ay / ax;
+            for (int i = 0; i < 2; ++i)
+                t = t / (1.0 + (double)sqrt((float)(1.0 + t * t)));
+
+            double term = t, sum = t;
+            for (int n = 1; n < 16; ++n)
+            {
+                term *= -t * t;
+                sum += term / (2.0 * n + 1.0);
+            }
+            sum *= 4.0;
+
+            if (swap)
+                sum = 0.5 * pi - sum;
+            if (x < 0.0f)
+                sum = pi - sum;
+            return (float)(y < 0.0f ? -sum : sum);
+        }
+
+        // the rows of a mesh are independent so they are split over the pool, a chunk is at least
+        // min_vertices vertices so small meshes stay on the calling thread
+        template <typename Fn>
+        constexpr void for_rows(size_t rows, size_t row_vertices, job_pool *pool, Fn &&fn) noexcept
+        {
+            if !consteval
+            {
+                constexpr size_t min_vertices = 16384;
+                if (pool != nullptr)
+                {
+                    pool->parallel_for(rows, std::max<size_t>(min_vertices / std::max<size_t>(row_vertices, 1), 1), fn);
+                    return;
+                }
+            }
+
+            if (rows != 0)
+                fn(size_t{0}, rows);
+        }
+
+        // cos and sin of count + 1 steps around a circle, the last is the first again so seams match exactly
+        constexpr void circle_table(size_t count, std::vector<float> &cos_table, std::vector<float> &sin_table) noexcept
+        {
+            cos_table.resize(count + 1);
+            sin_table.resize(count + 1);
+            for (size_t i = 0; i < count; ++i)
+            {
+                double angle = 2.0 * pi * (double)i / (double)count;
+                cos_table[i] = cos(angle);
+                sin_table[i] = sin(angle);
+            }
+            cos_table[count] = cos_table[0];
+            sin_table[count] = sin_table[0];
+        }
+
+        // two triangles for each cell of a row of quads between the vertex rows first and first + stride
+        constexpr void quad_row(uint32_t *out, uint32_t first, uint32_t stride, size_t cells) noexcept
+        {
+            for (uint32_t i = 0; i < (uint32_t)cells; ++i, out += 6)
             {
-                return c - 'a' + 10;
+                uint32_t a = first + i, b = a + 1, c = a + stride, d = c + 1;
+                out[0] = a; out[1] = c; out[2] = b;
+                out[3] = b; out[4] = c; out[5] = d;
             }
-            if ('A' <= c && c <= 'F')
+        }
+    }
+
+    constexpr bool gen_grid(size_t columns, size_t rows, const glm::vec2 &size, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool) noexcept
+    {
+        if (columns == 0 || rows == 0 || verts.size() < grid_vertex_count(columns, rows) || indices.size() < grid_index_count(columns, rows))
+            return false;
+
+        size_t stride = columns + 1;
+        float step_u = 1.0f / (float)columns, step_v = 1.0f / (float)rows;
+
+        detail::for_rows(rows + 1, stride, pool, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
             {
-                return c - 'A' + 10;
+                float v = (float)r * step_v;
+                float z = (v - 0.5f) * size.y;
+                mesh_vertex *row = verts.data() + r * stride;
+
+                for (size_t c = 0; c < stride; ++c)
+                {
+                    float u = (float)c * step_u;
+                    row[c] = mesh_vertex{glm::vec3{(u - 0.5f) * size.x, 0.0f, z}, glm::vec3{0.0f, 1.0f, 0.0f}, glm::vec2{u, v}};
+                }
+
+                if (r < rows)
+                    detail::quad_row(indices.data() + r * columns * 6, (uint32_t)(r * stride), (uint32_t)stride, columns);
             }
-            return 0;
-        };
-        
-        return code.size() > 5 ?
-                    glm::vec4{
-                        (heximal(code[2]) + heximal(code[1]) * 16.0) / 255.0,
-                        (heximal(code[4]) + heximal(code[3]) * 16.0) / 255.0,
-                        (heximal(code[6]) + heximal(code[5]) * 16.0) / 255.0,
-                        code.size() > 7 ? (heximal(code[8]) + heximal(code[7]) * 16.0) / 255.0 : 1.0,
-                    }
-                    :
-                    glm::vec4{
-                        ((heximal(code[1]) + heximal(code[1])) * 16.0) / 255.0,
-                        ((heximal(code[2]) + heximal(code[2])) * 16.0) / 255.0,
-                        ((heximal(code[3]) + heximal(code[3])) * 16.0) / 255.0,
-                        code.size() > 4 ? (heximal(code[4]) + heximal(code[4]) * 16.0) / 255.0 : 1.0,
-                    };
+        });
+
+        return true;
     }
 
-    template <size_t rows, size_t cols, typename T>
-    requires Printable<T>
-    void print_mat(const T *ptr) noexcept
+    constexpr bool gen_uv_sphere(float radius, size_t segments, size_t rings, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool) noexcept
     {
-        for (size_t i = 0; i < rows; ++i)
-        {
-            std::cout << "[";
-            for (size_t j = 0; j < cols; ++j)
+        if (segments < 3 || rings < 2 || verts.size() < uv_sphere_vertex_count(segments, rings) || indices.size() < uv_sphere_index_count(segments, rings))
+            return false;
+
+        std::vector<float> cos_theta, sin_theta;
+        detail::circle_table(segments, cos_theta, sin_theta);
+
+        size_t stride = segments + 1;
+
+        detail::for_rows(rings + 1, stride, pool, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
             {
-                std::cout << *(ptr + i * cols + j);
-                // std::cout << ptr[i][j];
-                if (j != cols - 1)
-                    std::cout << ", ";
+                // from the top pole down, the poles are exact so their normals are too
+                double phi = detail::pi * (double)r / (double)rings;
+                float y = r == 0 ? 1.0f : r == rings ? -1.0f : detail::cos(phi);
+                float ring = r == 0 || r == rings ? 0.0f : detail::sin(phi);
+                float v = 1.0f - (float)r / (float)rings;
+                mesh_vertex *row = verts.data() + r * stride;
+
+                for (size_t s = 0; s < stride; ++s)
+                {
+                    glm::vec3 n{ring * sin_theta[s], y, ring * cos_theta[s]};
+                    row[s] = mesh_vertex{n * radius, n, glm::vec2{(float)s / (float)segments, v}};
+                }
+
+                if (r == rings)
+                    continue;
+
+                // the bands at the poles have one triangle per segment
+                uint32_t first = (uint32_t)(r * stride), next = first + (uint32_t)stride;
+                uint32_t *out = indices.data() + (r == 0 ? 0 : segments * 3 + (r - 1) * segments * 6);
+                for (uint32_t s = 0; s < (uint32_t)segments; ++s)
+                {
+                    uint32_t a = first + s, b = a + 1, c = next + s, d = c + 1;
+                    if (r == 0)
+                    {
+                        *out++ = a; *out++ = c; *out++ = d;
+                    }
+                    else if (r == rings - 1)
+                    {
+                        *out++ = a; *out++ = c; *out++ = b;
+                    }
+                    else
+                    {
+                        *out++ = a; *out++ = c; *out++ = b;
+                        *out++ = b; *out++ = c; *out++ = d;
+                    }
+                }
             }
-            std::cout << "]\n";
-        }
+        });
+
+        return true;
     }
 
-    template <size_t rows, size_t cols, typename T, typename Fn>
-    requires PrintableFn<T, Fn>
-    void print_mat(const T *ptr, Fn&& fn) noexcept
+    constexpr bool gen_icosphere(float radius, size_t frequency, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool) noexcept
     {
-        for (size_t i = 0; i < rows; ++i)
-        {
-            std::cout << "[";
-            for (size_t j = 0; j < cols; ++j)
+        if (frequency == 0 || verts.size() < icosphere_vertex_count(frequency) || indices.size() < icosphere_index_count(frequency))
+            return false;
+
+        // the icosahedron with edges of length 2, its corners are (0, +-1, +-g) and the rotations of it
+        constexpr float g = 1.6180339887498949f;
+        constexpr std::array<glm::vec3, 12> corners{
+            glm::vec3{-1.0f, g, 0.0f}, glm::vec3{1.0f, g, 0.0f}, glm::vec3{-1.0f, -g, 0.0f}, glm::vec3{1.0f, -g, 0.0f},
+            glm::vec3{0.0f, -1.0f, g}, glm::vec3{0.0f, 1.0f, g}, glm::vec3{0.0f, -1.0f, -g}, glm::vec3{0.0f, 1.0f, -g},
+            glm::vec3{g, 0.0f, -1.0f}, glm::vec3{g, 0.0f, 1.0f}, glm::vec3{-g, 0.0f, -1.0f}, glm::vec3{-g, 0.0f, 1.0f},
+        };
+        constexpr std::array<std::array<uint32_t, 3>, 20> faces{{
+            {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+            {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+            {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+            {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1},
+        }};
+
+        size_t face_vertices = (frequency + 1) * (frequency + 2) / 2;
+        size_t face_indices = frequency * frequency * 3;
+        float step = 1.0f / (float)frequency;
+
+        auto texcoord = [](const glm::vec3 &n, float center_u) {
+            float u = 0.5f + detail::atan2(n.x, n.z) / (float)(2.0 * detail::pi);
+            // keep the face on one side of the seam, the poles take the u of the face
+            if (n.x * n.x + n.z * n.z < 1e-12f)
+                u = center_u;
+            else if (u - center_u > 0.5f)
+                u -= 1.0f;
+            else if (u - center_u < -0.5f)
+                u += 1.0f;
+            return glm::vec2{u, 0.5f + detail::atan2(n.y, detail::sqrt(n.x * n.x + n.z * n.z)) / (float)detail::pi};
+        };
+
+        detail::for_rows(faces.size(), face_vertices, pool, [&](size_t begin, size_t end) {
+            for (size_t f = begin; f < end; ++f)
             {
-                std::cout << fn(*(ptr + i * cols + j));
-                // std::cout << ptr[i][j];
-                if (j != cols - 1)
-                    std::cout << ", ";
+                const glm::vec3 &a = corners[faces[f][0]], &b = corners[faces[f][1]], &c = corners[faces[f][2]];
+                glm::vec3 center = a + b + c;
+                float center_u = 0.5f + detail::atan2(center.x, center.z) / (float)(2.0 * detail::pi);
+
+                // row i runs from a + i * (c - a) / frequency towards b
+                mesh_vertex *out = verts.data() + f * face_vertices;
+                for (size_t i = 0; i <= frequency; ++i)
+                    for (size_t j = 0; j + i <= frequency; ++j)
+                    {
+                        glm::vec3 p = a + (b - a) * ((float)j * step) + (c - a) * ((float)i * step);
+                        glm::vec3 n = p * (1.0f / detail::sqrt(p.x * p.x + p.y * p.y + p.z * p.z));
+                        *out++ = mesh_vertex{n * radius, n, texcoord(n, center_u)};
+                    }
+
+                uint32_t first = (uint32_t)(f * face_vertices);
+                uint32_t *idx = indices.data() + f * face_indices;
+                for (size_t i = 0; i < frequency; ++i)
+                {
+                    uint32_t row = first + (uint32_t)(i * (frequency + 1) - i * (i - 1) / 2);
+                    uint32_t next = row + (uint32_t)(frequency + 1 - i);
+                    for (uint32_t j = 0; j < (uint32_t)(frequency - i); ++j)
+                    {
+                        *idx++ = row + j; *idx++ = row + j + 1; *idx++ = next + j;
+                        if (j + 1 < (uint32_t)(frequency - i))
+                        {
+                            *idx++ = row + j + 1; *idx++ = next + j + 1; *idx++ = next + j;
+                        }
+                    }
+                }
             }
-            std::cout << "]\n";
-        }
+        });
+
+        return true;
     }
 
-    template <size_t vec_size, size_t n, typename T>
-    requires Printable<T>
-    void print_vecs(const T *ptr) noexcept
+    constexpr bool gen_cylinder(float radius, float height, size_t segments, size_t rings, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool) noexcept
     {
-        if (n != 1)
-            std::cout << "[ ";
+        if (segments < 3 || rings == 0 || verts.size() < cylinder_vertex_count(segments, rings) || indices.size() < cylinder_index_count(segments, rings))
+            return false;
 
-        for (size_t i = 0; i < n; ++i)
-        {
-            std::cout << "[";
-            for (size_t j = 0; j < vec_size; ++j)
+        std::vector<float> cos_theta, sin_theta;
+        detail::circle_table(segments, cos_theta, sin_theta);
+
+        size_t stride = segments + 1;
+
+        // the side from the bottom up
+        detail::for_rows(rings + 1, stride, pool, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
             {
-                std::cout << *(ptr + j + i * vec_size);
-                if (j != vec_size - 1)
-                    std::cout << ", ";
+                float v = (float)r / (float)rings;
+                float y = (v - 0.5f) * height;
+                mesh_vertex *row = verts.data() + r * stride;
+
+                for (size_t s = 0; s < stride; ++s)
+                {
+                    glm::vec3 n{sin_theta[s], 0.0f, cos_theta[s]};
+                    row[s] = mesh_vertex{glm::vec3{n.x * radius, y, n.z * radius}, n, glm::vec2{(float)s / (float)segments, v}};
+                }
+
+                if (r < rings)
+                {
+                    // the rows go up so the quads are wound the other way around to a grid
+                    uint32_t *out = indices.data() + r * segments * 6;
+                    for (uint32_t s = 0; s < (uint32_t)segments; ++s, out += 6)
+                    {
+                        uint32_t a = (uint32_t)(r * stride) + s, b = a + 1, c = a + (uint32_t)stride, d = c + 1;
+                        out[0] = a; out[1] = b; out[2] = c;
+                        out[3] = b; out[4] = d; out[5] = c;
+                    }
+                }
             }
-            std::cout << "]";
+        });
 
-            if (i != n - 1)
-                std::cout << ", ";
+        // the caps are a center and a rim of their own so their normals are flat
+        size_t cap_vertices = segments + 2;
+        for (size_t cap = 0; cap < 2; ++cap)
+        {
+            float up = cap == 0 ? 1.0f : -1.0f;
+            glm::vec3 n{0.0f, up, 0.0f};
+            size_t first = stride * (rings + 1) + cap * cap_vertices;
+            mesh_vertex *out = verts.data() + first;
+
+            out[0] = mesh_vertex{glm::vec3{0.0f, up * 0.5f * height, 0.0f}, n, glm::vec2{0.5f}};
+            for (size_t s = 0; s < stride; ++s)
+                out[s + 1] = mesh_vertex{glm::vec3{sin_theta[s] * radius, up * 0.5f * height, cos_theta[s] * radius}, n, glm::vec2{0.5f + 0.5f * sin_theta[s], 0.5f + 0.5f * up * cos_theta[s]}};
+
+            uint32_t center = (uint32_t)first;
+            uint32_t *idx = indices.data() + segments * rings * 6 + cap * segments * 3;
+            for (uint32_t s = 0; s < (uint32_t)segments; ++s)
+            {
+                uint32_t a = center + 1 + s, b = a + 1;
+                *idx++ = center;
+                *idx++ = cap == 0 ? a : b;
+                *idx++ = cap == 0 ? b : a;
+            }
         }
 
-        if (n != 1)
-            std::cout << " ]";
-        
-        
-        std::cout << "\n";    
+        return true;
     }
 
-    template <size_t vec_size, size_t n, typename T, typename Fn>
-    requires PrintableFn<T, Fn>
-    void print_vecs(const T *ptr, Fn&& fn) noexcept
+    constexpr bool gen_torus(float radius, float tube_radius, size_t segments, size_t sides, std::span<mesh_vertex> verts, std::span<uint32_t> indices, job_pool *pool) noexcept
     {
-        if (n != 1)
-            std::cout << "[ ";
+        if (segments < 3 || sides < 3 || verts.size() < torus_vertex_count(segments, sides) || indices.size() < torus_index_count(segments, sides))
+            return false;
 
-        for (size_t i = 0; i < n; ++i)
-        {
-            std::cout << "[";
-            for (size_t j = 0; j < vec_size; ++j)
+        std::vector<float> cos_theta, sin_theta, cos_phi, sin_phi;
+        detail::circle_table(segments, cos_theta, sin_theta);
+        detail::circle_table(sides, cos_phi, sin_phi);
+
+        size_t stride = sides + 1;
+
+        // one row per segment around y, each going around the tube from the outside
+        detail::for_rows(segments + 1, stride, pool, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r)
             {
-                std::cout << fn(*(ptr + j + i * vec_size));
-                if (j != vec_size - 1)
-                    std::cout << ", ";
-            }
-            std::cout << "]";
+                float u = (float)r / (float)segments;
+                mesh_vertex *row = verts.data() + r * stride;
 
-            if (i != n - 1)
-                std::cout << ", ";
-        }
+                for (size_t s = 0; s < stride; ++s)
+                {
+                    glm::vec3 n{cos_phi[s] * sin_theta[r], sin_phi[s], cos_phi[s] * cos_theta[r]};
+                    glm::vec3 center{radius * sin_theta[r], 0.0f, radius * cos_theta[r]};
+                    row[s] = mesh_vertex{center + n * tube_radius, n, glm::vec2{u, (float)s / (float)sides}};
+                }
 
-        if (n != 1)
-            std::cout << " ]";
-        
-        
-        std::cout << "\n";    
+                if (r < segments)
+                    detail::quad_row(indices.data() + r * sides * 6, (uint32_t)(r * stride), (uint32_t)stride, sides);
+            }
+        });
+
+        return true;
     }
 
-    template<typename Tuple, size_t ... Is>
-    void print_tuple_impl(const Tuple& tup, std::index_sequence<Is...>)
+    template <size_t Columns, size_t Rows>
+    [[nodiscard]] constexpr fixed_mesh<grid_vertex_count(Columns, Rows), grid_index_count(Columns, Rows)> gen_grid(const glm::vec2 &size) noexcept
     {
-        ((std::cout << (Is == 0 ? "" : ", ") << std::get<Is>(tup)), ... );
+        fixed_mesh<grid_vertex_count(Columns, Rows), grid_index_count(Columns, Rows)> m{};
+        (void)gen_grid(Columns, Rows, size, m.vertices, m.indices);
+        return m;
     }
 
-    template<typename ... Ts>
-    requires (Printable<Ts> && ...)
-    void print_tuple(const std::tuple<Ts...>& tup) noexcept
+    template <size_t Segments, size_t Rings>
+    requires(Segments >= 3 && Rings >= 2)
+    [[nodiscard]] constexpr fixed_mesh<uv_sphere_vertex_count(Segments, Rings), uv_sphere_index_count(Segments, Rings)> gen_uv_sphere(float radius) noexcept
     {
-        std::cout << "(";
-        print_tuple_impl(tup, std::make_index_sequence<sizeof...(Ts)>{});
-        std::cout << ")\n";
+        fixed_mesh<uv_sphere_vertex_count(Segments, Rings), uv_sphere_index_count(Segments, Rings)> m{};
+        (void)gen_uv_sphere(radius, Segments, Rings, m.vertices, m.indices);
+        return m;
     }
 
-    template <typename T>
-    requires Printable<T>
-    void print(const T *ptr) noexcept
+    template <size_t Frequency>
+    requires(Frequency >= 1)
+    [[nodiscard]] constexpr fixed_mesh<icosphere_vertex_count(Frequency), icosphere_index_count(Frequency)> gen_icosphere(float radius) noexcept
     {
-        std::cout << ptr << "\n";
+        fixed_mesh<icosphere_vertex_count(Frequency), icosphere_index_count(Frequency)> m{};
+        (void)gen_icosphere(radius, Frequency, m.vertices, m.indices);
+        return m;
     }
 
-    template <typename T, typename Fn>
-    requires PrintableFn<T, Fn>
-    void print(const T* ptr, Fn fn) noexcept
+    template <size_t Segments, size_t Rings>
+    requires(Segments >= 3 && Rings >= 1)
+    [[nodiscard]] constexpr fixed_mesh<cylinder_vertex_count(Segments, Rings), cylinder_index_count(Segments, Rings)> gen_cylinder(float radius, float height) noexcept
     {
-        std::cout << fn(ptr) << "\n";
+        fixed_mesh<cylinder_vertex_count(Segments, Rings), cylinder_index_count(Segments, Rings)> m{};
+        (void)gen_cylinder(radius, height, Segments, Rings, m.vertices, m.indices);
+        return m;
     }
 
-    template<typename ... Ts>
-    requires (Printable<Ts> && ...)
-    void print_all(const Ts&... args)
+    template <size_t Segments, size_t Sides>
+    requires(Segments >= 3 && Sides >= 3)
+    [[nodiscard]] constexpr fixed_mesh<torus_vertex_count(Segments, Sides), torus_index_count(Segments, Sides)> gen_torus(float radius, float tube_radius) noexcept
     {
-        (std::cout << ... << args) << '\n';
+        fixed_mesh<torus_vertex_count(Segments, Sides), torus_index_count(Segments, Sides)> m{};
+        (void)gen_torus(radius, tube_radius, Segments, Sides, m.vertices, m.indices);
+        return m;
     }
 
-    template<size_t Dimensions>
-    requires (Dimensions > 1 && Dimensions < 4)
-    constexpr std::array<glm::vec<Dimensions, float>, 3> gen_tri_verts(const glm::vec<Dimensions, float> &start, const glm::vec<Dimensions, float> &end) noexcept
+    ////
+    // terrain
+
+    heightmap::heightmap(int width, int depth, std::vector<float> heights) noexcept
+        : m_heights(std::move(heights)), m_width(width), m_depth(depth)
     {
-        if constexpr (Dimensions == 2) {
-            return {
-                glm::vec2{start.x, start.y},
-                glm::vec2{start.x + (end.x - start.x) / 2.0, end.y},
-                glm::vec2{end.x, start.y},
-            };
+        if (width <= 0 || depth <= 0 || m_heights.size() < (size_t)width * depth)
+        {
+            std::cout << "[utils] Error: Heightmap of " << width << " x " << depth << " samples given " << m_heights.size() << " heights.\n";
+            m_heights.clear();
+            m_width = m_depth = 0;
         }
-        if constexpr (Dimensions == 3) {
-            return {
-                glm::vec3{start.x, start.y, start.z},
-                glm::vec3{start.x + (end.x - start.x) / 2.0, end.y, start.z + (end.z - start.z) / 2.0},
-                glm::vec3{end.x, start.y, end.z},
-            };
+    }
+
+    [[nodiscard]] bool heightmap::load(stb_image &image, float scale) noexcept
+    {
+        if (image.data() == nullptr || image.width() <= 0 || image.height() <= 0)
+        {
+            std::cout << "[utils] Error: Heightmap image is not loaded.\n";
+            return false;
         }
+
+        m_width = image.width();
+        m_depth = image.height();
+        m_heights.resize((size_t)m_width * m_depth);
+
+        const unsigned char *pixels = image.data();
+        size_t channels = image.nr_channels();
+        float to_height = scale / 255.0f;
+        for (size_t i = 0; i < m_heights.size(); ++i)
+            m_heights[i] = pixels[i * channels] * to_height;
+
+        return true;
     }
 
-    template<size_t Dimensions>
-    requires (Dimensions > 1 && Dimensions < 4)
-    constexpr std::array<glm::vec<Dimensions, float>, 4> gen_rect_verts(const glm::vec<Dimensions, float> &start, const glm::vec<Dimensions, float> &end) noexcept
+    [[nodiscard]] float heightmap::sample(float x, float z) const noexcept
     {
-        if constexpr (Dimensions == 2) {
-            return {
-                glm::vec2{start.x, start.y},
-                glm::vec2{start.x, end.y},
-                glm::vec2{end.x, end.y},
-                glm::vec2{end.x, start.y},
-            };
+        float fx = std::floor(x), fz = std::floor(z);
+        int ix = (int)fx, iz = (int)fz;
+        float tx = x - fx, tz = z - fz;
+
+        float near = glm::mix(at(ix, iz), at(ix + 1, iz), tx);
+        float far = glm::mix(at(ix, iz + 1), at(ix + 1, iz + 1), tx);
+        return glm::mix(near, far, tz);
+    }
+
+    [[nodiscard]] glm::vec3 heightmap::normal(int x, int z, float spacing) const noexcept
+    {
+        return glm::normalize(glm::vec3{at(x - 1, z) - at(x + 1, z), 2.0f * spacing, at(x, z - 1) - at(x, z + 1)});
+    }
+
+    [[nodiscard]] glm::vec2 heightmap::range(int x, int z, int width, int depth) const noexcept
+    {
+        glm::vec2 r{std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+        for (int j = std::max(z, 0); j < std::min(z + depth, m_depth); ++j)
+        {
+            const float *row = m_heights.data() + (size_t)j * m_width;
+            for (int i = std::max(x, 0); i < std::min(x + width, m_width); ++i)
+            {
+                r.x = std::min(r.x, row[i]);
+                r.y = std::max(r.y, row[i]);
+            }
         }
-        if constexpr (Dimensions == 3) {
-            return {
-                glm::vec3{start.x, start.y, start.z},
-                glm::vec3{start.x, end.y, start.z},
-                glm::vec3{end.x, end.y, end.z},
-                glm::vec3{end.x, start.y, end.z},
-            };
+        return r;
+    }
+
+    bool gen_terrain_chunk(const heightmap &map, size_t x, size_t z, size_t cells, size_t lod, float spacing, std::span<mesh_vertex> verts) noexcept
+    {
+        size_t n = cells >> lod;
+        if (n == 0 || verts.size() < terrain_chunk_vertex_count(cells, lod) || x + cells >= (size_t)map.width() || z + cells >= (size_t)map.depth())
+            return false;
+
+        size_t step = (size_t)1 << lod;
+        glm::vec2 to_texcoord = 1.0f / glm::vec2{(float)(map.width() - 1), (float)(map.depth() - 1)};
+
+        mesh_vertex *out = verts.data();
+        for (size_t j = 0; j <= n; ++j)
+        {
+            int sz = (int)(z + j * step);
+            const float *row = map.data() + (size_t)sz * map.width();
+
+            for (size_t i = 0; i <= n; ++i)
+            {
+                int sx = (int)(x + i * step);
+                *out++ = mesh_vertex{
+                    glm::vec3{sx * spacing, row[sx], sz * spacing},
+                    map.normal(sx, sz, spacing),
+                    glm::vec2{(float)sx, (float)sz} * to_texcoord
+                };
+            }
         }
+
+        return true;
     }
 
-    constexpr std::array<glm::uvec3, 2> gen_rect_indices() noexcept
-    {
-        using V = utils::GEN_RECT_FACE_VERTS;
+    size_t gen_terrain_indices(size_t cells, size_t lod, uint32_t coarser_edges, std::span<uint32_t> indices) noexcept
+    {
+        size_t n = cells >> lod;
+        if (n == 0 || indices.size() < terrain_chunk_index_count(cells, lod))
+            return 0;
+
+        // an edge can only be stitched if its vertices pair up
+        if (n < 2)
+            coarser_edges = 0;
+
+        uint32_t stride = (uint32_t)n + 1;
+
+        // the odd vertices of a coarser edge are moved onto the even vertex before them, the triangles between
+        // the two are left with no area and dropped and the rest follow the coarser edge
+        auto snap = [&](uint32_t i, uint32_t j) {
+            if ((i & 1) && ((j == 0 && (coarser_edges & TERRAIN_NEG_Z)) || (j == n && (coarser_edges & TERRAIN_POS_Z))))
+                --i;
+            if ((j & 1) && ((i == 0 && (coarser_edges & TERRAIN_NEG_X)) || (i == n && (coarser_edges & TERRAIN_POS_X))))
+                --j;
+            return j * stride + i;
+        };
+
+        size_t count = 0;
+        auto triangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+            if (a == b || b == c || a == c)
+                return;
+            indices[count++] = a;
+            indices[count++] = b;
+            indices[count++] = c;
+        };
 
-        return std::array{
-            glm::uvec3{
-                V::BOTTOM_LEFT,
-                V::TOP_LEFT,
-                V::TOP_RIGHT
-            },
-            glm::uvec3{
-                V::BOTTOM_LEFT,
-                V::TOP_RIGHT,
-                V::BOTTOM_RIGHT
+        // with both far edges coarser the snapped b and c of the last cell are in line with a, so that cell is
+        // split along its other diagonal
+        bool flip_last = (coarser_edges & TERRAIN_POS_X) && (coarser_edges & TERRAIN_POS_Z);
+
+        // wound the same as gen_grid so the chunks face up
+        for (uint32_t j = 0; j < (uint32_t)n; ++j)
+            for (uint32_t i = 0; i < (uint32_t)n; ++i)
+            {
+                uint32_t a = snap(i, j), b = snap(i + 1, j), c = snap(i, j + 1), d = snap(i + 1, j + 1);
+                if (flip_last && i == n - 1 && j == n - 1)
+                {
+                    triangle(a, c, d);
+                    triangle(a, d, b);
+                }
+                else
+                {
+                    triangle(a, c, b);
+                    triangle(b, c, d);
+                }
             }
-        };
+
+        return count;
     }
+} // namespace utils
 
-    constexpr std::array<glm::vec3, 36> gen_cube_verts(const glm::vec3& start, const glm::vec3& end) noexcept
-    {
-        return std::array{
-            // BACK FACE
-            glm::vec3{start.x, start.y, start.z},
-            glm::vec3{start.x, end.y, start.z},
-            glm::vec3{end.x, end.y, start.z},
+#if UTILS_TRACK_ALLOCATIONS
+////
+// global allocation replacements for utils::alloc_tracker
 
-            glm::vec3{start.x, start.y, start.z},
-            glm::vec3{end.x, end.y, start.z},
-            glm::vec3{end.x, start.y, start.z},
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
-            // BOTTOM FACE
-            glm::vec3{start.x, start.y, start.z},
-            glm::vec3{start.x, start.y, end.z},
-            glm::vec3{end.x, start.y, end.z},
-            
-            glm::vec3{start.x, start.y, start.z},
-            glm::vec3{end.x, start.y, end.z},
-            glm::vec3{end.x, start.y, start.z},
+// gcc sees the free of memory from operator new when these are inlined into each other
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
 
-            // LEFT FACE
-            glm::vec3{start.x, start.y, start.z},
-            glm::vec3{start.x, end.y, start.z},
-            glm::vec3{start.x, end.y, end.z},
-            
-            glm::vec3{start.x, start.y, start.z},
-            glm::vec3{start.x, end.y, end.z},
-            glm::vec3{start.x, start.y, end.z},
+void *operator new(std::size_t size)
+{
+    utils::alloc_tracker::on_alloc(size);
 
-            // reflect on primary axis
+    if (void *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
 
-            // FRONT FACE
-            glm::vec3{start.x, start.y, end.z},
-            glm::vec3{start.x, end.y, end.z},
-            glm::vec3{end.x, end.y, end.z},
+    throw std::bad_alloc{};
+}
 
-            glm::vec3{start.x, start.y, end.z},
-            glm::vec3{end.x, end.y, end.z},
-            glm::vec3{end.x, start.y, end.z},
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
 
-            // TOP FACE
-            glm::vec3{start.x, end.y, start.z},
-            glm::vec3{start.x, end.y, end.z},
-            glm::vec3{end.x, end.y, end.z},
-            
-            glm::vec3{start.x, end.y, start.z},
-            glm::vec3{end.x, end.y, end.z},
-            glm::vec3{end.x, end.y, start.z},
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    utils::alloc_tracker::on_alloc(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
 
-            // RIGHT FACE
-            glm::vec3{end.x, start.y, start.z},
-            glm::vec3{end.x, end.y, start.z},
-            glm::vec3{end.x, end.y, end.z},
-            
-            glm::vec3{end.x, start.y, start.z},
-            glm::vec3{end.x, end.y, end.z},
-            glm::vec3{end.x, start.y, end.z},
-        };
-    }
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return ::operator new(size, tag);
+}
 
-    constexpr std::array<glm::vec2, 36> gen_cube_texcoords() noexcept
-    {
-        constexpr auto LEFT_START = -1.0f;
-        constexpr auto LEFT_END = 0.0f;
-        constexpr auto MIDDLE_START = LEFT_START;
-        constexpr auto MIDDLE_END = 1.0f;
-        constexpr auto RIGHT_START = MIDDLE_END;
-        constexpr auto RIGHT_END = 2.0f;
+void operator delete(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+        return;
 
-        constexpr auto TOP_START = -1.0f;
-        constexpr auto TOP_END = 0.0f;
-        constexpr auto TOP_SECOND_START = TOP_END;
-        constexpr auto TOP_SECOND_END = 1.0f;
-        constexpr auto BOTTOM_SECOND_START = TOP_SECOND_END;
-        constexpr auto BOTTOM_SECOND_END = 2.0f;
-        constexpr auto BOTTOM_START = BOTTOM_SECOND_END;
-        constexpr auto BOTTOM_END = 3.0f;
+    utils::alloc_tracker::on_free(0);
+    std::free(ptr);
+}
 
-        return std::array{
-            // BACK FACE
-            glm::vec2{MIDDLE_START, BOTTOM_END},
-            glm::vec2{MIDDLE_START, BOTTOM_START},
-            glm::vec2{MIDDLE_END, BOTTOM_START},
-            
-            glm::vec2{MIDDLE_START, BOTTOM_END},
-            glm::vec2{MIDDLE_END, BOTTOM_START},
-            glm::vec2{MIDDLE_END, BOTTOM_END},
-            
-            // BOTTOM FACE
-            glm::vec2{MIDDLE_START, BOTTOM_SECOND_END},
-            glm::vec2{MIDDLE_START, BOTTOM_SECOND_START},
-            glm::vec2{MIDDLE_END, BOTTOM_SECOND_START},
-            
-            glm::vec2{MIDDLE_START, BOTTOM_SECOND_END},
-            glm::vec2{MIDDLE_END, BOTTOM_SECOND_START},
-            glm::vec2{MIDDLE_END, BOTTOM_SECOND_END},
+void operator delete[](void *ptr) noexcept
+{
+    ::operator delete(ptr);
+}
 
-            // LEFT FACE
-            glm::vec2{LEFT_START, TOP_SECOND_END},
-            glm::vec2{LEFT_START, TOP_SECOND_START},
-            glm::vec2{LEFT_END, TOP_SECOND_START},
-            
-            glm::vec2{LEFT_START, TOP_SECOND_END},
-            glm::vec2{LEFT_END, TOP_SECOND_START},
-            glm::vec2{LEFT_END, TOP_SECOND_END},
+void operator delete(void *ptr, std::size_t size) noexcept
+{
+    if (ptr == nullptr)
+        return;
 
-            // FRONT FACE
-            glm::vec2{MIDDLE_START, TOP_SECOND_END},
-            glm::vec2{MIDDLE_START, TOP_SECOND_START},
-            glm::vec2{MIDDLE_END, TOP_SECOND_START},
-            
-            glm::vec2{MIDDLE_START, TOP_SECOND_END},
-            glm::vec2{MIDDLE_END, TOP_SECOND_START},
-            glm::vec2{MIDDLE_END, TOP_SECOND_END},
+    utils::alloc_tracker::on_free(size);
+    std::free(ptr);
+}
 
-            // TOP FACE
-            glm::vec2{MIDDLE_START, TOP_END},
-            glm::vec2{MIDDLE_START, TOP_START},
-            glm::vec2{MIDDLE_END, TOP_START},
-            
-            glm::vec2{MIDDLE_START, TOP_END},
-            glm::vec2{MIDDLE_END, TOP_START},
-            glm::vec2{MIDDLE_END, TOP_END},
+void operator delete[](void *ptr, std::size_t size) noexcept
+{
+    ::operator delete(ptr, size);
+}
 
-            // RIGHT FACE
-            glm::vec2{RIGHT_START, TOP_SECOND_END},
-            glm::vec2{RIGHT_START, TOP_SECOND_START},
-            glm::vec2{RIGHT_END, TOP_SECOND_START},
-            
-            glm::vec2{RIGHT_START, TOP_SECOND_END},
-            glm::vec2{RIGHT_END, TOP_SECOND_START},
-            glm::vec2{RIGHT_END, TOP_SECOND_END},
-        };
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    ::operator delete(ptr);
+}
+
+////
+// the over-aligned overloads, used for types aligned past __STDCPP_DEFAULT_NEW_ALIGNMENT__
+
+namespace utils::detail
+{
+    void *aligned_malloc(std::size_t size, std::align_val_t align) noexcept
+    {
+        size = size == 0 ? 1 : size;
+#ifdef _WIN32
+        return _aligned_malloc(size, (std::size_t)align);
+#else
+        // aligned_alloc needs the size to be a multiple of the alignment
+        return std::aligned_alloc((std::size_t)align, (size + (std::size_t)align - 1) & ~((std::size_t)align - 1));
+#endif
     }
 
-    constexpr std::array<glm::vec2, 36> gen_cube_texcoords_single_face(const glm::vec2& start, const glm::vec2& end) noexcept
+    void aligned_free(void *ptr) noexcept
     {
-        return std::array{
-            // BACK FACE
-            glm::vec2{start.x, start.y},
-            glm::vec2{start.x, end.y},
-            glm::vec2{end.x, end.y},
-            
-            glm::vec2{start.x, start.y},
-            glm::vec2{end.x, end.y},
-            glm::vec2{end.x, start.y},
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+} // namespace utils::detail
 
-            // BOTTOM FACE
-            glm::vec2{start.x, start.y},
-            glm::vec2{start.x, end.y},
-            glm::vec2{end.x, end.y},
-            
-            glm::vec2{start.x, start.y},
-            glm::vec2{end.x, end.y},
-            glm::vec2{end.x, start.y},
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    utils::alloc_tracker::on_alloc(size);
 
-            // LEFT FACE
-            glm::vec2{start.x, start.y},
-            glm::vec2{start.x, end.y},
-            glm::vec2{end.x, end.y},
-            
-            glm::vec2{start.x, start.y},
-            glm::vec2{end.x, end.y},
-            glm::vec2{end.x, start.y},
+    if (void *ptr = utils::detail::aligned_malloc(size, align))
+        return ptr;
 
-            // reflect on primary axis
-            
-            // FRONT FACE
-            glm::vec2{start.x, start.y},
-            glm::vec2{start.x, end.y},
-            glm::vec2{end.x, end.y},
-            
-            glm::vec2{start.x, start.y},
-            glm::vec2{end.x, end.y},
-            glm::vec2{end.x, start.y},
+    throw std::bad_alloc{};
+}
 
-            // TOP FACE
-            glm::vec2{start.x, start.y},
-            glm::vec2{start.x, end.y},
-            glm::vec2{end.x, end.y},
-            
-            glm::vec2{start.x, start.y},
-            glm::vec2{end.x, end.y},
-            glm::vec2{end.x, start.y},
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    return ::operator new(size, align);
+}
 
-            // RIGHT FACE
-            glm::vec2{start.x, start.y},
-            glm::vec2{start.x, end.y},
-            glm::vec2{end.x, end.y},
-            
-            glm::vec2{start.x, start.y},
-            glm::vec2{end.x, end.y},
-            glm::vec2{end.x, start.y},
-        };
-    }
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    utils::alloc_tracker::on_alloc(size);
+    return utils::detail::aligned_malloc(size, align);
+}
 
-    constexpr std::array<glm::vec3, 36> gen_cube_normals(const glm::vec3& start, const glm::vec3& end) noexcept
-    {
-        glm::vec3 dir = end - start;
-        glm::vec3 right, up, forward;
-        right = glm::vec3{dir.x, 0.0f, 0.0f};
-        up = glm::vec3{0.0f, dir.y, 0.0f};
-        forward = glm::vec3{0.0f, 0.0f, dir.z};
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &tag) noexcept
+{
+    return ::operator new(size, align, tag);
+}
 
-        return std::array{
-            // BACK FACE
-            -forward, -forward, -forward, -forward, -forward, -forward,
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    if (ptr == nullptr)
+        return;
 
-            // BOTTOM FACE
-            -up, -up, -up, -up, -up, -up,
+    utils::alloc_tracker::on_free(0);
+    utils::detail::aligned_free(ptr);
+}
 
-            // LEFT FACE
-            -right, -right, -right, -right, -right, -right,
+void operator delete[](void *ptr, std::align_val_t align) noexcept
+{
+    ::operator delete(ptr, align);
+}
 
-            // reflect on primary axis
+void operator delete(void *ptr, std::size_t size, std::align_val_t) noexcept
+{
+    if (ptr == nullptr)
+        return;
 
-            // FRONT FACE
-            forward, forward, forward, forward, forward, forward,
+    utils::alloc_tracker::on_free(size);
+    utils::detail::aligned_free(ptr);
+}
 
-            // TOP FACE
-            up, up, up, up, up, up,
+void operator delete[](void *ptr, std::size_t size, std::align_val_t align) noexcept
+{
+    ::operator delete(ptr, size, align);
+}
 
-            // RIGHT FACE
-            right, right, right, right, right, right,
-        };
-    }
-} // namespace utils
+void operator delete(void *ptr, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    ::operator delete(ptr, align);
+}
+
+void operator delete[](void *ptr, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    ::operator delete(ptr, align);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
 
 #endif
\ No newline at end of file
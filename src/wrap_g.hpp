@@ -57,6 +57,14 @@
 #include <iostream>
 #include <unordered_map>
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+#include <mutex>
+#include <memory>
+#include <algorithm>
 
 // gl
 #include <glad/glad.h>
@@ -77,8 +85,13 @@ namespace wrap_g
     class wrap_g;
     class window;
     class vertex_array_object;
+    class buffer;
+    class buffer_arena;
     class program;
     class texture;
+    class gpu_timer;
+    class debug_collector;
+    class input_recorder;
 
     ////////
     // concepts
@@ -137,12 +150,16 @@ namespace wrap_g
         static constexpr const unsigned int opengl_version_minor = WRAP_G_OPENGL_VERSION_MINOR;
 
     private:
-        // the output stream for debug and error logging
-        std::ostream &m_out;
+        // the debug and error log, written to the output stream on a background thread
+        utils::logger m_log;
 
         // a vairable that defines whether glfw is initialized
         bool m_init = false;
 
+        // the serial of the last buffer created. Names of deleted buffers are reused by opengl so the vaos
+        // remember the bound buffers by serial
+        uint64_t m_buffer_serial = 0;
+
     public:
         /**
          * @brief Initialize glfw. The version of opengl should be provided via a define (Done to prevent
@@ -159,9 +176,18 @@ namespace wrap_g
          */
         ~wrap_g() noexcept;
 
-        [[nodiscard]] inline constexpr std::ostream &out() noexcept { return m_out; }
+        [[nodiscard]] inline constexpr utils::logger &log() noexcept { return m_log; }
         [[nodiscard]] inline constexpr bool valid() const noexcept { return m_init; }
 
+        /**
+         * @brief Set a glfw window hint for the windows created after this call. Ex: GLFW_VISIBLE
+         * false creates hidden windows for headless runs.
+         *
+         * @param hint The glfw window hint.
+         * @param value The value of the hint.
+         */
+        void set_window_hint(int hint, int value) noexcept;
+
         /**
          * @brief Create a window object with this graphics object.
          *
@@ -185,6 +211,8 @@ namespace wrap_g
          * @return window The window object.
          */
         window create_window(GLint width, GLint height, const GLchar *title, const window &win, bool fullscreen = false) noexcept;
+
+        friend class buffer;
     };
 
     ////
@@ -205,6 +233,41 @@ namespace wrap_g
         const GLchar *m_title = "\0";
         GLFWwindow *m_win = nullptr;
 
+        // the recorder that input is recorded to or replayed from, if any
+        input_recorder *m_input = nullptr;
+
+        // the user callbacks, kept so recorded or replayed input can be forwarded to them
+        GLFWkeyfun m_key_callback = nullptr;
+        GLFWmousebuttonfun m_mouse_button_callback = nullptr;
+        GLFWcursorposfun m_cursor_position_callback = nullptr;
+        GLFWscrollfun m_scroll_callback = nullptr;
+
+    public:
+        /**
+         * @brief How the opengl debug messages of a debug context are handled.
+         *
+         */
+        enum class debug_output
+        {
+            // the driver waits while each message is logged, messages point at the call that caused them
+            SYNCHRONOUS,
+            // each message is logged without making the driver synchronous
+            ASYNCHRONOUS,
+            // messages are counted into a debug_collector and reported once per frame by collect_debug_messages
+            BATCHED
+        };
+
+    private:
+        std::atomic<debug_output> m_debug_output = debug_output::SYNCHRONOUS;
+        std::unique_ptr<debug_collector> m_debug_collector;
+
+        // one vao per vertex format, shared by every mesh of the format. See shared_vao
+        // * vaos are not shared between contexts so the cache is per window
+        std::unordered_map<const void *, std::unique_ptr<vertex_array_object>> m_shared_vaos;
+
+        // the vao last bound through bind_vao
+        GLuint m_bound_vao = 0;
+
     public:
         /**
          * @brief Prevent window from being constructed from anywhere other than through
@@ -250,11 +313,14 @@ namespace wrap_g
         [[nodiscard]] inline constexpr GLint height() const noexcept { return m_height; }
         [[nodiscard]] inline constexpr const GLchar *title() const noexcept { return m_title; }
 
+        // the log of the graphics object, for the objects made with the window
+        [[nodiscard]] inline constexpr utils::logger &log() noexcept { return __graphics.log(); }
+
         // check whether glad has been initialized.
         [[nodiscard]] inline bool check_glad() const noexcept { return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress); }
 
-        // gets whether the window should be closed.
-        [[nodiscard]] inline bool get_should_close() const noexcept { return glfwWindowShouldClose(m_win); }
+        // gets whether the window should be closed. Also true once a replayed input log runs out.
+        [[nodiscard]] inline bool get_should_close() const noexcept;
 
         // get the current position of the cursor.
         [[nodiscard]] inline std::pair<double, double> get_cursor_position() const noexcept;
@@ -263,13 +329,13 @@ namespace wrap_g
          * @brief get the mouse button from the window.
          * @param button the mouse button in question ex: GLFW_MOUSE_BUTTON_LEFT
         */
-        [[nodiscard]] inline int get_mouse_button(int button) const noexcept { return glfwGetMouseButton(m_win, button); }
+        [[nodiscard]] inline int get_mouse_button(int button) const noexcept;
 
         /**
          * @brief gets whether a specific key in the keyboard was pressed.
          * @param key the key to check
          */
-        [[nodiscard]] inline int get_key(int key) const noexcept { return glfwGetKey(m_win, key); }
+        [[nodiscard]] inline int get_key(int key) const noexcept;
 
         /**
          * @brief Set the framebuffer size callback.
@@ -316,6 +382,47 @@ namespace wrap_g
         requires MouseButtonCallback<Fn>
         void set_mouse_button_callback(Fn fn) noexcept;
 
+        /**
+         * @brief Set the scroll callback.
+         * @tparam Fn The type of the scroll callback. It must fulfill the ScrollCallback
+         * concept; be a function that accepts GLFWwindow* window, double dx, double dy and returns void.
+         * @param fn The scroll callback.
+        */
+        template <typename Fn>
+        requires ScrollCallback<Fn>
+        void set_scroll_callback(Fn fn) noexcept;
+
+        /**
+         * @brief Route all key, mouse button, cursor and scroll input through an input recorder.
+         * When recording, every event is logged before being forwarded to the user callbacks. When
+         * replaying, live input is ignored and the logged events are fed back instead during poll_events.
+         * get_key, get_mouse_button and get_cursor_position read from the recorder from then on.
+         * * The recorder must outlive the window.
+         *
+         * @param input The recorder to use.
+         */
+        void set_input_recorder(input_recorder &input) noexcept;
+
+        /**
+         * @brief Change how the opengl debug messages are handled. Only has an effect on a debug context
+         * (GLFW_OPENGL_DEBUG_CONTEXT) with WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL.
+         *
+         * @param mode The mode, SYNCHRONOUS by default.
+         */
+        void set_debug_output(debug_output mode) noexcept;
+
+        /**
+         * @brief Log the new messages collected since the last call and report the counts through the tracker
+         * as the "gl messages", "gl performance messages" and "gl high severity messages" counters.
+         * Call once per frame when the debug output is BATCHED, does nothing otherwise.
+         *
+         * @param tracker The metrics the counts are reported to, if any.
+         */
+        void collect_debug_messages(utils::metrics *tracker = nullptr) noexcept;
+
+        // the collector of the BATCHED debug output or nullptr if it was never used
+        [[nodiscard]] inline debug_collector *get_debug_collector() noexcept { return m_debug_collector.get(); }
+
         /**
          * @brief Set the input mode for the window.
          * Sets the input mode for the windwo must be one of
@@ -401,6 +508,46 @@ namespace wrap_g
          */
         vertex_array_object create_vao() noexcept;
 
+        /**
+         * @brief Get the vao of a vertex format, created the first time it is asked for. Meshes of the same
+         * format share it and only rebind their own buffers with bind_vertex_buffer and bind_element_buffer
+         * instead of switching vaos.
+         * ! buffers bound to a shared vao are not owned by it
+         *
+         * @tparam Format The vertex_format. Its attributes are defined on binding index 0.
+         * @return vertex_array_object& The shared vao, alive as long as the window.
+         */
+        template <typename Format>
+        vertex_array_object &shared_vao() noexcept;
+
+        /**
+         * @brief Bind a vao unless it is the one last bound through this function.
+         * ! binding a vao directly with vertex_array_object::bind is not seen by this
+         *
+         * @param vao The vao.
+         */
+        void bind_vao(const vertex_array_object &vao) noexcept;
+
+        /**
+         * @brief Create an immutable buffer. Ex: the vertices of a mesh, bound to a shared vao when drawn.
+         *
+         * @param size The size of the buffer in bytes.
+         * @param data The data the buffer starts with, can be nullptr.
+         * @param flags The flags of glNamedBufferStorage. Ex: GL_MAP_READ_BIT or GL_DYNAMIC_STORAGE_BIT.
+         * @return buffer
+         */
+        buffer create_buffer(GLsizeiptr size, const void *data, GLbitfield flags) noexcept;
+
+        /**
+         * @brief Create an arena which sub-allocates ranges from a few large buffers. Ex: to keep the vertices
+         * and indices of thousands of small meshes in a handful of buffer objects.
+         *
+         * @param block_size The size of each buffer in bytes. Default is 4 MiB.
+         * @param flags The flags of glNamedBufferStorage. GL_DYNAMIC_STORAGE_BIT is always added.
+         * @return buffer_arena
+         */
+        buffer_arena create_buffer_arena(GLsizeiptr block_size = 4 << 20, GLbitfield flags = 0) noexcept;
+
         /**
          * @brief Create a program object. The program can be used to create shaders such as fragment
          * First create_shader should be called to compile and attach a shader to the current program.
@@ -436,9 +583,344 @@ namespace wrap_g
          */
         texture create_texture(GLenum target) noexcept;
 
+        /**
+         * @brief Create a gpu timer which measures the time the gpu spends on the commands between
+         * begin and end with GL_TIME_ELAPSED queries.
+         *
+         * @return gpu_timer
+         */
+        gpu_timer create_gpu_timer() noexcept;
+
+    private:
+        // glfw callbacks installed while an input recorder is set
+        static void key_callback_hook(GLFWwindow *win, int key, int scancode, int action, int mods) noexcept;
+        static void mouse_button_callback_hook(GLFWwindow *win, int button, int action, int mods) noexcept;
+        static void cursor_position_callback_hook(GLFWwindow *win, double x, double y) noexcept;
+        static void scroll_callback_hook(GLFWwindow *win, double dx, double dy) noexcept;
+
+#if WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL
+        // route the opengl debug messages of this context to the wrap_g log
+        void enable_debug_output() noexcept;
+        static void debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *user_param) noexcept;
+#endif
+        // write one debug message to the log
+        static void log_debug_message(utils::logger &log, GLenum source, GLenum type, GLuint id, GLenum severity, std::string_view message) noexcept;
+
         friend class wrap_g;
+        friend class debug_collector;
     };
 
+    ////
+    // vertex format
+
+    /**
+     * @brief Marks an integer attribute as normalized. The shader reads it as a float in [0, 1] for unsigned
+     * and [-1, 1] for signed types. Ex: normalized<glm::u8vec4> for a color.
+     *
+     */
+    template <typename T>
+    struct normalized
+    {
+        T value;
+    };
+
+    /**
+     * @brief Marks 16 bit unsigned integers as the bits of half floats, ex: from utils::pack_half. The shader
+     * reads them as floats. Ex: half_float<glm::u16vec4> for a position in 8 bytes instead of 12.
+     *
+     */
+    template <typename T>
+    struct half_float
+    {
+        T value;
+    };
+
+    /**
+     * @brief A vector packed by utils::pack_snorm_10_10_10_2. The shader reads it as a normalized vec4 or
+     * its first components. Ex: a normal in 4 bytes instead of 12.
+     *
+     */
+    struct snorm_10_10_10_2
+    {
+        uint32_t value;
+    };
+
+    /**
+     * @brief The opengl type, count and kind of an attribute type. Defined for float, double and the 8, 16
+     * and 32 bit integers, the glm vectors of them, normalized integers and the compressed types above.
+     *
+     */
+    template <typename T>
+    struct attrib_traits;
+
+    template <typename T>
+    requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+    struct attrib_traits<T>
+    {
+        static constexpr const GLint count = 1;
+        static constexpr const GLenum type =
+            std::is_same_v<T, float> ? GL_FLOAT :
+            std::is_same_v<T, double> ? GL_DOUBLE :
+            std::is_same_v<T, std::int8_t> ? GL_BYTE :
+            std::is_same_v<T, std::uint8_t> ? GL_UNSIGNED_BYTE :
+            std::is_same_v<T, std::int16_t> ? GL_SHORT :
+            std::is_same_v<T, std::uint16_t> ? GL_UNSIGNED_SHORT :
+            std::is_same_v<T, std::int32_t> ? GL_INT :
+            std::is_same_v<T, std::uint32_t> ? GL_UNSIGNED_INT : GL_NONE;
+        static constexpr const bool normalized = false;
+    };
+
+    template <glm::length_t L, typename T, glm::qualifier Q>
+    struct attrib_traits<glm::vec<L, T, Q>>
+    {
+        static constexpr const GLint count = L;
+        static constexpr const GLenum type = attrib_traits<T>::type;
+        static constexpr const bool normalized = false;
+    };
+
+    // only integers can be normalized
+    template <typename T>
+    requires(attrib_traits<T>::type != GL_FLOAT && attrib_traits<T>::type != GL_DOUBLE)
+    struct attrib_traits<normalized<T>>
+    {
+        static constexpr const GLint count = attrib_traits<T>::count;
+        static constexpr const GLenum type = attrib_traits<T>::type;
+        static constexpr const bool normalized = true;
+    };
+
+    template <typename T>
+    requires(attrib_traits<T>::type == GL_UNSIGNED_SHORT)
+    struct attrib_traits<half_float<T>>
+    {
+        static constexpr const GLint count = attrib_traits<T>::count;
+        static constexpr const GLenum type = GL_HALF_FLOAT;
+        static constexpr const bool normalized = false;
+    };
+
+    template <>
+    struct attrib_traits<snorm_10_10_10_2>
+    {
+        static constexpr const GLint count = 4;
+        static constexpr const GLenum type = GL_INT_2_10_10_10_REV;
+        static constexpr const bool normalized = true;
+    };
+
+    template <typename T>
+    concept VertexAttrib = requires
+    {
+        { attrib_traits<T>::type } -> std::convertible_to<GLenum>;
+    } && attrib_traits<T>::type != GL_NONE;
+
+    /**
+     * @brief One interleaved vertex with a member per attribute, in order. Can be initialized like a flat
+     * struct. Ex: vertex<glm::vec3, glm::vec2> v{pos, tex_coord}; v.get<1>() is the tex coord.
+     * * laid out like a struct so an array of vertices can be uploaded as is
+     */
+    template <VertexAttrib... Ts>
+    struct vertex;
+
+    template <VertexAttrib T>
+    struct vertex<T>
+    {
+        T value;
+
+        template <size_t I>
+        requires(I == 0)
+        [[nodiscard]] constexpr T &get() noexcept { return value; }
+
+        template <size_t I>
+        requires(I == 0)
+        [[nodiscard]] constexpr const T &get() const noexcept { return value; }
+    };
+
+    template <VertexAttrib T, VertexAttrib... Ts>
+    struct vertex<T, Ts...>
+    {
+        T value;
+        vertex<Ts...> rest;
+
+        template <size_t I>
+        [[nodiscard]] constexpr auto &get() noexcept
+        {
+            if constexpr (I == 0)
+                return value;
+            else
+                return rest.template get<I - 1>();
+        }
+
+        template <size_t I>
+        [[nodiscard]] constexpr const auto &get() const noexcept
+        {
+            if constexpr (I == 0)
+                return value;
+            else
+                return rest.template get<I - 1>();
+        }
+    };
+
+    /**
+     * @brief The layout of one attribute of a vertex format.
+     *
+     */
+    struct vertex_attrib
+    {
+        enum class kind
+        {
+            // read as floats, glVertexArrayAttribFormat
+            FLOAT,
+            // read as ints, glVertexArrayAttribIFormat
+            INTEGER,
+            // read as doubles, glVertexArrayAttribLFormat
+            DOUBLE
+        };
+
+        GLint count;
+        GLenum type;
+        bool normalized;
+        kind read_as;
+        GLuint offset;
+    };
+
+    /**
+     * @brief Derives the offsets, types, counts and normalization of an interleaved vertex at compile time.
+     * Use vertex_array_object::define_format to declare every attribute of the format in one call.
+     * Ex: vertex_format<glm::vec3, glm::vec3, glm::vec2> for a position, normal and tex coord.
+     *
+     * @tparam Ts The type of each attribute, in attribute index order.
+     */
+    template <VertexAttrib... Ts>
+    requires(sizeof...(Ts) > 0)
+    struct vertex_format
+    {
+        using vertex_type = vertex<Ts...>;
+
+        static constexpr const size_t attrib_count = sizeof...(Ts);
+        static constexpr const GLsizei stride = sizeof(vertex_type);
+
+    private:
+        template <typename V>
+        static constexpr void offsets(size_t base, GLuint *out) noexcept
+        {
+            *out = (GLuint)base;
+
+            // offsetof needs a name without commas
+            if constexpr (requires(V v) { v.rest; })
+                offsets<decltype(V::rest)>(base + offsetof(V, rest), out + 1);
+        }
+
+        static constexpr std::array<vertex_attrib, attrib_count> make_attribs() noexcept
+        {
+            std::array<GLuint, attrib_count> offs{};
+            offsets<vertex_type>(0, offs.data());
+
+            size_t i = 0;
+            return {vertex_attrib{
+                attrib_traits<Ts>::count,
+                attrib_traits<Ts>::type,
+                attrib_traits<Ts>::normalized,
+                attrib_traits<Ts>::type == GL_DOUBLE ? vertex_attrib::kind::DOUBLE :
+                    (attrib_traits<Ts>::type == GL_FLOAT || attrib_traits<Ts>::type == GL_HALF_FLOAT || attrib_traits<Ts>::normalized) ? vertex_attrib::kind::FLOAT : vertex_attrib::kind::INTEGER,
+                offs[i++]
+            }...};
+        }
+
+    public:
+        static constexpr const std::array<vertex_attrib, attrib_count> attribs = make_attribs();
+    };
+
+    /**
+     * @brief Interleave separate attribute arrays into one array of vertices at compile time.
+     * Ex: interleave(positions, normals, tex_coords).
+     *
+     */
+    template <VertexAttrib... Ts, size_t N>
+    [[nodiscard]] constexpr std::array<vertex<Ts...>, N> interleave(const std::array<Ts, N> &...arrays) noexcept
+    {
+        std::array<vertex<Ts...>, N> verts{};
+        for (size_t i = 0; i < N; ++i)
+            verts[i] = vertex<Ts...>{arrays[i]...};
+
+        return verts;
+    }
+
+    /**
+     * @brief The format of utils::mesh_vertex, the vertices of meshes loaded from files.
+     * Ex: vao.define_format<mesh_format>() then vao.create_array_buffer(0, file.vertex_bytes(), file.vertices(), flags)
+     *
+     */
+    using mesh_format = vertex_format<glm::vec3, glm::vec3, glm::vec2>;
+    static_assert(sizeof(utils::mesh_vertex) == mesh_format::stride && offsetof(utils::mesh_vertex, normal) == mesh_format::attribs[1].offset
+        && offsetof(utils::mesh_vertex, texcoord) == mesh_format::attribs[2].offset, "utils::mesh_vertex must be laid out like mesh_format");
+
+    /**
+     * @brief The format of utils::glyph_quad, one instance per glyph of text. The rect and atlas rect are in
+     * pixels and the color is normalized. Ex: read by the shaders of wrap_g::text_renderer.
+     *
+     */
+    using glyph_format = vertex_format<glm::vec4, glm::u16vec4, normalized<glm::u8vec4>>;
+    static_assert(sizeof(utils::glyph_quad) == glyph_format::stride && offsetof(utils::glyph_quad, atlas_rect) == glyph_format::attribs[1].offset
+        && offsetof(utils::glyph_quad, color) == glyph_format::attribs[2].offset, "utils::glyph_quad must be laid out like glyph_format");
+
+    /**
+     * @brief Compress positions to half floats at compile time. w is 1 so the vertex stays 4 byte aligned
+     * and reads the same as a vec3 or a vec4 with w = 1.
+     *
+     */
+    template <size_t N>
+    [[nodiscard]] constexpr std::array<half_float<glm::u16vec4>, N> compress_positions(const std::array<glm::vec3, N> &positions) noexcept
+    {
+        std::array<half_float<glm::u16vec4>, N> out{};
+        for (size_t i = 0; i < N; ++i)
+            out[i].value = glm::u16vec4{utils::pack_half(positions[i].x), utils::pack_half(positions[i].y), utils::pack_half(positions[i].z), utils::pack_half(1.0f)};
+
+        return out;
+    }
+
+    /**
+     * @brief Compress unit normals to 10 bits per component at compile time.
+     * ! normals which are not unit length are clamped to [-1, 1]
+     *
+     */
+    template <size_t N>
+    [[nodiscard]] constexpr std::array<snorm_10_10_10_2, N> compress_normals(const std::array<glm::vec3, N> &normals) noexcept
+    {
+        std::array<snorm_10_10_10_2, N> out{};
+        for (size_t i = 0; i < N; ++i)
+            out[i].value = utils::pack_snorm_10_10_10_2(normals[i]);
+
+        return out;
+    }
+
+    /**
+     * @brief Compress texture coordinates in [0, 1] to unsigned normalized 16 bit integers at compile time.
+     * Use compress_half for coordinates outside of [0, 1]. Ex: gen_cube_texcoords for a cubemap
+     *
+     */
+    template <size_t N>
+    [[nodiscard]] constexpr std::array<normalized<glm::u16vec2>, N> compress_texcoords(const std::array<glm::vec2, N> &texcoords) noexcept
+    {
+        std::array<normalized<glm::u16vec2>, N> out{};
+        for (size_t i = 0; i < N; ++i)
+            out[i].value = glm::u16vec2{utils::pack_unorm16(texcoords[i].x), utils::pack_unorm16(texcoords[i].y)};
+
+        return out;
+    }
+
+    /**
+     * @brief Compress any float vectors to half floats at compile time.
+     *
+     */
+    template <glm::length_t L, glm::qualifier Q, size_t N>
+    [[nodiscard]] constexpr std::array<half_float<glm::vec<L, uint16_t, Q>>, N> compress_half(const std::array<glm::vec<L, float, Q>, N> &values) noexcept
+    {
+        std::array<half_float<glm::vec<L, uint16_t, Q>>, N> out{};
+        for (size_t i = 0; i < N; ++i)
+            for (glm::length_t c = 0; c < L; ++c)
+                out[i].value[c] = utils::pack_half(values[i][c]);
+
+        return out;
+    }
+
     ////
     // vertex array object
 
@@ -467,6 +949,22 @@ namespace wrap_g
         std::unordered_map<GLuint, array_buffer> m_array_buffers;
         GLuint m_element_buffer_id = 0;
 
+        // the buffers bound with bind_vertex_buffer and bind_element_buffer, used to skip rebinding them
+        // the first 16 binding indices are tracked, the minimum GL_MAX_VERTEX_ATTRIB_BINDINGS
+        // * kept by buffer::serial as a new buffer can get the name of a deleted one
+        struct bound_buffer
+        {
+            uint64_t buffer_serial = 0;
+            GLintptr offset = 0;
+            GLsizei stride = 0;
+        };
+        std::array<bound_buffer, 16> m_bound_buffers{};
+        uint64_t m_bound_element_buffer_serial = 0;
+
+        // the vao last bound in the window which created this one, kept in step by bind so window::bind_vao
+        // does not skip a bind after a vao was bound directly
+        GLuint *m_context_bound_vao = nullptr;
+
     public:
         /**
          * @brief Disally vaos from being created without a window.
@@ -485,8 +983,9 @@ namespace wrap_g
          * @brief Create a vao object.
          *
          * @param __graphics The graphics object being used.
+         * @param context_bound_vao The bound vao cache of the window creating it.
          */
-        vertex_array_object(wrap_g &__graphics) noexcept;
+        vertex_array_object(wrap_g &__graphics, GLuint *context_bound_vao = nullptr) noexcept;
 
     public:
         [[nodiscard]] inline constexpr GLuint id() const noexcept { return m_id; }
@@ -558,6 +1057,55 @@ namespace wrap_g
          */
         void define_attrib(GLuint binding_index, GLuint attrib_index, GLint count, GLenum data_type, bool normalised = false, GLuint relative_offset = 0) noexcept;
 
+        /**
+         * @brief Define every attribute of an interleaved vertex format, read from one buffer binding.
+         *
+         * @tparam Format The vertex_format.
+         * @param binding_index The index of the buffer containing the vertices.
+         * @param first_attrib The attribute index of the first attribute of the format, the rest follow in order.
+         */
+        template <typename Format>
+        void define_format(GLuint binding_index = 0, GLuint first_attrib = 0) noexcept;
+
+        /**
+         * @brief Create an interleaved array buffer and define the attributes of its vertex format.
+         *
+         * @param binding_index The index which the buffer should be bound to.
+         * @param verts The vertices.
+         * @param count The number of vertices.
+         * @param flags The flags that should be set on the buffer data, same as create_array_buffer.
+         * @param first_attrib The attribute index of the first attribute, the rest follow in order.
+         */
+        template <VertexAttrib... Ts>
+        void create_vertex_buffer(GLuint binding_index, const vertex<Ts...> *verts, size_t count, GLbitfield flags, GLuint first_attrib = 0) noexcept;
+
+        /**
+         * @brief Read the vertices of a binding index from a buffer which this vao does not own. Does nothing
+         * if the buffer is already bound there with the same offset and stride.
+         *
+         * @param binding_index The binding index.
+         * @param buf The buffer.
+         * @param stride The distance between vertices. Ex: Format::stride.
+         * @param offset The offset of the first vertex in the buffer.
+         */
+        void bind_vertex_buffer(GLuint binding_index, const buffer &buf, GLsizei stride, GLintptr offset = 0) noexcept;
+
+        /**
+         * @brief Read the indices from a buffer which this vao does not own. Does nothing if it is already bound.
+         *
+         * @param buf The buffer.
+         */
+        void bind_element_buffer(const buffer &buf) noexcept;
+
+        /**
+         * @brief Set how often the vertices of a binding index advance. 0 advances every vertex and n every n
+         * instances. Ex: 1 for a buffer of per instance data drawn with glDrawArraysInstanced.
+         *
+         * @param binding_index The binding index.
+         * @param divisor The instances per vertex, 0 for per vertex data.
+         */
+        void set_binding_divisor(GLuint binding_index, GLuint divisor) noexcept;
+
         /**
          * @brief Bind the vao. The vao must be bound before using it for draw calls.
          *
@@ -567,6 +1115,218 @@ namespace wrap_g
         friend class window;
     };
 
+    ////
+    // buffer
+
+    /**
+     * @brief An immutable opengl buffer which deletes itself. Unlike the buffers made by vertex_array_object
+     * it is not tied to a vao so meshes can keep their vertices in one and bind it to a shared vao.
+     *
+     */
+    class buffer
+    {
+    private:
+        wrap_g &__graphics;
+
+        GLuint m_id = 0;
+        GLsizeiptr m_size = 0;
+
+        // unique for every buffer created by the graphics object, unlike the name. 0 without a buffer
+        uint64_t m_serial = 0;
+
+    public:
+        /**
+         * @brief Disable buffers from being made without a window.
+         *
+         */
+        buffer() = delete;
+
+        buffer(const buffer &) = delete;
+        buffer &operator=(const buffer &) = delete;
+
+        /**
+         * @brief Delete the buffer.
+         *
+         */
+        ~buffer() noexcept;
+
+    private:
+        /**
+         * @brief Create the buffer and its storage.
+         *
+         * @param __graphics The graphics object which is being used.
+         * @param size The size of the buffer in bytes.
+         * @param data The data the buffer starts with, can be nullptr.
+         * @param flags The flags of glNamedBufferStorage.
+         */
+        buffer(wrap_g &__graphics, GLsizeiptr size, const void *data, GLbitfield flags) noexcept;
+
+    public:
+        [[nodiscard]] inline constexpr GLuint id() const noexcept { return m_id; }
+        [[nodiscard]] inline constexpr GLsizeiptr size() const noexcept { return m_size; }
+        [[nodiscard]] inline constexpr bool valid() const noexcept { return m_id != 0; }
+        [[nodiscard]] inline constexpr uint64_t serial() const noexcept { return m_serial; }
+
+        friend class window;
+        friend class buffer_arena;
+    };
+
+    ////
+    // buffer arena
+
+    /**
+     * @brief Sub-allocates many small ranges, ex: the vertices and indices of many small meshes, from a few
+     * large buffers so they share buffer objects and bindings. Each block is an immutable buffer split by a
+     * utils::offset_allocator and a new block is added when no block has room.
+     * Allocations are handles, get() returns the buffer, offset and size of one. A mesh allocated with its
+     * vertex stride as the alignment is drawn from its block with glDrawElementsBaseVertex or batched with
+     * glMultiDrawElementsBaseVertex using range::first() as the base vertex and first index.
+     *
+     */
+    class buffer_arena
+    {
+    public:
+        using handle = uint32_t;
+        static constexpr handle invalid_handle = ~handle{0};
+
+        // where an allocation is
+        struct range
+        {
+            const buffer *buf = nullptr;
+            GLintptr offset = 0;
+            GLsizeiptr size = 0;
+
+            [[nodiscard]] inline constexpr bool valid() const noexcept { return buf != nullptr; }
+
+            // the index of the first element in the buffer. Ex: the base vertex with the vertex stride
+            [[nodiscard]] inline constexpr GLint first(GLsizei element_size) const noexcept { return offset / element_size; }
+        };
+
+    private:
+        struct block
+        {
+            std::unique_ptr<buffer> buf;
+            utils::offset_allocator allocator;
+        };
+
+        struct record
+        {
+            uint32_t block = 0;
+            utils::offset_allocator::allocation alloc;
+            uint32_t size = 0;
+            uint32_t alignment = 1;
+        };
+
+        wrap_g &__graphics;
+
+        GLsizeiptr m_block_size;
+        GLbitfield m_flags;
+
+        std::vector<block> m_blocks;
+        // indexed by handle, freed records have an invalid allocation
+        std::vector<record> m_records;
+        std::vector<handle> m_free_handles;
+
+    public:
+        /**
+         * @brief Disable buffer arenas from being made without a window.
+         *
+         */
+        buffer_arena() = delete;
+
+        buffer_arena(const buffer_arena &) = delete;
+        buffer_arena &operator=(const buffer_arena &) = delete;
+
+    private:
+        /**
+         * @brief Create an arena without any blocks, the first is made by the first allocation.
+         *
+         * @param __graphics The graphics object which is being used.
+         * @param block_size The size of each block in bytes. Larger allocations get a block of their own size.
+         * @param flags The flags of glNamedBufferStorage. GL_DYNAMIC_STORAGE_BIT is always added to upload the data.
+         */
+        buffer_arena(wrap_g &__graphics, GLsizeiptr block_size, GLbitfield flags) noexcept;
+
+    public:
+        /**
+         * @brief Allocate a range and upload its data.
+         *
+         * @param size The size in bytes.
+         * @param data The data of the range, can be nullptr to write it later.
+         * @param alignment The offset is a multiple of it. Ex: the vertex stride for base vertex draws.
+         * @return handle invalid_handle if the allocation failed.
+         */
+        [[nodiscard]] handle allocate(GLsizeiptr size, const void *data = nullptr, GLsizeiptr alignment = 4) noexcept;
+
+        /**
+         * @brief Allocate a range for an array aligned to its element size so range::first() is its index
+         * in the buffer.
+         *
+         * @tparam T The element. Ex: format::vertex_type or glm::uvec3 for indices.
+         * @param data The elements.
+         * @param count The number of elements.
+         * @return handle invalid_handle if the allocation failed.
+         */
+        template <typename T>
+        [[nodiscard]] inline handle allocate(const T *data, size_t count) noexcept { return allocate(count * sizeof(T), data, sizeof(T)); }
+
+        /**
+         * @brief Write data to an allocation.
+         *
+         * @param h The allocation.
+         * @param data The data.
+         * @param size The size of the data in bytes.
+         * @param offset The offset in the allocation.
+         * @return true The data was written.
+         * @return false The handle is invalid or the data does not fit in the allocation.
+         */
+        bool write(handle h, const void *data, GLsizeiptr size, GLintptr offset = 0) noexcept;
+
+        /**
+         * @brief Free an allocation. Does nothing for invalid handles.
+         *
+         * @param h The allocation.
+         */
+        void free(handle h) noexcept;
+
+        /**
+         * @brief Where an allocation is.
+         * ! changes after defragment()
+         *
+         * @param h The allocation.
+         * @return range Invalid if the handle is invalid.
+         */
+        [[nodiscard]] range get(handle h) const noexcept;
+
+        /**
+         * @brief Pack the allocations of every block into as few new blocks as they fit in, largest first, so
+         * the free space is released. Nothing is moved unless it frees at least one block, which is checked on
+         * the cpu first. The data is moved on the gpu with glCopyNamedBufferSubData into the new buffers, so
+         * the ranges of the handles must be read again and their buffers rebound.
+         *
+         * @return size_t The number of allocations moved, 0 if no block would be freed.
+         */
+        size_t defragment() noexcept;
+
+        [[nodiscard]] inline size_t blocks() const noexcept { return m_blocks.size(); }
+
+        /**
+         * @brief The total size of the blocks in bytes.
+         *
+         * @return GLsizeiptr
+         */
+        [[nodiscard]] GLsizeiptr capacity() const noexcept;
+
+        /**
+         * @brief The total size of the allocations in bytes, not counting alignment.
+         *
+         * @return GLsizeiptr
+         */
+        [[nodiscard]] GLsizeiptr used() const noexcept;
+
+        friend class window;
+    };
+
     ///
     // program
 
@@ -686,23 +1446,14 @@ namespace wrap_g
         requires utils::Stringable<String>
         int uniform_location(String name) const noexcept;
 
-        // TODO: check if array version is better
         /**
          * @brief Get the uniform location of multiple unifomrs in a shader in this program.
+         * The locations are returned in an array so no heap allocation is made.
          * ! all strings must have null terminator
          */
         template <typename... Ts>
         requires((utils::Stringable<Ts> && ...))
-        std::vector<int> uniform_locations(Ts &&...names) const noexcept;
-
-        // /**
-        // //  * @brief Get the uniform location of multiple unifomrs in a shader in this program.
-        // // * ! all strings must have null terminator
-        // // */
-        // template <typename... Ts>
-        // requires((utils::Stringable<Ts> && ...))
-        // std::array<int, sizeof...(Ts)> uniform_locations(Ts &&...names)
-        // const noexcept;
+        std::array<int, sizeof...(Ts)> uniform_locations(Ts &&...names) const noexcept;
 
         /**
          * @brief Set the value of a uniform in the program. This function can be used to set the uniform
@@ -861,6 +1612,61 @@ namespace wrap_g
          */
         void sub_image2d(GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) noexcept;
 
+        /**
+         * @brief Assign already compressed blocks to storage allocated with define_texture2d with a compressed
+         * internal format. The offsets and size must be multiples of 4 but for blocks on the edges of the level.
+         *
+         * @param level The level of the image.
+         * @param xoffset The x offset.
+         * @param yoffset The y offset.
+         * @param width The width of the image.
+         * @param height The height of the image.
+         * @param format The compressed internal format of the storage. Ex: compressed_format(utils::block_format::BC1)
+         * @param size The bytes of data. Ex: utils::compressed_size
+         * @param data A pointer to the blocks.
+         */
+        void compressed_sub_image2d(GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei size, const void *data) noexcept;
+
+        /**
+         * @brief Allocate compressed storage for a 2d image and fill it. Each level is halved on the cpu from
+         * the one before and compressed with utils::compress_image, since gen_mipmap cannot make the levels of
+         * compressed textures. An eighth (BC1, BC4) or a quarter (BC3, BC5) of the memory of GL_RGBA8.
+         * * BC1 and BC3 need GL_EXT_texture_compression_s3tc, which desktop drivers have.
+         *
+         * @param pixels The rows of the image, tightly packed.
+         * @param width The width of the image.
+         * @param height The height of the image.
+         * @param channels The bytes per pixel, 1 to 4.
+         * @param format The block format. Ex: BC1 for rgb, BC3 for rgba
+         * @param levels The levels to allocate and fill, 0 for all of them down to 1x1.
+         * @param pool The pool the levels are compressed on, nullptr compresses on the calling thread.
+         */
+        void compressed_image2d(const unsigned char *pixels, size_t width, size_t height, size_t channels, utils::block_format format,
+                                size_t levels = 0, utils::job_pool *pool = nullptr) noexcept;
+
+        /**
+         * @brief The opengl internal format of a block format.
+         *
+         * @param format The block format.
+         * @return GLenum Ex: GL_COMPRESSED_RGB_S3TC_DXT1_EXT for BC1
+         */
+        [[nodiscard]] static constexpr GLenum compressed_format(utils::block_format format) noexcept
+        {
+            switch (format)
+            {
+            case utils::block_format::BC1:
+                return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case utils::block_format::BC3:
+                return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case utils::block_format::BC4:
+                return GL_COMPRESSED_RED_RGTC1;
+            case utils::block_format::BC5:
+                return GL_COMPRESSED_RG_RGTC2;
+            }
+
+            return GL_NONE;
+        }
+
         /**
          * @brief Create mipmaps for the texture.
          *
@@ -870,6 +1676,319 @@ namespace wrap_g
         friend class window;
     };
 
+    ////
+    // debug collector
+
+    /**
+     * @brief Collects the opengl debug messages of a window in batches instead of logging each one as it
+     * arrives. Every message is counted by id and severity but only the first message of each id and
+     * severity is kept, in a bounded buffer, to be logged when the batch is collected.
+     * * the driver may push from its own threads
+     */
+    class debug_collector
+    {
+    public:
+        // the new messages kept per batch, later ones are only counted
+        static constexpr const size_t capacity = 64;
+        // the id and severity pairs counted separately, later ones are only added to the totals
+        static constexpr const size_t max_counters = 256;
+        // kept messages are cut to this size
+        static constexpr const size_t max_text = 256;
+
+        struct counter
+        {
+            GLuint id;
+            GLenum type;
+            GLenum severity;
+            size_t count;
+        };
+
+        // the message counts of a batch or of every batch
+        struct summary
+        {
+            size_t messages = 0;
+            // GL_DEBUG_TYPE_PERFORMANCE messages
+            size_t performance = 0;
+            // GL_DEBUG_TYPE_ERROR messages
+            size_t errors = 0;
+            // by severity: notification, low, medium, high
+            std::array<size_t, 4> severity{};
+            // new messages that were not kept as the buffer was full
+            size_t dropped = 0;
+        };
+
+    private:
+        struct message
+        {
+            GLenum source;
+            GLenum type;
+            GLuint id;
+            GLenum severity;
+            size_t size;
+            std::array<char, max_text> text;
+        };
+
+        std::mutex m_lock;
+
+        std::array<message, capacity> m_messages;
+        size_t m_message_count = 0;
+
+        std::array<counter, max_counters> m_counters;
+        size_t m_counter_count = 0;
+
+        summary m_batch;
+        summary m_total;
+
+    public:
+        /**
+         * @brief Count a message and keep it if its id and severity were not seen before.
+         * Called by the debug message callback.
+         */
+        void push(GLenum source, GLenum type, GLuint id, GLenum severity, std::string_view text) noexcept;
+
+        /**
+         * @brief Log the messages kept since the last collect and start a new batch.
+         *
+         * @param log The log the kept messages are written to.
+         * @return summary The counts of the batch.
+         */
+        summary collect(utils::logger &log) noexcept;
+
+        // the counts of every batch
+        [[nodiscard]] summary total() noexcept;
+
+        // the count of each id and severity pair, ! allocates
+        [[nodiscard]] std::vector<counter> counters() noexcept;
+    };
+
+    ////
+    // gpu timer
+
+    /**
+     * @brief Measures gpu time with a ring of GL_TIME_ELAPSED queries. Results are read back a few frames
+     * later so the cpu never waits on the gpu. Call begin and end around the commands being timed once
+     * per frame and result to collect every finished measurement.
+     * If all the queries are still in flight the frame is not timed instead of stalling.
+     */
+    class gpu_timer
+    {
+    public:
+        // the number of frames that can be in flight before frames stop being timed
+        static constexpr const size_t query_count = 4;
+
+    private:
+        wrap_g &__graphics;
+
+        std::array<GLuint, query_count> m_queries{};
+
+        // the number of queries issued and read back
+        size_t m_issued = 0;
+        size_t m_read = 0;
+
+        // whether the current frame is being timed
+        bool m_active = false;
+
+    public:
+        /**
+         * @brief Disable gpu timers from being made without a window.
+         *
+         */
+        gpu_timer() = delete;
+
+        /**
+         * @brief Destroy the gpu timer and its queries.
+         *
+         */
+        ~gpu_timer() noexcept;
+
+    private:
+        /**
+         * @brief Construct a new gpu timer object.
+         *
+         * @param __graphics The graphics object which is being used.
+         */
+        gpu_timer(wrap_g &__graphics) noexcept;
+
+    public:
+        // the number of measurements which have not been read back yet
+        [[nodiscard]] inline constexpr size_t pending() const noexcept { return m_issued - m_read; }
+
+        /**
+         * @brief Start timing the commands that follow.
+         *
+         */
+        void begin() noexcept;
+
+        /**
+         * @brief Stop timing.
+         *
+         */
+        void end() noexcept;
+
+        /**
+         * @brief Read back the oldest measurement.
+         *
+         * @param ms The elapsed gpu time in ms.
+         * @param wait Whether to wait for the gpu to finish. Ex: when flushing at the end of a run.
+         * @return true A measurement was read.
+         * @return false No measurement was finished.
+         */
+        [[nodiscard]] bool result(double &ms, bool wait = false) noexcept;
+
+        friend class window;
+    };
+
+    ////
+    // input recorder
+
+    /**
+     * @brief Records key, mouse button, cursor and scroll events along with the frame dts into a binary
+     * log and replays them later in place of glfw. Attach it to a window with window::set_input_recorder
+     * and call frame() once per frame with the measured dt, using the returned dt for any movement math.
+     * While replaying the recorded dt is returned so runs are identical across builds and machines.
+     * * The log is written in the native byte order.
+     */
+    class input_recorder
+    {
+    public:
+        enum class mode
+        {
+            IDLE,
+            RECORD,
+            REPLAY
+        };
+
+        enum class event_type : std::uint32_t
+        {
+            FRAME,
+            KEY,
+            MOUSE_BUTTON,
+            CURSOR_POSITION,
+            SCROLL
+        };
+
+        /**
+         * @brief A single logged event. Stored as is in the binary log.
+         *
+         */
+        struct event
+        {
+            event_type type = event_type::FRAME;
+            // key or mouse button
+            std::int32_t code = 0;
+            std::int32_t scancode = 0;
+            std::int32_t action = 0;
+            std::int32_t mods = 0;
+            // cursor position, scroll offset or frame dt (x)
+            double x = 0.0;
+            double y = 0.0;
+            // seconds since the recording started
+            double time = 0.0;
+        };
+
+        // identifies the log file and its layout
+        static constexpr const char magic[4] = {'W', 'G', 'I', 'L'};
+        static constexpr const std::uint32_t version = 1;
+
+    private:
+        mode m_mode = mode::IDLE;
+
+        std::vector<event> m_events;
+        // the next event to be replayed
+        size_t m_next = 0;
+        double m_start_time = 0.0;
+
+        // the input state as seen through the events
+        std::array<std::uint8_t, GLFW_KEY_LAST + 1> m_keys{};
+        std::array<std::uint8_t, GLFW_MOUSE_BUTTON_LAST + 1> m_mouse_buttons{};
+        double m_cursor_x = 0.0;
+        double m_cursor_y = 0.0;
+
+    public:
+        [[nodiscard]] inline constexpr mode get_mode() const noexcept { return m_mode; }
+        [[nodiscard]] inline constexpr bool recording() const noexcept { return m_mode == mode::RECORD; }
+        [[nodiscard]] inline constexpr bool replaying() const noexcept { return m_mode == mode::REPLAY; }
+        [[nodiscard]] inline constexpr size_t size() const noexcept { return m_events.size(); }
+
+        // whether a replayed log has no more events
+        [[nodiscard]] inline constexpr bool finished() const noexcept { return m_mode == mode::REPLAY && m_next >= m_events.size(); }
+
+        /**
+         * @brief Clear any previous events and start recording.
+         *
+         */
+        void start_recording() noexcept;
+
+        /**
+         * @brief Stop recording or replaying. The events are kept.
+         *
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief Write the recorded events to a binary log.
+         *
+         * @param path The path of the log file.
+         * @return true Saved successfully.
+         * @return false Failed to write the file.
+         */
+        [[nodiscard]] bool save(const char *path) const noexcept;
+
+        /**
+         * @brief Read a binary log and start replaying it.
+         *
+         * @param path The path of the log file.
+         * @return true Loaded successfully.
+         * @return false Failed to read the file or the file is not a valid log.
+         */
+        [[nodiscard]] bool load(const char *path) noexcept;
+
+        /**
+         * @brief Start replaying the events currently held from the beginning.
+         *
+         */
+        void start_replay() noexcept;
+
+        /**
+         * @brief Append an event while recording. Used for scripted input as well.
+         *
+         * @param e The event. The time is set by the recorder.
+         */
+        void record(event e) noexcept;
+
+        /**
+         * @brief Mark the end of a frame.
+         *
+         * @param dt The measured frame time.
+         * @return float The dt that should be used for the next frame. The recorded dt when replaying.
+         */
+        float frame(float dt) noexcept;
+
+        /**
+         * @brief Apply the replayed events for the current frame, calling fn with each of them.
+         *
+         * @param fn Called as fn(const event&) for each event in the order they were recorded.
+         */
+        template <typename Fn>
+        requires std::is_invocable_v<Fn, const input_recorder::event &>
+        void replay_events(Fn &&fn) noexcept;
+
+        [[nodiscard]] int key(int key) const noexcept;
+        [[nodiscard]] int mouse_button(int button) const noexcept;
+        [[nodiscard]] inline std::pair<double, double> cursor_position() const noexcept { return {m_cursor_x, m_cursor_y}; }
+
+        /**
+         * @brief Move the cursor without logging an event. Mirrors window::set_cursor_pos so a replay
+         * sees the same cursor as the recording did.
+         *
+         */
+        void set_cursor_position(double x, double y) noexcept;
+
+    private:
+        // update the input state with an event
+        void apply(const event &e) noexcept;
+    };
+
 } // namespace wrap_g
 
 #include "wrap_g_impl.hpp"
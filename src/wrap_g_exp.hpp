@@ -7,6 +7,10 @@
 
 // stl
 #include <unordered_map>
+#include <memory>
+#include <vector>
+#include <array>
+#include <string_view>
 
 // local
 #include "wrap_g.hpp"
@@ -44,12 +48,22 @@ public:
 
 class gl_object
 {
+private:
+    // only set when the object has a vao of its own
+    std::unique_ptr<vertex_array_object> m_own_vao;
+
 public:
     window& _context;
-    vertex_array_object _vao;
+    vertex_array_object& _vao;
     program _prog;
 
-    gl_object(window& context) noexcept : _context(context), _vao(context.create_vao()), _prog(context.create_program()) {}
+    // with a vao of its own
+    gl_object(window& context) noexcept
+        : m_own_vao(new vertex_array_object(context.create_vao())), _context(context), _vao(*m_own_vao), _prog(context.create_program()) {}
+
+    // with a vao shared with other objects, ex: window::shared_vao
+    gl_object(window& context, vertex_array_object& shared_vao) noexcept
+        : _context(context), _vao(shared_vao), _prog(context.create_program()) {}
 };
 
 ////
@@ -57,28 +71,35 @@ public:
 
 struct rect
 {
-    gl_object _base_gl;
-    size_t m_indices_size;
+    // position and tex coord, compressed to 12 bytes from 20
+    // half float position and unorm16 tex coord, the shaders read them as vec3 and vec2 all the same
+    using format = vertex_format<half_float<glm::u16vec4>, normalized<glm::u16vec2>>;
 
-    rect(window& context) noexcept : _base_gl(context)
-    {
-        constexpr auto verts = utils::gen_rect_verts<3>(glm::vec3{-0.5f, -0.5f, 0.0f}, glm::vec3{0.5f, 0.5f, 0.0f});
-        constexpr auto tex_coords = utils::gen_rect_verts<2>(glm::vec2{0.0f}, glm::vec2{1.0f});
-        constexpr auto indices = utils::gen_rect_indices();
+    static constexpr auto verts = interleave(
+        compress_positions(utils::gen_rect_verts<3>(glm::vec3{-0.5f, -0.5f, 0.0f}, glm::vec3{0.5f, 0.5f, 0.0f})),
+        compress_texcoords(utils::gen_rect_verts<2>(glm::vec2{0.0f}, glm::vec2{1.0f}))
+    );
+    static constexpr auto indices = utils::gen_rect_indices();
 
-        _base_gl._vao.define_attrib(0, 0, 3, GL_FLOAT);
-        _base_gl._vao.define_attrib(1, 1, 2, GL_FLOAT);
+    gl_object _base_gl;
+    size_t m_indices_size;
 
-        _base_gl._vao.create_array_buffer(0, verts.size() * sizeof(glm::vec3), verts.data(), GL_MAP_READ_BIT);
-        _base_gl._vao.create_array_buffer(1, tex_coords.size() * sizeof(glm::vec2), tex_coords.data(), GL_MAP_READ_BIT);
+    buffer _vertices;
+    buffer _indices;
 
-        m_indices_size = indices.size();
-        _base_gl._vao.create_element_buffer(m_indices_size * sizeof(glm::uvec3), indices.data(), GL_MAP_READ_BIT);
+    // every rect shares the vao of its format and binds its own buffers when rendered
+    rect(window& context) noexcept
+        : _base_gl(context, context.shared_vao<format>()), m_indices_size(indices.size()),
+          _vertices(context.create_buffer(verts.size() * sizeof(format::vertex_type), verts.data(), GL_MAP_READ_BIT)),
+          _indices(context.create_buffer(indices.size() * sizeof(glm::uvec3), indices.data(), GL_MAP_READ_BIT))
+    {
     }
 
     void render() const noexcept
     {
-        _base_gl._vao.bind();
+        _base_gl._vao.bind_vertex_buffer(0, _vertices, format::stride);
+        _base_gl._vao.bind_element_buffer(_indices);
+        _base_gl._context.bind_vao(_base_gl._vao);
         _base_gl._prog.use();
 
         glDrawElements(GL_TRIANGLES, m_indices_size * sizeof(glm::uvec3) / sizeof(unsigned int), GL_UNSIGNED_INT, nullptr);
@@ -87,33 +108,40 @@ struct rect
 
 struct cube
 {
-    gl_object _base_gl;
-    size_t m_verts_size;
+    // position, normal and tex coord, compressed to 16 bytes from 32
+    // half float position, 10-10-10-2 normal and half float tex coord as the cubemap coords are outside [0, 1]
+    using format = vertex_format<half_float<glm::u16vec4>, snorm_10_10_10_2, half_float<glm::u16vec2>>;
+
+    // 4 vertices per face instead of 6, the corners shared by the two triangles are indexed twice
+    static constexpr auto verts = interleave(
+        compress_positions(utils::gen_cube_indexed_verts(glm::vec3{-0.5f}, glm::vec3{0.5f})),
+        compress_normals(utils::gen_cube_indexed_normals(glm::vec3{-0.5f}, glm::vec3{0.5f})),
+        compress_half(utils::gen_cube_indexed_texcoords())
+    );
+    static constexpr auto indices = utils::gen_cube_indices();
 
-    cube(window& context) noexcept : _base_gl(context)
-    {
-        constexpr auto verts = utils::gen_cube_verts(glm::vec3{-0.5f}, glm::vec3{0.5f});
-        constexpr auto normals = utils::gen_cube_normals(glm::vec3{-0.5f}, glm::vec3{0.5f});
-        constexpr auto tex_coords = utils::gen_cube_texcoords();
-
-        std::cout << "\n";
+    gl_object _base_gl;
+    size_t m_indices_size;
 
-        _base_gl._vao.define_attrib(0, 0, 3, GL_FLOAT);
-        _base_gl._vao.define_attrib(1, 1, 3, GL_FLOAT);
-        _base_gl._vao.define_attrib(2, 2, 2, GL_FLOAT);
+    buffer _vertices;
+    buffer _indices;
 
-        _base_gl._vao.create_array_buffer(0, verts.size() * sizeof(glm::vec3), verts.data(), GL_MAP_READ_BIT);
-        m_verts_size = verts.size();
-        _base_gl._vao.create_array_buffer(1, normals.size() * sizeof(glm::vec3), normals.data(), GL_MAP_READ_BIT);
-        _base_gl._vao.create_array_buffer(2, tex_coords.size() * sizeof(glm::vec2), tex_coords.data(), GL_MAP_READ_BIT);
+    // every cube shares the vao of its format and binds its own buffers when rendered
+    cube(window& context) noexcept
+        : _base_gl(context, context.shared_vao<format>()), m_indices_size(indices.size()),
+          _vertices(context.create_buffer(verts.size() * sizeof(format::vertex_type), verts.data(), GL_MAP_READ_BIT)),
+          _indices(context.create_buffer(indices.size() * sizeof(glm::uvec3), indices.data(), GL_MAP_READ_BIT))
+    {
     }
 
     void render() const noexcept
     {
-        _base_gl._vao.bind();
+        _base_gl._vao.bind_vertex_buffer(0, _vertices, format::stride);
+        _base_gl._vao.bind_element_buffer(_indices);
+        _base_gl._context.bind_vao(_base_gl._vao);
         _base_gl._prog.use();
 
-        glDrawArrays(GL_TRIANGLES, 0, m_verts_size);
+        glDrawElements(GL_TRIANGLES, m_indices_size * sizeof(glm::uvec3) / sizeof(unsigned int), GL_UNSIGNED_INT, nullptr);
     }
 };
 
@@ -221,6 +249,391 @@ struct dynamic_camera
     }
 };
 
+////
+// Terrain
+
+struct terrain_settings
+{
+    // the cells per side of a chunk at lod 0, a power of 2 of at least 2
+    size_t chunk_cells = 32;
+
+    // the distance between heightmap samples
+    float spacing = 1.0f;
+
+    // chunks closer than this use lod 0 and each lod after is used up to twice the distance of the one
+    // before. Set for a 90 degree fov, the distance grows as the camera zooms in so the detail stays the same
+    float lod_distance = 64.0f;
+
+    // the most vertex data the chunks keep on the gpu in bytes, the chunks seen the longest ago are
+    // evicted to make room
+    GLsizeiptr memory_budget = 32 << 20;
+
+    // the most chunks built and uploaded in one update so moving fast does not stall a frame
+    size_t max_uploads = 16;
+};
+
+struct terrain_stats
+{
+    size_t chunks = 0;
+    size_t visible = 0;
+
+    // visible chunks with vertices on the gpu which can be stitched to their neighbours, the rest are not drawn until they are uploaded
+    size_t drawn = 0;
+
+    size_t resident = 0;
+    GLsizeiptr resident_bytes = 0;
+
+    // in the last update
+    size_t uploads = 0;
+    size_t evictions = 0;
+};
+
+/**
+ * @brief A heightmap split into square chunks drawn with geomipmapping. Each update picks a lod for every
+ * chunk from its distance to the camera, culls the chunks outside the view and streams the vertices of
+ * the visible chunks into a buffer_arena at their lod under a memory budget. The indices of every lod and
+ * combination of coarser neighbours are made once and shared by all chunks.
+ * The vertices are laid out as mesh_format in world space from (0, 0, 0) to the far corner of the map.
+ *
+ */
+class terrain
+{
+private:
+    struct chunk
+    {
+        // the first sample
+        uint32_t x = 0;
+        uint32_t z = 0;
+
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+
+        float distance = 0.0f;
+        uint8_t lod = 0;
+        bool visible = false;
+
+        // the lod of the vertices on the gpu, -1 without any
+        int8_t resident_lod = -1;
+        buffer_arena::handle verts = buffer_arena::invalid_handle;
+        uint64_t last_visible = 0;
+
+        // visible, resident and no more than one lod coarser than its neighbours so its edges can be stitched
+        bool drawn = false;
+    };
+
+    // where the indices of a lod and its coarser edges are in m_indices
+    struct pattern
+    {
+        GLsizei first = 0;
+        GLsizei count = 0;
+    };
+
+    utils::heightmap m_map;
+    terrain_settings m_settings;
+
+    size_t m_chunks_x = 0;
+    size_t m_chunks_z = 0;
+    size_t m_lods = 0;
+
+    std::vector<chunk> m_chunks;
+    // indexed by lod * 16 + coarser edges
+    std::vector<pattern> m_patterns;
+
+    buffer m_indices;
+    buffer_arena m_arena;
+
+    // reused by every update
+    std::vector<uint32_t> m_builds;
+    std::vector<std::vector<utils::mesh_vertex>> m_staging;
+    std::vector<uint32_t> m_evictable;
+
+    uint64_t m_frame = 0;
+    terrain_stats m_stats;
+
+    // the arena is tried for defragmenting at most once in this many updates, the frame of the last try
+    static constexpr uint64_t defragment_interval = 120;
+    uint64_t m_last_defragment = 0;
+
+public:
+    gl_object _base_gl;
+
+    /**
+     * @brief Split the heightmap into chunks and make the shared indices. No vertices are uploaded until
+     * the first update.
+     *
+     * @param context The window.
+     * @param map The heightmap, its samples past the last whole chunk are not used.
+     * @param settings The chunk size, lod distance and memory budget.
+     */
+    terrain(window &context, utils::heightmap map, const terrain_settings &settings = {}) noexcept;
+
+    ~terrain() noexcept = default;
+
+    terrain(const terrain &) = delete;
+    terrain &operator=(const terrain &) = delete;
+
+    /**
+     * @brief Pick the lods and visible chunks for the camera and upload the chunks which changed, at most
+     * max_uploads of the closest ones. The vertices are generated on utils::job_pool::shared().
+     *
+     * @param pers_cam The projection, its zoom scales the lod distance.
+     * @param dyn_cam The view and position of the camera.
+     */
+    void update(const perspective_camera &pers_cam, const dynamic_camera &dyn_cam) noexcept;
+
+    /**
+     * @brief Draw the visible chunks with vertices on the gpu, one glDrawElementsBaseVertex each.
+     *
+     */
+    void render() const noexcept;
+
+    [[nodiscard]] inline const utils::heightmap &map() const noexcept { return m_map; }
+    [[nodiscard]] inline const terrain_stats &stats() const noexcept { return m_stats; }
+
+    // the number of lods, the coarsest has 2 * 2 cells per chunk
+    [[nodiscard]] inline size_t lods() const noexcept { return m_lods; }
+
+    /**
+     * @brief The height of the terrain under a point, between the samples. Ex: to keep the camera above it.
+     *
+     * @param x The x in world space.
+     * @param z The z in world space.
+     * @return float
+     */
+    [[nodiscard]] inline float height(float x, float z) const noexcept { return m_map.sample(x / m_settings.spacing, z / m_settings.spacing); }
+
+private:
+    // the settings with the chunk size rounded down to a power of 2
+    [[nodiscard]] static terrain_settings checked(terrain_settings settings) noexcept;
+
+    // the indices of every lod and combination of coarser edges
+    [[nodiscard]] static GLsizeiptr pattern_bytes(size_t chunk_cells, size_t lods) noexcept;
+
+    // make room for bytes more under the budget by evicting chunks which are not visible
+    bool reserve(GLsizeiptr bytes) noexcept;
+
+    void evict(chunk &c) noexcept;
+};
+
+////
+// Text
+
+struct text_settings
+{
+    // the size of the glyph atlas in pixels
+    int atlas_width = 1024;
+    int atlas_height = 1024;
+
+    // the most glyphs drawn in one render, the rest are dropped
+    size_t max_glyphs = 4096;
+
+    // draw signed distance field glyphs, one per codepoint scaled to every font height
+    bool sdf = false;
+    utils::sdf_settings sdf_glyphs{};
+};
+
+/**
+ * @brief Draws text with one instanced quad per glyph. The glyphs are rasterized once into a
+ * utils::glyph_atlas kept in a GL_R8 texture, and only the rect of the atlas with new glyphs is uploaded.
+ * Text which changes every frame, ex: a frame time readout, then only costs a layout and a write of its
+ * quads to the instance buffer.
+ * With text_settings::sdf the atlas holds distance fields which are drawn with sdf_frag_src, so text of
+ * any size and scale stays sharp from one glyph per codepoint. Save the atlas with atlas().save and load it
+ * before the first render to skip making the glyphs at startup.
+ * Draws with the shaders below unless _base_gl._prog is relinked with others using the same inputs.
+ *
+ */
+class text_renderer
+{
+private:
+    utils::glyph_atlas m_atlas;
+    texture m_texture;
+    buffer m_instances;
+
+    // the quads added since the last clear
+    std::vector<utils::glyph_quad> m_quads;
+    size_t m_max_glyphs;
+
+    std::array<int, 2> m_uniforms{-1, -1};
+
+public:
+    gl_object _base_gl;
+
+    // the quad corners come from gl_VertexID so only the instances have a buffer
+    static constexpr const char *vert_src = R"(#version 450 core
+
+layout (location = 0) in vec4 rect;
+layout (location = 1) in uvec4 atlas_rect;
+layout (location = 2) in vec4 color;
+
+uniform vec2 screen;
+uniform sampler2D atlas;
+
+out vec2 tex_coord;
+out vec4 glyph_color;
+
+void main()
+{
+    // a counter clockwise triangle strip over the rect
+    vec2 corner = vec2(gl_VertexID >> 1, gl_VertexID & 1);
+
+    vec2 pos = rect.xy + corner * rect.zw;
+    gl_Position = vec4(pos / screen * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);
+
+    tex_coord = (vec2(atlas_rect.xy) + corner * vec2(atlas_rect.zw)) / vec2(textureSize(atlas, 0));
+    glyph_color = color;
+}
+)";
+
+    static constexpr const char *frag_src = R"(#version 450 core
+
+in vec2 tex_coord;
+in vec4 glyph_color;
+
+uniform sampler2D atlas;
+
+out vec4 frag_color;
+
+void main()
+{
+    frag_color = vec4(glyph_color.rgb, glyph_color.a * texture(atlas, tex_coord).r);
+}
+)";
+
+    // the outline is at 0.5, smoothed over about a pixel of the screen at any scale
+    static constexpr const char *sdf_frag_src = R"(#version 450 core
+
+in vec2 tex_coord;
+in vec4 glyph_color;
+
+uniform sampler2D atlas;
+
+out vec4 frag_color;
+
+void main()
+{
+    float dist = texture(atlas, tex_coord).r;
+    float width = max(fwidth(dist), 1e-4);
+
+    frag_color = vec4(glyph_color.rgb, glyph_color.a * smoothstep(0.5 - width, 0.5 + width, dist));
+}
+)";
+
+    /**
+     * @brief Create the atlas texture, the instance buffer and the program.
+     *
+     * @param context The window.
+     * @param font A loaded font, it must outlive the renderer.
+     * @param settings The atlas size and the most glyphs drawn at once.
+     */
+    text_renderer(window &context, const utils::stb_true_type &font, const text_settings &settings = {}) noexcept;
+
+    ~text_renderer() noexcept = default;
+
+    text_renderer(const text_renderer &) = delete;
+    text_renderer &operator=(const text_renderer &) = delete;
+
+    /**
+     * @brief Lay out text to be drawn by the next render. The glyphs not in the atlas yet are rasterized.
+     *
+     * @param text The text, '\n' starts a new line.
+     * @param font_height The font height in pixels.
+     * @param position The top left of the text in pixels from the top left of the screen.
+     * @param color The color of the text.
+     * @return glm::vec2 The pen position after the last glyph. Ex: to add more text after it.
+     */
+    glm::vec2 add(std::string_view text, int font_height, glm::vec2 position, glm::vec4 color = glm::vec4{1.0f}) noexcept;
+
+    /**
+     * @brief Add the lines of a text_layout made with the same font, one under the other.
+     *
+     * @param lines The layout.
+     * @param position The top left of the first line in pixels from the top left of the screen.
+     * @param color The color of the text.
+     * @return glm::vec2 The pen position after the last glyph.
+     */
+    glm::vec2 add(const utils::text_layout &lines, glm::vec2 position, glm::vec4 color = glm::vec4{1.0f}) noexcept;
+
+    /**
+     * @brief Remove the text added so far. Ex: at the start of a frame when the text changes. Text kept
+     * across frames is drawn again by each render until render clears the atlas.
+     *
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Upload the new glyphs and the quads and draw the text added since the last clear in one
+     * instanced draw, blended and without depth testing. The blend, depth test and unit 0 texture state is
+     * restored after.
+     * If the atlas ran out of room it is cleared after the draw so the next frame rasterizes only the glyphs
+     * it uses, the glyphs which did not fit are missing for one frame. The text is cleared with it as its
+     * quads point into the old atlas, so text kept across frames has to be added again.
+     *
+     * @param screen_size The size of the framebuffer in pixels.
+     * @return true The atlas and the text were cleared.
+     * @return false The text is kept.
+     */
+    bool render(glm::vec2 screen_size) noexcept;
+
+    [[nodiscard]] inline const utils::glyph_atlas &atlas() const noexcept { return m_atlas; }
+
+    // Ex: to prepare, load or save the glyphs, the changes are uploaded by the next render
+    [[nodiscard]] inline utils::glyph_atlas &atlas() noexcept { return m_atlas; }
+    [[nodiscard]] inline size_t glyphs() const noexcept { return m_quads.size(); }
+};
+
+/**
+ * @brief A text kept in a GL_R8 texture of a fixed size. Ex: to draw on a rect or in a ui.
+ * The text is drawn into a utils::text_surface which redraws only the glyphs that changed, and only the
+ * rects it changed are uploaded with sub_image2d, so a label which changes a few characters every frame
+ * uploads those characters instead of the whole texture.
+ *
+ */
+class text_label
+{
+private:
+    utils::text_surface m_surface;
+    texture m_texture;
+
+    // the pixels uploaded by the last set_text or set_font_height
+    size_t m_uploaded = 0;
+
+public:
+    /**
+     * @brief Create the surface and its texture, both empty.
+     *
+     * @param context The window.
+     * @param font A loaded font, it must outlive the label.
+     * @param width The width of the texture in pixels.
+     * @param height The height of the texture in pixels.
+     * @param font_height The font height in pixels.
+     */
+    text_label(window &context, const utils::stb_true_type &font, int width, int height, int font_height) noexcept;
+
+    ~text_label() noexcept = default;
+
+    text_label(const text_label &) = delete;
+    text_label &operator=(const text_label &) = delete;
+
+    /**
+     * @brief Draw a new text and upload the rects which changed.
+     *
+     * @param text The text, '\n' starts a new line.
+     * @return true Some pixels changed.
+     */
+    bool set_text(std::string_view text) noexcept;
+
+    // draw the whole text again at another font height and upload it
+    void set_font_height(int font_height) noexcept;
+
+    [[nodiscard]] inline const utils::text_surface &surface() const noexcept { return m_surface; }
+    [[nodiscard]] inline texture &tex() noexcept { return m_texture; }
+    [[nodiscard]] inline size_t uploaded() const noexcept { return m_uploaded; }
+
+private:
+    void upload() noexcept;
+};
+
 } // namespace wrap_g
 
 #include "wrap_g_exp_impl.hpp"
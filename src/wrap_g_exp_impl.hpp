@@ -3,9 +3,465 @@
 
 namespace wrap_g
 {
-    
+    ////
+    // terrain
 
-    
+    terrain::terrain(window &context, utils::heightmap map, const terrain_settings &settings) noexcept
+        : m_map(std::move(map)), m_settings(checked(settings)),
+          m_chunks_x(m_map.valid() ? (m_map.width() - 1) / m_settings.chunk_cells : 0),
+          m_chunks_z(m_map.valid() ? (m_map.depth() - 1) / m_settings.chunk_cells : 0),
+          m_lods(std::bit_width(m_settings.chunk_cells) - 1),
+          m_indices(context.create_buffer(pattern_bytes(m_settings.chunk_cells, m_lods), nullptr, GL_DYNAMIC_STORAGE_BIT)),
+          m_arena(context.create_buffer_arena(std::min<GLsizeiptr>(m_settings.memory_budget, 4 << 20))),
+          _base_gl(context, context.shared_vao<mesh_format>())
+    {
+        const size_t cells = m_settings.chunk_cells;
+
+        if (m_chunks_x == 0 || m_chunks_z == 0)
+        {
+            context.log().error("[wrap_g] Error: Heightmap of {} x {} samples is smaller than a terrain chunk of {} cells.\n", m_map.width(), m_map.depth(), cells);
+            return;
+        }
+
+        // every lod with every combination of coarser edges, one after the other
+        std::vector<uint32_t> indices(pattern_bytes(cells, m_lods) / sizeof(uint32_t));
+        m_patterns.resize(m_lods * 16);
+
+        size_t used = 0;
+        for (size_t lod = 0; lod < m_lods; ++lod)
+        {
+            for (uint32_t edges = 0; edges < 16; ++edges)
+            {
+                size_t count = utils::gen_terrain_indices(cells, lod, edges, std::span<uint32_t>(indices).subspan(used));
+                m_patterns[lod * 16 + edges] = pattern{(GLsizei)used, (GLsizei)count};
+                used += count;
+            }
+        }
+
+        glNamedBufferSubData(m_indices.id(), 0, used * sizeof(uint32_t), indices.data());
+
+        m_chunks.resize(m_chunks_x * m_chunks_z);
+        for (size_t z = 0; z < m_chunks_z; ++z)
+        {
+            for (size_t x = 0; x < m_chunks_x; ++x)
+            {
+                chunk &c = m_chunks[z * m_chunks_x + x];
+                c.x = x * cells;
+                c.z = z * cells;
+
+                glm::vec2 heights = m_map.range(c.x, c.z, cells + 1, cells + 1);
+                c.min = glm::vec3{c.x * m_settings.spacing, heights.x, c.z * m_settings.spacing};
+                c.max = glm::vec3{(c.x + cells) * m_settings.spacing, heights.y, (c.z + cells) * m_settings.spacing};
+            }
+        }
+
+        m_stats.chunks = m_chunks.size();
+    }
+
+    terrain_settings terrain::checked(terrain_settings settings) noexcept
+    {
+        settings.chunk_cells = std::bit_floor(std::max<size_t>(settings.chunk_cells, 2));
+        settings.max_uploads = std::max<size_t>(settings.max_uploads, 1);
+        return settings;
+    }
+
+    GLsizeiptr terrain::pattern_bytes(size_t chunk_cells, size_t lods) noexcept
+    {
+        GLsizeiptr bytes = 0;
+        for (size_t lod = 0; lod < lods; ++lod)
+            bytes += 16 * utils::terrain_chunk_index_count(chunk_cells, lod) * sizeof(uint32_t);
+        return bytes;
+    }
+
+    void terrain::update(const perspective_camera &pers_cam, const dynamic_camera &dyn_cam) noexcept
+    {
+        ++m_frame;
+        m_stats.visible = m_stats.drawn = m_stats.uploads = m_stats.evictions = 0;
+
+        if (m_chunks.empty())
+            return;
+
+        // the planes of the view frustum, a box is outside if its corner furthest along a plane's normal is behind it
+        glm::mat4 view_proj = pers_cam.m_proj * dyn_cam.m_view;
+        std::array<glm::vec4, 6> planes;
+        for (int i = 0; i < 3; ++i)
+        {
+            glm::vec4 row{view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]};
+            glm::vec4 w{view_proj[0][3], view_proj[1][3], view_proj[2][3], view_proj[3][3]};
+            planes[i * 2] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+
+        // m_proj[1][1] is 1 at a 90 degree fov and grows as the fov shrinks
+        const float lod_distance = m_settings.lod_distance * pers_cam.m_proj[1][1];
+        const glm::vec3 eye = dyn_cam.m_pos;
+
+        for (auto &c : m_chunks)
+        {
+            c.distance = glm::length(eye - glm::clamp(eye, c.min, c.max));
+            c.lod = c.distance < lod_distance ? 0 : (uint8_t)std::min<size_t>(m_lods - 1, (size_t)std::log2(c.distance / lod_distance) + 1);
+
+            c.visible = true;
+            for (const auto &p : planes)
+            {
+                glm::vec3 far{p.x >= 0.0f ? c.max.x : c.min.x, p.y >= 0.0f ? c.max.y : c.min.y, p.z >= 0.0f ? c.max.z : c.min.z};
+                if (glm::dot(glm::vec3(p), far) + p.w < 0.0f)
+                {
+                    c.visible = false;
+                    break;
+                }
+            }
+
+            if (c.visible)
+            {
+                c.last_visible = m_frame;
+                ++m_stats.visible;
+            }
+        }
+
+        // neighbours may only differ by one lod for the edges to be stitched, the finer one wins
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t z = 0; z < m_chunks_z; ++z)
+            {
+                for (size_t x = 0; x < m_chunks_x; ++x)
+                {
+                    chunk &c = m_chunks[z * m_chunks_x + x];
+                    uint8_t finest = c.lod;
+                    if (x > 0) finest = std::min(finest, m_chunks[z * m_chunks_x + x - 1].lod);
+                    if (x + 1 < m_chunks_x) finest = std::min(finest, m_chunks[z * m_chunks_x + x + 1].lod);
+                    if (z > 0) finest = std::min(finest, m_chunks[(z - 1) * m_chunks_x + x].lod);
+                    if (z + 1 < m_chunks_z) finest = std::min(finest, m_chunks[(z + 1) * m_chunks_x + x].lod);
+
+                    if (c.lod > finest + 1)
+                    {
+                        c.lod = finest + 1;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // the closest visible chunks not at their lod yet
+        m_builds.clear();
+        for (uint32_t i = 0; i < m_chunks.size(); ++i)
+            if (m_chunks[i].visible && m_chunks[i].resident_lod != m_chunks[i].lod)
+                m_builds.push_back(i);
+
+        size_t builds = std::min(m_builds.size(), m_settings.max_uploads);
+        std::partial_sort(m_builds.begin(), m_builds.begin() + builds, m_builds.end(), [this](uint32_t a, uint32_t b) {
+            return m_chunks[a].distance < m_chunks[b].distance;
+        });
+        m_builds.resize(builds);
+
+        // the least recently seen chunks are evicted first
+        m_evictable.clear();
+        for (uint32_t i = 0; i < m_chunks.size(); ++i)
+            if (!m_chunks[i].visible && m_chunks[i].resident_lod >= 0)
+                m_evictable.push_back(i);
+
+        std::sort(m_evictable.begin(), m_evictable.end(), [this](uint32_t a, uint32_t b) {
+            return m_chunks[a].last_visible > m_chunks[b].last_visible;
+        });
+
+        // generate on the pool and upload here as only this thread has the context
+        if (m_staging.size() < builds)
+            m_staging.resize(builds);
+
+        utils::job_pool::shared().parallel_for(builds, 1, [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const chunk &c = m_chunks[m_builds[i]];
+                m_staging[i].resize(utils::terrain_chunk_vertex_count(m_settings.chunk_cells, c.lod));
+                (void)utils::gen_terrain_chunk(m_map, c.x, c.z, m_settings.chunk_cells, c.lod, m_settings.spacing, m_staging[i]);
+            }
+        });
+
+        for (size_t i = 0; i < builds; ++i)
+        {
+            chunk &c = m_chunks[m_builds[i]];
+            const auto &verts = m_staging[i];
+
+            GLsizeiptr old = c.resident_lod >= 0 ? m_arena.get(c.verts).size : 0;
+            if (!reserve((GLsizeiptr)(verts.size() * sizeof(utils::mesh_vertex)) - old))
+                break;
+
+            if (c.resident_lod >= 0)
+                m_arena.free(c.verts);
+
+            c.verts = m_arena.allocate(verts.data(), verts.size());
+            c.resident_lod = c.verts != buffer_arena::invalid_handle ? (int8_t)c.lod : -1;
+            m_stats.uploads += c.resident_lod >= 0;
+        }
+
+        // compact the blocks once they are mostly empty, the ranges are read again when drawn. It does nothing
+        // unless a block is freed, and is only tried every so often as the arena stays half empty when it fails
+        if (m_arena.blocks() > 1 && m_arena.used() * 2 < m_arena.capacity() && m_frame - m_last_defragment >= defragment_interval)
+        {
+            (void)m_arena.defragment();
+            m_last_defragment = m_frame;
+        }
+
+        // the resident lods lag the lods when the uploads run out, a chunk more than one lod coarser than a
+        // neighbour would crack against it so it is left out until either is rebuilt, which leaves a gap for
+        // a few frames instead. the finest chunks always pass so the drawn ones differ by at most one lod
+        auto resident_lod = [this](size_t x, size_t z) {
+            const chunk &c = m_chunks[z * m_chunks_x + x];
+            return c.visible && c.resident_lod >= 0 ? c.resident_lod : (int8_t)INT8_MAX;
+        };
+
+        m_stats.resident = 0;
+        for (size_t z = 0; z < m_chunks_z; ++z)
+        {
+            for (size_t x = 0; x < m_chunks_x; ++x)
+            {
+                chunk &c = m_chunks[z * m_chunks_x + x];
+                m_stats.resident += c.resident_lod >= 0;
+
+                int finest = INT8_MAX;
+                if (x > 0) finest = std::min<int>(finest, resident_lod(x - 1, z));
+                if (x + 1 < m_chunks_x) finest = std::min<int>(finest, resident_lod(x + 1, z));
+                if (z > 0) finest = std::min<int>(finest, resident_lod(x, z - 1));
+                if (z + 1 < m_chunks_z) finest = std::min<int>(finest, resident_lod(x, z + 1));
+
+                c.drawn = c.visible && c.resident_lod >= 0 && c.resident_lod <= finest + 1;
+                m_stats.drawn += c.drawn;
+            }
+        }
+        m_stats.resident_bytes = m_arena.used();
+    }
+
+    bool terrain::reserve(GLsizeiptr bytes) noexcept
+    {
+        while (m_arena.used() + bytes > m_settings.memory_budget)
+        {
+            if (m_evictable.empty())
+                return false;
+
+            evict(m_chunks[m_evictable.back()]);
+            m_evictable.pop_back();
+        }
+
+        return true;
+    }
+
+    void terrain::evict(chunk &c) noexcept
+    {
+        m_arena.free(c.verts);
+        c.verts = buffer_arena::invalid_handle;
+        c.resident_lod = -1;
+        ++m_stats.evictions;
+    }
+
+    void terrain::render() const noexcept
+    {
+        if (m_chunks.empty())
+            return;
+
+        _base_gl._vao.bind_element_buffer(m_indices);
+        _base_gl._context.bind_vao(_base_gl._vao);
+        _base_gl._prog.use();
+
+        // the lod drawn by a neighbour, -1 if it is not drawn and its edge does not matter
+        auto drawn_lod = [this](size_t x, size_t z) {
+            const chunk &c = m_chunks[z * m_chunks_x + x];
+            return c.drawn ? c.resident_lod : (int8_t)-1;
+        };
+
+        for (size_t z = 0; z < m_chunks_z; ++z)
+        {
+            for (size_t x = 0; x < m_chunks_x; ++x)
+            {
+                const chunk &c = m_chunks[z * m_chunks_x + x];
+                if (!c.drawn)
+                    continue;
+
+                uint32_t edges = 0;
+                if (x > 0 && drawn_lod(x - 1, z) > c.resident_lod) edges |= utils::TERRAIN_NEG_X;
+                if (x + 1 < m_chunks_x && drawn_lod(x + 1, z) > c.resident_lod) edges |= utils::TERRAIN_POS_X;
+                if (z > 0 && drawn_lod(x, z - 1) > c.resident_lod) edges |= utils::TERRAIN_NEG_Z;
+                if (z + 1 < m_chunks_z && drawn_lod(x, z + 1) > c.resident_lod) edges |= utils::TERRAIN_POS_Z;
+
+                const pattern &p = m_patterns[c.resident_lod * 16 + edges];
+                auto range = m_arena.get(c.verts);
+
+                _base_gl._vao.bind_vertex_buffer(0, *range.buf, sizeof(utils::mesh_vertex));
+                glDrawElementsBaseVertex(GL_TRIANGLES, p.count, GL_UNSIGNED_INT, (const void *)(p.first * sizeof(uint32_t)), range.first(sizeof(utils::mesh_vertex)));
+            }
+        }
+    }
+
+    ////
+    // text renderer
+
+    text_renderer::text_renderer(window &context, const utils::stb_true_type &font, const text_settings &settings) noexcept
+        : m_atlas(settings.sdf ? utils::glyph_atlas(font, settings.sdf_glyphs, settings.atlas_width, settings.atlas_height)
+                               : utils::glyph_atlas(font, settings.atlas_width, settings.atlas_height)),
+          m_texture(context.create_texture(GL_TEXTURE_2D)),
+          m_instances(context.create_buffer(std::max<size_t>(settings.max_glyphs, 1) * sizeof(utils::glyph_quad), nullptr, GL_DYNAMIC_STORAGE_BIT)),
+          m_max_glyphs(std::max<size_t>(settings.max_glyphs, 1)), _base_gl(context, context.shared_vao<glyph_format>())
+    {
+        m_quads.reserve(m_max_glyphs);
+
+        // one quad per instance
+        _base_gl._vao.set_binding_divisor(0, 1);
+
+        m_texture.define_texture2d(1, GL_R8, m_atlas.width(), m_atlas.height());
+        m_texture.set_param(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        m_texture.set_param(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        m_texture.set_param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_texture.set_param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // start empty, the glyphs are uploaded as they are added
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        m_texture.sub_image2d(0, 0, 0, m_atlas.width(), m_atlas.height(), GL_RED, GL_UNSIGNED_BYTE, m_atlas.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        bool success = _base_gl._prog.quick<const char *>({
+            {GL_VERTEX_SHADER, {vert_src}},
+            {GL_FRAGMENT_SHADER, {m_atlas.sdf() ? sdf_frag_src : frag_src}}
+        });
+
+        if (!success)
+        {
+            context.log().error("[wrap_g] Error: Failed to create the text program.\n");
+            return;
+        }
+
+        m_uniforms = _base_gl._prog.uniform_locations("screen", "atlas");
+        _base_gl._prog.set_uniform(m_uniforms[1], 0);
+    }
+
+    glm::vec2 text_renderer::add(std::string_view text, int font_height, glm::vec2 position, glm::vec4 color) noexcept
+    {
+        glm::u8vec4 packed = glm::u8vec4(glm::round(glm::clamp(color, glm::vec4{0.0f}, glm::vec4{1.0f}) * 255.0f));
+        return m_atlas.layout(text, font_height, position, packed, m_quads);
+    }
+
+    glm::vec2 text_renderer::add(const utils::text_layout &lines, glm::vec2 position, glm::vec4 color) noexcept
+    {
+        glm::u8vec4 packed = glm::u8vec4(glm::round(glm::clamp(color, glm::vec4{0.0f}, glm::vec4{1.0f}) * 255.0f));
+        return m_atlas.layout(lines, position, packed, m_quads);
+    }
+
+    void text_renderer::clear() noexcept
+    {
+        m_quads.clear();
+    }
+
+    bool text_renderer::render(glm::vec2 screen_size) noexcept
+    {
+        // only the rect with new glyphs, read from the rows of the whole atlas
+        auto dirty = m_atlas.take_dirty();
+        if (!dirty.empty())
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, m_atlas.width());
+            m_texture.sub_image2d(0, dirty.x, dirty.y, dirty.width, dirty.height, GL_RED, GL_UNSIGNED_BYTE,
+                m_atlas.data() + (size_t)dirty.y * m_atlas.width() + dirty.x);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+
+        const size_t count = std::min(m_quads.size(), m_max_glyphs);
+        if (count != 0)
+        {
+            glNamedBufferSubData(m_instances.id(), 0, count * sizeof(utils::glyph_quad), m_quads.data());
+
+            _base_gl._vao.bind_vertex_buffer(0, m_instances, glyph_format::stride);
+            _base_gl._context.bind_vao(_base_gl._vao);
+            _base_gl._prog.use();
+            _base_gl._prog.set_uniform_vec<2>(m_uniforms[0], glm::value_ptr(screen_size));
+
+            // the scene's texture on unit 0 is put back after, like the blend and depth state
+            GLint active_unit = 0, unit_texture = 0;
+            glGetIntegerv(GL_ACTIVE_TEXTURE, &active_unit);
+            glActiveTexture(GL_TEXTURE0);
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &unit_texture);
+            glActiveTexture(active_unit);
+            m_texture.bind_unit(0);
+
+            const bool blend = glIsEnabled(GL_BLEND), depth_test = glIsEnabled(GL_DEPTH_TEST);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glDisable(GL_DEPTH_TEST);
+
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+
+            if (!blend)
+                glDisable(GL_BLEND);
+            if (depth_test)
+                glEnable(GL_DEPTH_TEST);
+            glBindTextureUnit(0, unit_texture);
+        }
+
+        // the glyphs of this frame did not all fit, start over with only the glyphs the next frame uses
+        // the quads hold rects in the old atlas so they go too
+        if (m_atlas.full())
+        {
+#if WRAP_G_DEBUG
+            _base_gl._context.log().debug("[wrap_g] Debug: Glyph atlas is full, clearing it.\n");
+#endif
+            m_atlas.clear();
+            m_quads.clear();
+            return true;
+        }
+
+        return false;
+    }
+
+    ////
+    // text label
+
+    text_label::text_label(window &context, const utils::stb_true_type &font, int width, int height, int font_height) noexcept
+        : m_surface(font, width, height, font_height), m_texture(context.create_texture(GL_TEXTURE_2D))
+    {
+        m_texture.define_texture2d(1, GL_R8, std::max(m_surface.width(), 1), std::max(m_surface.height(), 1));
+        m_texture.set_param(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        m_texture.set_param(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        m_texture.set_param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_texture.set_param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // the surface starts dirty so the texture starts empty instead of undefined
+        upload();
+    }
+
+    bool text_label::set_text(std::string_view text) noexcept
+    {
+        bool changed = m_surface.update(text);
+        upload();
+        return changed;
+    }
+
+    void text_label::set_font_height(int font_height) noexcept
+    {
+        m_surface.set_font_height(font_height);
+        upload();
+    }
+
+    void text_label::upload() noexcept
+    {
+        m_uploaded = 0;
+        if (m_surface.dirty().empty())
+            return;
+
+        // each rect is read from the rows of the whole surface
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, m_surface.width());
+
+        for (const auto &r : m_surface.dirty())
+        {
+            m_texture.sub_image2d(0, r.x, r.y, r.width, r.height, GL_RED, GL_UNSIGNED_BYTE,
+                m_surface.data() + (size_t)r.y * m_surface.width() + r.x);
+            m_uploaded += (size_t)r.width * r.height;
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        m_surface.clear_dirty();
+    }
 } // namespace wrap_g
 
-#endif
\ No newline at end of file
+#endif
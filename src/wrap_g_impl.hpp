@@ -28,11 +28,11 @@ namespace wrap_g
     // wrap_g
 
     wrap_g::wrap_g(std::ostream &out) noexcept
-        : m_out(out)
+        : m_log(out)
     {
         if (!glfwInit())
         {
-            m_out << "[wrap_g] Error: Failed to initialize glfw.\n";
+            m_log.error("[wrap_g] Error: Failed to initialize glfw.\n");
             return;
         }
 
@@ -64,7 +64,7 @@ namespace wrap_g
         m_init = true;
 
 #if WRAP_G_DEBUG
-        m_out << "[wrap_g] Debug: Initialized glfw.\n";
+        m_log.debug("[wrap_g] Debug: Initialized glfw.\n");
 #endif
     }
 
@@ -74,10 +74,15 @@ namespace wrap_g
         glfwTerminate();
 
 #if WRAP_G_DEBUG
-        m_out << "[wrap_g] Debug: Terminated glfw.\n";
+        m_log.debug("[wrap_g] Debug: Terminated glfw.\n");
 #endif
     }
 
+    void wrap_g::set_window_hint(int hint, int value) noexcept
+    {
+        glfwWindowHint(hint, value);
+    }
+
     window wrap_g::create_window(GLint width, GLint height, const GLchar *title, bool fullscreen) noexcept
     {
         // simply create a window object
@@ -107,11 +112,14 @@ namespace wrap_g
 
     window::~window()
     {
+        // the shared vaos need the context so delete them before it is destroyed
+        m_shared_vaos.clear();
+
         // destroy the window 
         glfwDestroyWindow(m_win);
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Destroyed window.\n";
+        __graphics.log().debug("[wrap_g] Debug: Destroyed window.\n");
 #endif
     }
 
@@ -124,7 +132,7 @@ namespace wrap_g
         // check whether the window was actually created
         if (m_win == nullptr)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create window.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create window.\n");
             return;
         }
         // make it the current context in this thread
@@ -133,120 +141,15 @@ namespace wrap_g
         // make sure glad is loaded properly
         if (!check_glad())
         {
-            __graphics.out() << "[wrap_g] Error: Failed to initialize glad.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to initialize glad.\n");
             return;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created window.\n";
+        __graphics.log().debug("[wrap_g] Debug: Created window.\n");
 #endif
 #if WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL
-        // check whether debug context was activated
-        int flags;
-        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
-        if (flags & GL_CONTEXT_FLAG_DEBUG_BIT)
-        {
-            // enable the debug output
-            glEnable(GL_DEBUG_OUTPUT);
-
-            // make the output synchron6ous
-            // so the output commands are called immediately
-            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-
-            // allow all debug messages
-            // this function can be used to control debug outputs
-            // for sources, types, severity
-            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true);
-            
-            // actual debug message output function
-            glDebugMessageCallback([](GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei llength, const GLchar* message, const void *user_param){
-                std::stringstream ss;
-
-                switch (source)
-                {
-                case GL_DEBUG_SOURCE_API:
-                    ss << "[opengl api] ";
-                    break;
-                case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-                    ss << "[window system] ";
-                    break;
-                case GL_DEBUG_SOURCE_SHADER_COMPILER:
-                    ss << "[shader compiler] ";
-                    break;
-                case GL_DEBUG_SOURCE_THIRD_PARTY:
-                    ss << "[third party] ";
-                    break;
-                case GL_DEBUG_SOURCE_APPLICATION:
-                    ss << "[application] ";
-                    break;
-                case GL_DEBUG_SOURCE_OTHER:
-                    ss << "[other] ";
-                    break;
-                case GL_DONT_CARE:
-                default:
-                    ss << "[unknown] ";
-                    break;
-                }
-                
-                switch (type)
-                {
-                    case GL_DEBUG_TYPE_ERROR:
-                        ss << "(Error) ";
-                        break;
-                    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-                        ss << "(Deprecated) ";
-                        break;
-                    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-                        ss << "(Undefined) ";
-                        break;
-                    case GL_DEBUG_TYPE_PORTABILITY:
-                        ss << "(Portability) ";
-                        break;
-                    case GL_DEBUG_TYPE_PERFORMANCE:
-                        ss << "(Performance) ";
-                        break;
-                    case GL_DEBUG_TYPE_MARKER:
-                        ss << "(Marker) ";
-                        break;
-                    case GL_DEBUG_TYPE_PUSH_GROUP:
-                        ss << "(Push Group) ";
-                        break;
-                    case GL_DEBUG_TYPE_POP_GROUP:
-                        ss << "(Pop Group) ";
-                        break;
-                    case GL_DEBUG_TYPE_OTHER:
-                        ss << "(Other) ";
-                        break;
-                    case GL_DONT_CARE:
-                    default:
-                        ss << "(Unknown) ";
-                        break;
-                }
-
-                switch (severity)
-                {
-                case GL_DEBUG_SEVERITY_NOTIFICATION:
-                    ss << "notify ";
-                    break;
-                case GL_DEBUG_SEVERITY_LOW:
-                    ss << "info ";
-                    break;
-                case GL_DEBUG_SEVERITY_MEDIUM:
-                    ss << "medium ";
-                    break;
-                case GL_DEBUG_SEVERITY_HIGH:
-                    ss << "IMPORTANT ";
-                    break;
-                case GL_DONT_CARE:
-                default:
-                    ss << "unknown ";
-                    break;
-                }
-
-                // possibly use userid to block messages
-                std::cout << ss.str() << "#" << id << " : " << message << "\n";
-            }, nullptr);
-        }
+        enable_debug_output();
 #endif
     }
 
@@ -256,7 +159,7 @@ namespace wrap_g
         // check whether the shared context window is empty
         if (win.win() == nullptr)
         {
-            __graphics.out() << "[wrap_g] Error: Shared resources context is empty.\n";
+            __graphics.log().error("[wrap_g] Error: Shared resources context is empty.\n");
             return;
         }
         
@@ -266,7 +169,7 @@ namespace wrap_g
         // check whether the window was actually created
         if (m_win == nullptr)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create window.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create window.\n");
             return;
         }
         // make it the current context in this thread
@@ -275,125 +178,202 @@ namespace wrap_g
         // make sure glad is loaded properly
         if (!check_glad())
         {
-            __graphics.out() << "[wrap_g] Error: Failed to initialize glad.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to initialize glad.\n");
             return;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created window.\n";
+        __graphics.log().debug("[wrap_g] Debug: Created window.\n");
+#endif
+#if WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL
+        enable_debug_output();
 #endif
+    }
+
 #if WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL
+    void window::enable_debug_output() noexcept
+    {
         // check whether debug context was activated
         int flags;
         glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
-        if (flags & GL_CONTEXT_FLAG_DEBUG_BIT)
-        {
-            // enable the debug output
-            glEnable(GL_DEBUG_OUTPUT);
+        if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+            return;
 
-            // make the output synchron6ous
-            // so the output commands are called immediately
-            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        // enable the debug output
+        glEnable(GL_DEBUG_OUTPUT);
 
-            // allow all debug messages
-            // this function can be used to control debug outputs
-            // for sources, types, severity
-            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true);
-            
-            // actual debug message output function
-            glDebugMessageCallback([](GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei llength, const GLchar* message, const void *user_param){
-                std::stringstream ss;
+        // make the output synchronous
+        // so the output commands are called immediately
+        // * set_debug_output can turn this off
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 
-                switch (source)
-                {
-                case GL_DEBUG_SOURCE_API:
-                    ss << "[opengl api] ";
-                    break;
-                case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-                    ss << "[window system] ";
-                    break;
-                case GL_DEBUG_SOURCE_SHADER_COMPILER:
-                    ss << "[shader compiler] ";
-                    break;
-                case GL_DEBUG_SOURCE_THIRD_PARTY:
-                    ss << "[third party] ";
-                    break;
-                case GL_DEBUG_SOURCE_APPLICATION:
-                    ss << "[application] ";
-                    break;
-                case GL_DEBUG_SOURCE_OTHER:
-                    ss << "[other] ";
-                    break;
-                case GL_DONT_CARE:
-                default:
-                    ss << "[unknown] ";
-                    break;
-                }
-                
-                switch (type)
-                {
-                    case GL_DEBUG_TYPE_ERROR:
-                        ss << "(Error) ";
-                        break;
-                    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-                        ss << "(Deprecated) ";
-                        break;
-                    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-                        ss << "(Undefined) ";
-                        break;
-                    case GL_DEBUG_TYPE_PORTABILITY:
-                        ss << "(Portability) ";
-                        break;
-                    case GL_DEBUG_TYPE_PERFORMANCE:
-                        ss << "(Performance) ";
-                        break;
-                    case GL_DEBUG_TYPE_MARKER:
-                        ss << "(Marker) ";
-                        break;
-                    case GL_DEBUG_TYPE_PUSH_GROUP:
-                        ss << "(Push Group) ";
-                        break;
-                    case GL_DEBUG_TYPE_POP_GROUP:
-                        ss << "(Pop Group) ";
-                        break;
-                    case GL_DEBUG_TYPE_OTHER:
-                        ss << "(Other) ";
-                        break;
-                    case GL_DONT_CARE:
-                    default:
-                        ss << "(Unknown) ";
-                        break;
-                }
+        // allow all debug messages
+        // this function can be used to control debug outputs
+        // for sources, types, severity
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true);
 
-                switch (severity)
-                {
-                case GL_DEBUG_SEVERITY_NOTIFICATION:
-                    ss << "notify ";
-                    break;
-                case GL_DEBUG_SEVERITY_LOW:
-                    ss << "info ";
-                    break;
-                case GL_DEBUG_SEVERITY_MEDIUM:
-                    ss << "medium ";
-                    break;
-                case GL_DEBUG_SEVERITY_HIGH:
-                    ss << "IMPORTANT ";
-                    break;
-                case GL_DONT_CARE:
-                default:
-                    ss << "unknown ";
-                    break;
-                }
+        // actual debug message output function
+        glDebugMessageCallback(debug_message_callback, this);
+    }
 
-                // possibly use userid to block messages
-                std::cout << ss.str() << "#" << id << " : " << message << "\n";
-            }, nullptr);
+    void window::debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *user_param) noexcept
+    {
+        auto &win = *static_cast<window *>(const_cast<void *>(user_param));
+
+        // length excludes the null terminator
+        std::string_view text(message, length > 0 ? (size_t)length : std::strlen(message));
+
+        // the collector is made before the output is set to BATCHED and kept until the window is destroyed
+        if (win.m_debug_output.load(std::memory_order_acquire) == debug_output::BATCHED)
+            win.m_debug_collector->push(source, type, id, severity, text);
+        else
+            log_debug_message(win.__graphics.log(), source, type, id, severity, text);
+    }
+#endif
+
+    void window::log_debug_message(utils::logger &log, GLenum source, GLenum type, GLuint id, GLenum severity, std::string_view text) noexcept
+    {
+
+        const char *source_name;
+        switch (source)
+        {
+        case GL_DEBUG_SOURCE_API:
+            source_name = "[opengl api] ";
+            break;
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+            source_name = "[window system] ";
+            break;
+        case GL_DEBUG_SOURCE_SHADER_COMPILER:
+            source_name = "[shader compiler] ";
+            break;
+        case GL_DEBUG_SOURCE_THIRD_PARTY:
+            source_name = "[third party] ";
+            break;
+        case GL_DEBUG_SOURCE_APPLICATION:
+            source_name = "[application] ";
+            break;
+        case GL_DEBUG_SOURCE_OTHER:
+            source_name = "[other] ";
+            break;
+        case GL_DONT_CARE:
+        default:
+            source_name = "[unknown] ";
+            break;
+        }
+
+        const char *type_name;
+        switch (type)
+        {
+        case GL_DEBUG_TYPE_ERROR:
+            type_name = "(Error) ";
+            break;
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+            type_name = "(Deprecated) ";
+            break;
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+            type_name = "(Undefined) ";
+            break;
+        case GL_DEBUG_TYPE_PORTABILITY:
+            type_name = "(Portability) ";
+            break;
+        case GL_DEBUG_TYPE_PERFORMANCE:
+            type_name = "(Performance) ";
+            break;
+        case GL_DEBUG_TYPE_MARKER:
+            type_name = "(Marker) ";
+            break;
+        case GL_DEBUG_TYPE_PUSH_GROUP:
+            type_name = "(Push Group) ";
+            break;
+        case GL_DEBUG_TYPE_POP_GROUP:
+            type_name = "(Pop Group) ";
+            break;
+        case GL_DEBUG_TYPE_OTHER:
+            type_name = "(Other) ";
+            break;
+        case GL_DONT_CARE:
+        default:
+            type_name = "(Unknown) ";
+            break;
         }
+
+        // the message is copied by the logger
+        // the severity picks the log level so notifications can be filtered out
+        constexpr const char *format = "{}{}{}#{} : {}\n";
+        switch (severity)
+        {
+        case GL_DEBUG_SEVERITY_NOTIFICATION:
+            log.debug(format, source_name, type_name, "notify ", id, text);
+            break;
+        case GL_DEBUG_SEVERITY_LOW:
+            log.info(format, source_name, type_name, "info ", id, text);
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            log.warning(format, source_name, type_name, "medium ", id, text);
+            break;
+        case GL_DEBUG_SEVERITY_HIGH:
+            log.error(format, source_name, type_name, "IMPORTANT ", id, text);
+            break;
+        case GL_DONT_CARE:
+        default:
+            log.info(format, source_name, type_name, "unknown ", id, text);
+            break;
+        }
+    }
+
+    void window::set_debug_output(debug_output mode) noexcept
+    {
+#if WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL
+        if (mode == debug_output::BATCHED && m_debug_collector == nullptr)
+            m_debug_collector = std::make_unique<debug_collector>();
+
+        glfwMakeContextCurrent(m_win);
+
+        // the driver may call the callback from its own threads once the output is not synchronous
+        if (mode == debug_output::SYNCHRONOUS)
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        else
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+        m_debug_output.store(mode, std::memory_order_release);
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Set debug output to {}.\n",
+            mode == debug_output::SYNCHRONOUS ? "synchronous" : mode == debug_output::ASYNCHRONOUS ? "asynchronous" : "batched");
 #endif
+#else
+        (void)mode;
+#endif
+    }
+
+    void window::collect_debug_messages(utils::metrics *tracker) noexcept
+    {
+        if (m_debug_output.load(std::memory_order_relaxed) != debug_output::BATCHED)
+            return;
+
+        auto batch = m_debug_collector->collect(__graphics.log());
+
+        if (tracker == nullptr)
+            return;
+
+        tracker->track_count("gl messages", batch.messages);
+        tracker->track_count("gl performance messages", batch.performance);
+        tracker->track_count("gl high severity messages", batch.severity[3]);
+    }
+
+    [[nodiscard]] inline bool window::get_should_close() const noexcept
+    {
+        // a replayed input log that has run out also closes the window
+        // so replays end on the same frame every time
+        return glfwWindowShouldClose(m_win) || (m_input != nullptr && m_input->finished());
     }
 
     [[nodiscard]] inline std::pair<double, double> window::get_cursor_position() const noexcept
     {
+        // the recorder holds the cursor as seen through the recorded events
+        if (m_input != nullptr)
+            return m_input->cursor_position();
+
         // get the current position of the cursor
         // just retreives the values from the inner glfw
         // function
@@ -402,6 +382,22 @@ namespace wrap_g
         return pos;
     }
 
+    [[nodiscard]] inline int window::get_mouse_button(int button) const noexcept
+    {
+        if (m_input != nullptr)
+            return m_input->mouse_button(button);
+
+        return glfwGetMouseButton(m_win, button);
+    }
+
+    [[nodiscard]] inline int window::get_key(int key) const noexcept
+    {
+        if (m_input != nullptr)
+            return m_input->key(key);
+
+        return glfwGetKey(m_win, key);
+    }
+
     template <typename Fn>
     requires FramebufferSizeCallback<Fn>
     void window::set_framebuffer_size_callback(Fn fn) noexcept
@@ -415,27 +411,129 @@ namespace wrap_g
     requires KeyCallback<Fn>
     void window::set_key_callback(Fn fn) noexcept
     {
+        // keep the callback so recorded input can be forwarded to it
+        m_key_callback = fn;
+
         // set the key callback
         // just forwards to inner glfw function
-        glfwSetKeyCallback(m_win, fn);
+        // unless the recorder hook is already installed
+        if (m_input == nullptr)
+            glfwSetKeyCallback(m_win, m_key_callback);
     }
 
     template <typename Fn>
     requires CursorPositionCallback<Fn>
     void window::set_cursor_position_callback(Fn fn) noexcept
     {
+        m_cursor_position_callback = fn;
+
         // set the cursor position callback
         // also forwards to inner glfw function
-        glfwSetCursorPosCallback(m_win, fn);
+        if (m_input == nullptr)
+            glfwSetCursorPosCallback(m_win, m_cursor_position_callback);
     }
 
     template <typename Fn>
     requires MouseButtonCallback<Fn>
     void window::set_mouse_button_callback(Fn fn) noexcept
     {
+        m_mouse_button_callback = fn;
+
         // set the mouse button callback
         // also forwards to inner glfw function
-        glfwSetMouseButtonCallback(m_win, fn);
+        if (m_input == nullptr)
+            glfwSetMouseButtonCallback(m_win, m_mouse_button_callback);
+    }
+
+    template <typename Fn>
+    requires ScrollCallback<Fn>
+    void window::set_scroll_callback(Fn fn) noexcept
+    {
+        m_scroll_callback = fn;
+
+        // set the scroll callback
+        // also forwards to inner glfw function
+        if (m_input == nullptr)
+            glfwSetScrollCallback(m_win, m_scroll_callback);
+    }
+
+    void window::set_input_recorder(input_recorder &input) noexcept
+    {
+        m_input = &input;
+
+        // the hooks find this window through the glfw user pointer
+        // the window is never moved after creation so the pointer stays valid
+        glfwSetWindowUserPointer(m_win, this);
+
+        glfwSetKeyCallback(m_win, key_callback_hook);
+        glfwSetMouseButtonCallback(m_win, mouse_button_callback_hook);
+        glfwSetCursorPosCallback(m_win, cursor_position_callback_hook);
+        glfwSetScrollCallback(m_win, scroll_callback_hook);
+
+        // log where the cursor starts so a replay begins from the same state
+        if (m_input->recording())
+        {
+            double x, y;
+            glfwGetCursorPos(m_win, &x, &y);
+            m_input->record({.type = input_recorder::event_type::CURSOR_POSITION, .x = x, .y = y});
+        }
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Set input recorder, {} {} events.\n", m_input->replaying() ? "replaying" : "recording", m_input->size());
+#endif
+    }
+
+    void window::key_callback_hook(GLFWwindow *win, int key, int scancode, int action, int mods) noexcept
+    {
+        auto *self = static_cast<window *>(glfwGetWindowUserPointer(win));
+
+        // live input is dropped while replaying
+        if (self->m_input->replaying())
+            return;
+
+        self->m_input->record({.type = input_recorder::event_type::KEY, .code = key, .scancode = scancode, .action = action, .mods = mods});
+
+        if (self->m_key_callback != nullptr)
+            self->m_key_callback(win, key, scancode, action, mods);
+    }
+
+    void window::mouse_button_callback_hook(GLFWwindow *win, int button, int action, int mods) noexcept
+    {
+        auto *self = static_cast<window *>(glfwGetWindowUserPointer(win));
+
+        if (self->m_input->replaying())
+            return;
+
+        self->m_input->record({.type = input_recorder::event_type::MOUSE_BUTTON, .code = button, .action = action, .mods = mods});
+
+        if (self->m_mouse_button_callback != nullptr)
+            self->m_mouse_button_callback(win, button, action, mods);
+    }
+
+    void window::cursor_position_callback_hook(GLFWwindow *win, double x, double y) noexcept
+    {
+        auto *self = static_cast<window *>(glfwGetWindowUserPointer(win));
+
+        if (self->m_input->replaying())
+            return;
+
+        self->m_input->record({.type = input_recorder::event_type::CURSOR_POSITION, .x = x, .y = y});
+
+        if (self->m_cursor_position_callback != nullptr)
+            self->m_cursor_position_callback(win, x, y);
+    }
+
+    void window::scroll_callback_hook(GLFWwindow *win, double dx, double dy) noexcept
+    {
+        auto *self = static_cast<window *>(glfwGetWindowUserPointer(win));
+
+        if (self->m_input->replaying())
+            return;
+
+        self->m_input->record({.type = input_recorder::event_type::SCROLL, .x = dx, .y = dy});
+
+        if (self->m_scroll_callback != nullptr)
+            self->m_scroll_callback(win, dx, dy);
     }
 
     void window::set_input_mode(int mode, int value) noexcept
@@ -454,6 +552,16 @@ namespace wrap_g
 
     void window::set_cursor_pos(double x, double y) noexcept
     {
+        // the recorder keeps its own cursor so replays see the same position
+        if (m_input != nullptr)
+        {
+            m_input->set_cursor_position(x, y);
+
+            // do not move the real cursor while replaying
+            if (m_input->replaying())
+                return;
+        }
+
         // forward the call to glfwSetCursorPos to set the cursor position
         glfwSetCursorPos(m_win, x, y);
     }
@@ -492,6 +600,36 @@ namespace wrap_g
         // just calls glfwPollEvents
         // which is non-blocking
         glfwPollEvents();
+
+        // feed the recorded events for this frame to the user callbacks
+        // in place of the live ones that were just dropped
+        if (m_input != nullptr && m_input->replaying())
+        {
+            m_input->replay_events([this](const input_recorder::event &e){
+                switch (e.type)
+                {
+                case input_recorder::event_type::KEY:
+                    if (m_key_callback != nullptr)
+                        m_key_callback(m_win, e.code, e.scancode, e.action, e.mods);
+                    break;
+                case input_recorder::event_type::MOUSE_BUTTON:
+                    if (m_mouse_button_callback != nullptr)
+                        m_mouse_button_callback(m_win, e.code, e.action, e.mods);
+                    break;
+                case input_recorder::event_type::CURSOR_POSITION:
+                    if (m_cursor_position_callback != nullptr)
+                        m_cursor_position_callback(m_win, e.x, e.y);
+                    break;
+                case input_recorder::event_type::SCROLL:
+                    if (m_scroll_callback != nullptr)
+                        m_scroll_callback(m_win, e.x, e.y);
+                    break;
+                case input_recorder::event_type::FRAME:
+                default:
+                    break;
+                }
+            });
+        }
     }
 
     void window::wait_events() noexcept
@@ -514,7 +652,7 @@ namespace wrap_g
     vertex_array_object window::create_vao() noexcept
     {
         // create a vertex array object to store vertex information
-        return vertex_array_object(__graphics);
+        return vertex_array_object(__graphics, &m_bound_vao);
     }
 
     program window::create_program() noexcept
@@ -531,11 +669,56 @@ namespace wrap_g
         return texture(__graphics, target);
     }
 
+    template <typename Format>
+    vertex_array_object &window::shared_vao() noexcept
+    {
+        // the address of this static is unique per format
+        static constexpr const char key = 0;
+
+        auto &vao = m_shared_vaos[&key];
+        if (vao == nullptr)
+        {
+            vao.reset(new vertex_array_object(create_vao()));
+            vao->define_format<Format>(0);
+        }
+
+        return *vao;
+    }
+
+    void window::bind_vao(const vertex_array_object &vao) noexcept
+    {
+        if (m_bound_vao == vao.id())
+            return;
+
+        // updates m_bound_vao unless the vao is from another window
+        vao.bind();
+        m_bound_vao = vao.id();
+    }
+
+    buffer window::create_buffer(GLsizeiptr size, const void *data, GLbitfield flags) noexcept
+    {
+        // create an immutable buffer not owned by any vao
+        return buffer(__graphics, size, data, flags);
+    }
+
+    buffer_arena window::create_buffer_arena(GLsizeiptr block_size, GLbitfield flags) noexcept
+    {
+        // the blocks are made by the first allocations
+        return buffer_arena(__graphics, block_size, flags);
+    }
+
+    gpu_timer window::create_gpu_timer() noexcept
+    {
+        // create the queries used to time
+        // gpu commands
+        return gpu_timer(__graphics);
+    }
+
     ////
     // vertex array object
 
-    vertex_array_object::vertex_array_object(wrap_g &__graphics) noexcept
-        : __graphics(__graphics)
+    vertex_array_object::vertex_array_object(wrap_g &__graphics, GLuint *context_bound_vao) noexcept
+        : __graphics(__graphics), m_context_bound_vao(context_bound_vao)
     {
         // create the vertex array
         // and get an id
@@ -544,12 +727,12 @@ namespace wrap_g
         // make sure the id is valid
         if (m_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create VAO.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create VAO.\n");
             return;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created VAO #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created VAO #{}.\n", m_id);
 #endif
     }
 
@@ -561,7 +744,7 @@ namespace wrap_g
             glDeleteBuffers(1, &buffer.buffer_id);
 
 #if WRAP_G_DEBUG
-            __graphics.out() << "[wrap_g] Debug: Deleted VAO #" << m_id << " array buffer #" << buffer.buffer_id << ".\n";
+            __graphics.log().debug("[wrap_g] Debug: Deleted VAO #{} array buffer #{}.\n", m_id, buffer.buffer_id);
 #endif
         }
 
@@ -569,14 +752,17 @@ namespace wrap_g
         glDeleteBuffers(1, &m_element_buffer_id);
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Deleted VAO #" << m_id << " element buffer #" << m_element_buffer_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Deleted VAO #{} element buffer #{}.\n", m_id, m_element_buffer_id);
 #endif
 
-        // delete the vertex array object
+        // delete the vertex array object, which unbinds it if bound and its id may be reused
         glDeleteVertexArrays(1, &m_id);
 
+        if (m_context_bound_vao != nullptr && *m_context_bound_vao == m_id)
+            *m_context_bound_vao = 0;
+
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Deleted VAO #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Deleted VAO #{}.\n", m_id);
 #endif
     }
 
@@ -591,7 +777,7 @@ namespace wrap_g
         // make sure the id is valid
         if (buffer_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create VAO #" << m_id << " array buffer.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create VAO #{} array buffer.\n", m_id);
             return;
         }
 
@@ -601,11 +787,15 @@ namespace wrap_g
         // assign the buffer a binding index
         glVertexArrayVertexBuffer(m_id, binding_index, buffer_id, offset, sizeof(Wrapper));
 
+        // the binding no longer holds a buffer from bind_vertex_buffer
+        if (binding_index < m_bound_buffers.size())
+            m_bound_buffers[binding_index] = {};
+
         // add the binding index to the array buffer index list
         m_array_buffers.insert_or_assign(binding_index, array_buffer{buffer_id, sizeof(Wrapper)});
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created VAO #" << m_id << " array buffer #" << buffer_id << " and is bound to binding index: " << binding_index << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created VAO #{} array buffer #{} and is bound to binding index: {}.\n", m_id, buffer_id, binding_index);
 #endif
     }
 
@@ -620,7 +810,7 @@ namespace wrap_g
         // make sure the id is valid
         if (buffer_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create VAO #" << m_id << " array buffer.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create VAO #{} array buffer.\n", m_id);
             return;
         }
         
@@ -630,11 +820,15 @@ namespace wrap_g
         // assign the buffer a binding index
         glVertexArrayVertexBuffer(m_id, binding_index, buffer_id, offset, stride);
 
+        // the binding no longer holds a buffer from bind_vertex_buffer
+        if (binding_index < m_bound_buffers.size())
+            m_bound_buffers[binding_index] = {};
+
         // add the binding index to the array buffer index list
         m_array_buffers.insert_or_assign(binding_index, array_buffer{buffer_id, sizeof(Wrapper)});
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created VAO #" << m_id << " array buffer #" << buffer_id << " and is bound to binding index: " << binding_index << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created VAO #{} array buffer #{} and is bound to binding index: {}.\n", m_id, buffer_id, binding_index);
 #endif
     }
 
@@ -649,7 +843,7 @@ namespace wrap_g
         // make sure the id is valid
         if (buffer_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create VAO #" << m_id << " element buffer.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create VAO #{} element buffer.\n", m_id);
             return;
         }
 
@@ -658,12 +852,13 @@ namespace wrap_g
         
         // set the element array buffer
         glVertexArrayElementBuffer(m_id, buffer_id);
+        m_bound_element_buffer_serial = 0;
 
         // set the element buffer id
         m_element_buffer_id = buffer_id;
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created VAO #" << m_id << " element buffer #" << buffer_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created VAO #{} element buffer #{}.\n", m_id, buffer_id);
 #endif
     }
 
@@ -693,14 +888,309 @@ namespace wrap_g
         glVertexArrayAttribBinding(m_id, attrib_index, binding_index);
         
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Defined attributes for VAO #" << m_id << ", buffer binding index: " << binding_index << ", attribute index: " << attrib_index << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Defined attributes for VAO #{}, buffer binding index: {}, attribute index: {}.\n", m_id, binding_index, attrib_index);
+#endif
+    }
+
+    template <typename Format>
+    void vertex_array_object::define_format(GLuint binding_index, GLuint first_attrib) noexcept
+    {
+        for (GLuint i = 0; i < Format::attrib_count; ++i)
+        {
+            const auto &attrib = Format::attribs[i];
+            GLuint attrib_index = first_attrib + i;
+
+            // enable the attribute index
+            glEnableVertexArrayAttrib(m_id, attrib_index);
+
+            // declare the data contained within the attribute with the call that matches how the shader reads it
+            switch (attrib.read_as)
+            {
+            case vertex_attrib::kind::INTEGER:
+                glVertexArrayAttribIFormat(m_id, attrib_index, attrib.count, attrib.type, attrib.offset);
+                break;
+            case vertex_attrib::kind::DOUBLE:
+                glVertexArrayAttribLFormat(m_id, attrib_index, attrib.count, attrib.type, attrib.offset);
+                break;
+            case vertex_attrib::kind::FLOAT:
+            default:
+                glVertexArrayAttribFormat(m_id, attrib_index, attrib.count, attrib.type, attrib.normalized, attrib.offset);
+                break;
+            }
+
+            // every attribute is read from the same interleaved buffer
+            glVertexArrayAttribBinding(m_id, attrib_index, binding_index);
+        }
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Defined {} interleaved attributes for VAO #{}, buffer binding index: {}, stride: {}.\n",
+            Format::attrib_count, m_id, binding_index, Format::stride);
 #endif
     }
 
+    template <VertexAttrib... Ts>
+    void vertex_array_object::create_vertex_buffer(GLuint binding_index, const vertex<Ts...> *verts, size_t count, GLbitfield flags, GLuint first_attrib) noexcept
+    {
+        define_format<vertex_format<Ts...>>(binding_index, first_attrib);
+        create_array_buffer(binding_index, count * sizeof(vertex<Ts...>), verts, flags);
+    }
+
+    void vertex_array_object::bind_vertex_buffer(GLuint binding_index, const buffer &buf, GLsizei stride, GLintptr offset) noexcept
+    {
+        if (binding_index < m_bound_buffers.size())
+        {
+            auto &bound = m_bound_buffers[binding_index];
+            if (bound.buffer_serial == buf.serial() && bound.offset == offset && bound.stride == stride)
+                return;
+
+            bound = {buf.serial(), offset, stride};
+        }
+
+        glVertexArrayVertexBuffer(m_id, binding_index, buf.id(), offset, stride);
+    }
+
+    void vertex_array_object::bind_element_buffer(const buffer &buf) noexcept
+    {
+        if (m_bound_element_buffer_serial == buf.serial())
+            return;
+
+        glVertexArrayElementBuffer(m_id, buf.id());
+        m_bound_element_buffer_serial = buf.serial();
+    }
+
+    void vertex_array_object::set_binding_divisor(GLuint binding_index, GLuint divisor) noexcept
+    {
+        glVertexArrayBindingDivisor(m_id, binding_index, divisor);
+    }
+
     void vertex_array_object::bind() const noexcept
     {
         // bind this vertex array to the current context
         glBindVertexArray(m_id);
+
+        if (m_context_bound_vao != nullptr)
+            *m_context_bound_vao = m_id;
+    }
+
+    ////
+    // buffer
+
+    buffer::buffer(wrap_g &__graphics, GLsizeiptr size, const void *data, GLbitfield flags) noexcept
+        : __graphics(__graphics), m_size(size)
+    {
+        // create the buffer
+        glCreateBuffers(1, &m_id);
+
+        // make sure the id is valid
+        if (m_id == 0)
+        {
+            __graphics.log().error("[wrap_g] Error: Failed to create buffer.\n");
+            return;
+        }
+
+        // assign the data of the buffer with additional flags
+        glNamedBufferStorage(m_id, size, data, flags);
+        m_serial = ++__graphics.m_buffer_serial;
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Created buffer #{} of {} bytes.\n", m_id, size);
+#endif
+    }
+
+    buffer::~buffer() noexcept
+    {
+        if (m_id == 0)
+            return;
+
+        glDeleteBuffers(1, &m_id);
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Deleted buffer #{}.\n", m_id);
+#endif
+    }
+
+    ////
+    // buffer arena
+
+    buffer_arena::buffer_arena(wrap_g &__graphics, GLsizeiptr block_size, GLbitfield flags) noexcept
+        : __graphics(__graphics), m_block_size(std::clamp<GLsizeiptr>(block_size, 1, utils::offset_allocator::invalid)),
+          m_flags(flags | GL_DYNAMIC_STORAGE_BIT)
+    {
+    }
+
+    buffer_arena::handle buffer_arena::allocate(GLsizeiptr size, const void *data, GLsizeiptr alignment) noexcept
+    {
+        alignment = std::max<GLsizeiptr>(alignment, 1);
+        if (size <= 0 || size + alignment > utils::offset_allocator::invalid)
+        {
+            __graphics.log().error("[wrap_g] Error: Cannot allocate {} bytes from a buffer arena.\n", size);
+            return invalid_handle;
+        }
+
+        record r;
+        r.size = size;
+        r.alignment = alignment;
+
+        // the first block with room
+        for (r.block = 0; r.block < m_blocks.size(); ++r.block)
+        {
+            r.alloc = m_blocks[r.block].allocator.allocate(r.size, r.alignment);
+            if (r.alloc.valid())
+                break;
+        }
+
+        // otherwise a new block, large enough for the allocation
+        if (!r.alloc.valid())
+        {
+            GLsizeiptr block_size = std::max(m_block_size, size + alignment - 1);
+            std::unique_ptr<buffer> buf(new buffer(__graphics, block_size, nullptr, m_flags));
+            if (!buf->valid())
+                return invalid_handle;
+
+            m_blocks.push_back(block{std::move(buf), utils::offset_allocator((uint32_t)block_size)});
+            r.block = m_blocks.size() - 1;
+            r.alloc = m_blocks.back().allocator.allocate(r.size, r.alignment);
+
+#if WRAP_G_DEBUG
+            __graphics.log().debug("[wrap_g] Debug: Added block {} of {} bytes to a buffer arena.\n", r.block, block_size);
+#endif
+        }
+
+        if (data != nullptr)
+            glNamedBufferSubData(m_blocks[r.block].buf->id(), r.alloc.offset, size, data);
+
+        handle h;
+        if (!m_free_handles.empty())
+        {
+            h = m_free_handles.back();
+            m_free_handles.pop_back();
+            m_records[h] = r;
+        }
+        else
+        {
+            h = m_records.size();
+            m_records.push_back(r);
+        }
+
+        return h;
+    }
+
+    bool buffer_arena::write(handle h, const void *data, GLsizeiptr size, GLintptr offset) noexcept
+    {
+        if (h >= m_records.size() || !m_records[h].alloc.valid())
+        {
+            __graphics.log().error("[wrap_g] Error: Invalid buffer arena handle {}.\n", h);
+            return false;
+        }
+
+        const auto &r = m_records[h];
+        if (offset < 0 || size < 0 || offset + size > r.size)
+        {
+            __graphics.log().error("[wrap_g] Error: Writing {} bytes at {} is outside of the {} bytes of buffer arena handle {}.\n", size, offset, r.size, h);
+            return false;
+        }
+
+        glNamedBufferSubData(m_blocks[r.block].buf->id(), r.alloc.offset + offset, size, data);
+        return true;
+    }
+
+    void buffer_arena::free(handle h) noexcept
+    {
+        if (h >= m_records.size() || !m_records[h].alloc.valid())
+            return;
+
+        auto &r = m_records[h];
+        m_blocks[r.block].allocator.free(r.alloc);
+        r = record{};
+        m_free_handles.push_back(h);
+    }
+
+    buffer_arena::range buffer_arena::get(handle h) const noexcept
+    {
+        if (h >= m_records.size() || !m_records[h].alloc.valid())
+            return {};
+
+        const auto &r = m_records[h];
+        return {m_blocks[r.block].buf.get(), r.alloc.offset, r.size};
+    }
+
+    size_t buffer_arena::defragment() noexcept
+    {
+        // the live allocations, largest first so the first fit packs them tightly
+        std::vector<handle> live;
+        for (handle h = 0; h < m_records.size(); ++h)
+            if (m_records[h].alloc.valid())
+                live.push_back(h);
+
+        std::sort(live.begin(), live.end(), [this](handle l, handle r){ return m_records[l].size > m_records[r].size; });
+
+        // plan where each allocation goes before anything is copied, it is only worth it if a block is freed
+        std::vector<utils::offset_allocator> packed;
+        std::vector<record> moves(live.size());
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            const auto &r = m_records[live[i]];
+            auto &m = moves[i];
+            m = r;
+
+            for (m.block = 0; m.block < packed.size(); ++m.block)
+            {
+                m.alloc = packed[m.block].allocate(r.size, r.alignment);
+                if (m.alloc.valid())
+                    break;
+            }
+
+            if (!m.alloc.valid())
+            {
+                packed.emplace_back((uint32_t)std::max<GLsizeiptr>(m_block_size, r.size + r.alignment - 1));
+                m.block = packed.size() - 1;
+                m.alloc = packed.back().allocate(r.size, r.alignment);
+            }
+        }
+
+        if (packed.size() >= m_blocks.size())
+            return 0;
+
+        std::vector<block> blocks;
+        blocks.reserve(packed.size());
+        for (auto &allocator : packed)
+        {
+            std::unique_ptr<buffer> buf(new buffer(__graphics, allocator.size(), nullptr, m_flags));
+            if (!buf->valid())
+                return 0;
+
+            blocks.push_back(block{std::move(buf), std::move(allocator)});
+        }
+
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            auto &r = m_records[live[i]];
+            glCopyNamedBufferSubData(m_blocks[r.block].buf->id(), blocks[moves[i].block].buf->id(), r.alloc.offset, moves[i].alloc.offset, r.size);
+            r = moves[i];
+        }
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Defragmented a buffer arena, moved {} allocations from {} blocks into {}.\n", live.size(), m_blocks.size(), blocks.size());
+#endif
+
+        m_blocks = std::move(blocks);
+        return live.size();
+    }
+
+    GLsizeiptr buffer_arena::capacity() const noexcept
+    {
+        GLsizeiptr size = 0;
+        for (const auto &blk : m_blocks)
+            size += blk.buf->size();
+        return size;
+    }
+
+    GLsizeiptr buffer_arena::used() const noexcept
+    {
+        GLsizeiptr size = 0;
+        for (const auto &blk : m_blocks)
+            size += blk.allocator.used_size();
+        return size;
     }
 
     ////
@@ -715,12 +1205,12 @@ namespace wrap_g
         // check if the shader is valid
         if (m_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create program #" << m_id << ".\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create program #{}.\n", m_id);
             return;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created program #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created program #{}.\n", m_id);
 #endif
     }
 
@@ -732,7 +1222,7 @@ namespace wrap_g
             glDeleteShader(id);
 
 #if WRAP_G_DEBUG
-            __graphics.out() << "[wrap_g] Debug: Deleted program #" << m_id << " shader #" << id << ".\n";
+            __graphics.log().debug("[wrap_g] Debug: Deleted program #{} shader #{}.\n", m_id, id);
 #endif
         }
 
@@ -740,7 +1230,7 @@ namespace wrap_g
         glDeleteProgram(m_id);
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Deleted program #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Deleted program #{}.\n", m_id);
 #endif
     }
 
@@ -772,12 +1262,12 @@ namespace wrap_g
         // checking if the shader is valid
         if (shader_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create program #" << m_id << " shader.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create program #{} shader.\n", m_id);
             return false;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created program #" << m_id << " shader #" << shader_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created program #{} shader #{}.\n", m_id, shader_id);
 #endif
 
         // add the sub shader source to opengl current context
@@ -797,19 +1287,19 @@ namespace wrap_g
             constexpr size_t size = 512;
             char info[size];
             glGetShaderInfoLog(shader_id, size, NULL, info);
-            __graphics.out() << "[wrap_g] Error: Failed to compile program #" << m_id << " shader #" << shader_id << ". " << info << "\n";
+            __graphics.log().error("[wrap_g] Error: Failed to compile program #{} shader #{}. {}\n", m_id, shader_id, info);
 
             // delete the shader
             glDeleteShader(shader_id);
 
 #if WRAP_G_DEBUG
-            __graphics.out() << "[wrap_g] Debug: Deleted program #" << m_id << " shader #" << shader_id << ".\n ";
+            __graphics.log().debug("[wrap_g] Debug: Deleted program #{} shader #{}.\n", m_id, shader_id);
 #endif
             return false;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Compiled program #" << m_id << " shader #" << shader_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Compiled program #{} shader #{}.\n", m_id, shader_id);
 #endif
 
         m_shaders.push_back(shader_id);
@@ -818,7 +1308,7 @@ namespace wrap_g
         glAttachShader(m_id, shader_id);
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Attached program #" << m_id << " shader #" << shader_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Attached program #{} shader #{}.\n", m_id, shader_id);
 #endif
 
         return true;
@@ -840,19 +1330,19 @@ namespace wrap_g
             constexpr size_t size = 512;
             char info[size];
             glGetProgramInfoLog(m_id, size, NULL, info);
-            __graphics.out() << "[wrap_g] Error: Failed to link program. " << info << "\n";
+            __graphics.log().error("[wrap_g] Error: Failed to link program. {}\n", info);
             return false;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Linked program #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Linked program #{}.\n", m_id);
 #endif
 
         for (auto& id : m_shaders)
         {
             glDetachShader(m_id, id);
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Detached program #" << m_id << " shader #" << id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Detached program #{} shader #{}.\n", m_id, id);
 #endif
         }
     
@@ -870,7 +1360,7 @@ namespace wrap_g
         for (auto& id : m_shaders)
         {
 #if WRAP_G_DEBUG
-            __graphics.out() << "[wrap_g] Debug: Deleted program #" << m_id << " shader #" << id << ".\n";
+            __graphics.log().debug("[wrap_g] Debug: Deleted program #{} shader #{}.\n", m_id, id);
 #endif
             glDeleteShader(id);
         }
@@ -885,42 +1375,23 @@ namespace wrap_g
         return glGetUniformLocation(m_id, ((std::string_view)name).data());
     }
 
-    // TODO: check if array version is better
     template <typename... Ts>
     requires((utils::Stringable<Ts> && ...))
-    std::vector<int> program::uniform_locations(Ts &&...names) const noexcept
+    std::array<int, sizeof...(Ts)> program::uniform_locations(Ts &&...names) const noexcept
     {
         // gets the locations of all the uniforms in the
         // order they were provided in the arguments
         // this function can be typically used with an
         // enum to keep constants readable
-        std::vector<int> uniforms;
+        std::array<int, sizeof...(Ts)> uniforms;
+        size_t i = 0;
 
-        for (std::string_view name : std::initializer_list{names...})
-            uniforms.push_back(glGetUniformLocation(m_id, name.data()));
+        for (std::string_view name : std::initializer_list<std::string_view>{names...})
+            uniforms[i++] = glGetUniformLocation(m_id, name.data());
 
         return uniforms;
     }
 
-    // template <typename... Ts>
-    // requires((utils::Stringable<Ts> && ...))
-    // std::array<int, sizeof...(Ts)> program::uniform_locations(Ts &&...names) const noexcept
-    // {
-    //     // gets the locations of all the uniforms in the
-    //     // order they were provided in the arguments
-    //     // this function can be typically used with an
-    //     // enum to keep constants readable
-    //     std::array<int, sizeof...(Ts)> uniforms;
-    //     int i = 0;
-
-    //     for (std::string_view name : std::initializer_list{names...})
-    //     {
-    //         uniforms[i++] = glGetUniformLocation(m_id, name.data());
-    //     }
-
-    //     return uniforms;
-    // }
-
     template <typename... Ts>
     requires(std::is_integral_v<Ts> &&...) || (std::is_floating_point_v<Ts> && ...) void program::set_uniform(int loc, const Ts &...vals) noexcept
     {
@@ -1117,12 +1588,12 @@ namespace wrap_g
         // check if the id is valid
         if (m_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to create texture.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to create texture.\n");
             return;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Created texture #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Created texture #{}.\n", m_id);
 #endif
     }
 
@@ -1132,7 +1603,7 @@ namespace wrap_g
         glDeleteTextures(1, &m_id);
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Deleted texture #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Deleted texture #{}.\n", m_id);
 #endif
     }
 
@@ -1141,7 +1612,7 @@ namespace wrap_g
         glDeleteTextures(1, &m_id);
         
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Deleted texture #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Deleted texture #{}.\n", m_id);
 #endif
 
         // create the texture
@@ -1150,12 +1621,12 @@ namespace wrap_g
         // check if the id is valid
         if (m_id == 0)
         {
-            __graphics.out() << "[wrap_g] Error: Failed to re-create texture.\n";
+            __graphics.log().error("[wrap_g] Error: Failed to re-create texture.\n");
             return;
         }
 
 #if WRAP_G_DEBUG
-        __graphics.out() << "[wrap_g] Debug: Re-Created texture #" << m_id << ".\n";
+        __graphics.log().debug("[wrap_g] Debug: Re-Created texture #{}.\n", m_id);
 #endif
     }
 
@@ -1227,12 +1698,421 @@ namespace wrap_g
         glTextureSubImage2D(m_id, level, xoffset, yoffset, width, height, format, type, pixels);
     }
 
+    void texture::compressed_sub_image2d(GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei size, const void *data) noexcept
+    {
+        // fill the space created in the storage with blocks as they are
+        glCompressedTextureSubImage2D(m_id, level, xoffset, yoffset, width, height, format, size, data);
+    }
+
+    void texture::compressed_image2d(const unsigned char *pixels, size_t width, size_t height, size_t channels, utils::block_format format,
+                                     size_t levels, utils::job_pool *pool) noexcept
+    {
+        if (width == 0 || height == 0)
+            return;
+
+        // every level down to 1x1
+        const size_t max_levels = std::bit_width(std::max(width, height));
+        levels = levels == 0 ? max_levels : std::min(levels, max_levels);
+
+        const GLenum internal_format = compressed_format(format);
+        glTextureStorage2D(m_id, levels, internal_format, width, height);
+
+        // the blocks of the first level fit every level after it
+        std::vector<unsigned char> blocks(utils::compressed_size(format, width, height));
+        std::vector<unsigned char> level_pixels, next_pixels;
+
+        const unsigned char *src = pixels;
+        for (size_t level = 0; level < levels; ++level)
+        {
+            const size_t size = utils::compressed_size(format, width, height);
+            utils::compress_image(src, width, height, channels, format, blocks.data(), pool);
+            compressed_sub_image2d(level, 0, 0, width, height, internal_format, size, blocks.data());
+
+            if (level + 1 == levels)
+                break;
+
+            const size_t half_width = std::max<size_t>(width / 2, 1);
+            const size_t half_height = std::max<size_t>(height / 2, 1);
+            next_pixels.resize(half_width * half_height * channels);
+            utils::downsample_image(src, width, height, channels, next_pixels.data(), pool);
+
+            std::swap(level_pixels, next_pixels);
+            src = level_pixels.data();
+            width = half_width;
+            height = half_height;
+        }
+    }
+
     void texture::gen_mipmap() noexcept
     {
         // generate mipmaps
         glGenerateTextureMipmap(m_id);
     }
 
+    ////
+    // debug collector
+
+    void debug_collector::push(GLenum source, GLenum type, GLuint id, GLenum severity, std::string_view text) noexcept
+    {
+        std::lock_guard lock(m_lock);
+
+        size_t severity_index;
+        switch (severity)
+        {
+        case GL_DEBUG_SEVERITY_LOW:
+            severity_index = 1;
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            severity_index = 2;
+            break;
+        case GL_DEBUG_SEVERITY_HIGH:
+            severity_index = 3;
+            break;
+        case GL_DEBUG_SEVERITY_NOTIFICATION:
+        default:
+            severity_index = 0;
+            break;
+        }
+
+        for (auto *s : {&m_batch, &m_total})
+        {
+            ++s->messages;
+            ++s->severity[severity_index];
+            s->performance += type == GL_DEBUG_TYPE_PERFORMANCE;
+            s->errors += type == GL_DEBUG_TYPE_ERROR;
+        }
+
+        // most programs only ever see a handful of ids so a linear search is enough
+        for (size_t i = 0; i < m_counter_count; ++i)
+        {
+            if (m_counters[i].id == id && m_counters[i].severity == severity)
+            {
+                ++m_counters[i].count;
+                return;
+            }
+        }
+
+        if (m_counter_count < max_counters)
+            m_counters[m_counter_count++] = {id, type, severity, 1};
+
+        // keep the first message of each id and severity
+        if (m_message_count == capacity)
+        {
+            ++m_batch.dropped;
+            ++m_total.dropped;
+            return;
+        }
+
+        auto &msg = m_messages[m_message_count++];
+        msg.source = source;
+        msg.type = type;
+        msg.id = id;
+        msg.severity = severity;
+        msg.size = std::min(text.size(), max_text);
+        std::copy_n(text.data(), msg.size, msg.text.data());
+    }
+
+    debug_collector::summary debug_collector::collect(utils::logger &log) noexcept
+    {
+        std::lock_guard lock(m_lock);
+
+        for (size_t i = 0; i < m_message_count; ++i)
+        {
+            const auto &msg = m_messages[i];
+            window::log_debug_message(log, msg.source, msg.type, msg.id, msg.severity, {msg.text.data(), msg.size});
+        }
+
+        if (m_batch.dropped != 0)
+            log.warning("[wrap_g] Warning: {} new opengl debug messages were not kept, the batch was full.\n", m_batch.dropped);
+
+        auto batch = m_batch;
+        m_batch = {};
+        m_message_count = 0;
+
+        return batch;
+    }
+
+    [[nodiscard]] debug_collector::summary debug_collector::total() noexcept
+    {
+        std::lock_guard lock(m_lock);
+        return m_total;
+    }
+
+    [[nodiscard]] std::vector<debug_collector::counter> debug_collector::counters() noexcept
+    {
+        std::lock_guard lock(m_lock);
+        return {m_counters.begin(), m_counters.begin() + m_counter_count};
+    }
+
+    ////
+    // gpu timer
+
+    gpu_timer::gpu_timer(wrap_g &__graphics) noexcept
+        : __graphics(__graphics)
+    {
+        glCreateQueries(GL_TIME_ELAPSED, (GLsizei)query_count, m_queries.data());
+
+        if (m_queries[0] == 0)
+        {
+            __graphics.log().error("[wrap_g] Error: Failed to create gpu timer queries.\n");
+            return;
+        }
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Created gpu timer #{}.\n", m_queries[0]);
+#endif
+    }
+
+    gpu_timer::~gpu_timer() noexcept
+    {
+        glDeleteQueries((GLsizei)query_count, m_queries.data());
+
+#if WRAP_G_DEBUG
+        __graphics.log().debug("[wrap_g] Debug: Deleted gpu timer #{}.\n", m_queries[0]);
+#endif
+    }
+
+    void gpu_timer::begin() noexcept
+    {
+        // every query is in flight
+        // skip the frame instead of waiting
+        m_active = pending() < query_count;
+
+        if (m_active)
+            glBeginQuery(GL_TIME_ELAPSED, m_queries[m_issued % query_count]);
+    }
+
+    void gpu_timer::end() noexcept
+    {
+        if (!m_active)
+            return;
+
+        glEndQuery(GL_TIME_ELAPSED);
+        ++m_issued;
+        m_active = false;
+    }
+
+    [[nodiscard]] bool gpu_timer::result(double &ms, bool wait) noexcept
+    {
+        if (pending() == 0)
+            return false;
+
+        GLuint query = m_queries[m_read % query_count];
+
+        if (!wait)
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (!available)
+                return false;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        ++m_read;
+
+        ms = elapsed / 1e6;
+        return true;
+    }
+
+    ////
+    // input recorder
+
+    void input_recorder::start_recording() noexcept
+    {
+        m_events.clear();
+        m_next = 0;
+        m_keys.fill(GLFW_RELEASE);
+        m_mouse_buttons.fill(GLFW_RELEASE);
+        m_cursor_x = m_cursor_y = 0.0;
+
+        m_start_time = glfwGetTime();
+        m_mode = mode::RECORD;
+    }
+
+    void input_recorder::stop() noexcept
+    {
+        m_mode = mode::IDLE;
+    }
+
+    [[nodiscard]] bool input_recorder::save(const char *path) const noexcept
+    {
+        std::ofstream file;
+        file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+        try
+        {
+            file.open(path, std::ios::binary | std::ios::trunc);
+
+            const std::uint64_t count = m_events.size();
+
+            // header: magic, version, event count
+            file.write(magic, sizeof(magic));
+            file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+            file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+
+            // events are trivially copyable and written as is
+            file.write(reinterpret_cast<const char *>(m_events.data()), m_events.size() * sizeof(event));
+            file.close();
+            return true;
+        }
+        catch (const std::ofstream::failure &e)
+        {
+            std::cout << "[wrap_g] Error: Failed to write input log " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            return false;
+        }
+    }
+
+    [[nodiscard]] bool input_recorder::load(const char *path) noexcept
+    {
+        std::ifstream file;
+        file.exceptions(std::ifstream::badbit | std::ifstream::failbit);
+        try
+        {
+            file.open(path, std::ios::binary);
+
+            char file_magic[sizeof(magic)];
+            std::uint32_t file_version = 0;
+            std::uint64_t count = 0;
+
+            file.read(file_magic, sizeof(file_magic));
+            file.read(reinterpret_cast<char *>(&file_version), sizeof(file_version));
+            file.read(reinterpret_cast<char *>(&count), sizeof(count));
+
+            if (!std::equal(std::begin(magic), std::end(magic), file_magic) || file_version != version)
+            {
+                std::cout << "[wrap_g] Error: " << path << " is not a version " << version << " input log.\n";
+                return false;
+            }
+
+            // a truncated or corrupt log must not size the events past what the file holds
+            std::streampos events_begin = file.tellg();
+            file.seekg(0, std::ios::end);
+            std::uint64_t remaining = (std::uint64_t)(file.tellg() - events_begin);
+            file.seekg(events_begin);
+
+            if (count > remaining / sizeof(event))
+            {
+                std::cout << "[wrap_g] Error: " << path << " holds " << remaining / sizeof(event) << " of its " << count << " input events.\n";
+                m_events.clear();
+                return false;
+            }
+
+            m_events.resize(count);
+            file.read(reinterpret_cast<char *>(m_events.data()), count * sizeof(event));
+            file.close();
+        }
+        catch (const std::ifstream::failure &e)
+        {
+            std::cout << "[wrap_g] Error: Failed to read input log " << path << ". Code: " << e.code() << ", Message: " << e.what() << ".\n";
+            m_events.clear();
+            return false;
+        }
+
+        start_replay();
+        return true;
+    }
+
+    void input_recorder::start_replay() noexcept
+    {
+        m_next = 0;
+        m_keys.fill(GLFW_RELEASE);
+        m_mouse_buttons.fill(GLFW_RELEASE);
+        m_cursor_x = m_cursor_y = 0.0;
+
+        m_mode = mode::REPLAY;
+    }
+
+    void input_recorder::record(event e) noexcept
+    {
+        if (m_mode != mode::RECORD)
+            return;
+
+        e.time = glfwGetTime() - m_start_time;
+
+        apply(e);
+        m_events.push_back(e);
+    }
+
+    float input_recorder::frame(float dt) noexcept
+    {
+        if (m_mode == mode::RECORD)
+        {
+            record({.type = event_type::FRAME, .x = dt});
+            return dt;
+        }
+
+        // use the recorded dt so the movement math matches the recording
+        if (m_mode == mode::REPLAY && m_next < m_events.size() && m_events[m_next].type == event_type::FRAME)
+        {
+            return static_cast<float>(m_events[m_next++].x);
+        }
+
+        return dt;
+    }
+
+    template <typename Fn>
+    requires std::is_invocable_v<Fn, const input_recorder::event &>
+    void input_recorder::replay_events(Fn &&fn) noexcept
+    {
+        if (m_mode != mode::REPLAY)
+            return;
+
+        // everything up to the next frame marker belongs to this frame
+        while (m_next < m_events.size() && m_events[m_next].type != event_type::FRAME)
+        {
+            const auto &e = m_events[m_next++];
+            apply(e);
+            fn(e);
+        }
+    }
+
+    [[nodiscard]] int input_recorder::key(int key) const noexcept
+    {
+        if (key < 0 || key >= (int)m_keys.size())
+            return GLFW_RELEASE;
+
+        // glfwGetKey only reports press or release, repeats count as pressed
+        return m_keys[key] == GLFW_RELEASE ? GLFW_RELEASE : GLFW_PRESS;
+    }
+
+    [[nodiscard]] int input_recorder::mouse_button(int button) const noexcept
+    {
+        if (button < 0 || button >= (int)m_mouse_buttons.size())
+            return GLFW_RELEASE;
+
+        return m_mouse_buttons[button];
+    }
+
+    void input_recorder::set_cursor_position(double x, double y) noexcept
+    {
+        m_cursor_x = x;
+        m_cursor_y = y;
+    }
+
+    void input_recorder::apply(const event &e) noexcept
+    {
+        switch (e.type)
+        {
+        case event_type::KEY:
+            if (e.code >= 0 && e.code < (int)m_keys.size())
+                m_keys[e.code] = e.action;
+            break;
+        case event_type::MOUSE_BUTTON:
+            if (e.code >= 0 && e.code < (int)m_mouse_buttons.size())
+                m_mouse_buttons[e.code] = e.action;
+            break;
+        case event_type::CURSOR_POSITION:
+            m_cursor_x = e.x;
+            m_cursor_y = e.y;
+            break;
+        case event_type::SCROLL:
+        case event_type::FRAME:
+        default:
+            break;
+        }
+    }
+
 } // namespace wrap_g
 
 #endif
\ No newline at end of file
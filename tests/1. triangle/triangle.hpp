@@ -7,11 +7,12 @@
 
 #include "../../src/utils.hpp"
 #include "../../src/wrap_g.hpp"
+#include "../scene_options.hpp"
 
 namespace wrap_tests
 {
 
-void create_triangle() noexcept
+void create_triangle(const scene_options &options = {}) noexcept
 {
 #if WRAP_G_DEBUG
     // time each process
@@ -25,6 +26,9 @@ void create_triangle() noexcept
     if (!graphics.valid())
         return;
 
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
     // create a window / context.
     // width: 800
     // height: 600
@@ -62,7 +66,7 @@ void create_triangle() noexcept
     ////
     // Resource locations
 
-    constexpr const char *stats_loc = "./tests/1. triangle/stats.csv";
+    [[maybe_unused]] constexpr const char *stats_loc = "./tests/1. triangle/stats.csv";
 
 #if WRAP_G_TESTS__TRIANGLE_USE_SHADERS
     constexpr const char *vert_path = "./tests/1. triangle/vert.glsl";
@@ -171,7 +175,11 @@ void create_triangle() noexcept
     tracker.start_tracking();
 #endif
 
-    while (!win.get_should_close())
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    while (options.running(win, frame++))
     {
         // get events such as mouse input
         // checks every time for event
@@ -180,6 +188,8 @@ void create_triangle() noexcept
 #if WRAP_G_DEBUG
         watch.start();
 #endif
+        bench_watch.begin();
+
         // set the color that will be used when glClear is called on the color buffer bit
         glClearColor(blue.r, blue.g, blue.b, blue.a);
         
@@ -200,6 +210,7 @@ void create_triangle() noexcept
 
         // swap the buffers to show the newly drawn frame
         win.swap_buffers();
+        bench_watch.end();
 
 #if WRAP_G_DEBUG
         tracker.track_frame(watch.stop());
@@ -5,11 +5,12 @@
 
 #include "../../src/utils.hpp"
 #include "../../src/wrap_g.hpp"
+#include "../scene_options.hpp"
 
 namespace wrap_tests
 {
     
-void create_textured_rect() noexcept
+void create_textured_rect(const scene_options &options = {}) noexcept
 {
 #if WRAP_G_DEBUG
     // time each process
@@ -23,6 +24,9 @@ void create_textured_rect() noexcept
     if (!graphics.valid())
         return;
 
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
     // create a window / context.
     // width: 800
     // height: 600
@@ -68,7 +72,7 @@ void create_textured_rect() noexcept
     constexpr const char *vert_path = "./tests/2. textured rect/vert.glsl";
     constexpr const char *frag_path = "./tests/2. textured rect/frag.glsl";
 
-    constexpr const char *stats_loc = "./tests/2. textured rect/stats.csv";
+    [[maybe_unused]] constexpr const char *stats_loc = "./tests/2. textured rect/stats.csv";
 
 #if WRAP_G_BACKGROUND_RESOURCE_LOAD
     ////
@@ -76,8 +80,8 @@ void create_textured_rect() noexcept
 
     // call blocking functions such as files/img loading in seperate thread.
 
-    auto load_img_1 = img_loader_1.load_file_async(img_path_1);
-    auto load_img_2 = img_loader_2.load_file_async(img_path_2, true);
+    auto load_img_1 = utils::stb_image::load_file_async(img_path_1);
+    auto load_img_2 = utils::stb_image::load_file_async(img_path_2, true);
 
     auto load_vert_src = utils::read_file_async(vert_path);
     auto load_frag_src = utils::read_file_async(frag_path);
@@ -216,7 +220,8 @@ void create_textured_rect() noexcept
     // Resource Fetching Threads Done
 
     // wait for thread to load img just in case it is not done
-    success = load_img_1.get();
+    img_loader_1 = load_img_1.get();
+    success = img_loader_1.data() != nullptr;
 #else
     // load image now
     success = img_loader_1.load_file(img_path_1);
@@ -247,7 +252,8 @@ void create_textured_rect() noexcept
 
 #if WRAP_G_BACKGROUND_RESOURCE_LOAD
     // wait for thread to load img just in case it is not done
-    success = load_img_2.get();
+    img_loader_2 = load_img_2.get();
+    success = img_loader_2.data() != nullptr;
 #else
     // load image now
     success = img_loader_2.load_file(img_path_2, true);
@@ -283,7 +289,11 @@ void create_textured_rect() noexcept
     utils::metrics tracker;
     tracker.start_tracking();
 #endif
-    while (!win.get_should_close())
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    while (options.running(win, frame++))
     {
         // get events such as mouse input
         // checks every time for event
@@ -299,6 +309,8 @@ void create_textured_rect() noexcept
 #if WRAP_G_DEBUG
         watch.start();
 #endif
+        bench_watch.begin();
+
 
         // set the color that will be used when glClear is called on the color buffer bit
         glClearColor(blue.r, blue.g, blue.b, blue.a);
@@ -322,6 +334,7 @@ void create_textured_rect() noexcept
 
         // swap the buffers to show the newly drawn frame
         win.swap_buffers();
+        bench_watch.end();
 
 #if WRAP_G_DEBUG
         tracker.track_frame(watch.stop());
@@ -5,11 +5,12 @@
 
 #include "../../src/utils.hpp"
 #include "../../src/wrap_g.hpp"
+#include "../scene_options.hpp"
 
 namespace wrap_tests
 {
 
-void create_moving_around_cubes() noexcept
+void create_moving_around_cubes(const scene_options &options = {}) noexcept
 {
     // time each process
     // outside as dt per frame is calculated using this
@@ -25,6 +26,9 @@ void create_moving_around_cubes() noexcept
     if (!graphics.valid())
         return;
 
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
     // create a window / context.
     // width: 800
     // height: 600
@@ -52,6 +56,11 @@ void create_moving_around_cubes() noexcept
     // *supposed to set buffer swap rate to sync with monitor.
     // *not sure if works
     win.set_buffer_swap_interval(0);
+
+    // record the input into or replay it from the recorder if one was given
+    // get_key, get_mouse_button and get_cursor_position then go through the recorder
+    if (options.input != nullptr)
+        win.set_input_recorder(*options.input);
     
     // hide the cursor
     win.set_input_mode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -73,7 +82,7 @@ void create_moving_around_cubes() noexcept
     constexpr const char *vert_path = "./tests/3. moving around cubes/vert.glsl";
     constexpr const char *frag_path = "./tests/3. moving around cubes/frag.glsl";
 
-    constexpr const char *stats_loc = "./tests/3. moving around cubes/stats.csv";
+    [[maybe_unused]] constexpr const char *stats_loc = "./tests/3. moving around cubes/stats.csv";
 
 #if WRAP_G_BACKGROUND_RESOURCE_LOAD
     ////
@@ -81,8 +90,8 @@ void create_moving_around_cubes() noexcept
 
     // call blocking functions such as files/img loading in seperate thread.
 
-    auto load_img_1 = img_loader_1.load_file_async(img_path_1);
-    auto load_img_2 = img_loader_2.load_file_async(img_path_2, true);
+    auto load_img_1 = utils::stb_image::load_file_async(img_path_1);
+    auto load_img_2 = utils::stb_image::load_file_async(img_path_2, true);
 
     auto load_vert_src = utils::read_file_async(vert_path);
     auto load_frag_src = utils::read_file_async(frag_path);
@@ -282,7 +291,8 @@ void create_moving_around_cubes() noexcept
     // Resource Fetching Threads Done
 
     // wait for thread to load img just in case it is not done
-    success = load_img_1.get();
+    img_loader_1 = load_img_1.get();
+    success = img_loader_1.data() != nullptr;
 #else
     // load image now
     success = img_loader_1.load_file(img_path_1);    
@@ -313,7 +323,8 @@ void create_moving_around_cubes() noexcept
 
 #if WRAP_G_BACKGROUND_RESOURCE_LOAD
     // wait for thread to load img just in case it is not done
-    success = load_img_2.get();
+    img_loader_2 = load_img_2.get();
+    success = img_loader_2.data() != nullptr;
 #else
     // load image now
     success = img_loader_2.load_file(img_path_2, true);
@@ -353,7 +364,11 @@ void create_moving_around_cubes() noexcept
 #endif
     float dt = 0.01;
 
-    while (!win.get_should_close())
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    while (options.running(win, frame++))
     {
         ////
         // event handling
@@ -500,6 +515,7 @@ void create_moving_around_cubes() noexcept
         }
 
         watch.start();
+        bench_watch.begin();
 
         ////
         // rendering
@@ -523,12 +539,17 @@ void create_moving_around_cubes() noexcept
         
         // swap the buffers to show the newly drawn frame
         win.swap_buffers();
+        bench_watch.end();
 
         dt = watch.stop();
 #if WRAP_G_DEBUG
         tracker.track_frame(dt);
 #endif
         dt = glm::clamp(dt, 0.0001f, 0.01f);
+
+        // log the dt or use the logged one so movement is the same on every replay
+        if (options.input != nullptr)
+            dt = options.input->frame(dt);
     }
     
 #if WRAP_G_DEBUG
@@ -5,6 +5,7 @@
 
 #include "../../src/utils.hpp"
 #include "../../src/wrap_g.hpp"
+#include "../scene_options.hpp"
 #include "../../src/wrap_g_exp.hpp"
 
 namespace wrap_tests
@@ -12,7 +13,7 @@ namespace wrap_tests
 
 // TODO: Bug about rotation... sometimes it freaks out and rotates randomly... fix unknown
 
-void create_materials() noexcept
+void create_materials(const scene_options &options = {}) noexcept
 {
     // time each process
     // outside as dt per frame is calculated using this
@@ -28,6 +29,9 @@ void create_materials() noexcept
     if (!graphics.valid())
         return;
 
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
     // create a window / context.
     // width: 800
     // height: 600
@@ -56,6 +60,11 @@ void create_materials() noexcept
     // *not sure if works
     win.set_buffer_swap_interval(0);
 
+    // record the input into or replay it from the recorder if one was given
+    // get_key, get_mouse_button and get_cursor_position then go through the recorder
+    if (options.input != nullptr)
+        win.set_input_recorder(*options.input);
+
     // hide the cursor
     win.set_input_mode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -73,7 +82,7 @@ void create_materials() noexcept
 
     constexpr const char *materials_list_path = "./tests/4. materials/materials list.csv";
 
-    constexpr const char *stats_loc = "./tests/4. materials/stats.csv";
+    [[maybe_unused]] constexpr const char *stats_loc = "./tests/4. materials/stats.csv";
 
     // the struct containing info about the material
     struct Material {
@@ -288,7 +297,11 @@ void create_materials() noexcept
 #endif
     float dt = 0.01;
 
-    while (!win.get_should_close())
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    while (options.running(win, frame++))
     {
         ////
         // event handling
@@ -559,6 +572,7 @@ void create_materials() noexcept
         cube_gl._base_gl._prog.set_uniform_mat<3>(cube_uniforms[(int)CUBE_OBJ_UNIFORMS::NORMAL_MAT], glm::value_ptr(cube_obj._normal_mat));
         
         watch.start();
+        bench_watch.begin();
 
         ////
         // rendering
@@ -574,12 +588,17 @@ void create_materials() noexcept
 
         // swap the buffers to show the newly drawn frame
         win.swap_buffers();
+        bench_watch.end();
 
         dt = watch.stop();
 #if WRAP_G_DEBUG
         tracker.track_frame(dt);
 #endif
         dt = glm::clamp(dt, 0.0001f, 0.01f);
+
+        // log the dt or use the logged one so movement is the same on every replay
+        if (options.input != nullptr)
+            dt = options.input->frame(dt);
     }
 
 #if WRAP_G_DEBUG
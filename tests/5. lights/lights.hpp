@@ -5,12 +5,13 @@
 
 #include "../../src/utils.hpp"
 #include "../../src/wrap_g.hpp"
+#include "../scene_options.hpp"
 #include "../../src/wrap_g_exp.hpp"
 
 namespace wrap_tests
 {
 
-void create_lights() noexcept
+void create_lights(const scene_options &options = {}) noexcept
 {
     // time each process
     // outside as dt per frame is calculated using this
@@ -26,6 +27,9 @@ void create_lights() noexcept
     if (!graphics.valid())
         return;
 
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
     // create a window / context.
     // width: 800
     // height: 600
@@ -54,6 +58,11 @@ void create_lights() noexcept
     // *not sure if works
     win.set_buffer_swap_interval(0);
 
+    // record the input into or replay it from the recorder if one was given
+    // get_key, get_mouse_button and get_cursor_position then go through the recorder
+    if (options.input != nullptr)
+        win.set_input_recorder(*options.input);
+
     // hide the cursor
     win.set_input_mode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -72,7 +81,7 @@ void create_lights() noexcept
     constexpr const char *frag_path = "./tests/5. lights/frag.glsl";
     constexpr const char *light_frag_path = "./tests/5. lights/light_frag.glsl";
 
-    constexpr const char *stats_loc = "./tests/5. lights/stats.csv";
+    [[maybe_unused]] constexpr const char *stats_loc = "./tests/5. lights/stats.csv";
     
 #if WRAP_G_BACKGROUND_RESOURCE_LOAD
     ////
@@ -80,10 +89,8 @@ void create_lights() noexcept
 
     // call blocking functions such as files/img loading in seperate thread.
 
-    utils::stb_image diff_map_loader, spec_map_loader;
-
-    auto load_diff_map = diff_map_loader.load_file_async(diff_map_path);
-    auto load_spec_map = spec_map_loader.load_file_async(spec_map_path);
+    auto load_diff_map = utils::stb_image::load_file_async(diff_map_path);
+    auto load_spec_map = utils::stb_image::load_file_async(spec_map_path);
 
     auto load_vert_src = utils::read_file_async(vert_path);
     auto load_frag_src = utils::read_file_async(frag_path);
@@ -190,6 +197,13 @@ void create_lights() noexcept
     diff_map.bind_unit(cube_mat.diffuse);
     spec_map.bind_unit(cube_mat.specular);
 
+    // the maps are compressed into bc1 or bc3 blocks with all of their mip levels on the cpu, an eighth or
+    // a quarter of the memory of rgba8. 1 and 2 channel maps are read as grey and grey alpha
+    auto upload_map = [](wrap_g::texture &map, utils::stb_image &image){
+        auto format = image.nr_channels() == 2 || image.nr_channels() == 4 ? utils::block_format::BC3 : utils::block_format::BC1;
+        map.compressed_image2d(image.data(), image.width(), image.height(), image.nr_channels(), format, 0, &utils::job_pool::shared());
+    };
+
     // store the source code of the shaders
     std::string vert_src, frag_src, light_frag_src;
 
@@ -215,26 +229,7 @@ void create_lights() noexcept
 
     if (success)
     {
-        GLenum iformat, format;
-        if (img_loader.nr_channels() == 1) 
-        {
-            iformat = GL_R;
-            format = GL_RED;
-        }
-        else if (img_loader.nr_channels() == 3)
-        {
-            iformat = GL_RGB4;
-            format = GL_RGB;
-        }
-        else if (img_loader.nr_channels() == 4)
-        {
-            iformat = GL_RGBA4;
-            format = GL_RGBA;
-        }
-
-        diff_map.define_texture2d(1, iformat, img_loader.width(), img_loader.height());
-        diff_map.sub_image2d(0, 0, 0, img_loader.width(), img_loader.height(), format, GL_UNSIGNED_BYTE, img_loader.data());
-        diff_map.gen_mipmap();
+        upload_map(diff_map, img_loader);
     }
     else
     {
@@ -245,26 +240,7 @@ void create_lights() noexcept
     
     if (success)
     {
-        GLenum iformat, format;
-        if (img_loader.nr_channels() == 1) 
-        {
-            iformat = GL_R;
-            format = GL_RED;
-        }
-        else if (img_loader.nr_channels() == 3)
-        {
-            iformat = GL_RGB4;
-            format = GL_RGB;
-        }
-        else if (img_loader.nr_channels() == 4)
-        {
-            iformat = GL_RGBA4;
-            format = GL_RGBA;
-        }
-
-        spec_map.define_texture2d(1, iformat, img_loader.width(), img_loader.height());
-        spec_map.sub_image2d(0, 0, 0, img_loader.width(), img_loader.height(), format, GL_UNSIGNED_BYTE, img_loader.data());
-        spec_map.gen_mipmap();
+        upload_map(spec_map, img_loader);
     }
     else
     {
@@ -288,60 +264,24 @@ void create_lights() noexcept
     if (!success)
         return;
 
-    success = load_diff_map.get();
+    utils::stb_image diff_map_loader = load_diff_map.get();
+    success = diff_map_loader.data() != nullptr;
 
     if (success)
     {
-        GLenum iformat, format;
-        if (diff_map_loader.nr_channels() == 1) 
-        {
-            iformat = GL_R;
-            format = GL_RED;
-        }
-        else if (diff_map_loader.nr_channels() == 3)
-        {
-            iformat = GL_RGB4;
-            format = GL_RGB;
-        }
-        else if (diff_map_loader.nr_channels() == 4)
-        {
-            iformat = GL_RGBA4;
-            format = GL_RGBA;
-        }
-
-        diff_map.define_texture2d(1, iformat, diff_map_loader.width(), diff_map_loader.height());
-        diff_map.sub_image2d(0, 0, 0, diff_map_loader.width(), diff_map_loader.height(), format, GL_UNSIGNED_BYTE, diff_map_loader.data());
-        diff_map.gen_mipmap();
+        upload_map(diff_map, diff_map_loader);
     }
     else
     {
         std::cout << "[main] Error: Failed to load diffuse map from " << diff_map_path << "\n";
     }
 
-    success = load_spec_map.get();
+    utils::stb_image spec_map_loader = load_spec_map.get();
+    success = spec_map_loader.data() != nullptr;
     
     if (success)
     {
-        GLenum iformat, format;
-        if (spec_map_loader.nr_channels() == 1) 
-        {
-            iformat = GL_R;
-            format = GL_RED;
-        }
-        else if (spec_map_loader.nr_channels() == 3)
-        {
-            iformat = GL_RGB4;
-            format = GL_RGB;
-        }
-        else if (spec_map_loader.nr_channels() == 4)
-        {
-            iformat = GL_RGBA4;
-            format = GL_RGBA;
-        }
-
-        spec_map.define_texture2d(1, iformat, spec_map_loader.width(), spec_map_loader.height());
-        spec_map.sub_image2d(0, 0, 0, spec_map_loader.width(), spec_map_loader.height(), format, GL_UNSIGNED_BYTE, spec_map_loader.data());
-        spec_map.gen_mipmap();
+        upload_map(spec_map, spec_map_loader);
     }
     else
     {
@@ -419,7 +359,11 @@ void create_lights() noexcept
 #endif
     float dt = 0.01;
     
-    while (!win.get_should_close())
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    while (options.running(win, frame++))
     {
         ////
         // event handling
@@ -673,6 +617,7 @@ void create_lights() noexcept
         cube_gl._base_gl._prog.set_uniform_mat<3>(cube_uniforms[(int)CUBE_OBJ_UNIFORMS::NORMAL_MAT], glm::value_ptr(cube_obj._normal_mat));
         
         watch.start();
+        bench_watch.begin();
 
         ////
         // rendering
@@ -688,12 +633,17 @@ void create_lights() noexcept
 
         // swap the buffers to show the newly drawn frame
         win.swap_buffers();
+        bench_watch.end();
 
         dt = watch.stop();
 #if WRAP_G_DEBUG
         tracker.track_frame(dt);
 #endif
         dt = glm::clamp(dt, 0.0001f, 0.01f);
+
+        // log the dt or use the logged one so movement is the same on every replay
+        if (options.input != nullptr)
+            dt = options.input->frame(dt);
     }
 
 #if WRAP_G_DEBUG
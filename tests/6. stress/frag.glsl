@@ -0,0 +1,34 @@
+#version 450 core
+
+// must match stress_options::max_lights
+#define MAX_LIGHTS 32
+
+in vec3 frag_pos;
+in vec3 normals;
+in vec2 tex_coord;
+
+out vec4 frag_col;
+
+uniform sampler2D tex;
+
+uniform int light_count;
+uniform vec3 light_positions[MAX_LIGHTS];
+uniform vec3 light_colors[MAX_LIGHTS];
+
+void main()
+{
+    vec3 albedo = texture(tex, tex_coord).rgb;
+    vec3 norm = normalize(normals);
+
+    vec3 col = 0.1 * albedo;
+    for (int i = 0; i < light_count; ++i)
+    {
+        vec3 to_light = light_positions[i] - frag_pos;
+        float dist = length(to_light);
+        float diff = max(dot(norm, to_light / dist), 0.0);
+        float attenuation = 1.0 / (1.0 + 0.05 * dist + 0.01 * dist * dist);
+        col += diff * attenuation * light_colors[i] * albedo;
+    }
+
+    frag_col = vec4(col, 1.0);
+}
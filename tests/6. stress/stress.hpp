@@ -0,0 +1,333 @@
+#ifndef WRAP_G_TESTS_STRESS
+#define WRAP_G_TESTS_STRESS
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cmath>
+
+#include "../../src/utils.hpp"
+#include "../../src/wrap_g.hpp"
+#include "../../src/wrap_g_exp.hpp"
+#include "../scene_options.hpp"
+
+namespace wrap_tests
+{
+
+/**
+ * @brief The knobs of the stress scene. Objects cycle through the unique textures and programs so
+ * every object after the first few changes state.
+ *
+ */
+struct stress_options
+{
+    // must match MAX_LIGHTS in frag.glsl
+    static constexpr const size_t max_lights = 32;
+
+    // the number of objects, each is its own draw call
+    size_t objects = 1000;
+
+    // the number of unique textures
+    size_t textures = 1;
+
+    // the number of unique programs, each with its own shape and vao
+    size_t programs = 1;
+
+    // the number of point lights, clamped to max_lights
+    size_t lights = 1;
+
+    // the width and height of each texture
+    size_t texture_size = 64;
+};
+
+/**
+ * @brief What the stress scene measured. Times are the mean over every frame.
+ *
+ */
+struct stress_stats
+{
+    size_t frames = 0;
+
+    // draw calls issued each frame
+    size_t draws = 0;
+
+    // the cpu time spent binding, setting uniforms and issuing draw calls
+    double submit_ms = 0.0;
+
+    // the cpu time of the whole frame including the buffer swap
+    double frame_ms = 0.0;
+
+    // draw calls submitted per second of frame time
+    double draws_per_second = 0.0;
+
+    // the process memory before the scene was created and after the first frame
+    size_t start_memory = 0;
+    size_t resident_memory = 0;
+
+    // the size of the textures and vertex data created on the gpu
+    size_t gpu_memory = 0;
+};
+
+/**
+ * @brief Draw a grid of cubes or rects one draw call at a time to find where the per object cost
+ * of the wrapper stops scaling. The camera orbits the grid on its own so no input is needed.
+ *
+ * @tparam Shape wrap_g::cube or wrap_g::rect
+ * @param stress The knobs of the scene.
+ * @param options How the scene is run.
+ * @return stress_stats
+ */
+template <typename Shape = wrap_g::cube>
+requires utils::is_one_of<Shape, wrap_g::cube, wrap_g::rect>
+stress_stats create_stress(const stress_options &stress = {}, const scene_options &options = {}) noexcept
+{
+    stress_stats stats;
+    stats.start_memory = utils::resident_memory();
+
+    // keep every knob at least 1
+    const size_t object_count = std::max<size_t>(stress.objects, 1);
+    const size_t texture_count = std::max<size_t>(stress.textures, 1);
+    const size_t program_count = std::max<size_t>(stress.programs, 1);
+    const size_t light_count = std::clamp<size_t>(stress.lights, 1, stress_options::max_lights);
+    const size_t texture_size = std::max<size_t>(stress.texture_size, 1);
+
+    // initialize glfw and set opengl version and some stuff
+    wrap_g::wrap_g graphics;
+
+    if (!graphics.valid())
+        return stats;
+
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
+    // create a window / context.
+    // width: 800
+    // height: 600
+    // title: "Stress Test Window."
+    // underlying function also checks to see if glad is valid
+    auto win = graphics.create_window(800, 600, "Stress Test Window.");
+
+    // check if underlying GLFWwindow* is valid
+    if (win.win() == nullptr)
+        return stats;
+
+    // set window resize function to adjust viewport automatically
+    // internally forwards to glfwSetFramebufferSizeCallback
+    win.set_framebuffer_size_callback([](GLFWwindow *, GLint w, GLint h){ glViewport(0, 0, w, h); });
+
+    // ensure ESC can always exit the program
+    // internally forwards to glfwSetKeyCallback
+    win.set_key_callback([](GLFWwindow *win, int key, int, int action, int){
+        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+        {
+            glfwSetWindowShouldClose(win, true);
+        }
+    });
+
+    // vsync would cap the draws per second
+    win.set_buffer_swap_interval(0);
+
+    ////
+    // Resource locations
+
+    constexpr bool is_cube = std::is_same_v<Shape, wrap_g::cube>;
+
+    constexpr const char *vert_path = is_cube ? "./tests/6. stress/cube_vert.glsl" : "./tests/6. stress/rect_vert.glsl";
+    constexpr const char *frag_path = "./tests/6. stress/frag.glsl";
+
+    ////
+    // startup code
+
+    // logic
+
+    // objects are placed on a cube shaped grid
+    constexpr float spacing = 1.5f;
+    const size_t side = (size_t)std::ceil(std::cbrt((double)object_count));
+    const glm::vec3 center = glm::vec3{(side - 1) * spacing / 2.0f};
+    const float orbit_radius = side * spacing * 1.5f + 2.0f;
+
+    std::vector<glm::vec3> positions(object_count);
+    for (size_t i = 0; i < object_count; ++i)
+        positions[i] = glm::vec3{(float)(i % side), (float)(i / side % side), (float)(i / (side * side))} * spacing;
+
+    // the lights circle above the grid
+    std::vector<glm::vec3> light_positions(light_count), light_colors(light_count);
+    for (size_t i = 0; i < light_count; ++i)
+    {
+        float angle = 2.0f * 3.14159265f * i / light_count;
+        light_positions[i] = center + glm::vec3{std::cos(angle) * orbit_radius * 0.5f, side * spacing, std::sin(angle) * orbit_radius * 0.5f};
+        light_colors[i] = glm::vec3{0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::sin(angle), 1.0f} * (2.0f / light_count);
+    }
+
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)win.width() / win.height(), 0.1f, orbit_radius * 4.0f);
+    glm::mat4 view{1.0f}, model{1.0f};
+
+    // gives a glm::vec4 containing the rgba color values
+    constexpr auto blue = utils::hex("#111b24");
+
+    // opengl rendering
+
+    std::string vert_src = utils::read_file_sync(vert_path);
+    std::string frag_src = utils::read_file_sync(frag_path);
+
+    // index of specific uniform location in the vector for each program
+    enum class SHAPE_UNIFORMS {
+        PROJ, VIEW, MODEL, TEX,
+        LIGHT_COUNT, LIGHT_POSITIONS, LIGHT_COLORS
+    };
+
+    // every unique program gets its own shape as shapes own their program
+    // ! shapes cannot be moved so they are stored as pointers
+    std::vector<std::unique_ptr<Shape>> shapes;
+    std::vector<std::array<int, 7>> shape_uniforms;
+
+    for (size_t i = 0; i < program_count; ++i)
+    {
+        auto &shape = shapes.emplace_back(std::make_unique<Shape>(win));
+        wrap_g::program &prog = shape->_base_gl._prog;
+
+        bool success = prog.quick({
+            {GL_VERTEX_SHADER, {vert_src}},
+            {GL_FRAGMENT_SHADER, {frag_src}}
+        });
+
+        if (!success)
+            return stats;
+
+        auto &uniforms = shape_uniforms.emplace_back(prog.uniform_locations(
+            "proj", "view", "model", "tex",
+            "light_count", "light_positions", "light_colors"
+        ));
+
+        prog.set_uniform_mat<4>(uniforms[(int)SHAPE_UNIFORMS::PROJ], glm::value_ptr(proj));
+        prog.set_uniform(uniforms[(int)SHAPE_UNIFORMS::TEX], 0);
+        prog.set_uniform(uniforms[(int)SHAPE_UNIFORMS::LIGHT_COUNT], (int)light_count);
+        prog.set_uniform_vec<3>(uniforms[(int)SHAPE_UNIFORMS::LIGHT_POSITIONS], glm::value_ptr(light_positions[0]), light_count);
+        prog.set_uniform_vec<3>(uniforms[(int)SHAPE_UNIFORMS::LIGHT_COLORS], glm::value_ptr(light_colors[0]), light_count);
+    }
+
+    // the same sizes the shapes create their buffers with
+    stats.gpu_memory += program_count * (Shape::verts.size() * sizeof(typename Shape::format::vertex_type) + Shape::indices.size() * sizeof(glm::uvec3));
+
+    // unique checkerboard textures with a different tint each
+    std::vector<std::unique_ptr<wrap_g::texture>> textures;
+    std::vector<unsigned char> pixels(texture_size * texture_size * 4);
+
+    for (size_t i = 0; i < texture_count; ++i)
+    {
+        // ! textures cannot be moved, new on the returned texture constructs it in place
+        auto &tex = textures.emplace_back(new wrap_g::texture(win.create_texture(GL_TEXTURE_2D)));
+
+        tex->set_param(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        tex->set_param(GL_TEXTURE_WRAP_T, GL_REPEAT);
+        tex->set_param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        tex->set_param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        for (size_t y = 0; y < texture_size; ++y)
+        {
+            for (size_t x = 0; x < texture_size; ++x)
+            {
+                bool light = ((x / 8) + (y / 8)) % 2 == 0;
+                unsigned char *pixel = &pixels[(y * texture_size + x) * 4];
+                pixel[0] = light ? 255 : (unsigned char)(i * 37 % 256);
+                pixel[1] = light ? 255 : (unsigned char)(i * 91 % 256);
+                pixel[2] = light ? 255 : (unsigned char)(i * 157 % 256);
+                pixel[3] = 255;
+            }
+        }
+
+        tex->define_texture2d(1, GL_RGBA8, texture_size, texture_size);
+        tex->sub_image2d(0, 0, 0, texture_size, texture_size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+
+    stats.gpu_memory += texture_count * texture_size * texture_size * 4;
+    stats.draws = object_count;
+
+    glEnable(GL_DEPTH_TEST);
+
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    utils::timer frame_watch, submit_watch;
+    double total_frame_ms = 0.0, total_submit_ms = 0.0;
+
+    while (options.running(win, frame++))
+    {
+        // get events such as mouse input
+        // checks every time for event
+        win.poll_events();
+
+        frame_watch.start();
+        bench_watch.begin();
+
+        // orbit the grid
+        float angle = frame * 0.005f;
+        glm::vec3 cam_pos = center + glm::vec3{std::sin(angle) * orbit_radius, orbit_radius * 0.5f, std::cos(angle) * orbit_radius};
+        view = glm::lookAt(cam_pos, center, glm::vec3{0.0f, 1.0f, 0.0f});
+
+        for (size_t i = 0; i < program_count; ++i)
+        {
+            wrap_g::program &prog = shapes[i]->_base_gl._prog;
+            prog.set_uniform_mat<4>(shape_uniforms[i][(int)SHAPE_UNIFORMS::VIEW], glm::value_ptr(view));
+        }
+
+        ////
+        // rendering
+
+        // set the color that will be used when glClear is called on the color buffer bit
+        glClearColor(blue.r, blue.g, blue.b, blue.a);
+
+        // use this to reset the color and reset the depth buffer bit
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        submit_watch.start();
+
+        // a draw per object the way the other scenes draw their objects
+        size_t bound_texture = texture_count;
+        for (size_t i = 0; i < object_count; ++i)
+        {
+            size_t shape_index = i % program_count;
+            size_t texture_index = i % texture_count;
+
+            if (texture_index != bound_texture)
+            {
+                textures[texture_index]->bind_unit(0);
+                bound_texture = texture_index;
+            }
+
+            Shape &shape = *shapes[shape_index];
+            wrap_g::program &prog = shape._base_gl._prog;
+
+            model = glm::translate(glm::mat4{1.0f}, positions[i]);
+            prog.set_uniform_mat<4>(shape_uniforms[shape_index][(int)SHAPE_UNIFORMS::MODEL], glm::value_ptr(model));
+            shape.render();
+        }
+
+        total_submit_ms += submit_watch.stop_ms();
+
+        // swap the buffers to show the newly drawn frame
+        win.swap_buffers();
+        bench_watch.end();
+
+        total_frame_ms += frame_watch.stop_ms();
+        ++stats.frames;
+
+        // the driver allocates lazily so sample the memory once everything was used
+        if (stats.frames == 1)
+            stats.resident_memory = utils::resident_memory();
+    }
+
+    if (stats.frames != 0)
+    {
+        stats.submit_ms = total_submit_ms / stats.frames;
+        stats.frame_ms = total_frame_ms / stats.frames;
+        stats.draws_per_second = stats.frame_ms > 0.0 ? stats.draws * 1e3 / stats.frame_ms : 0.0;
+    }
+
+    return stats;
+}
+
+} // namespace wrap_tests
+
+#endif
@@ -0,0 +1,30 @@
+#version 450 core
+
+in vec3 frag_pos;
+in vec3 normals;
+in vec2 tex_coord;
+
+out vec4 frag_col;
+
+uniform vec3 light_dir;
+uniform float max_height;
+uniform vec3 cam_pos;
+uniform vec3 fog_col;
+
+void main()
+{
+    vec3 norm = normalize(normals);
+
+    // grass on the flat low ground, rock on the slopes and snow on the peaks
+    float height = frag_pos.y / max_height;
+    float slope = 1.0 - norm.y;
+    vec3 albedo = mix(vec3(0.25, 0.45, 0.2), vec3(0.45, 0.4, 0.35), smoothstep(0.15, 0.35, slope));
+    albedo = mix(albedo, vec3(0.9), smoothstep(0.7, 0.8, height) * (1.0 - smoothstep(0.4, 0.6, slope)));
+
+    float diff = max(dot(norm, -light_dir), 0.0);
+    vec3 col = (0.2 + 0.8 * diff) * albedo;
+
+    // fog hides the far chunks popping between lods
+    float fog = smoothstep(300.0, 700.0, length(cam_pos - frag_pos));
+    frag_col = vec4(mix(col, fog_col, fog), 1.0);
+}
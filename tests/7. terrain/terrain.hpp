@@ -0,0 +1,304 @@
+#ifndef WRAP_G_TESTS_TERRAIN
+#define WRAP_G_TESTS_TERRAIN
+
+#include <iostream>
+#include <optional>
+#include <cstdio>
+
+#include "../../src/utils.hpp"
+#include "../../src/wrap_g.hpp"
+#include "../scene_options.hpp"
+#include "../../src/wrap_g_exp.hpp"
+
+namespace wrap_tests
+{
+
+/**
+ * @brief Fly over a heightmap terrain drawn with geomipmapping. The chunks change lod and are streamed
+ * in and out as the camera moves, so the frame times include the uploads of the chunks coming into view.
+ *
+ * @param options How the scene is run.
+ */
+void create_terrain(const scene_options &options = {}) noexcept
+{
+    // initialize glfw and set opengl version and some stuff
+    wrap_g::wrap_g graphics;
+
+    if (!graphics.valid())
+        return;
+
+    // hide the window for headless runs and request a debug context for gl_debug
+    options.set_window_hints(graphics);
+
+    // create a window / context.
+    // width: 800
+    // height: 600
+    // title: "Terrain Test Window."
+    // underlying function also checks to see if glad is valid
+    auto win = graphics.create_window(800, 600, "Terrain Test Window.");
+
+    // check if underlying GLFWwindow* is valid
+    if (win.win() == nullptr)
+        return;
+
+    // set window resize function to adjust viewport automatically
+    // internally forwards to glfwSetFramebufferSizeCallback
+    win.set_framebuffer_size_callback([](GLFWwindow *, GLint w, GLint h){ glViewport(0, 0, w, h); });
+
+    // ensure ESC can always exit the program
+    // internally forwards to glfwSetKeyCallback
+    win.set_key_callback([](GLFWwindow *win, int key, int, int action, int){
+        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+        {
+            glfwSetWindowShouldClose(win, true);
+        }
+    });
+
+    win.set_buffer_swap_interval(0);
+
+    // record the input into or replay it from the recorder if one was given
+    // get_key, get_mouse_button and get_cursor_position then go through the recorder
+    if (options.input != nullptr)
+        win.set_input_recorder(*options.input);
+
+    // hide the cursor
+    win.set_input_mode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    ////
+    // Resource locations
+
+    constexpr const char *heightmap_path = "./tests/res/images/heightmap.png";
+
+    constexpr const char *vert_path = "./tests/7. terrain/vert.glsl";
+    constexpr const char *frag_path = "./tests/7. terrain/frag.glsl";
+
+    // the frame time readout is only drawn if the font is found
+    constexpr const char *font_path = "C:/Windows/Fonts/arial.ttf";
+
+    ////
+    // startup code
+
+    // logic
+
+    glm::vec3 world_up {0.0f, 1.0f, 0.0f};
+
+    // the heightmap is 513 x 513 samples, one unit apart
+    constexpr float max_height = 64.0f;
+    glm::vec3 cam_start_pos {64.0f, max_height + 16.0f, 64.0f};
+    glm::vec3 cam_look_at {256.0f, max_height * 0.25f, 256.0f};
+    glm::vec3 light_dir = glm::normalize(glm::vec3{-1.0f, -1.0f, -0.5f});
+
+    wrap_g::perspective_camera pers_cam(45.0f, win.width() / (float)win.height(), 0.1f, 1000.0f);
+    wrap_g::dynamic_camera dyn_cam(cam_start_pos, cam_look_at, world_up);
+
+    // first mouse needed for mouse rotation
+    bool first_mouse = false;
+
+    glm::vec2 last_cursor = glm::vec2{win.width(), win.height()} / 2.0f;
+
+    // the terrain is much larger than the other scenes so the camera moves faster
+    float look_sens = 300.0, move_sens = 50.0, zoom_sens = 100.0;
+
+    // gives a glm::vec4 containing the rgba color values
+    constexpr auto sky = utils::hex("#8fb3cf");
+
+    // opengl rendering
+
+    utils::stb_image img_loader;
+    utils::heightmap map;
+
+    if (!img_loader.load_file(heightmap_path) || !map.load(img_loader, max_height))
+    {
+        std::cout << "[main] Error: Failed to load heightmap from " << heightmap_path << "\n";
+        return;
+    }
+
+    // a small budget so the chunks left behind are evicted
+    wrap_g::terrain ground(win, std::move(map), { .chunk_cells = 32, .spacing = 1.0f, .lod_distance = 32.0f, .memory_budget = 4 << 20 });
+
+    std::string vert_src = utils::read_file_sync(vert_path);
+    std::string frag_src = utils::read_file_sync(frag_path);
+
+    bool success = ground._base_gl._prog.quick({
+        {GL_VERTEX_SHADER, {vert_src}},
+        {GL_FRAGMENT_SHADER, {frag_src}}
+    });
+
+    if (!success)
+        return;
+
+    // index of specific uniform location in the vector for the terrain
+    enum class TERRAIN_UNIFORMS { PROJ, VIEW, LIGHT_DIR, MAX_HEIGHT, CAM_POS, FOG_COL };
+
+    auto uniforms = ground._base_gl._prog.uniform_locations("proj", "view", "light_dir", "max_height", "cam_pos", "fog_col");
+
+    ground._base_gl._prog.set_uniform_mat<4>(uniforms[(int)TERRAIN_UNIFORMS::PROJ], glm::value_ptr(pers_cam.m_proj));
+    ground._base_gl._prog.set_uniform_vec<3>(uniforms[(int)TERRAIN_UNIFORMS::LIGHT_DIR], glm::value_ptr(light_dir));
+    ground._base_gl._prog.set_uniform(uniforms[(int)TERRAIN_UNIFORMS::MAX_HEIGHT], max_height);
+    ground._base_gl._prog.set_uniform_vec<3>(uniforms[(int)TERRAIN_UNIFORMS::FOG_COL], glm::value_ptr(glm::vec3(sky)));
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    // a readout of the frame time redrawn every frame, only its quads are uploaded once the digits
+    // are in the glyph atlas
+    utils::stb_true_type font;
+    std::optional<wrap_g::text_renderer> hud;
+    if (font.load_file(font_path))
+        hud.emplace(win, font, wrap_g::text_settings{ .atlas_width = 256, .atlas_height = 256, .max_glyphs = 256 });
+
+    utils::timer hud_watch;
+    char hud_text[64];
+
+    float dt = 0.01;
+
+    // times each frame for benchmark runs
+    frame_timer bench_watch(win, options);
+    unsigned int frame = 0;
+
+    while (options.running(win, frame++))
+    {
+        ////
+        // event handling
+
+        // get events such as mouse input
+        // checks every time for event
+        win.poll_events();
+
+        // look direction
+        // rotate camera along with mouse rotation
+        // but only if user is pressing left click
+        if (win.get_mouse_button(GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+        {
+            auto cursor = win.get_cursor_position();
+
+            if (first_mouse)
+            {
+                // basically ignore first mouse
+                first_mouse = false;
+                // update last cursor position
+                last_cursor = glm::vec2{cursor.first, cursor.second};
+            }
+            else
+            {
+                if (cursor.first >= win.width() - 1 || cursor.second >= win.height() - 1 || cursor.first < 1 || cursor.second < 1) {
+                    last_cursor = glm::vec2{win.width(), win.height()} / 2.0f;
+                    win.set_cursor_pos(last_cursor.x, last_cursor.y);
+                }
+
+                // calculate how far the mouse is from last position
+                glm::vec2 cursor_offset = glm::vec2{cursor.first, cursor.second} - last_cursor;
+
+                // min is to prevent redundant changing of rotation when change is zero
+                constexpr const float cursor_offset_min = 2.0;
+                // max is to prevent weird jerking behaviour when cursor moves between windows
+                constexpr const float cursor_offset_max = 500.0;
+
+                const auto len = glm::length(cursor_offset);
+
+                if (len > cursor_offset_min && len < cursor_offset_max) {
+                    // update last cursor position
+                    last_cursor = glm::vec2{cursor.first, cursor.second};
+                    // y axis is flipped as y is measured from top to bottom
+                    // top of screen is y=0 when we get the cursor position
+                    cursor_offset *= glm::vec2{1, -1} * look_sens * dt;
+                    dyn_cam.rotate(cursor_offset, world_up);
+                }
+            }
+        }
+
+        // movement
+
+        if (win.get_key(GLFW_KEY_A) == GLFW_PRESS)
+            dyn_cam.move(- dyn_cam.m_right * move_sens * dt);
+
+        if (win.get_key(GLFW_KEY_D) == GLFW_PRESS)
+            dyn_cam.move(dyn_cam.m_right * move_sens * dt);
+
+        if (win.get_key(GLFW_KEY_W) == GLFW_PRESS)
+            dyn_cam.move(dyn_cam.m_front * move_sens * dt);
+
+        if (win.get_key(GLFW_KEY_S) == GLFW_PRESS)
+            dyn_cam.move(- dyn_cam.m_front * move_sens * dt);
+
+        if (win.get_key(GLFW_KEY_SPACE) == GLFW_PRESS)
+            dyn_cam.move(dyn_cam.m_up * move_sens * dt);
+
+        if (win.get_key(GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+            dyn_cam.move(- dyn_cam.m_up * move_sens * dt);
+
+        // keep the camera above the ground
+        float ground_height = ground.height(dyn_cam.m_pos.x, dyn_cam.m_pos.z) + 2.0f;
+        if (dyn_cam.m_pos.y < ground_height)
+            dyn_cam.move(glm::vec3{0.0f, ground_height - dyn_cam.m_pos.y, 0.0f});
+
+        // zoom event
+        if (win.get_key(GLFW_KEY_Z) == GLFW_PRESS)
+        {
+            pers_cam.adjust_fov(-(win.get_key(GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS ? -1.0 : 1.0) * zoom_sens * dt);
+            ground._base_gl._prog.set_uniform_mat<4>(uniforms[(int)TERRAIN_UNIFORMS::PROJ], glm::value_ptr(pers_cam.m_proj));
+        }
+
+        // * Reset the camera to its starting position and fov
+        if (win.get_key(GLFW_KEY_R) == GLFW_PRESS)
+        {
+            // reset cursor position
+            win.set_cursor_pos((double)win.width() / 2.0, (double)win.height() / 2.0);
+            first_mouse = true;
+
+            dyn_cam.reset(world_up);
+            pers_cam.reset_fov();
+
+            ground._base_gl._prog.set_uniform_mat<4>(uniforms[(int)TERRAIN_UNIFORMS::PROJ], glm::value_ptr(pers_cam.m_proj));
+        }
+
+        ground._base_gl._prog.set_uniform_mat<4>(uniforms[(int)TERRAIN_UNIFORMS::VIEW], glm::value_ptr(dyn_cam.m_view));
+        ground._base_gl._prog.set_uniform_vec<3>(uniforms[(int)TERRAIN_UNIFORMS::CAM_POS], glm::value_ptr(dyn_cam.m_pos));
+
+        bench_watch.begin();
+
+        // pick the lods and stream the chunks for this frame, timed with the frame as it uploads
+        ground.update(pers_cam, dyn_cam);
+
+        if (options.tracker != nullptr)
+        {
+            options.tracker->track_count("terrain chunk uploads", ground.stats().uploads);
+            options.tracker->track_count("terrain chunk evictions", ground.stats().evictions);
+        }
+
+        ////
+        // rendering
+
+        // set the color that will be used when glClear is called on the color buffer bit
+        glClearColor(sky.r, sky.g, sky.b, sky.a);
+
+        // use this to reset the color and reset the depth buffer bit
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        ground.render();
+
+        if (hud)
+        {
+            std::snprintf(hud_text, sizeof(hud_text), "%.2f ms\nchunks: %zu / %zu", hud_watch.stop_ms(), ground.stats().drawn, ground.stats().chunks);
+            hud_watch.start();
+
+            hud->clear();
+            hud->add(hud_text, 20, glm::vec2{8.0f, 8.0f});
+            hud->render(glm::vec2{win.width(), win.height()});
+        }
+
+        // swap the buffers to show the newly drawn frame
+        win.swap_buffers();
+        bench_watch.end();
+    }
+
+#if WRAP_G_DEBUG
+    const auto &stats = ground.stats();
+    std::cout << "[main] Debug: Terrain chunks: " << stats.chunks << ", visible: " << stats.visible << ", drawn: " << stats.drawn
+              << ", resident: " << stats.resident << " (" << stats.resident_bytes / 1024 << " KiB)\n";
+#endif
+}
+
+} // namespace wrap_tests
+
+#endif
@@ -0,0 +1,21 @@
+#version 450 core
+
+layout (location = 0) in vec3 ipos;
+layout (location = 1) in vec3 inormals;
+layout (location = 2) in vec2 itex_coord;
+
+out vec3 frag_pos;
+out vec3 normals;
+out vec2 tex_coord;
+
+uniform mat4 proj;
+uniform mat4 view;
+
+void main()
+{
+    // the terrain vertices are already in world space
+    tex_coord = itex_coord;
+    normals = inormals;
+    frag_pos = ipos;
+    gl_Position = proj * view * vec4(ipos, 1.0);
+}
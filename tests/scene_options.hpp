@@ -0,0 +1,117 @@
+#ifndef WRAP_G_TESTS_SCENE_OPTIONS
+#define WRAP_G_TESTS_SCENE_OPTIONS
+
+#include "../src/utils.hpp"
+#include "../src/wrap_g.hpp"
+
+namespace wrap_tests
+{
+
+/**
+ * @brief Controls how a test scene is run. The defaults run the scene in a visible window until it is
+ * closed, the same as running it by hand.
+ *
+ */
+struct scene_options
+{
+    // the recorder the camera input is recorded into or replayed from
+    // * only used by the scenes with a camera (3-5)
+    wrap_g::input_recorder *input = nullptr;
+
+    // hide the window. Ex: for benchmarks
+    bool headless = false;
+
+    // stop after this many frames, 0 runs until the window is closed
+    unsigned int max_frames = 0;
+
+    // receives the cpu and gpu time of every frame if set
+    utils::metrics *tracker = nullptr;
+
+    // create a debug context and collect its opengl debug messages once per frame. The counts are
+    // reported to the tracker. Ex: to fail a benchmark on performance warnings
+    // * needs WRAP_G_USE_NEW_OPENGL_DEBUG_MESSAGE_CONTROL
+    bool gl_debug = false;
+
+    // set the window hints for the options, call before the window is created
+    inline void set_window_hints(wrap_g::wrap_g &graphics) const noexcept
+    {
+        // hide the window for headless runs
+        if (headless)
+            graphics.set_window_hint(GLFW_VISIBLE, GLFW_FALSE);
+
+        if (gl_debug)
+            graphics.set_window_hint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    }
+
+    // whether the frame loop should keep going
+    [[nodiscard]] inline bool running(const wrap_g::window &win, unsigned int frame) const noexcept
+    {
+        return !win.get_should_close() && (max_frames == 0 || frame < max_frames);
+    }
+};
+
+/**
+ * @brief Times each frame on the cpu and the gpu and passes the times to the options tracker.
+ * Also collects the opengl debug messages of each frame when gl_debug is set.
+ * Does nothing if no tracker was given and gl_debug is not set.
+ *
+ */
+class frame_timer
+{
+private:
+    wrap_g::window &m_win;
+    utils::metrics *m_tracker;
+    bool m_gl_debug;
+
+    utils::timer m_watch;
+    wrap_g::gpu_timer m_gpu_watch;
+
+public:
+    frame_timer(wrap_g::window &win, const scene_options &options) noexcept
+        : m_win(win), m_tracker(options.tracker), m_gl_debug(options.gl_debug), m_gpu_watch(win.create_gpu_timer())
+    {
+        // collect the messages instead of making the driver wait for each one
+        if (m_gl_debug)
+            m_win.set_debug_output(wrap_g::window::debug_output::BATCHED);
+    }
+
+    // read back the frames still in flight
+    ~frame_timer() noexcept
+    {
+        if (m_tracker == nullptr)
+            return;
+
+        double ms;
+        while (m_gpu_watch.result(ms, true))
+            m_tracker->track_gpu_frame(ms);
+    }
+
+    void begin() noexcept
+    {
+        if (m_tracker == nullptr)
+            return;
+
+        m_watch.start();
+        m_gpu_watch.begin();
+    }
+
+    void end() noexcept
+    {
+        if (m_gl_debug)
+            m_win.collect_debug_messages(m_tracker);
+
+        if (m_tracker == nullptr)
+            return;
+
+        m_gpu_watch.end();
+        m_tracker->track_frame(m_watch.stop_ms());
+
+        double ms;
+        while (m_gpu_watch.result(ms))
+            m_tracker->track_gpu_frame(ms);
+    }
+};
+
+} // namespace wrap_tests
+
+#endif